@@ -0,0 +1,80 @@
+// Compares `da_append` with `arena_da_append` on the vector sizes the parser
+// builds: call arguments, paths and tuples mostly hold one to three items.
+//
+//     make out/bench_da && ./out/bench_da
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../src/arena.h"
+#include "../src/dynarray.h"
+
+#define VECTORS 2000000
+#define ROUNDS 5
+
+typedef struct {
+    void **items;
+    size_t count;
+    size_t capacity;
+} Vector;
+
+static Vector vectors[VECTORS];
+
+static
+double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// deterministic mix of 1, 2 and 3 element vectors
+static inline
+size_t vector_size(size_t i) {
+    return 1 + (i * 2654435761u >> 7) % 3;
+}
+
+static
+double bench_heap(void) {
+    double start = now();
+    for (size_t i = 0; i < VECTORS; i++) {
+        Vector v = {0};
+        for (size_t j = 0; j < vector_size(i); j++) {
+            da_append(&v, &vectors[i]);
+        }
+        vectors[i] = v;
+    }
+    for (size_t i = 0; i < VECTORS; i++) {
+        free(vectors[i].items);
+    }
+    return now() - start;
+}
+
+static
+double bench_arena(void) {
+    double start = now();
+    Arena arena = {0};
+    for (size_t i = 0; i < VECTORS; i++) {
+        Vector v = {0};
+        for (size_t j = 0; j < vector_size(i); j++) {
+            arena_da_append(&arena, &v, &vectors[i]);
+        }
+        vectors[i] = v;
+    }
+    arena_free(&arena);
+    return now() - start;
+}
+
+int main(void) {
+    double heap = 0, arena = 0;
+    for (int round = 0; round < ROUNDS; round++) {
+        heap += bench_heap();
+        arena += bench_arena();
+    }
+    heap /= ROUNDS;
+    arena /= ROUNDS;
+    printf("%d vectors of 1-3 items, mean of %d rounds\n", VECTORS, ROUNDS);
+    printf("    da_append:       %8.2f ms  (%5.1f ns/vector)\n", heap * 1e3, heap * 1e9 / VECTORS);
+    printf("    arena_da_append: %8.2f ms  (%5.1f ns/vector)\n", arena * 1e3, arena * 1e9 / VECTORS);
+    return 0;
+}
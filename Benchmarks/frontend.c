@@ -0,0 +1,299 @@
+// Front-end benchmark: lexing, parsing and end-to-end time per input file.
+//
+//     make bench
+//     ./out/bench_frontend [--warmup N] [--reps N] [--json <file>] [--cfg <name>]... <file>...
+//
+// Every phase is repeated `reps` times after `warmup` untimed runs, the
+// report gives min, mean and percentiles of the repetitions together with
+// throughput derived from the median.
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../src/ast_pool.h"
+#include "../src/lexer.h"
+#include "../src/parser.h"
+#include "../src/visitor.h"
+#include "../src/writer.h"
+
+typedef struct {
+    double *items;
+    size_t count;
+    size_t capacity;
+} Samples;
+
+typedef struct {
+    double min;
+    double mean;
+    double p50;
+    double p90;
+    double p99;
+    double max;
+} Stats;
+
+typedef struct {
+    const char *filename;
+    size_t bytes;
+    size_t tokens;
+    size_t nodes;
+    Samples lex;
+    Samples parse;
+    Samples end_to_end;
+} Result;
+
+static Writer sink;
+// for the #if conditions of the inputs
+static Parser_Cfg cfg;
+
+static
+double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static
+bool read_file(const char *filename, String_Builder *sb) {
+    FILE *file = fopen(filename, "r");
+    if (file == NULL) {
+        fprintf(stderr, "ERROR: Could not open %s\n", filename);
+        return false;
+    }
+    sb->count = 0;
+    char buffer[64*1024];
+    size_t count;
+    while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        da_append_many(sb, buffer, count);
+    }
+    fclose(file);
+    return true;
+}
+
+static
+size_t count_tokens(Lex_TokenStream stream) {
+    size_t count = 0;
+    for (size_t i = 0; i < stream.count; i++) {
+        Lex_TokenTree *tree = &stream.items[i];
+        if (tree->type == Tt_Delimited) {
+            // opening and closing delimiter
+            count += 2 + count_tokens(tree->Tt_Delimited.stream);
+        } else {
+            count++;
+        }
+    }
+    return count;
+}
+
+static
+Ast_VisitResult _count_node(Ast_Visitor *visitor, Ast_Node node) {
+    (void)node;
+    (*(size_t *)visitor->data)++;
+    return Visit_Continue;
+}
+
+static
+Lex_TokenStream tokenize(const char *filename, String_Builder *content) {
+    bool success;
+    Lex_TokenizeResult result = lexer_tokenize_source(
+        sv_from_cstring(filename, strlen(filename)),
+        sb_to_string_view(content),
+        &success
+    );
+    if (!success) {
+        fprintf(stderr, "ERROR: %s does not tokenize\n", filename);
+        exit(1);
+    }
+    return result.stream;
+}
+
+static
+void run_once(Result *result, String_Builder *content, bool record) {
+    double start = now();
+    if (!read_file(result->filename, content)) {
+        exit(1);
+    }
+
+    double lex_start = now();
+    Lex_TokenStream stream = tokenize(result->filename, content);
+    double lex_end = now();
+
+    Ast_Pool pool = {0};
+    Ast_Source source;
+    Parser_Error error;
+    if (!parser_parse_source(&pool, stream, &cfg, &source, &error)) {
+        fprintf(stderr, "ERROR: %s does not parse\n", result->filename);
+        exit(1);
+    }
+    double parse_end = now();
+
+    ast_print_source(&sink, &source, 0);
+    writer_flush(&sink);
+    double end = now();
+
+    if (record) {
+        da_append(&result->lex, lex_end - lex_start);
+        da_append(&result->parse, parse_end - lex_end);
+        da_append(&result->end_to_end, end - start);
+    } else if (result->tokens == 0) {
+        result->bytes = content->count;
+        result->tokens = count_tokens(stream);
+        Ast_Visitor visitor = { .pre = _count_node, .data = &result->nodes };
+        ast_walk_source(&visitor, &source);
+        ast_visitor_free(&visitor);
+    }
+
+    // the strings of the nodes are shared with the token stream
+    ast_pool_free(&pool);
+    lexer_token_stream_free(&stream);
+    // every run starts with an empty interner, like a compiler invocation
+    lexer_free_interned();
+}
+
+static
+int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// nearest-rank percentile of sorted samples
+static
+double percentile(Samples *samples, double p) {
+    size_t rank = (size_t)(p / 100.0 * samples->count + 0.5);
+    if (rank < 1) {
+        rank = 1;
+    }
+    if (rank > samples->count) {
+        rank = samples->count;
+    }
+    return samples->items[rank - 1];
+}
+
+static
+Stats compute_stats(Samples *samples) {
+    qsort(samples->items, samples->count, sizeof(double), compare_doubles);
+    double sum = 0;
+    for (size_t i = 0; i < samples->count; i++) {
+        sum += samples->items[i];
+    }
+    return (Stats) {
+        .min = samples->items[0],
+        .mean = sum / samples->count,
+        .p50 = percentile(samples, 50),
+        .p90 = percentile(samples, 90),
+        .p99 = percentile(samples, 99),
+        .max = samples->items[samples->count - 1],
+    };
+}
+
+static
+void write_stats(FILE *out, const char *name, Stats stats, const char *rate_name, double rate) {
+    fprintf(out, "\"%s\":{\"min_ms\":%.4f,\"mean_ms\":%.4f,\"p50_ms\":%.4f,\"p90_ms\":%.4f,"
+                 "\"p99_ms\":%.4f,\"max_ms\":%.4f",
+            name, stats.min * 1e3, stats.mean * 1e3, stats.p50 * 1e3, stats.p90 * 1e3,
+            stats.p99 * 1e3, stats.max * 1e3);
+    if (rate_name != NULL) {
+        fprintf(out, ",\"%s\":%.1f", rate_name, rate);
+    }
+    fprintf(out, "}");
+}
+
+static
+void usage(const char *program) {
+    fprintf(stderr, "Usage: %s [--warmup N] [--reps N] [--json <file>] [--cfg <name>]... <file>...\n", program);
+}
+
+int main(int argc, char **argv) {
+    size_t warmup = 2;
+    size_t reps = 10;
+    const char *json = NULL;
+    Result results[64];
+    size_t count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+            warmup = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+            reps = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json = argv[++i];
+        } else if (strcmp(argv[i], "--cfg") == 0 && i + 1 < argc) {
+            da_append(&cfg, argv[++i]);
+        } else if (argv[i][0] == '-') {
+            usage(argv[0]);
+            return 1;
+        } else {
+            assert(count < sizeof(results) / sizeof(results[0]) && "too many input files");
+            results[count++] = (Result) { .filename = argv[i] };
+        }
+    }
+    if (count == 0 || reps == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    int null_fd = open("/dev/null", O_WRONLY);
+    writer_init(&sink, null_fd);
+
+    String_Builder content = {0};
+    printf("%-24s %10s %12s %12s %12s %12s\n",
+           "file", "MB/s lex", "Mtok/s lex", "Mnode/s", "e2e p50 ms", "e2e p99 ms");
+    for (size_t i = 0; i < count; i++) {
+        Result *result = &results[i];
+        for (size_t j = 0; j < warmup + 1; j++) {
+            run_once(result, &content, false);
+        }
+        for (size_t j = 0; j < reps; j++) {
+            run_once(result, &content, true);
+        }
+
+        Stats lex = compute_stats(&result->lex);
+        Stats parse = compute_stats(&result->parse);
+        Stats e2e = compute_stats(&result->end_to_end);
+        const char *name = strrchr(result->filename, '/');
+        printf("%-24s %10.1f %12.2f %12.2f %12.2f %12.2f\n",
+               name != NULL ? name + 1 : result->filename,
+               result->bytes / lex.p50 / 1e6,
+               result->tokens / lex.p50 / 1e6,
+               result->nodes / parse.p50 / 1e6,
+               e2e.p50 * 1e3, e2e.p99 * 1e3);
+    }
+
+    if (json != NULL) {
+        FILE *out = fopen(json, "w");
+        if (out == NULL) {
+            fprintf(stderr, "ERROR: Could not open %s\n", json);
+            return 1;
+        }
+        fprintf(out, "{\"warmup\":%zu,\"reps\":%zu,\"results\":[", warmup, reps);
+        for (size_t i = 0; i < count; i++) {
+            Result *result = &results[i];
+            // samples are sorted by now, compute_stats is idempotent
+            Stats lex = compute_stats(&result->lex);
+            Stats parse = compute_stats(&result->parse);
+            Stats e2e = compute_stats(&result->end_to_end);
+            fprintf(out, "%s\n{\"file\":\"%s\",\"bytes\":%zu,\"tokens\":%zu,\"nodes\":%zu,",
+                    i > 0 ? "," : "", result->filename, result->bytes, result->tokens, result->nodes);
+            write_stats(out, "lex", lex, "mb_per_s", result->bytes / lex.p50 / 1e6);
+            fprintf(out, ",\"lex_tokens_per_s\":%.1f,", result->tokens / lex.p50);
+            write_stats(out, "parse", parse, "nodes_per_s", result->nodes / parse.p50);
+            fprintf(out, ",");
+            write_stats(out, "end_to_end", e2e, "mb_per_s", result->bytes / e2e.p50 / 1e6);
+            fprintf(out, "}");
+        }
+        fprintf(out, "\n]}\n");
+        fclose(out);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        free(results[i].lex.items);
+        free(results[i].parse.items);
+        free(results[i].end_to_end.items);
+    }
+    free(content.items);
+    close(null_fd);
+    return 0;
+}
@@ -0,0 +1,157 @@
+import argparse
+import os
+import random
+
+# Writes a deterministic corpus of synthetic bang sources, one file per
+# workload shape. The same seed and size always produce byte-identical
+# files, so timings of different revisions can be compared.
+
+BINARY_OPS = ['+', '-', '*', '/', '%', '<<', '>>', '&', '|', '^', '==', '!=', '<', '<=', '>', '>=', '&&', '||']
+ASSIGN_OPS = ['=', '+=', '-=', '*=', '/=']
+WORDS = ['buffer', 'count', 'index', 'value', 'result', 'node', 'token', 'span', 'offset', 'length', 'state', 'parser']
+
+def ident(rng: random.Random) -> str:
+    return f'{rng.choice(WORDS)}_{rng.choice(WORDS)}{rng.randrange(1000)}'
+
+def path(rng: random.Random) -> str:
+    return ':'.join(ident(rng) for _ in range(rng.randint(1, 3)))
+
+def number(rng: random.Random) -> str:
+    match rng.randrange(5):
+        case 0:
+            return f'0x{rng.getrandbits(32):x}'
+        case 1:
+            return f'{rng.random() * 1000:.6f}'
+        case 2:
+            return f'{rng.randrange(256)}u8'
+        case 3:
+            return f'{rng.randrange(1 << 31)}i64'
+    return str(rng.randrange(1 << 16))
+
+def string(rng: random.Random, length: int) -> str:
+    chars = []
+    for _ in range(length):
+        # the lexer does not take an escape as the very first character yet
+        if chars and rng.random() < 0.02:
+            chars.append(rng.choice(['\\n', '\\"', '\\\\']))
+        else:
+            chars.append(chr(rng.randrange(0x20, 0x7f)).replace('\\', '/').replace('"', "'"))
+    return '"' + ''.join(chars) + '"'
+
+def gen_idents(rng: random.Random):
+    while True:
+        args = ', '.join(path(rng) for _ in range(rng.randint(0, 4)))
+        yield f'    let {ident(rng)} = {path(rng)}.{ident(rng)}({args})[{ident(rng)}];\n'
+
+def gen_numbers(rng: random.Random):
+    while True:
+        row = ', '.join(number(rng) for _ in range(8))
+        yield f'    const {ident(rng)} = table({row});\n'
+
+def gen_nesting(rng: random.Random):
+    while True:
+        depth = rng.randint(8, 64)
+        expr = ident(rng)
+        for _ in range(depth):
+            expr = f'({expr} {rng.choice(BINARY_OPS)} {number(rng)})'
+        inner = f'{ident(rng)} = {expr};'
+        for _ in range(rng.randint(4, 24)):
+            inner = f'if {ident(rng)} {{ {inner} }} else {{ {{ {ident(rng)}; }} }}'
+        yield f'    {inner}\n'
+
+def gen_strings(rng: random.Random):
+    while True:
+        yield f'    let {ident(rng)} = {string(rng, rng.randint(64, 4096))};\n'
+
+def gen_comments(rng: random.Random):
+    while True:
+        if rng.random() < 0.5:
+            text = string(rng, rng.randint(16, 120))[1:-1].replace('*/', '* /').replace('/*', '/ *')
+            yield f'    /* {text}\n       {text} */\n'
+        else:
+            yield f'    // {string(rng, rng.randint(16, 120))[1:-1]}\n'
+        yield f'    {ident(rng)} += 1;\n'
+
+def gen_operators(rng: random.Random):
+    while True:
+        terms = [ident(rng) if rng.random() < 0.6 else number(rng) for _ in range(rng.randint(16, 128))]
+        expr = terms[0]
+        for term in terms[1:]:
+            expr += f' {rng.choice(BINARY_OPS)} {rng.choice(["", "-", "!", "~", "&"])}{term}'
+        yield f'    {ident(rng)} {rng.choice(ASSIGN_OPS)} {expr};\n'
+
+# Straight-line code that checks and runs: every name is declared first and
+# only mixed with names of its own type, divisors are odd so never zero
+RUN_TYPES = ['i64', 'u32', 'f64']
+RUN_OPS = {
+    'i64': ['+', '-', '*', '/', '%', '&', '|', '^'],
+    'u32': ['+', '-', '*', '/', '%', '&', '|', '^', '<<', '>>'],
+    'f64': ['+', '-', '*'],
+}
+
+def gen_run(rng: random.Random):
+    names = {ty: [f'{ty}_{i}' for i in range(16)] for ty in RUN_TYPES}
+    for ty in RUN_TYPES:
+        for name in names[ty]:
+            value = f'{rng.random() * 100:.3f}' if ty == 'f64' else str(rng.randrange(1, 1000))
+            yield f'    let {name} {ty} = {value};\n'
+
+    def expr(ty: str) -> str:
+        result = rng.choice(names[ty])
+        for _ in range(rng.randint(2, 8)):
+            op = rng.choice(RUN_OPS[ty])
+            if op in ('/', '%'):
+                term = f'({rng.choice(names[ty])} | 1)'
+            elif op in ('<<', '>>'):
+                term = str(rng.randrange(8))
+            else:
+                term = rng.choice(names[ty]) if rng.random() < 0.7 else str(rng.randrange(1, 100))
+            result = f'{result} {op} {term}'
+        return result
+
+    def assign(ty: str) -> str:
+        op = rng.choice(['=', '+=', '-=']) if ty == 'f64' else rng.choice(['=', '+=', '-=', '^=', '*='])
+        return f'{rng.choice(names[ty])} {op} {expr(ty)};'
+
+    while True:
+        ty = rng.choice(RUN_TYPES)
+        if rng.random() < 0.3:
+            other = rng.choice(RUN_TYPES)
+            condition = f'{expr(ty)} < {rng.choice(names[ty])}'
+            yield f'    if {condition} {{ {assign(other)} }} else {{ {assign(other)} }};\n'
+        else:
+            yield f'    {assign(ty)}\n'
+
+WORKLOADS = {
+    'idents': gen_idents,
+    'numbers': gen_numbers,
+    'nesting': gen_nesting,
+    'strings': gen_strings,
+    'comments': gen_comments,
+    'operators': gen_operators,
+    'run': gen_run,
+}
+
+def generate(name: str, size: int, seed: int) -> str:
+    rng = random.Random(f'{seed}:{name}')
+    parts = ['#entrypoint {\n']
+    written = len(parts[0])
+    for line in WORKLOADS[name](rng):
+        if written >= size:
+            break
+        parts.append(line)
+        written += len(line)
+    parts.append('}\n')
+    return ''.join(parts)
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='generate the benchmark corpus')
+    parser.add_argument('outdir')
+    parser.add_argument('--size', type=int, default=2 * 1024 * 1024, help='approximate bytes per file')
+    parser.add_argument('--seed', type=int, default=1337)
+    args = parser.parse_args()
+
+    os.makedirs(args.outdir, exist_ok=True)
+    for name in WORKLOADS:
+        with open(os.path.join(args.outdir, f'{name}.bang'), 'w') as f:
+            f.write(generate(name, args.size, args.seed))
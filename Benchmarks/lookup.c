@@ -0,0 +1,469 @@
+// Lookup benchmark: the generated `*_resolve` functions, SipHash perfect
+// hashes from Generators/phf.templ8 or the strategy `lookup_map` picked,
+// against all alternative strategies of Generators/lookup.templ8.
+//
+//     make bench
+//     ./out/bench_lookup [--reps N] [--json <file>] <file>...
+//
+// The queries are the lookups the lexer and parser do on the given files, in
+// source order: every identifier goes through keyword_resolve, every
+// directive through directive_resolve and every punctuator is probed with
+// its 3, 2 and 1 byte prefixes by check_is_punctuator. The operator lookups
+// get the kind of every punctuator token, assignment_op_resolve only the
+// ones binary_op_resolve did not match, like is_associative_operator does.
+// Each of those streams is timed as is and split into its hits and misses.
+
+#define LEXERC_H_LOOKUP_STRATEGIES
+#define OPERATORS_H_LOOKUP_STRATEGIES
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/dynarray.h"
+#include "../src/lexer.h"
+
+// the arguments are passed on to every _S, to expand it per lookup
+#define ENUMERATE_STRATEGIES(...) \
+    _S(generated, __VA_ARGS__)    \
+    _S(switch, __VA_ARGS__)       \
+    _S(length, __VA_ARGS__)       \
+    _S(direct, __VA_ARGS__)       \
+    _S(mulshift, __VA_ARGS__)
+
+// the query type is either a C string or a token kind
+#define ENUMERATE_LOOKUPS                           \
+    _L(keyword_resolve, STRING, K_Invalid)          \
+    _L(directive_resolve, STRING, D_Invalid)        \
+    _L(binary_op_resolve, KIND, Bo_Invalid)         \
+    _L(assignment_op_resolve, KIND, Ao_Invalid)     \
+    _L(unary_op_resolve, KIND, Uo_Invalid)          \
+    _L(check_is_punctuator, STRING, false)
+
+#define ENUMERATE_MIXES \
+    _M(corpus)          \
+    _M(hits)            \
+    _M(misses)
+
+#define _TYPE_STRING const char *
+#define _TYPE_KIND uint32_t
+
+// the generated lookups under the name of their strategy
+#define _L(name, type, invalid) \
+    static inline int name##_generated(_TYPE_##type in) { return name(in); }
+ENUMERATE_LOOKUPS
+#undef _L
+
+typedef enum {
+#define _S(name, ...) Strategy_##name,
+    ENUMERATE_STRATEGIES()
+#undef _S
+    Strategy_NumberOfElements
+} Strategy;
+
+typedef enum {
+#define _L(name, type, invalid) Lookup_##name,
+    ENUMERATE_LOOKUPS
+#undef _L
+    Lookup_NumberOfElements
+} Lookup;
+
+typedef enum {
+#define _M(name) Mix_##name,
+    ENUMERATE_MIXES
+#undef _M
+    Mix_NumberOfElements
+} Mix;
+
+static const char *strategy_names[] = {
+#define _S(name, ...) #name,
+    ENUMERATE_STRATEGIES()
+#undef _S
+};
+
+static const char *lookup_names[] = {
+#define _L(name, type, invalid) #name,
+    ENUMERATE_LOOKUPS
+#undef _L
+};
+
+static const char *mix_names[] = {
+#define _M(name) #name,
+    ENUMERATE_MIXES
+#undef _M
+};
+
+// string queries are collected as offsets into one pool and turned into
+// pointers once the pool stopped growing
+typedef struct {
+    uint64_t *items;
+    size_t count;
+    size_t capacity;
+} Queries;
+
+typedef struct {
+    Queries queries;
+    const char **strings;
+    size_t hits;
+    double ns[Strategy_NumberOfElements];
+} Query_Mix;
+
+static String_Builder pool;
+static Queries collected[Lookup_NumberOfElements];
+static Query_Mix mixes[Lookup_NumberOfElements][Mix_NumberOfElements];
+
+static
+double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static
+void add_string(Lookup lookup, const char *data, size_t count) {
+    da_append(&collected[lookup], pool.count);
+    da_append_many(&pool, data, count);
+    da_append(&pool, '\0');
+}
+
+static
+bool is_ident_char(char chr) {
+    return chr == '$' || chr == '_' || (chr >= 'a' && chr <= 'z') ||
+        (chr >= 'A' && chr <= 'Z') || (chr >= '0' && chr <= '9');
+}
+
+typedef struct {
+    String_View content;
+    // byte offset of every line, spans only have rows and columns
+    size_t *lines;
+} Source;
+
+static
+size_t source_offset(Source *source, Lex_Pos pos) {
+    return source->lines[pos.row - 1] + pos.col - 1;
+}
+
+// the prefixes consume_punctuators tries, longest first
+static
+void add_punctuator(Source *source, size_t offset, size_t length) {
+    size_t remaining = source->content.count - offset;
+    for (size_t i = remaining < 3 ? remaining : 3; i >= length && i > 0; i--) {
+        add_string(Lookup_check_is_punctuator, source->content.data + offset, i);
+    }
+}
+
+static
+void collect_stream(Source *source, Lex_TokenStream stream) {
+    for (size_t i = 0; i < stream.count; i++) {
+        Lex_TokenTree *tree = &stream.items[i];
+        if (tree->type == Tt_Delimited) {
+            Lex_Delimited *delimited = &tree->Tt_Delimited;
+            add_punctuator(source, source_offset(source, delimited->span.open.start), 1);
+            collect_stream(source, delimited->stream);
+            add_punctuator(source, source_offset(source, delimited->span.close.start), 1);
+            continue;
+        }
+
+        Lex_Token *token = &tree->Tt_Token;
+        size_t offset = source_offset(source, token->span.start);
+        const char *start = source->content.data + offset;
+        size_t length = 0;
+        switch (token->kind) {
+            case Tk_Ident:
+            case Tk_Keyword:
+                while (offset + length < source->content.count && is_ident_char(start[length])) {
+                    length++;
+                }
+                if (start[0] != '$') {
+                    add_string(Lookup_keyword_resolve, start, length);
+                }
+                break;
+            case Tk_Directive:
+                length = 1;
+                while (offset + length < source->content.count && is_ident_char(start[length])) {
+                    length++;
+                }
+                add_string(Lookup_directive_resolve, start + 1, length - 1);
+                break;
+            default:
+                if (IS_TOKEN_KIND(token->kind)) {
+                    break;
+                }
+                uint32_t kind = token->kind;
+                add_punctuator(source, offset, strlen(AS_PUNCTUATOR(kind)));
+                da_append(&collected[Lookup_binary_op_resolve], kind);
+                da_append(&collected[Lookup_unary_op_resolve], kind);
+                if (binary_op_resolve(kind) == Bo_Invalid) {
+                    da_append(&collected[Lookup_assignment_op_resolve], kind);
+                }
+                break;
+        }
+    }
+}
+
+static
+bool collect_file(const char *filename) {
+    FILE *file = fopen(filename, "r");
+    if (file == NULL) {
+        fprintf(stderr, "ERROR: Could not open %s\n", filename);
+        return false;
+    }
+    String_Builder content = {0};
+    char buffer[64*1024];
+    size_t count;
+    while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        da_append_many(&content, buffer, count);
+    }
+    fclose(file);
+
+    struct {
+        size_t *items;
+        size_t count;
+        size_t capacity;
+    } lines = {0};
+    da_append(&lines, 0);
+    for (size_t i = 0; i < content.count; i++) {
+        if (content.items[i] == '\n') {
+            da_append(&lines, i + 1);
+        }
+    }
+
+    bool success;
+    Lex_TokenizeResult result = lexer_tokenize_source(
+        sv_from_cstring(filename, strlen(filename)),
+        sb_to_string_view(&content),
+        &success
+    );
+    if (!success) {
+        fprintf(stderr, "ERROR: %s does not tokenize\n", filename);
+        return false;
+    }
+    Source source = { .content = sb_to_string_view(&content), .lines = lines.items };
+    collect_stream(&source, result.stream);
+
+    lexer_token_stream_free(&result.stream);
+    free(lines.items);
+    free(content.items);
+    return true;
+}
+
+static
+bool is_string_lookup(Lookup lookup) {
+    return lookup == Lookup_keyword_resolve || lookup == Lookup_directive_resolve ||
+        lookup == Lookup_check_is_punctuator;
+}
+
+#define _QUERY_STRING(query) (pool.items + (query))
+#define _QUERY_KIND(query) ((uint32_t)(query))
+
+static
+bool is_hit(Lookup lookup, uint64_t query) {
+    switch (lookup) {
+#define _L(name, type, invalid) \
+        case Lookup_##name: return name(_QUERY_##type(query)) != invalid;
+        ENUMERATE_LOOKUPS
+#undef _L
+        default:
+            assert(0 && "unreachable");
+    }
+}
+
+// every strategy has to agree with the generated lookup on every query
+static
+void verify(Lookup lookup, Queries *queries) {
+    for (size_t i = 0; i < queries->count; i++) {
+        switch (lookup) {
+#define _S(strategy, name, type) \
+            assert(name##_##strategy(_QUERY_##type(queries->items[i])) == (int)name(_QUERY_##type(queries->items[i])));
+#define _L(name, type, invalid) \
+            case Lookup_##name: { ENUMERATE_STRATEGIES(name, type) } break;
+            ENUMERATE_LOOKUPS
+#undef _L
+#undef _S
+            default:
+                assert(0 && "unreachable");
+        }
+    }
+}
+
+static
+void build_mixes(void) {
+    for (Lookup lookup = 0; lookup < Lookup_NumberOfElements; lookup++) {
+        Queries *queries = &collected[lookup];
+        verify(lookup, queries);
+        for (size_t i = 0; i < queries->count; i++) {
+            uint64_t query = queries->items[i];
+            bool hit = is_hit(lookup, query);
+            da_append(&mixes[lookup][Mix_corpus].queries, query);
+            da_append(&mixes[lookup][hit ? Mix_hits : Mix_misses].queries, query);
+            mixes[lookup][Mix_corpus].hits += hit;
+            mixes[lookup][Mix_hits].hits += hit;
+        }
+
+        if (!is_string_lookup(lookup)) {
+            continue;
+        }
+        for (Mix mix = 0; mix < Mix_NumberOfElements; mix++) {
+            Query_Mix *m = &mixes[lookup][mix];
+            m->strings = malloc(m->queries.count * sizeof(const char *) + 1);
+            assert(m->strings != NULL && "Buy more RAM lol");
+            for (size_t i = 0; i < m->queries.count; i++) {
+                m->strings[i] = pool.items + m->queries.items[i];
+            }
+        }
+    }
+}
+
+// One loop per lookup and strategy, so every strategy is called directly,
+// the way the lexer and parser call the perfect hashes
+#define _LOOP_STRING(function, invalid)                         \
+    for (size_t i = 0; i < mix->queries.count; i++) {           \
+        hits += function(mix->strings[i]) != invalid;           \
+    }
+#define _LOOP_KIND(function, invalid)                           \
+    for (size_t i = 0; i < mix->queries.count; i++) {           \
+        hits += function((uint32_t)mix->queries.items[i]) != invalid; \
+    }
+
+static
+size_t run_lookups(Lookup lookup, Strategy strategy, Query_Mix *mix) {
+    size_t hits = 0;
+    switch (lookup) {
+#define _S(strategy, name, type, invalid)                           \
+            case Strategy_##strategy:                               \
+                _LOOP_##type(name##_##strategy, invalid) break;
+#define _L(name, type, invalid)                                     \
+        case Lookup_##name:                                         \
+            switch (strategy) {                                     \
+                ENUMERATE_STRATEGIES(name, type, invalid)           \
+                default: assert(0 && "unreachable");                \
+            }                                                       \
+            break;
+        ENUMERATE_LOOKUPS
+#undef _L
+#undef _S
+        default:
+            assert(0 && "unreachable");
+    }
+    return hits;
+}
+
+static
+void time_mix(Lookup lookup, Query_Mix *mix, size_t reps) {
+    for (Strategy strategy = 0; strategy < Strategy_NumberOfElements; strategy++) {
+        double best = -1;
+        // the first round only warms the caches
+        for (size_t rep = 0; rep < reps + 1; rep++) {
+            double start = now();
+            size_t hits = run_lookups(lookup, strategy, mix);
+            double elapsed = now() - start;
+            assert(hits == mix->hits && "strategies disagree on the number of hits");
+            if (rep > 0 && (best < 0 || elapsed < best)) {
+                best = elapsed;
+            }
+        }
+        mix->ns[strategy] = best * 1e9 / mix->queries.count;
+    }
+}
+
+static
+Strategy winner(Query_Mix *mix) {
+    Strategy best = 0;
+    for (Strategy strategy = 1; strategy < Strategy_NumberOfElements; strategy++) {
+        if (mix->ns[strategy] < mix->ns[best]) {
+            best = strategy;
+        }
+    }
+    return best;
+}
+
+static
+void usage(const char *program) {
+    fprintf(stderr, "Usage: %s [--reps N] [--json <file>] <file>...\n", program);
+}
+
+int main(int argc, char **argv) {
+    size_t reps = 5;
+    const char *json = NULL;
+    size_t files = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+            reps = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json = argv[++i];
+        } else if (argv[i][0] == '-') {
+            usage(argv[0]);
+            return 1;
+        } else {
+            if (!collect_file(argv[i])) {
+                return 1;
+            }
+            files++;
+        }
+    }
+    if (files == 0 || reps == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    build_mixes();
+
+    printf("%-22s %-7s %9s %6s", "lookup", "mix", "queries", "hits");
+    for (Strategy strategy = 0; strategy < Strategy_NumberOfElements; strategy++) {
+        printf(" %9s", strategy_names[strategy]);
+    }
+    printf("  %s\n", "winner (ns/lookup)");
+    for (Lookup lookup = 0; lookup < Lookup_NumberOfElements; lookup++) {
+        for (Mix m = 0; m < Mix_NumberOfElements; m++) {
+            Query_Mix *mix = &mixes[lookup][m];
+            if (mix->queries.count == 0) {
+                continue;
+            }
+            time_mix(lookup, mix, reps);
+            printf("%-22s %-7s %9zu %5.1f%%", lookup_names[lookup], mix_names[m],
+                   mix->queries.count, 100.0 * mix->hits / mix->queries.count);
+            for (Strategy strategy = 0; strategy < Strategy_NumberOfElements; strategy++) {
+                printf(" %9.2f", mix->ns[strategy]);
+            }
+            printf("  %s\n", strategy_names[winner(mix)]);
+        }
+    }
+
+    if (json != NULL) {
+        FILE *out = fopen(json, "w");
+        if (out == NULL) {
+            fprintf(stderr, "ERROR: Could not open %s\n", json);
+            return 1;
+        }
+        fprintf(out, "{\"reps\":%zu,\"results\":[", reps);
+        bool first = true;
+        for (Lookup lookup = 0; lookup < Lookup_NumberOfElements; lookup++) {
+            for (Mix m = 0; m < Mix_NumberOfElements; m++) {
+                Query_Mix *mix = &mixes[lookup][m];
+                if (mix->queries.count == 0) {
+                    continue;
+                }
+                fprintf(out, "%s\n{\"lookup\":\"%s\",\"mix\":\"%s\",\"queries\":%zu,\"hits\":%zu,\"ns_per_lookup\":{",
+                        first ? "" : ",", lookup_names[lookup], mix_names[m], mix->queries.count, mix->hits);
+                for (Strategy strategy = 0; strategy < Strategy_NumberOfElements; strategy++) {
+                    fprintf(out, "%s\"%s\":%.3f", strategy > 0 ? "," : "", strategy_names[strategy], mix->ns[strategy]);
+                }
+                fprintf(out, "},\"winner\":\"%s\"}", strategy_names[winner(mix)]);
+                first = false;
+            }
+        }
+        fprintf(out, "\n]}\n");
+        fclose(out);
+    }
+
+    for (Lookup lookup = 0; lookup < Lookup_NumberOfElements; lookup++) {
+        free(collected[lookup].items);
+        for (Mix m = 0; m < Mix_NumberOfElements; m++) {
+            free(mixes[lookup][m].queries.items);
+            free(mixes[lookup][m].strings);
+        }
+    }
+    free(pool.items);
+    return 0;
+}
@@ -0,0 +1,496 @@
+// VM benchmark: the register bytecode of src/vm.h against a naive tree
+// walking interpreter of the same checked AST.
+//
+//     make bench
+//     ./out/bench_vm [--reps N] <file>...
+//
+// Every #entrypoint of the files is compiled once and then run `reps` times
+// by both, the report gives the median time of a run. The tree walker keeps
+// its locals in a slot per Decl id and looks up the type of every node it
+// evaluates, like an interpreter without a compile step has to. Both have to
+// end up with the same locals, or the benchmark fails.
+//
+// The lowering of the same entrypoints into SSA form, see src/ssa.h, is
+// timed as well and reported as SSA instructions per second, and so is
+// ssa_optimize on the lowered form. The SSA interpreter runs the form before
+// and after the optimization, both have to end up with the locals of the VM.
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/ast_pool.h"
+#include "../src/checker.h"
+#include "../src/lexer.h"
+#include "../src/parser.h"
+#include "../src/resolver.h"
+#include "../src/ssa.h"
+#include "../src/vm.h"
+
+typedef struct {
+    double *items;
+    size_t count;
+    size_t capacity;
+} Samples;
+
+typedef struct {
+    Checker *checker;
+    // by Decl id
+    Vm_Value *slots;
+} Walker;
+
+static Writer err;
+
+static
+double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static
+int _compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static
+double median(Samples *samples) {
+    qsort(samples->items, samples->count, sizeof(double), _compare_doubles);
+    return samples->items[samples->count / 2];
+}
+
+static
+bool read_file(const char *filename, String_Builder *sb) {
+    FILE *file = fopen(filename, "r");
+    if (file == NULL) {
+        fprintf(stderr, "ERROR: Could not open %s\n", filename);
+        return false;
+    }
+    sb->count = 0;
+    char buffer[64*1024];
+    size_t count;
+    while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        da_append_many(sb, buffer, count);
+    }
+    fclose(file);
+    return true;
+}
+
+static
+Vm_Value walk_narrow(Walker *walker, Vm_Value value, Type_Id type) {
+    if (type == TYPE_NUMBER(Nc_f32)) {
+        value.f = (float)value.f;
+    } else if (types_is_integer(type)) {
+        Lex_NumberClass nclass = types_info(&walker->checker->table, type)->nclass;
+        int bits = types_class_bits(nclass);
+        if (bits < 64 && IS_UNSIGNED_CLASS(nclass)) {
+            value.u &= ((uint64_t)1 << bits) - 1;
+        } else if (bits < 64) {
+            value.i = (int64_t)(value.u << (64 - bits)) >> (64 - bits);
+        }
+    }
+    return value;
+}
+
+static
+bool is_plain(Type_Id type) {
+    return type == TYPE_NUMBER(Nc_Number) || type == TYPE_NUMBER(Nc_FloatingPointNumber);
+}
+
+static Vm_Value walk_expr(Walker *walker, Ast_Expr *expr, Type_Id as);
+
+static
+void walk_block(Walker *walker, Ast_Block *block) {
+    for (size_t i = 0; i < block->stmts.count; i++) {
+        Ast_Stmt *stmt = block->stmts.items[i];
+        if (stmt->kind == Decl_kind) {
+            Type_Id type = check_type_of(walker->checker, stmt->id);
+            Vm_Value value = {0};
+            if (stmt->Decl.init != NULL) {
+                value = walk_expr(walker, stmt->Decl.init, type);
+            }
+            walker->slots[stmt->id] = value;
+        } else {
+            walk_expr(walker, stmt->Expr.expr, Type_Void);
+        }
+    }
+}
+
+// The operands are evaluated in `type`, like the VM picks its instruction
+static
+Vm_Value walk_binary(BinaryOp op, Type_Id type, bool is_unsigned, Vm_Value a, Vm_Value b) {
+    Vm_Value result = {0};
+    if (types_is_float(type)) {
+        switch (op) {
+            case Bo_Plus: result.f = a.f + b.f; break;
+            case Bo_Minus: result.f = a.f - b.f; break;
+            case Bo_Mul: result.f = a.f * b.f; break;
+            case Bo_Div: result.f = a.f / b.f; break;
+            case Bo_Mod: result.f = fmod(a.f, b.f); break;
+            case Bo_Eq: result.i = a.f == b.f; break;
+            case Bo_Ne: result.i = a.f != b.f; break;
+            case Bo_Lt: result.i = a.f < b.f; break;
+            case Bo_Le: result.i = a.f <= b.f; break;
+            case Bo_Gt: result.i = a.f > b.f; break;
+            case Bo_Ge: result.i = a.f >= b.f; break;
+            default: assert(false && "unreachable");
+        }
+        return result;
+    }
+    switch (op) {
+        case Bo_Plus: result.u = a.u + b.u; break;
+        case Bo_Minus: result.u = a.u - b.u; break;
+        case Bo_Mul: result.u = a.u * b.u; break;
+        case Bo_Div:
+            result.u = is_unsigned ? a.u / b.u : b.i == -1 ? -a.u : (uint64_t)(a.i / b.i);
+            break;
+        case Bo_Mod:
+            result.u = is_unsigned ? a.u % b.u : b.i == -1 ? 0 : (uint64_t)(a.i % b.i);
+            break;
+        case Bo_Shl: result.u = a.u << (b.u & 63); break;
+        case Bo_Shr: result.u = is_unsigned ? a.u >> (b.u & 63) : (uint64_t)(a.i >> (b.u & 63)); break;
+        case Bo_BAnd: result.u = a.u & b.u; break;
+        case Bo_BOr: result.u = a.u | b.u; break;
+        case Bo_BXor: result.u = a.u ^ b.u; break;
+        case Bo_Eq: result.i = a.u == b.u; break;
+        case Bo_Ne: result.i = a.u != b.u; break;
+        case Bo_Lt: result.i = is_unsigned ? a.u < b.u : a.i < b.i; break;
+        case Bo_Le: result.i = is_unsigned ? a.u <= b.u : a.i <= b.i; break;
+        case Bo_Gt: result.i = is_unsigned ? a.u > b.u : a.i > b.i; break;
+        case Bo_Ge: result.i = is_unsigned ? a.u >= b.u : a.i >= b.i; break;
+        default: assert(false && "unreachable");
+    }
+    return result;
+}
+
+static
+bool walk_unsigned(Walker *walker, Type_Id type) {
+    return types_is_integer(type) && IS_UNSIGNED_CLASS(types_info(&walker->checker->table, type)->nclass);
+}
+
+static
+Vm_Value walk_expr(Walker *walker, Ast_Expr *expr, Type_Id as) {
+    Type_Id type = check_type_of(walker->checker, expr->id);
+    Vm_Value value = {0};
+    switch (expr->kind) {
+        case Literal_kind:
+            switch (expr->Literal.kind) {
+                case L_Integer: value.u = expr->Literal.integer; break;
+                case L_Float:
+                    value.f = expr->Literal.nclass == Nc_f32 ? (float)expr->Literal.floating : expr->Literal.floating;
+                    break;
+                case L_Boolean: value.i = expr->Literal.boolean; break;
+                case L_Char: value.i = expr->Literal.wchar; break;
+                default: break;
+            }
+            break;
+        case Path_kind:
+            return walker->slots[expr->Path.path.decl->id];
+        case Paren_kind:
+            return walk_expr(walker, expr->Paren.expr, as);
+        case Unary_kind: {
+            Type_Id result = is_plain(type) && !is_plain(as) ? as : type;
+            value = walk_expr(walker, expr->Unary.expr, result);
+            switch (expr->Unary.op) {
+                case Uo_Minus:
+                    if (types_is_float(result)) value.f = -value.f; else value.u = -value.u;
+                    break;
+                case Uo_BitwiseNot: value.u = ~value.u; break;
+                case Uo_Not: value.i = !value.i; break;
+                default: break;
+            }
+            return walk_narrow(walker, value, result);
+        }
+        case Binary_kind: {
+            BinaryOp op = expr->Binary.op;
+            if (op == Bo_And || op == Bo_Or) {
+                value = walk_expr(walker, expr->Binary.lhs, Type_Bool);
+                if ((op == Bo_And) == (value.i != 0)) {
+                    value = walk_expr(walker, expr->Binary.rhs, Type_Bool);
+                }
+                return value;
+            }
+            Type_Id lhs = check_type_of(walker->checker, expr->Binary.lhs->id);
+            Type_Id rhs = check_type_of(walker->checker, expr->Binary.rhs->id);
+            bool shift = op == Bo_Shl || op == Bo_Shr;
+            Type_Id operands = lhs;
+            if (!shift && (lhs == TYPE_NUMBER(Nc_Number) || (lhs == TYPE_NUMBER(Nc_FloatingPointNumber) && rhs != TYPE_NUMBER(Nc_Number)))) {
+                operands = rhs;
+            }
+            Vm_Value a = walk_expr(walker, expr->Binary.lhs, operands);
+            Vm_Value b = walk_expr(walker, expr->Binary.rhs, shift ? rhs : operands);
+            value = walk_narrow(walker, walk_binary(op, operands, walk_unsigned(walker, operands), a, b), type);
+        } break;
+        case Assign_kind: {
+            Ast_Expr *lhs = expr->Assign.lhs;
+            while (lhs->kind == Paren_kind) {
+                lhs = lhs->Paren.expr;
+            }
+            Vm_Value *slot = &walker->slots[lhs->Path.path.decl->id];
+            BinaryOp op = check_compound_operator(expr->Assign.op);
+            Type_Id rhs = check_type_of(walker->checker, expr->Assign.rhs->id);
+            if (op == Bo_Invalid) {
+                *slot = walk_expr(walker, expr->Assign.rhs, type);
+            } else if (op == Bo_And || op == Bo_Or) {
+                if ((op == Bo_And) == (slot->i != 0)) {
+                    *slot = walk_expr(walker, expr->Assign.rhs, type);
+                }
+            } else {
+                bool shift = op == Bo_Shl || op == Bo_Shr;
+                Vm_Value b = walk_expr(walker, expr->Assign.rhs, shift ? rhs : type);
+                *slot = walk_narrow(walker, walk_binary(op, type, walk_unsigned(walker, type), *slot, b), type);
+            }
+            return *slot;
+        }
+        case If_kind:
+            if (walk_expr(walker, expr->If.condition, Type_Bool).i) {
+                walk_block(walker, expr->If.if_branch);
+            } else if (expr->If.else_block != NULL) {
+                walk_expr(walker, expr->If.else_block, as);
+            }
+            return value;
+        case Block_kind:
+            walk_block(walker, expr->Block.block);
+            return value;
+        default:
+            assert(false && "the VM does not run it either");
+    }
+    // a plain value takes the type of its place, see _convert of the VM
+    if (is_plain(type) && type != as && !is_plain(as)) {
+        if (type == TYPE_NUMBER(Nc_Number) && types_is_float(as)) {
+            value.f = (double)value.i;
+        }
+        value = walk_narrow(walker, value, as);
+    } else if (type == TYPE_NUMBER(Nc_Number) && as == TYPE_NUMBER(Nc_FloatingPointNumber)) {
+        value.f = (double)value.i;
+    }
+    return value;
+}
+
+static
+bool same_value(Vm_Value a, Vm_Value b, Type_Id type) {
+    if (types_is_float(type)) {
+        return a.f == b.f || (isnan(a.f) && isnan(b.f));
+    }
+    return a.u == b.u;
+}
+
+// Runs `function` in the SSA interpreter, false if one of its locals differs
+// from the one the VM ended up with
+static
+bool same_as_vm(const char *filename, const char *form, Ssa_Function *function, Type_Table *types,
+                Ssa_Values *values, Vm *vm, Vm_Chunk *chunk) {
+    if (ssa_execute(function, types, values) >= 0) {
+        fprintf(stderr, "ERROR: %s: the %s SSA form divides by zero\n", filename, form);
+        return false;
+    }
+    Ssa_Id ret = function->instrs.count - 1;
+    while (function->instrs.items[ret].op != Ssa_Ret) {
+        ret--;
+    }
+    Ssa_Instr *instr = &function->instrs.items[ret];
+    // the locals are in the order of their Decls in both
+    assert(instr->b == chunk->locals.count);
+    bool success = true;
+    for (uint32_t i = 0; i < instr->b; i++) {
+        Vm_Local *local = &chunk->locals.items[i];
+        Ssa_Id value = function->operands.items[instr->a + i];
+        Vm_Value bits = { .u = value != SSA_NONE ? values->items[value].u : 0 };
+        if (value != SSA_NONE && !same_value(vm->registers[local->reg], bits, local->type)) {
+            fprintf(stderr, "ERROR: %s: the VM and the %s SSA form disagree on %.*s\n",
+                    filename, form, (int)local->name.count, local->name.items);
+            success = false;
+        }
+    }
+    return success;
+}
+
+// Benchmarks every entrypoint of `filename`, false if it does not check or
+// the two disagree
+static
+bool bench_file(const char *filename, size_t reps) {
+    String_Builder content = {0};
+    if (!read_file(filename, &content)) {
+        return false;
+    }
+    bool success;
+    Lex_TokenizeResult result = lexer_tokenize_source(
+        sv_from_cstring(filename, strlen(filename)),
+        sb_to_string_view(&content),
+        &success
+    );
+    if (!success) {
+        fprintf(stderr, "ERROR: %s does not tokenize\n", filename);
+        return false;
+    }
+    Ast_Pool pool = {0};
+    Parser_Cfg cfg = {0};
+    Ast_Source source;
+    Parser_Error error;
+    if (!parser_parse_source(&pool, result.stream, &cfg, &source, &error)) {
+        fprintf(stderr, "ERROR: %s does not parse\n", filename);
+        return false;
+    }
+    Resolver resolver = {0};
+    Checker checker = {0};
+    success = resolve_source(&resolver, &source, &err);
+    success = check_source(&checker, &pool, &source, &err) && success;
+    writer_flush(&err);
+    if (!success) {
+        fprintf(stderr, "ERROR: %s does not check\n", filename);
+        return false;
+    }
+
+    Vm_Compiler compiler = {0};
+    Vm_Chunk chunk = {0};
+    Vm vm = {0};
+    Walker walker = { .checker = &checker, .slots = calloc(pool.ids, sizeof(Vm_Value)) };
+    Ssa_Lowerer lowerer = {0};
+    Ssa_Function function = {0};
+    Ssa_Optimizer optimizer = {0};
+    Ssa_Values values = {0};
+    Samples vm_samples = {0}, walker_samples = {0}, lower_samples = {0}, optimize_samples = {0};
+    for (size_t i = 0; i < source.count && success; i++) {
+        Ast_Item *item = source.items[i];
+        if (item->kind != RunBlock_kind) {
+            continue;
+        }
+        if (!vm_compile(&compiler, &checker, item->RunBlock.block, &chunk, &err)) {
+            writer_flush(&err);
+            success = false;
+            break;
+        }
+        vm_samples.count = 0;
+        walker_samples.count = 0;
+        lower_samples.count = 0;
+        optimize_samples.count = 0;
+        size_t lowered = 0;
+        for (size_t rep = 0; rep < reps; rep++) {
+            double lower_start = now();
+            ssa_lower(&lowerer, &checker, item->RunBlock.block, &function, &err);
+            da_append(&lower_samples, now() - lower_start);
+            lowered = function.order.count;
+
+            double optimize_start = now();
+            ssa_optimize(&optimizer, &function, &checker.table);
+            da_append(&optimize_samples, now() - optimize_start);
+
+            double start = now();
+            int64_t failed = vm_execute(&vm, &chunk);
+            double middle = now();
+            // the walker would trap on it
+            if (failed >= 0) {
+                fprintf(stderr, "ERROR: %s divides by zero\n", filename);
+                success = false;
+                break;
+            }
+            walk_block(&walker, item->RunBlock.block);
+            double end = now();
+            da_append(&vm_samples, middle - start);
+            da_append(&walker_samples, end - middle);
+        }
+        for (size_t j = 0; j < chunk.locals.count && success; j++) {
+            Vm_Local *local = &chunk.locals.items[j];
+            Ast_Stmt *decl = NULL;
+            // the locals are in the order of their Decls
+            for (size_t k = 0; k < item->RunBlock.block->stmts.count; k++) {
+                Ast_Stmt *stmt = item->RunBlock.block->stmts.items[k];
+                if (stmt->kind == Decl_kind && stmt->Decl.ident.items == local->name.items
+                        && check_type_of(&checker, stmt->id) == local->type
+                        && compiler.locals.items[stmt->id] == local->reg) {
+                    decl = stmt;
+                }
+            }
+            assert(decl != NULL);
+            if (!same_value(vm.registers[local->reg], walker.slots[decl->id], local->type)) {
+                fprintf(stderr, "ERROR: %s: the VM and the walker disagree on %.*s\n",
+                        filename, (int)local->name.count, local->name.items);
+                success = false;
+            }
+        }
+        if (!success) {
+            break;
+        }
+        size_t optimized = function.order.count;
+        ssa_lower(&lowerer, &checker, item->RunBlock.block, &function, &err);
+        success = same_as_vm(filename, "lowered", &function, &checker.table, &values, &vm, &chunk);
+        ssa_optimize(&optimizer, &function, &checker.table);
+        success = same_as_vm(filename, "optimized", &function, &checker.table, &values, &vm, &chunk) && success;
+        if (!success) {
+            break;
+        }
+        double vm_median = median(&vm_samples);
+        double walker_median = median(&walker_samples);
+        double lower_median = median(&lower_samples);
+        double optimize_median = median(&optimize_samples);
+        printf("%-24s %10zu %12.3f %12.3f %10.1fx %12.1f %10zu %12.3f %12.1f %10zu %12.3f\n",
+               filename, chunk.code.count, vm_median * 1e3, walker_median * 1e3,
+               walker_median / vm_median, chunk.code.count / vm_median * 1e-6,
+               lowered, lower_median * 1e3, lowered / lower_median * 1e-6,
+               optimized, optimize_median * 1e3);
+        for (int pass = 0; pass < Ssa_NumberOfPasses; pass++) {
+            Ssa_PassStats *stats = &optimizer.stats[pass];
+            printf("    %-20s %6llu runs %10llu removed %12.3f ms\n", ssa_pass_names[pass],
+                   (unsigned long long)stats->runs, (unsigned long long)stats->removed, stats->ns * 1e-6);
+        }
+    }
+
+    free(vm_samples.items);
+    free(walker_samples.items);
+    free(lower_samples.items);
+    free(optimize_samples.items);
+    free(values.items);
+    ssa_optimizer_free(&optimizer);
+    ssa_lowerer_free(&lowerer);
+    ssa_function_free(&function);
+    free(walker.slots);
+    vm_free(&vm);
+    vm_chunk_free(&chunk);
+    vm_compiler_free(&compiler);
+    checker_free(&checker);
+    resolver_free(&resolver);
+    ast_pool_free(&pool);
+    lexer_token_stream_free(&result.stream);
+    lexer_free_interned();
+    free(content.items);
+    return success;
+}
+
+void usage(const char *program) {
+    fprintf(stderr, "Usage: %s [--reps N] <file>...\n", program);
+}
+
+int main(int argc, char **argv) {
+    size_t reps = 20;
+    const char *filenames[64];
+    size_t count = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+            reps = strtoul(argv[++i], NULL, 10);
+        } else if (argv[i][0] == '-') {
+            usage(argv[0]);
+            return 1;
+        } else {
+            assert(count < sizeof(filenames) / sizeof(filenames[0]) && "too many input files");
+            filenames[count++] = argv[i];
+        }
+    }
+    if (count == 0 || reps == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    writer_init(&err, 2);
+
+    printf("%-24s %10s %12s %12s %11s %12s %10s %12s %12s %10s %12s\n",
+           "file", "instrs", "vm p50 ms", "walk p50 ms", "speedup", "Minstr/s",
+           "ssa instrs", "lower p50 ms", "Mssa/s", "opt instrs", "opt p50 ms");
+    bool success = true;
+    for (size_t i = 0; i < count; i++) {
+        success = bench_file(filenames[i], reps) && success;
+    }
+    return success ? 0 : 1;
+}
@@ -0,0 +1,179 @@
+import os
+import re
+
+from dataclasses import dataclass, field
+from typing import List
+
+from Templ8.cache import depend
+
+# Reads the `ENUMERATE_*_NODES` X-macros out of AST.h, so templates can
+# generate code that follows the node definitions instead of repeating them.
+
+CHILD_TYPES = {
+    'Ast_Expr*': 'expr',
+    'Ast_Type*': 'type',
+    'Ast_Stmt*': 'stmt',
+    'Ast_Block*': 'block',
+    'Ast_Item*': 'item',
+    'Ast_Exprs': 'exprs',
+    'Ast_Tys': 'tys',
+}
+
+LIST_ELEMENT = {
+    'exprs': 'expr',
+    'tys': 'type',
+}
+
+NODE_CLASS = {
+    'expr': 'Node_Expr',
+    'type': 'Node_Type',
+    'stmt': 'Node_Stmt',
+    'block': 'Node_Block',
+    'item': 'Node_Item',
+}
+
+@dataclass
+class Field:
+    name: str
+    ctype: str
+    # `expr`, `type`, `block`, ... for single child nodes, `exprs`, `tys`
+    # for node lists and None for plain data
+    child: str|None = None
+    # names of the inline enum, if the field is declared as `enum { ... }`
+    variants: List[str] = field(default_factory=list)
+    # position within the anonymous union the field is declared in
+    union_member: int|None = None
+
+    def is_child(self):
+        return self.child is not None
+
+    def is_list(self):
+        return self.child in LIST_ELEMENT
+
+    def element(self):
+        return LIST_ELEMENT.get(self.child, self.child)
+
+    def node_class(self):
+        return NODE_CLASS[self.element()]
+
+@dataclass
+class Node:
+    name: str
+    fields: List[Field]
+
+    def children(self):
+        return [f for f in self.fields if f.is_child()]
+
+    def data(self):
+        return [f for f in self.fields if not f.is_child() and f.union_member is None]
+
+    def union(self):
+        return [f for f in self.fields if f.union_member is not None]
+
+    def kind(self):
+        return f'{self.name}_kind'
+
+@dataclass
+class Schema:
+    exprs: List[Node]
+    types: List[Node]
+    stmts: List[Node]
+    items: List[Node]
+
+    def classes(self):
+        return [
+            ('expr', 'Ast_Expr', 'Node_Expr', self.exprs),
+            ('type', 'Ast_Type', 'Node_Type', self.types),
+            ('stmt', 'Ast_Stmt', 'Node_Stmt', self.stmts),
+            ('item', 'Ast_Item', 'Node_Item', self.items),
+        ]
+
+def _macro_body(source: str, name: str) -> str:
+    match = re.search(rf'#define\s+{name}\b(.*?)(?<!\\)\n', source, re.S)
+    if match is None:
+        raise RuntimeError(f'could not find X-macro {name!r}')
+    return match.group(1).replace('\\\n', '\n').replace('\\', '')
+
+def _split_toplevel(body: str, sep: str) -> List[str]:
+    parts = []
+    level = 0
+    current = ''
+    for chr in body:
+        if chr in '({':
+            level += 1
+        elif chr in ')}':
+            level -= 1
+        if chr == sep and level == 0:
+            parts.append(current)
+            current = ''
+            continue
+        current += chr
+    if current.strip() != '':
+        parts.append(current)
+    return parts
+
+def _strip_braces(body: str) -> str:
+    body = body.strip()
+    assert body.startswith('{') and body.endswith('}'), f'expected braced body {body!r}'
+    return body[1:-1]
+
+def _parse_declaration(decl: str) -> List[Field]:
+    decl = ' '.join(decl.split())
+    if decl == '':
+        return []
+    if decl.startswith('union'):
+        # anonymous unions are flattened into their parent, they only
+        # share storage
+        fields = []
+        for inner in _split_toplevel(_strip_braces(decl[len('union'):]), ';'):
+            fields.extend(_parse_declaration(inner))
+        for idx, f in enumerate(fields):
+            f.union_member = idx
+        return fields
+    if decl.startswith('enum'):
+        body, name = decl[len('enum'):].rsplit('}', 1)
+        variants = [v.strip() for v in body.strip().lstrip('{').split(',') if v.strip() != '']
+        return [Field(name.strip(), 'enum', None, variants)]
+
+    match = re.fullmatch(r'(.*?)\s*(\**)\s*([A-Za-z_][A-Za-z_0-9]*)', decl)
+    if match is None:
+        raise RuntimeError(f'unsupported field declaration {decl!r}')
+    base, pointer, name = match.groups()
+    ctype = base.strip() + pointer
+    return [Field(name, ctype, CHILD_TYPES.get(ctype))]
+
+def _parse_nodes(body: str) -> List[Node]:
+    nodes = []
+    for match in re.finditer(r'_NODE\(\s*([A-Za-z_][A-Za-z_0-9]*)\s*,', body):
+        start = match.end()
+        level = 1
+        end = start
+        while level > 0:
+            if body[end] == '(':
+                level += 1
+            elif body[end] == ')':
+                level -= 1
+            end += 1
+        fields = []
+        for decl in _split_toplevel(_strip_braces(body[start:end-1]), ';'):
+            fields.extend(_parse_declaration(decl))
+        nodes.append(Node(match.group(1), fields))
+    return nodes
+
+def load(template_filename: str, header: str) -> Schema:
+    path = os.path.join(os.path.dirname(template_filename), header)
+    depend(path)
+    with open(path, 'r') as f:
+        source = f.read()
+    return Schema(
+        exprs=_parse_nodes(_macro_body(source, 'ENUMERATE_EXPR_NODES')),
+        types=_parse_nodes(_macro_body(source, 'ENUMERATE_TYPE_NODES')),
+        stmts=_parse_nodes(_macro_body(source, 'ENUMERATE_STMT_NODES')),
+        items=_parse_nodes(_macro_body(source, 'ENUMERATE_ITEM_NODES')),
+    )
+
+if __name__ == '__main__':
+    schema = load(os.path.join(os.path.dirname(__file__), '../src/x'), 'AST.h')
+    for cls, _, _, nodes in schema.classes():
+        for node in nodes:
+            print(cls, node.name, [(f.name, f.ctype, f.child) for f in node.fields])
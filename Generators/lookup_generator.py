@@ -0,0 +1,202 @@
+import math
+import random
+
+from dataclasses import dataclass
+from typing import List, Optional
+
+from Templ8.cache import memoize
+from phf_generator import format_to_string_literal
+
+# Tables for the alternative lookup strategies of lookup.templ8. They are
+# generated next to the SipHash perfect hashes of phf.templ8, so the lookup
+# benchmark can compare both on the same keys.
+
+@dataclass
+class Entry:
+    key: int | str
+    value: str
+
+    def literal(self) -> str:
+        if isinstance(self.key, str):
+            return format_to_string_literal(self.key)
+        return f'0x{self.key:08x}'
+
+    def to_bytes(self) -> bytes:
+        if isinstance(self.key, str):
+            return self.key.encode()
+        return self.key.to_bytes(4, byteorder='little').rstrip(b'\x00')
+
+    def first(self) -> int:
+        return self.to_bytes()[0]
+
+    def length(self) -> int:
+        return len(self.to_bytes())
+
+    def fold(self) -> int:
+        # keep in sync with the multiply-shift function in lookup.templ8
+        if isinstance(self.key, int):
+            return self.key
+        data = self.to_bytes()
+        folded = int.from_bytes(data[:4].ljust(4, b'\x00'), byteorder='little')
+        return (folded ^ (len(data) << 24)) & 0xffffffff
+
+@dataclass
+class Range:
+    index: int
+    start: int
+    count: int
+
+@dataclass
+class LookupState:
+    entries: List[Entry]
+    invalid: str
+    is_string: bool
+
+    by_first: List[Entry]
+    first_ranges: List[Range]
+
+    by_length: List[Entry]
+    length_ranges: List[Range]
+    max_length: int
+
+    multiplier: int
+    shift: int
+    table: List[Optional[Entry]]
+
+    # rows[first byte] and columns[row][second byte], None if two keys
+    # share their first two bytes
+    rows: Optional[List[int]]
+    strategy: str
+
+def ranges(entries: List[Entry], key) -> tuple[List[Entry], List[Range]]:
+    entries = sorted(entries, key=key)
+    result: List[Range] = []
+    for i, entry in enumerate(entries):
+        if result and result[-1].index == key(entry):
+            result[-1].count += 1
+        else:
+            result.append(Range(index=key(entry), start=i, count=1))
+    return entries, result
+
+@memoize
+def multiply_shift(entries: List[Entry]) -> tuple[int, int, List[Optional[Entry]]]:
+    folded = [entry.fold() for entry in entries]
+    assert len(set(folded)) == len(folded), 'multiply-shift needs distinct folded keys'
+
+    rng = random.Random(1234567890)
+    bits = max(1, math.ceil(math.log2(len(entries))))
+    while bits <= 16:
+        for _ in range(1 << 14):
+            multiplier = rng.getrandbits(32) | 1
+            shift = 32 - bits
+            slots = [((key * multiplier) & 0xffffffff) >> shift for key in folded]
+            if len(set(slots)) != len(slots):
+                continue
+            table: List[Optional[Entry]] = [None] * (1 << bits)
+            for slot, entry in zip(slots, entries):
+                table[slot] = entry
+            return multiplier, shift, table
+        bits += 1
+    raise RuntimeError('no multiply-shift function found')
+
+def two_level_rows(entries: List[Entry]) -> Optional[List[int]]:
+    pairs = [entry.to_bytes()[:2] for entry in entries]
+    if len(set(pairs)) != len(pairs):
+        return None
+    rows: List[int] = []
+    for entry in entries:
+        if entry.first() not in rows:
+            rows.append(entry.first())
+    return rows
+
+# Cheapest correct strategy for a uint32_t keyed map, in the order of the
+# lookup benchmark: a multiply-shift hash into a table at most four times
+# the size of the map, a table indexed by the key itself (it needs a branch
+# for wider keys, which mispredicts on the mixed punctuator stream), a table
+# per byte and the switch, which always works
+MAX_TWO_LEVEL_ROWS = 4
+
+def select_strategy(state: LookupState) -> str:
+    if state.is_string:
+        return 'switch'
+    if len(state.table) <= 4 * len(state.entries):
+        return 'mulshift'
+    if max(entry.key for entry in state.entries) < 256:
+        return 'direct'
+    if state.rows is not None and len(state.rows) <= MAX_TWO_LEVEL_ROWS:
+        return 'two_level'
+    return 'switch'
+
+def init_state(entries: List[Entry], invalid: str) -> LookupState:
+    assert len(entries) < 255, 'lookup tables store entry indices in a byte'
+    by_first, first_ranges = ranges(entries, Entry.first)
+    by_length, length_ranges = ranges(entries, Entry.length)
+    multiplier, shift, table = multiply_shift(entries)
+    state = LookupState(
+        entries=entries,
+        invalid=invalid,
+        is_string=isinstance(entries[0].key, str),
+        by_first=by_first,
+        first_ranges=first_ranges,
+        by_length=by_length,
+        length_ranges=length_ranges,
+        max_length=max(entry.length() for entry in entries),
+        multiplier=multiplier,
+        shift=shift,
+        table=table,
+        rows=two_level_rows(entries),
+        strategy=''
+    )
+    state.strategy = select_strategy(state)
+    return state
+
+def init_enum(enum, variant_prefix: str, invalid: str) -> LookupState:
+    entries = [Entry(variant.data(), f'{variant_prefix}_{variant.name}') for variant in enum]
+    return init_state(entries, invalid)
+
+def init_set(elements) -> LookupState:
+    # sorted, sets of strings iterate in a different order every run
+    entries = [Entry(element, 'true') for element in sorted(elements)]
+    return init_state(entries, 'false')
+
+def char_literal(byte: int) -> str:
+    char = chr(byte)
+    if char in '\'\\':
+        return f"'\\{char}'"
+    if 32 <= byte <= 126:
+        return f"'{char}'"
+    return f'0x{byte:02x}'
+
+def iter_first_groups(state: LookupState):
+    for r in state.first_ranges:
+        yield char_literal(r.index), state.by_first[r.start:r.start + r.count]
+
+def iter_table(state: LookupState):
+    for entry in state.table:
+        if entry is None:
+            yield ('""' if state.is_string else '0'), state.invalid
+        else:
+            yield entry.literal(), entry.value
+
+def iter_first_ranges(state: LookupState):
+    for r in state.first_ranges:
+        yield char_literal(r.index), r.start, r.count
+
+def iter_length_ranges(state: LookupState):
+    for r in state.length_ranges:
+        yield r.index, r.start, r.count
+
+def iter_direct(state: LookupState):
+    for entry in state.entries:
+        yield f'0x{entry.key:02x}', entry.value
+
+def iter_rows(state: LookupState):
+    assert state.rows is not None
+    for row, first in enumerate(state.rows):
+        yield char_literal(first), row
+
+def iter_columns(state: LookupState):
+    assert state.rows is not None
+    for first in state.rows:
+        yield [(char_literal(entry.to_bytes()[1]) if entry.length() > 1 else '0', i)
+               for i, entry in enumerate(state.entries) if entry.first() == first]
@@ -1,11 +1,15 @@
+import multiprocessing
 import numpy as np
+import os
 import siphash
-import functools
 import random
 
 from dataclasses import dataclass
+from concurrent.futures import ProcessPoolExecutor
 from typing import Any, List, Tuple
 
+from Templ8.cache import memoize
+
 def displace(f1: np.uint32, f2: np.uint32, d1: np.uint32, d2: np.uint32) -> np.uint32:
     return d2 + f1 * d1 + f2
 
@@ -22,15 +26,57 @@ class HashState:
     key: int
     disps: List[Tuple[int, int]]
     idx_map: List[int]
+    hash: str = 'siphash'
 
 def ikey_to_bkey(key: int):
     return (key << 8 * 8).to_bytes(length=16, byteorder='little')
 
-def my_hash(x: bytes, key: int) -> Hashes: 
-    bkey = ikey_to_bkey(key)
-    hasher = siphash.siphash24(bkey)
+MASK64 = (1 << 64) - 1
+HASH_P0 = 0xa0761d6478bd642f
+HASH_P1 = 0xe7037ed1a0b428db
+
+def _mix(a: int, b: int) -> int:
+    r = a * b
+    return (r ^ (r >> 64)) & MASK64
+
+def fast_hash(x: bytes, seed: int) -> int:
+    # keep in sync with hash_bytes in src/hash.h
+    read4 = lambda i: int.from_bytes(x[i:i + 4], byteorder='little')
+    read8 = lambda i: int.from_bytes(x[i:i + 8], byteorder='little')
+    length = len(x)
+    seed ^= _mix(seed ^ HASH_P0, HASH_P1)
+    if length <= 16:
+        if length >= 4:
+            shift = (length >> 3) << 2
+            a = (read4(0) << 32) | read4(shift)
+            b = (read4(length - 4) << 32) | read4(length - 4 - shift)
+        elif length > 0:
+            a = (x[0] << 16) | (x[length >> 1] << 8) | x[length - 1]
+            b = 0
+        else:
+            a = b = 0
+    else:
+        p, i = 0, length
+        while i > 16:
+            seed = _mix(read8(p) ^ HASH_P1, read8(p + 8) ^ seed)
+            p, i = p + 16, i - 16
+        a = read8(p + i - 16)
+        b = read8(p + i - 8)
+    r = (a ^ HASH_P1) * (b ^ seed)
+    return _mix((r & MASK64) ^ HASH_P0 ^ length, (r >> 64) ^ HASH_P1)
+
+def sip_hash(x: bytes, key: int) -> int:
+    hasher = siphash.siphash24(ikey_to_bkey(key))
     hasher.update(x)
-    result = hasher.hash()
+    return hasher.hash()
+
+HASH_FUNCTIONS = {
+    'siphash': sip_hash,
+    'fast': fast_hash,
+}
+
+def my_hash(x: bytes, key: int, hash: str = 'siphash') -> Hashes: 
+    result = HASH_FUNCTIONS[hash](x, key)
     lower = result & 0xffffffff
     upper = (result >> 32) & 0xffffffff
     # print(f"0x{result:x}")
@@ -42,13 +88,6 @@ def my_hash(x: bytes, key: int) -> Hashes:
     )
     return h
 
-@dataclass
-class Bucket:
-    idx: int
-    keys: List[int]
-
-NP_ZERO = np.uint32(0)
-
 def to_bytes(any: Any) -> bytes:
     match any:
         case int():
@@ -60,127 +99,253 @@ def to_bytes(any: Any) -> bytes:
         case _:
             raise Exception(f'Object of type {type(any).__name__!r} is not hashable to bytes')
 
-def generate_hash_state(entries: List[Any]) -> HashState:
+# Vectorized versions of fast_hash and sip_hash: the entries are prepared once
+# into uint64 words, every key attempt then hashes all of them with a few
+# numpy operations. numpy has no 128 bit integers, the multiply of fast_hash
+# is put together from 32 bit halves.
+
+U64 = np.uint64
+M32 = U64(0xffffffff)
+
+def _mul128(a: np.ndarray, b: np.ndarray) -> tuple[np.ndarray, np.ndarray]:
+    a0, a1 = a & M32, a >> U64(32)
+    b0, b1 = b & M32, b >> U64(32)
+    p00, p01, p10, p11 = a0 * b0, a0 * b1, a1 * b0, a1 * b1
+    mid = (p00 >> U64(32)) + (p01 & M32) + (p10 & M32)
+    lo = (p00 & M32) | (mid << U64(32))
+    hi = p11 + (p01 >> U64(32)) + (p10 >> U64(32)) + (mid >> U64(32))
+    return lo, hi
+
+def _mix_vec(a: np.ndarray, b: np.ndarray) -> np.ndarray:
+    lo, hi = _mul128(a, b)
+    return lo ^ hi
+
+def _rotl(x: np.ndarray, r: int) -> np.ndarray:
+    return (x << U64(r)) | (x >> U64(64 - r))
+
+@dataclass
+class PreparedFast:
+    a: np.ndarray
+    b: np.ndarray
+    length: np.ndarray
+    # entries longer than 16 bytes go through the scalar fast_hash
+    long: List[Tuple[int, bytes]]
+
+@dataclass
+class PreparedSip:
+    # entry indices and their message words, grouped by word count
+    groups: List[Tuple[np.ndarray, np.ndarray]]
+
+def prepare_fast(data: List[bytes]) -> PreparedFast:
+    read4 = lambda x, i: int.from_bytes(x[i:i + 4], byteorder='little')
+    a, b, long = [], [], []
+    for i, x in enumerate(data):
+        length = len(x)
+        if length > 16:
+            long.append((i, x))
+            a.append(0)
+            b.append(0)
+        elif length >= 4:
+            shift = (length >> 3) << 2
+            a.append((read4(x, 0) << 32) | read4(x, shift))
+            b.append((read4(x, length - 4) << 32) | read4(x, length - 4 - shift))
+        elif length > 0:
+            a.append((x[0] << 16) | (x[length >> 1] << 8) | x[length - 1])
+            b.append(0)
+        else:
+            a.append(0)
+            b.append(0)
+    return PreparedFast(
+        a=np.array(a, dtype=U64) ^ U64(HASH_P1),
+        b=np.array(b, dtype=U64),
+        length=np.array([len(x) for x in data], dtype=U64) ^ U64(HASH_P0),
+        long=long,
+    )
+
+def fast_hash_vec(prepared: PreparedFast, seed: int) -> np.ndarray:
+    mixed = seed ^ _mix(seed ^ HASH_P0, HASH_P1)
+    lo, hi = _mul128(prepared.a, prepared.b ^ U64(mixed))
+    result = _mix_vec(lo ^ prepared.length, hi ^ U64(HASH_P1))
+    for i, x in prepared.long:
+        result[i] = fast_hash(x, seed)
+    return result
+
+def prepare_sip(data: List[bytes]) -> PreparedSip:
+    by_words: dict[int, List[int]] = {}
+    for i, x in enumerate(data):
+        by_words.setdefault(len(x) // 8 + 1, []).append(i)
+    groups = []
+    for count, indices in sorted(by_words.items()):
+        words = np.zeros((len(indices), count), dtype=U64)
+        for row, i in enumerate(indices):
+            # the last word holds the tail and the length in its top byte
+            x = data[i]
+            tail = x[len(x) - len(x) % 8:] + bytes(7 - len(x) % 8) + bytes([len(x) & 0xff])
+            message = np.frombuffer(x[:len(x) - len(x) % 8] + tail, dtype='<u8')
+            words[row] = message
+        groups.append((np.array(indices), words))
+    return PreparedSip(groups)
+
+def sip_hash_vec(prepared: PreparedSip, key: int) -> np.ndarray:
+    # SipHash-2-4 with the 16 byte key of ikey_to_bkey, k0 = 0 and k1 = key
+    count = sum(len(indices) for indices, _ in prepared.groups)
+    result = np.zeros(count, dtype=U64)
+    for indices, words in prepared.groups:
+        v = [
+            np.full(len(indices), 0x736f6d6570736575, dtype=U64),
+            np.full(len(indices), key ^ 0x646f72616e646f6d, dtype=U64),
+            np.full(len(indices), 0x6c7967656e657261, dtype=U64),
+            np.full(len(indices), key ^ 0x7465646279746573, dtype=U64),
+        ]
+        def sipround():
+            v[0] += v[1]; v[1] = _rotl(v[1], 13); v[1] ^= v[0]; v[0] = _rotl(v[0], 32)
+            v[2] += v[3]; v[3] = _rotl(v[3], 16); v[3] ^= v[2]
+            v[0] += v[3]; v[3] = _rotl(v[3], 21); v[3] ^= v[0]
+            v[2] += v[1]; v[1] = _rotl(v[1], 17); v[1] ^= v[2]; v[2] = _rotl(v[2], 32)
+        for column in range(words.shape[1]):
+            m = words[:, column]
+            v[3] ^= m
+            sipround(); sipround()
+            v[0] ^= m
+        v[2] ^= U64(0xff)
+        sipround(); sipround(); sipround(); sipround()
+        result[indices] = v[0] ^ v[1] ^ v[2] ^ v[3]
+    return result
+
+PREPARE_FUNCTIONS = {
+    'siphash': (prepare_sip, sip_hash_vec),
+    'fast': (prepare_fast, fast_hash_vec),
+}
+
+# displacements d2 tried at once, while the table is not full the first
+# block almost always has a fit
+D2_BLOCK = 256
+
+def _first_fit(base: np.ndarray, occupied: np.ndarray, d2s: np.ndarray) -> Tuple[int, np.ndarray]|None:
+    table_len = U64(len(occupied))
+    for start in range(0, len(d2s), D2_BLOCK):
+        block = d2s[start:start + D2_BLOCK]
+        # the generated lookup computes d2 + f1 * d1 + f2 in uint32_t
+        slots = ((base[:, None] + block[None, :]) & M32) % table_len
+        fits = ~occupied[slots].any(axis=0)
+        for i in range(1, len(base)):
+            for j in range(i):
+                fits &= slots[i] != slots[j]
+        if (candidates := np.flatnonzero(fits)).size > 0:
+            return start + int(candidates[0]), slots[:, candidates[0]]
+    return None
+
+def place_buckets(hashes: np.ndarray) -> Tuple[List[Tuple[int, int]], List[int]]|None:
+    """CHD placement: buckets from largest to smallest get the first
+    displacement (d1, d2) that moves all of their keys into free slots. A
+    block of d2 is tried at once, a column per d2"""
+    table_len = len(hashes)
+    lower = hashes & M32
+    f1 = lower
+    f2 = hashes >> U64(32)
+    g = lower >> U64(16)
+
+    buckets_len = (table_len + DEFAULT_LAMBDA - 1) // DEFAULT_LAMBDA
+    bucket_of = g % U64(buckets_len)
+    # stable, equally sized buckets stay in index order
+    order = np.argsort(-np.bincount(bucket_of.astype(np.intp), minlength=buckets_len), kind='stable')
+    members = np.argsort(bucket_of, kind='stable')
+    starts = np.searchsorted(bucket_of[members], np.arange(buckets_len + 1, dtype=U64))
+
+    disps = [(0, 0)] * buckets_len
+    idx_map: List[int|None] = [None] * table_len
+    occupied = np.zeros(table_len, dtype=bool)
+    d2s = np.arange(table_len, dtype=U64)
+    for bucket in order:
+        keys = members[starts[bucket]:starts[bucket + 1]]
+        if len(keys) == 0:
+            break
+        for d1 in range(table_len):
+            base = (f1[keys] * U64(d1) + f2[keys]) & M32
+            if (fit := _first_fit(base, occupied, d2s)) is not None:
+                d2, slots = fit
+                disps[bucket] = (d1, d2)
+                occupied[slots] = True
+                for key, slot in zip(keys, slots):
+                    idx_map[int(slot)] = int(key)
+                break
+        else:
+            return None
+    return disps, idx_map
+
+def _attempt(prepared: Any, hash: str, key: int) -> Tuple[List[Tuple[int, int]], List[int]]|None:
+    return place_buckets(PREPARE_FUNCTIONS[hash][1](prepared, key))
+
+# below that a process pool costs more than it can save, small sets almost
+# always succeed with the first key
+PARALLEL_MIN_ENTRIES = 2048
+
+# the search is randomized but seeded, its result only depends on the entries
+@memoize
+def generate_hash_state(entries: List[Any], hash: str = 'siphash') -> HashState:
     random.seed(1234567890)
-    generator = Generator(len(entries))
-    while True:
-        key = random.getrandbits(64)
-        hashes = [my_hash(to_bytes(entry), key) for entry in entries]
-
-        generator.reset(hashes)
-        if generator.try_generate_hash():
-            return HashState(
-                key=key,
-                disps=generator.disps,
-                idx_map=generator.map
-            )
-
-class Generator:
-    def __init__(self, table_len: int) -> None:
-        self.hashes: List[Hashes] = [Hashes(NP_ZERO, NP_ZERO, NP_ZERO) for _ in range(table_len)]
-        self.hashes.clear()
-
-        buckets_len = (table_len + DEFAULT_LAMBDA - 1) // DEFAULT_LAMBDA
-        self.buckets: List[Bucket] = [Bucket(idx=i, keys=[]) for i in range(0, buckets_len)]
-        self.disps: List[Tuple[int, int]] = [(0, 0) for _ in range(buckets_len)]
-        self.map: List[None | int] = [None for _ in range(table_len)]
-        self.try_map: List[int] = [0 for _ in range(table_len)]
-
-    def reset(self, hashes: List[Hashes]):
-        for bucket in self.buckets:
-            bucket.keys.clear()
-        self.buckets.sort(key=lambda b: b.idx)
-
-        buckets_len = len(self.buckets)
-        self.disps = [(0, 0) for _ in range(buckets_len)]
-        self.map = [None for _ in range(len(self.map))]
-        self.try_map = [0 for _ in range(len(self.try_map))]
-
-        self.hashes.clear()
-        self.hashes.extend(hashes)
-
-    def gen_2(self, 
-            bucket: Bucket,
-            values_to_add: List[Tuple[int, int]],
-            d1: int, d2: int,
-            table_len: int, 
-            generation: int) -> bool:
-        for key in bucket.keys:
-            idx = int(displace(
-                    self.hashes[key].f1,
-                    self.hashes[key].f2,
-                    np.uint32(d1), 
-                    np.uint32(d2))) % table_len
-            if self.map[idx] != None or self.try_map[idx] == generation:
-                return False
-            self.try_map[idx] = generation
-            values_to_add.append((idx, key))
-        return True
-
-    def gen_1(self, bucket: Bucket, table_len: int, values_to_add: List[Tuple[int, int]], generation: int) -> Tuple[int, bool]: 
-        for d1 in range(0, table_len):
-            for d2 in range(0, table_len):
-                values_to_add.clear()
-                generation += 1
-
-                if not self.gen_2(bucket, values_to_add, d1, d2, table_len, generation):
-                    continue
-                
-                self.disps[bucket.idx] = (d1, d2)
-                for idx, key in values_to_add:
-                    self.map[idx] = key
-
-                return generation, True
-        return generation, False
-
-    def try_generate_hash(self): 
-        buckets_len = len(self.buckets)
-        for i, hash in enumerate(self.hashes):
-            self.buckets[hash.g % buckets_len].keys.append(i);
-
-        self.buckets.sort(key=functools.cmp_to_key(lambda a,b: len(b.keys) - len(a.keys)))
-
-        generation = 0
-        table_len = len(self.hashes)
-        values_to_add = []
-
-        for bucket in self.buckets:
-            generation, success = self.gen_1(bucket, table_len, values_to_add, generation)
-            if not success:
-                return False
-
-        return True
+    prepared = PREPARE_FUNCTIONS[hash][0]([to_bytes(entry) for entry in entries])
+
+    workers = os.cpu_count() or 1
+    if len(entries) < PARALLEL_MIN_ENTRIES or workers == 1:
+        while True:
+            key = random.getrandbits(64)
+            if (result := _attempt(prepared, hash, key)) is not None:
+                return HashState(key=key, disps=result[0], idx_map=result[1], hash=hash)
+
+    # keys are tried in batches, the first key of the sequence that works
+    # wins, so the result is the same as trying them one after another
+    context = multiprocessing.get_context('fork')
+    with ProcessPoolExecutor(max_workers=workers, mp_context=context) as pool:
+        while True:
+            keys = [random.getrandbits(64) for _ in range(workers)]
+            results = pool.map(_attempt, [prepared] * workers, [hash] * workers, keys)
+            for key, result in zip(keys, results):
+                if result is not None:
+                    pool.shutdown(cancel_futures=True)
+                    return HashState(key=key, disps=result[0], idx_map=result[1], hash=hash)
+
 
 def format_to_string_literal(string):
     if isinstance(string, str):
         string = string.encode()
     escaped_bytes = bytearray()
+    after_hex_escape = False
     for byte in string:
+        # C hex escapes don't stop after two digits, so a hex digit following
+        # one has to be escaped as well: "\x00D" is a single char in C
+        continues_escape = after_hex_escape and chr(byte) in '0123456789abcdefABCDEF'
+        after_hex_escape = False
         if byte == ord("'"):
             escaped_bytes.append(byte)
         elif byte == ord('"'):
             escaped_bytes.extend([ord('\\'), byte])
-        elif 32 <= byte <= 126:
+        elif 32 <= byte <= 126 and not continues_escape:
             escaped_bytes.append(byte)
         else:
             escaped_bytes.extend([ord('\\'), ord('x')])
             escaped_bytes.extend(f'{byte:02x}'.encode())
+            after_hex_escape = True
 
     return '"{}"'.format(escaped_bytes.decode('utf-8'))
 
 def format_key(state):
+    if state.hash == 'fast':
+        return f'0x{state.key:016x}ull'
     byte_string = ikey_to_bkey(state.key)
     return format_to_string_literal(byte_string)
 
-def init_enum(enum):
+def init_enum(enum, hash='siphash'):
     entries = [variant.data() for variant in enum]
-    state = generate_hash_state(entries)
+    state = generate_hash_state(entries, hash)
     state.__enum__ = enum
     return state
 
-def init_set(set):
-    entries = list(set) 
-    state = generate_hash_state(entries)
+def init_set(set, hash='siphash'):
+    # sorted, sets of strings iterate in a different order every run and the
+    # cached hash states are keyed by the entries
+    entries = sorted(set)
+    state = generate_hash_state(entries, hash)
     state.__elements__ = entries
     return state
 
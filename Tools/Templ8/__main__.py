@@ -1,64 +1,99 @@
 import os
 import sys
 
-from Templ8.templating import process_file_handle_error
+import Templ8.cache as cache
 from rich import print as rprint
 
-valid_options = {'-o', '--output', '-h', '--help'}
+valid_options = {'-o', '--output', '--cache-dir', '--no-cache', '--compile', '-h', '--help'}
 
 def print_help(program: str):
-    assert len(valid_options) == 4, 'hanlde more opts'
+    assert len(valid_options) == 7, 'hanlde more opts'
 
-    rprint(f'Usage: {program} \\[options] infile', file=sys.stderr)
+    rprint(f'Usage: {program} \\[options] infile...', file=sys.stderr)
     rprint(f'Options:')
-    print(f'   --output <file> -o <file>       Specify output file')
+    print(f'   --output <file> -o <file>       Specify output file, only for a single infile')
+    print(f'   --cache-dir <dir>               Cache directory, defaults to {cache.CACHE_DIRNAME} next to the first infile')
+    print(f'   --no-cache                      Neither read nor write the cache')
+    print(f'   --compile                       Only compile the infiles to bytecode in __pycache__')
     print(f'   --help -h                       Prints this help')
 
-def process_arguments(args: list[str]) -> tuple[str, str]|None:
-    assert len(valid_options) == 4, 'hanlde more opts'
+def default_outfile(infile: str) -> str:
+    if infile.endswith('.templ8'):
+        outfile = os.path.splitext(infile)[0]
+        if (res := os.path.splitext(outfile))[1] != '':
+            return res[0] + '.generated' + res[1]
+        return outfile + '.generated'
+    return infile + '.generated'
+
+def process_arguments(args: list[str]) -> tuple[list[tuple[str, str]], str|None, bool]|None:
+    assert len(valid_options) == 7, 'hanlde more opts'
     argv = iter(args + [None])
 
     if (program := next(argv)) is None:
         raise RuntimeError('program name is not available')
-    if (option_or_filename := next(argv)) is None:
-        rprint(f'{program}: Error: No input file provided', file=sys.stderr)
-        return None
 
-    if option_or_filename.startswith('-'):
-        option = option_or_filename
+    outfile = None
+    cache_dir = ''
+    compile_only = False
+    infiles: list[str] = []
+    while (arg := next(argv)) is not None:
+        if not arg.startswith('-'):
+            infiles.append(arg)
+            continue
+        option = arg
         if option not in valid_options:
             rprint(f'{program}: Error: Unknwon option {option!r}', file=sys.stderr)
             return None
         if option in {'-h', '--help'}:
             print_help(program)
             return None
-        if (outfile := next(argv)) is None:
-            rprint(f'{program}: Error: Expected outfile after option {option!r}', file=sys.stderr)
+        if option == '--no-cache':
+            cache_dir = None
+            continue
+        if option == '--compile':
+            compile_only = True
+            continue
+        if (value := next(argv)) is None:
+            rprint(f'{program}: Error: Expected argument after option {option!r}', file=sys.stderr)
             return None
-        if (infile := next(argv)) is None:
-            rprint(f'{program}: Error: No input file provided', file=sys.stderr)
-            return None
-    else:
-        infile = option_or_filename
-        if infile.endswith('.templ8'):
-            outfile = os.path.splitext(infile)[0]
-            if (res := os.path.splitext(outfile))[1] != '':
-                outfile = res[0] + '.generated' + res[1]
-            else:
-                outfile = outfile + '.generated'
+        if option == '--cache-dir':
+            cache_dir = value
         else:
-            outfile = infile + '.generated'
+            outfile = value
 
-    return infile, outfile
+    if len(infiles) == 0:
+        rprint(f'{program}: Error: No input file provided', file=sys.stderr)
+        return None
+    if outfile is not None and len(infiles) > 1:
+        rprint(f'{program}: Error: Option --output needs a single input file', file=sys.stderr)
+        return None
+
+    if cache_dir == '':
+        cache_dir = os.path.join(os.path.dirname(os.path.abspath(infiles[0])), cache.CACHE_DIRNAME)
+    files = [(infile, outfile or default_outfile(infile)) for infile in infiles]
+    return files, cache_dir, compile_only
 
 def main():
     if (result := process_arguments(sys.argv)) is None:
         exit(1)
-    infile, outfile = result
+    files, cache_dir, compile_only = result
+
+    cache.init_cache(cache_dir)
+    if compile_only:
+        from Templ8.templating import compile_files_handle_error
+        if not compile_files_handle_error([infile for infile, _ in files]):
+            exit(1)
+        return
 
-    if not process_file_handle_error(infile, outfile):
+    files = [(infile, outfile) for infile, outfile in files if not cache.output_is_current(infile, outfile)]
+    if len(files) == 0:
+        return
+
+    # only imported with work to do, a run with nothing to regenerate stays
+    # cheap
+    from Templ8.templating import process_files_handle_error
+    if not process_files_handle_error(files):
         exit(1)
 
 if __name__ == '__main__':
     main()
-
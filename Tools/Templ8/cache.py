@@ -0,0 +1,152 @@
+import functools
+import hashlib
+import inspect
+import os
+import pickle
+import sys
+import sysconfig
+
+from typing import Any, Callable, TypeVar
+
+# Persistent cache for Templ8 runs, everything is keyed by content:
+#  - `outputs/`  per output file the hashes of every file it was generated
+#                from, an output whose inputs did not change is not generated
+#  - `memo/`     results of expensive generator functions, see `memoize`
+# The directory defaults to `__templ8cache__` next to the first input file.
+# Compiled templates are not kept here but in `__pycache__` next to the
+# template, see `TemplateFileLoader`.
+
+CACHE_DIRNAME = '__templ8cache__'
+
+_cache_dir: str|None = None
+_dependencies: set[str] = set()
+
+def init_cache(directory: str|None):
+    global _cache_dir
+    _cache_dir = directory
+    if directory is not None:
+        for sub in ('outputs', 'memo'):
+            os.makedirs(os.path.join(directory, sub), exist_ok=True)
+
+def cache_enabled() -> bool:
+    return _cache_dir is not None
+
+def data_digest(data: bytes) -> str:
+    return hashlib.sha256(data).hexdigest()
+
+def file_digest(path: str) -> str|None:
+    try:
+        with open(path, 'rb') as f:
+            return data_digest(f.read())
+    except OSError:
+        return None
+
+def digest(*parts: bytes|str) -> str:
+    h = hashlib.sha256()
+    for part in parts:
+        h.update(part.encode() if isinstance(part, str) else part)
+        h.update(b'\0')
+    return h.hexdigest()
+
+def _load(sub: str, key: str, loads: Callable[[bytes], Any]) -> Any|None:
+    if _cache_dir is None:
+        return None
+    try:
+        with open(os.path.join(_cache_dir, sub, key), 'rb') as f:
+            return loads(f.read())
+    except (OSError, EOFError, ValueError, pickle.UnpicklingError):
+        return None
+
+def _store(sub: str, key: str, data: bytes):
+    if _cache_dir is None:
+        return
+    # written next to the entry and renamed, a concurrent make never reads a
+    # half written file
+    path = os.path.join(_cache_dir, sub, key)
+    tmp = f'{path}.{os.getpid()}.tmp'
+    with open(tmp, 'wb') as f:
+        f.write(data)
+    os.replace(tmp, path)
+
+def depend(path: str):
+    """Record a file the current output is generated from, for generator
+    modules that read files on their own"""
+    _dependencies.add(os.path.abspath(path))
+
+_library_paths: tuple[str, ...]|None = None
+
+def _is_library(path: str) -> bool:
+    global _library_paths
+    if _library_paths is None:
+        paths = sysconfig.get_paths()
+        _library_paths = tuple(paths[key] for key in ('stdlib', 'platstdlib', 'purelib', 'platlib'))
+    return path.startswith(_library_paths)
+
+def _module_dependencies() -> set[str]:
+    # Templ8 itself and every generator module, but neither the standard
+    # library nor installed packages
+    result = set()
+    for module in list(sys.modules.values()):
+        path = getattr(module, '__file__', None)
+        if path is None or not path.endswith('.py'):
+            continue
+        path = os.path.abspath(path)
+        if not _is_library(path):
+            result.add(path)
+    return result
+
+def begin_output():
+    _dependencies.clear()
+
+def _output_key(input_file: str) -> str:
+    return digest(os.path.abspath(input_file))
+
+def output_is_current(input_file: str, output_file: str) -> bool:
+    output_file = os.path.abspath(output_file)
+    manifest = _load('outputs', _output_key(input_file), pickle.loads)
+    if manifest is None or manifest['output'] != output_file:
+        return False
+    if file_digest(output_file) != manifest['output_digest']:
+        return False
+    return all(file_digest(path) == value for path, value in manifest['dependencies'].items())
+
+def finish_output(input_file: str, output_file: str, output_digest: str):
+    dependencies = _dependencies | _module_dependencies() | {os.path.abspath(input_file)}
+    manifest = {
+        'output': output_file,
+        'output_digest': output_digest,
+        'dependencies': {path: file_digest(path) for path in sorted(dependencies)},
+    }
+    _store('outputs', _output_key(input_file), pickle.dumps(manifest))
+
+_templ8_digest: str|None = None
+
+def compiler_digest() -> str:
+    # compiled templates are only valid for the Templ8 that compiled them
+    global _templ8_digest
+    if _templ8_digest is None:
+        package = os.path.dirname(__file__)
+        sources = sorted(f for f in os.listdir(package) if f.endswith('.py'))
+        _templ8_digest = digest(sys.version, *(file_digest(os.path.join(package, f)) or '' for f in sources))
+    return _templ8_digest
+
+TResult = TypeVar('TResult')
+def memoize(function: Callable[..., TResult]) -> Callable[..., TResult]:
+    """Persistently cache the results of a deterministic generator function,
+    keyed by its pickled arguments and the source of its module"""
+    source = inspect.getsourcefile(function)
+    assert source is not None, 'memoize needs functions defined in a file'
+    name = f'{function.__module__}.{function.__qualname__}'
+    # pickled results, every call gets its own copy to modify
+    memory: dict[str, bytes] = {}
+    module_digest = file_digest(source) or ''
+
+    @functools.wraps(function)
+    def wrapper(*args, **kwargs):
+        key = digest(name, module_digest, pickle.dumps((args, kwargs)))
+        if (data := memory.get(key)) is None and (data := _load('memo', key, bytes)) is None:
+            data = pickle.dumps(function(*args, **kwargs))
+            _store('memo', key, data)
+        memory[key] = data
+        return pickle.loads(data)
+    return wrapper
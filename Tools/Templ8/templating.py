@@ -1,6 +1,7 @@
 import builtins
 from dataclasses import dataclass
 from importlib import import_module
+import importlib.util
 import io
 import os
 import sys
@@ -11,6 +12,7 @@ from typing import Any, Callable, Generator, Iterable, Literal, Type, TypeVar
 from importlib.machinery import PathFinder, SourceFileLoader
 from typing_extensions import Self
 
+import Templ8.cache as cache
 from Templ8.compiler import CodeGenerator
 import Templ8.nodes as n
 from Templ8.lexing import TOK_INITIAL, LimitedException, Pos, expect, test, tokenize, tokenize_line, register_tokens, tokenwraps, TokenStream, Token, find_next, unexpected_error, WSyntaxError
@@ -59,6 +61,9 @@ class Context(dict[str, Any]):
         self.output_filename = output_filename
         self.macros: dict[str, Macro] = {}
         self.exports: dict[str, Any] = {}
+        # calls for the include, pyimport, pymodule and customcode blocks,
+        # they run before the rest of the template
+        self.actions: list[n.Node] = []
         self.update(builtins.__dict__)
         self.__FILENAME__ = os.path.basename(self.input_filename)
 
@@ -124,6 +129,9 @@ class Context(dict[str, Any]):
     def export(self, **kwargs: Any):
         self.exports.update(kwargs)
 
+    def run_action(self, runner: str, *args: Any):
+        action_runners[runner](self, *args)
+
     def __getitem__(self, key: str) -> Any:
         _missing = object()
         if (res := dict.get(self, key, _missing)) is not _missing:
@@ -532,23 +540,28 @@ def define_module(stream: TokenStream, context: Context):
     assert isinstance(result, tuple)
     name, text = result 
 
+    lineno = text.start.lineno if text is not None else 0
+    add_action(
+        context, stream.current.start, 'pymodule',
+        name, stream.filename, text.value if text is not None else None, lineno)
+
+def run_define_module(context: Context, name: str, filename: str, text: str|None, lineno: int):
     from importlib._bootstrap import _init_module_attrs
     from importlib.machinery import ModuleSpec
 
     module = ModuleType(name)
-    spec = ModuleSpec(name, None, origin=stream.filename)
+    spec = ModuleSpec(name, None, origin=filename)
     spec.has_location = True
     _init_module_attrs(spec, module)
 
     if text is not None:
         try:
-            code = compile(text.value, stream.filename, 'exec')
+            code = compile(text, filename, 'exec')
         except SyntaxError as err:
             assert err.lineno is not None
-            err.lineno += text.start.lineno
+            err.lineno += lineno
             raise err
-        code = update_firstlineno(code, text.start.lineno)
-        exec(code, module.__dict__)
+        exec(update_firstlineno(code, lineno), module.__dict__)
 
     sys.modules[module.__name__] = module
     context[module.__name__] = module
@@ -577,18 +590,20 @@ def include_file(stream: TokenStream, context: Context):
 
     include_filename = include_file_tok.value[1:-1].encode().decode('unicode_escape')
 
-    template = check_template_valid_library(include_file_tok, include_filename)
+    check_template_valid_library(include_file_tok, include_filename)
+    add_action(context, include_file_tok.start, 'include', include_filename, stream.filename, include_file_tok.start.lineno, include_file_tok.start.col)
+
+def run_include_file(context: Context, include_filename: str, filename: str, lineno: int, col: int):
+    template, _ = os.path.splitext(include_filename)
     if (template_ctx := sys.templates_cache.get(include_filename)) is None:
         spec = PathFinder.find_spec(template)
 
         if spec is None or not isinstance(spec.loader, TemplateFileLoader):
-            raise WSyntaxError(include_file_tok, f'cannot find template library {include_filename!r}')
+            raise WSyntaxError((Pos(lineno, col), filename), f'cannot find template library {include_filename!r}')
         
         assert spec.origin is not None
-        template_ctx = process_single_file(
-            spec.origin,
-            spec.loader.get_data(spec.origin).decode(),
-            None, base_context=context)
+        cache.depend(spec.origin)
+        template_ctx = process_single_file(spec.loader, None, base_context=context)
 
         sys.templates_cache[include_filename] = template_ctx
 
@@ -617,15 +632,16 @@ def parse_customcode(stream: TokenStream, context: Context):
 
     init, texttok = result
     if texttok is not None:
-        gen = CodeGenerator(stream.filename)
-        code = gen.compile(init.parser_expr, mode='eval')
-        parser = eval(code, context)
+        add_action(
+            context, texttok.start, 'customcode', init.parser_expr, stream.filename, texttok.value,
+            texttok.start.lineno, texttok.start.col, init.result_variable)
 
-        stream = tokenize(stream.filename, texttok.value, lineno=texttok.start.lineno, col=texttok.start.col)
-        parsed_result = parser(stream)
+def run_customcode(context: Context, parser: Callable[[TokenStream], Any], filename: str, text: str, lineno: int, col: int, result_variable: str|None):
+    stream = tokenize(filename, text, lineno=lineno, col=col)
+    parsed_result = parser(stream)
 
-        if init.result_variable is not None:
-            context[init.result_variable] = parsed_result
+    if result_variable is not None:
+        context[result_variable] = parsed_result
 
 def export_block(stream: TokenStream, context: Context) -> n.Call:
     assert test((startok := stream.current), 'block_begin:'), "export_block needs to be called with block_begin as stream.current"
@@ -704,7 +720,10 @@ def parse_import(stream: TokenStream, context: Context):
     if not test(stream.current, 'block_end:'):
         unexpected_error(stream.current, 'end of block')
 
-    module_path = '.'.join(dotted_path)
+    add_action(context, stream.current.start, 'pyimport', '.'.join(dotted_path), alias)
+    next(stream)
+
+def run_import(context: Context, module_path: str, alias: str|None):
     module = import_module(module_path)
 
     if alias is not None:
@@ -712,7 +731,20 @@ def parse_import(stream: TokenStream, context: Context):
     else:
         context[module_path] = module
 
-    next(stream)
+def add_action(context: Context, pos: Pos, runner: str, *args: n.Expression|str|int|None):
+    span = dict(start=pos, end=pos)
+    arguments = [arg if isinstance(arg, n.Node) else n.Literal(arg, **span) for arg in args]
+    context.actions.append(n.Call(
+        n.Variable('run_action', **span),
+        n.CallArguments([n.Literal(runner, **span), *arguments], {}, **span),
+        **span))
+
+action_runners: dict[str, Callable[..., None]] = {
+        'pymodule': run_define_module,
+        'include': run_include_file,
+        'customcode': run_customcode,
+        'pyimport': run_import
+}
 
 block_parsers: dict[str, Callable[[TokenStream], n.Node|None]|Callable[[TokenStream, Context], n.Node|None]] = {
         'if': parse_if_block,
@@ -776,8 +808,10 @@ def create_template(filename: str, content: str, context: Context) -> n.Template
     next(stream)
     starttok = stream.current
     body = list(templating(stream, context))
+    # the blocks that used to run while parsing, so parsing has no effects
+    # and the template compiles to a self-contained module
     return n.Template(
-        body,
+        context.actions + body,
         start=starttok.start,
         end=stream.current.end
     )
@@ -849,38 +883,37 @@ def display_python_syntax_error(exc: SyntaxError):
         print(f'    {" " * (exc.offset - number_of_leading_spaces)}^', file=sys.stderr)
     rprint(f'SyntaxError: {exc.msg}', file=sys.stderr)
 
+def compile_template(filename: str, content: str) -> CodeType:
+    template = create_template(filename, content, Context(filename, filename))
+    return CodeGenerator(filename).compile(template)
+
 def process_single_file(
-    input_filename: str,
-    file_content: str,
+    loader: 'TemplateFileLoader',
     output_filename: str|None,
     *,
     base_context: Context|None = None
 ) -> Context:
+    input_filename = loader.get_filename()
     if base_context is None:
         assert output_filename is not None, "output_file_name must be provided if there is no base_context"
         context = Context(input_filename, output_filename)
     else:
         context = Context.from_base_context(input_filename, base_context)
-    template = create_template(input_filename, file_content, context)
-    gen = CodeGenerator(input_filename)
-    code = gen.compile(template)
-    exec(code, context)
+    exec(loader.get_code(loader.name), context)
     return context
 
 def process_file_handle_error(input_file: str, output_file: str) -> bool:
     input_file = os.path.abspath(input_file)
     output_file = os.path.abspath(output_file)
     init_importlib(os.path.dirname(input_file))
+    cache.begin_output()
 
     try:
-        with open(input_file, 'r') as f_in:
-            content = f_in.read()
+        loader = TemplateFileLoader(os.path.basename(input_file), input_file)
+        context = process_single_file(loader, output_file)
     except OSError as e:
         rprint(f'templ8: OSError: {e}', file=sys.stderr)
         return False
-
-    try:
-        context = process_single_file(input_file, content, output_file)
     except SyntaxError as psyntax:
         display_python_syntax_error(psyntax)
         return False
@@ -892,28 +925,95 @@ def process_file_handle_error(input_file: str, output_file: str) -> bool:
         display_runtime_error(typ, exc, traceback)
         return False
 
+    # unchanged outputs are not rewritten, so make does not rebuild what
+    # includes them
+    output = context.to_string().encode()
+    output_digest = cache.data_digest(output)
     try:
-        with open(output_file, 'w') as f_out:
-            f_out.write(context.to_string())
+        if cache.file_digest(output_file) != output_digest:
+            with open(output_file, 'wb') as f_out:
+                f_out.write(output)
     except OSError as e:
         rprint(f'templ8: OSError: {e}', file=sys.stderr)
         return False
 
+    cache.finish_output(input_file, output_file, output_digest)
     return True
 
+def process_files_handle_error(files: list[tuple[str, str]]) -> bool:
+    success = True
+    for input_file, output_file in files:
+        success = process_file_handle_error(input_file, output_file) and success
+    return success
+
 class TemplateFileLoader(SourceFileLoader):
-    def get_code(self, _):
+    """Compiles a template to the code of a Python module, stored in
+    __pycache__ like any other module. The pyc is checked against a hash of
+    the template and of Templ8 itself instead of the modification time."""
+
+    def source_to_code(self, data, path, *, _optimize=-1):
+        return compile_template(path, data.decode() if isinstance(data, bytes) else data)
+
+    def get_code(self, fullname: str|None = None) -> CodeType:
+        from importlib._bootstrap_external import (
+            _classify_pyc, _code_to_hash_pyc, _compile_bytecode, _validate_hash_pyc, cache_from_source)
+        source_path = self.get_filename(fullname)
+        data = self.get_data(source_path)
+        source_hash = importlib.util.source_hash(data + cache.compiler_digest().encode())
+        # x.templ8 is cached as x.templ8.<tag>.pyc, it would clash with x.py
+        bytecode_path = cache_from_source(source_path + '.py')
+
+        if cache.cache_enabled():
+            try:
+                pyc = self.get_data(bytecode_path)
+                details = {'name': fullname, 'path': bytecode_path}
+                if _classify_pyc(pyc, fullname, details) & 0b1:
+                    _validate_hash_pyc(pyc, source_hash, fullname, details)
+                    return _compile_bytecode(
+                        memoryview(pyc)[16:], name=fullname,
+                        bytecode_path=bytecode_path, source_path=source_path)
+            except (OSError, ImportError, EOFError):
+                pass
+
+        code = self.source_to_code(data, source_path)
+        if cache.cache_enabled():
+            self._cache_bytecode(source_path, bytecode_path, _code_to_hash_pyc(code, source_hash, True))
+        return code
+
+    def exec_module(self, module):
         raise ImportError("importing templates via python is not allowed")
 
+def compile_files_handle_error(files: list[str]) -> bool:
+    success = True
+    for input_file in files:
+        input_file = os.path.abspath(input_file)
+        try:
+            TemplateFileLoader(os.path.basename(input_file), input_file).get_code()
+        except OSError as e:
+            rprint(f'templ8: OSError: {e}', file=sys.stderr)
+            success = False
+        except SyntaxError as psyntax:
+            display_python_syntax_error(psyntax)
+            success = False
+        except WSyntaxError as wsyntax:
+            display_templating_syntax_error(wsyntax)
+            success = False
+    return success
+
 _missing = object()
 def init_importlib(template_directory: str): 
     from importlib._bootstrap_external import FileFinder, _get_supported_file_loaders
 
+    if template_directory not in sys.path:
+        sys.path.append(template_directory)
+        sys.path_importer_cache.clear()
+
+    # included libraries emit into the context of the file including them,
+    # every output file starts with a fresh set
     if getattr(sys, 'templates_cache', _missing) is not _missing:
+        sys.templates_cache = {}
         return
 
-    if template_directory not in sys.path:
-        sys.path.append(template_directory)
     sys.path_importer_cache.clear()
     prev_hook = next(filter(lambda x: 'FileFinder' in str(x), sys.path_hooks))
     sys.path_hooks.remove(prev_hook)
@@ -1,13 +1,18 @@
 #ifndef AST_H_
 #define AST_H_
 
+#include <stddef.h>
+
 #include "lexer.h"
 #include "strings.h"
+#include "writer.h"
 
 // FIXME: Ident should be a struct containing the 
 //        definition span and the name should be stored
 //        as an index in a symbol table
 
+// Literal.integer is the value in two's complement, sign extended to 64 bits
+// for the signed number classes
 #define ENUMERATE_EXPR_NODES                \
     _NODE(Literal, {                        \
         enum {                              \
@@ -22,7 +27,7 @@
             String_Builder string;          \
             uint32_t wchar;                 \
             bool boolean;                   \
-            uint32_t integer;               \
+            uint64_t integer;               \
             double floating;                \
         };                                  \
         Lex_NumberClass nclass;             \
@@ -88,8 +93,15 @@ typedef struct {
     size_t count;
     size_t capacity;
     Lex_Span span;
+    // the Decl statement a local name refers to, set by the resolver and
+    // NULL until then
+    struct _Ast_Stmt *decl;
 } Ast_Path;
 
+#define _NODE(name, ...) typedef struct __VA_ARGS__ Ast_##name##Expr;
+    ENUMERATE_EXPR_NODES
+#undef _NODE
+
 typedef enum {
 #define _NODE(name, ...) name##_kind,
     ENUMERATE_EXPR_NODES
@@ -99,12 +111,14 @@ typedef enum {
 
 struct _Ast_Expr {
     Ast_ExprKind kind;
+    // see Ast_Pool.ids
+    uint32_t id;
+    Lex_Span span;
     union {
-#define _NODE(name, ...) struct __VA_ARGS__ name;
+#define _NODE(name, ...) Ast_##name##Expr name;
         ENUMERATE_EXPR_NODES
 #undef _NODE
     };
-    Lex_Span span;
 };
 
 typedef struct _Ast_Type Ast_Type;
@@ -151,6 +165,10 @@ typedef struct {
         Ast_Type *ty;                       \
     })                                      \
 
+#define _NODE(name, ...) typedef struct __VA_ARGS__ Ast_##name##Type;
+    ENUMERATE_TYPE_NODES
+#undef _NODE
+
 typedef enum {
 #define _NODE(name, ...) name##_kind,
     ENUMERATE_TYPE_NODES
@@ -160,12 +178,14 @@ typedef enum {
 
 struct _Ast_Type {
     Ast_TypeKind kind;
+    // see Ast_Pool.ids
+    uint32_t id;
+    Lex_Span span;
     union {
-#define _NODE(name, ...) struct __VA_ARGS__ name;
+#define _NODE(name, ...) Ast_##name##Type name;
         ENUMERATE_TYPE_NODES
 #undef _NODE
     };
-    Lex_Span span;
 };
 
 #define ENUMERATE_STMT_NODES                \
@@ -194,6 +214,10 @@ struct _Ast_Block {
     Lex_Span span;
 };
 
+#define _NODE(name, ...) typedef struct __VA_ARGS__ Ast_##name##Stmt;
+    ENUMERATE_STMT_NODES
+#undef _NODE
+
 typedef enum {
 #define _NODE(name, ...) name##_kind,
     ENUMERATE_STMT_NODES
@@ -203,18 +227,30 @@ typedef enum {
 
 struct _Ast_Stmt {
     Ast_StmtKind kind;
+    // see Ast_Pool.ids
+    uint32_t id;
+    Lex_Span span;
     union {
-#define _NODE(name, ...) struct __VA_ARGS__ name;
+#define _NODE(name, ...) Ast_##name##Stmt name;
         ENUMERATE_STMT_NODES
 #undef _NODE
     };
-    Lex_Span span;
 };
 
 #define ENUMERATE_ITEM_NODES                \
     _NODE(RunBlock, {                       \
         Ast_Block *block;                   \
     })                                      \
+    _NODE(Include, {                        \
+        String_Builder path;                \
+    })                                      \
+    _NODE(Open, {                           \
+        String_Builder path;                \
+    })                                      \
+
+#define _NODE(name, ...) typedef struct __VA_ARGS__ Ast_##name##Item;
+    ENUMERATE_ITEM_NODES
+#undef _NODE
 
 typedef enum {
 #define _NODE(name, ...) name##_kind,
@@ -225,12 +261,14 @@ typedef enum {
 
 typedef struct {
     Ast_ItemKind kind;
+    // see Ast_Pool.ids
+    uint32_t id;
+    Lex_Span span;
     union {
-#define _NODE(name, ...) struct __VA_ARGS__ name;
+#define _NODE(name, ...) Ast_##name##Item name;
         ENUMERATE_ITEM_NODES
 #undef _NODE
     };
-    Lex_Span span;
 } Ast_Item;
 
 typedef struct {
@@ -239,12 +277,9 @@ typedef struct {
     size_t capacity;
 } Ast_Source;
 
-#define _new_1(Typ, variant) (Typ){ .kind = variant##_kind, .variant =
-#define _new_2(_span, ...) __VA_ARGS__, .span = (_span) }
-#define create_expr(variant) _new_1(Ast_Expr, variant)_new_2
-#define create_stmt(variant) _new_1(Ast_Stmt, variant)_new_2
-#define create_item(variant) _new_1(Ast_Item, variant)_new_2
-#define create_type(variant) _new_1(Ast_Type, variant)_new_2
+// Nodes are allocated only up to the end of their variant, so `span` comes
+// before the union and a node is never copied as a whole, see ast_pool.h
+#define ast_node_size(Typ, variant) (offsetof(Typ, variant) + sizeof(((Typ *)0)->variant))
 
 #define intermediate(...) intermediate_inter(__VA_ARGS__, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1)
 #define intermediate_inter(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, count, ...) \
@@ -279,12 +314,16 @@ typedef struct {
 #define bind(name, ...) \
     case name##_kind: { typeof(__expr->name) __variant = __expr->name; intermediate __VA_ARGS__ } break;
 
-void ast_print_expr(String_Builder *sb, Ast_Expr *expr, uint32_t level);
-void ast_print_stmt(String_Builder *sb, Ast_Stmt *stmt, uint32_t level);
-void ast_print_item(String_Builder *sb, Ast_Item *item, uint32_t level);
-void ast_print_type(String_Builder *sb, Ast_Type *type, uint32_t level);
-void ast_print_block(String_Builder *sb, Ast_Block *block, uint32_t level);
-void ast_print_source(String_Builder *sb, Ast_Source *source, uint32_t level);
-void ast_print_path(String_Builder *sb, Ast_Path *path);
+void ast_print_expr(Writer *w, Ast_Expr *expr, uint32_t level);
+void ast_print_stmt(Writer *w, Ast_Stmt *stmt, uint32_t level);
+void ast_print_item(Writer *w, Ast_Item *item, uint32_t level);
+void ast_print_type(Writer *w, Ast_Type *type, uint32_t level);
+void ast_print_block(Writer *w, Ast_Block *block, uint32_t level);
+void ast_print_source(Writer *w, Ast_Source *source, uint32_t level);
+void ast_print_path(Writer *w, Ast_Path *path);
+
+// Machine-readable dumps, see ast_export.h.templ8 for the binary format
+void ast_export_json(Writer *w, Ast_Source *source);
+void ast_export_bin(Writer *w, Ast_Source *source);
 
 #endif //AST_H_
@@ -47,252 +47,257 @@ const char *type_to_string(Ast_TypeKind kind) {
 }
 
 #define INDENT "    "
-void indent(String_Builder *sb, uint32_t level) {
+void indent(Writer *w, uint32_t level) {
     for (uint32_t i = 0; i < level; i++) {
-        sb_append_cstr(sb, INDENT);
+        writer_cstr(w, INDENT);
     }
 }
 
-void ast_print_expr(String_Builder *sb, Ast_Expr *expr, uint32_t level) {
-    sb_append_cstr(sb, expr_to_string(expr->kind));
-    sb_append_cstr(sb, " { ");
+void ast_print_expr(Writer *w, Ast_Expr *expr, uint32_t level) {
+    writer_cstr(w, expr_to_string(expr->kind));
+    writer_cstr(w, " { ");
 
-    sb_append_cstr(sb, "span = ");
-    lexer_print_span(sb, expr->span);
+    writer_cstr(w, "span = ");
+    lexer_print_span(w, expr->span);
 
     bswitch(expr, {
         bind(Literal, (kind, string, wchar, boolean, integer, floating, nclass) {
-            char buffer[100] = {0};
             switch (kind) {
                 case L_String:
-                    sb_append_cstr(sb, ", string = ");
-                    da_append_many(sb, string.items, string.count);
+                    writer_cstr(w, ", string = ");
+                    writer_write(w, string.items, string.count);
                     break;
                 case L_Char:
-                    sb_append_cstr(sb, ", char = ");
-                    da_append(sb, (char)wchar);
+                    writer_cstr(w, ", char = ");
+                    writer_char(w, (char)wchar);
                     break;
                 case L_Boolean:
-                    sb_append_cstr(sb, ", boolean = ");
-                    sb_append_cstr(sb, boolean ? "true" : "false");
+                    writer_cstr(w, ", boolean = ");
+                    writer_cstr(w, boolean ? "true" : "false");
                     break;
                 case L_Nil:
-                    sb_append_cstr(sb, ", nil");
+                    writer_cstr(w, ", nil");
                     break;
                 case L_Integer:
-                    sprintf(buffer, "%d", integer);
-                    sb_append_cstr(sb, ", integer = ");
-                    sb_append_cstr(sb, buffer);
-                    da_append(sb, ':');
-                    sb_append_cstr(sb, number_class_to_string(nclass));
+                    writer_cstr(w, ", integer = ");
+                    if (IS_UNSIGNED_CLASS(nclass)) {
+                        writer_u64(w, integer);
+                    } else {
+                        writer_i64(w, (int64_t)integer);
+                    }
+                    writer_char(w, ':');
+                    writer_cstr(w, number_class_to_string(nclass));
                     break;
                 case L_Float:
-                    sprintf(buffer, "%f", floating);
-                    sb_append_cstr(sb, ", float = ");
-                    sb_append_cstr(sb, buffer);
-                    da_append(sb, ':');
-                    sb_append_cstr(sb, number_class_to_string(nclass));
+                    writer_cstr(w, ", float = ");
+                    writer_f64(w, floating);
+                    writer_char(w, ':');
+                    writer_cstr(w, number_class_to_string(nclass));
                     break;
             };
         });
         bind(Path, (path) {
-            sb_append_cstr(sb, ", path = ");
-            ast_print_path(sb, &path);
+            writer_cstr(w, ", path = ");
+            ast_print_path(w, &path);
+            if (path.decl != NULL) {
+                writer_cstr(w, ", decl = ");
+                lexer_print_span(w, path.decl->span);
+            }
         });
         bind(Unary, (op, expr) {
-            sb_append_cstr(sb, ", op = UnaryOp::");
-            sb_append_cstr(sb, unary_op_to_string(op));
-            sb_append_cstr(sb, ",\n");
-            indent(sb, level + 1);
-            sb_append_cstr(sb, "expr = ");
-            ast_print_expr(sb, expr, level + 1);
+            writer_cstr(w, ", op = UnaryOp::");
+            writer_cstr(w, unary_op_to_string(op));
+            writer_cstr(w, ",\n");
+            indent(w, level + 1);
+            writer_cstr(w, "expr = ");
+            ast_print_expr(w, expr, level + 1);
         });
         bind(Call, (function, arguments) {
-            sb_append_cstr(sb, ",\n");
-            indent(sb, level + 1);
-            sb_append_cstr(sb, "function = ");
-            ast_print_expr(sb, function, level + 1);
-
-            sb_append_cstr(sb, ",\n");
-            indent(sb, level + 1);
-            sb_append_cstr(sb, "arguments = [");
+            writer_cstr(w, ",\n");
+            indent(w, level + 1);
+            writer_cstr(w, "function = ");
+            ast_print_expr(w, function, level + 1);
+
+            writer_cstr(w, ",\n");
+            indent(w, level + 1);
+            writer_cstr(w, "arguments = [");
             for (size_t i = 0; i < arguments.count; i++) {
-                da_append(sb, '\n');
-                indent(sb, level+2);
+                writer_char(w, '\n');
+                indent(w, level+2);
                 Ast_Expr *arg = arguments.items[i];
-                ast_print_expr(sb, arg, level + 2);
-                da_append(sb, ',');
+                ast_print_expr(w, arg, level + 2);
+                writer_char(w, ',');
             }
-            sb_append_cstr(sb, "]");
+            writer_cstr(w, "]");
         });
         bind(Member, (expr, ident) {
-            sb_append_cstr(sb, ", ident = ");
-            da_append_many(sb, ident.items, ident.count);
-            sb_append_cstr(sb, ",\n");
-            indent(sb, level + 1);
-            sb_append_cstr(sb, "expr = ");
-            ast_print_expr(sb, expr, level + 1);
+            writer_cstr(w, ", ident = ");
+            writer_write(w, ident.items, ident.count);
+            writer_cstr(w, ",\n");
+            indent(w, level + 1);
+            writer_cstr(w, "expr = ");
+            ast_print_expr(w, expr, level + 1);
         });
         bind(Paren, (expr) {
-            sb_append_cstr(sb, ",\n");
-            indent(sb, level + 1);
-            sb_append_cstr(sb, "expr = ");
-            ast_print_expr(sb, expr, level + 1);
+            writer_cstr(w, ",\n");
+            indent(w, level + 1);
+            writer_cstr(w, "expr = ");
+            ast_print_expr(w, expr, level + 1);
         });
         bind(Binary, (op, lhs, rhs) {
-            sb_append_cstr(sb, ", op = BinaryOp::");
-            sb_append_cstr(sb, binary_op_to_string(op));
+            writer_cstr(w, ", op = BinaryOp::");
+            writer_cstr(w, binary_op_to_string(op));
  
-            sb_append_cstr(sb, ",\n");
-            indent(sb, level + 1);
-            sb_append_cstr(sb, "lhs = ");
-            ast_print_expr(sb, lhs, level + 1);
-
-            sb_append_cstr(sb, ",\n");
-            indent(sb, level + 1);
-            sb_append_cstr(sb, "rhs = ");
-            ast_print_expr(sb, rhs, level + 1);
+            writer_cstr(w, ",\n");
+            indent(w, level + 1);
+            writer_cstr(w, "lhs = ");
+            ast_print_expr(w, lhs, level + 1);
+
+            writer_cstr(w, ",\n");
+            indent(w, level + 1);
+            writer_cstr(w, "rhs = ");
+            ast_print_expr(w, rhs, level + 1);
         });
         bind(Assign, (op, lhs, rhs) {
-            sb_append_cstr(sb, ", op = AssignmentOp::");
-            sb_append_cstr(sb, assignment_op_to_string(op));
+            writer_cstr(w, ", op = AssignmentOp::");
+            writer_cstr(w, assignment_op_to_string(op));
  
-            sb_append_cstr(sb, ",\n");
-            indent(sb, level + 1);
-            sb_append_cstr(sb, "lhs = ");
-            ast_print_expr(sb, lhs, level + 1);
-
-            sb_append_cstr(sb, ",\n");
-            indent(sb, level + 1);
-            sb_append_cstr(sb, "rhs = ");
-            ast_print_expr(sb, rhs, level + 1);
+            writer_cstr(w, ",\n");
+            indent(w, level + 1);
+            writer_cstr(w, "lhs = ");
+            ast_print_expr(w, lhs, level + 1);
+
+            writer_cstr(w, ",\n");
+            indent(w, level + 1);
+            writer_cstr(w, "rhs = ");
+            ast_print_expr(w, rhs, level + 1);
         });
         bind(Refrence, (expr) {
-            sb_append_cstr(sb, ",\n");
-            indent(sb, level + 1);
-            sb_append_cstr(sb, "expr = ");
-            ast_print_expr(sb, expr, level + 1);
+            writer_cstr(w, ",\n");
+            indent(w, level + 1);
+            writer_cstr(w, "expr = ");
+            ast_print_expr(w, expr, level + 1);
         });
         bind(If, (condition, if_branch, else_block) {
-            sb_append_cstr(sb, ",\n");
-            indent(sb, level + 1);
-            sb_append_cstr(sb, "condition = ");
-            ast_print_expr(sb, condition, level + 1);
-
-            sb_append_cstr(sb, ",\n");
-            indent(sb, level + 1);
-            sb_append_cstr(sb, "if_branch = ");
-            ast_print_block(sb, if_branch, level + 1);
-
-            sb_append_cstr(sb, ",\n");
-            indent(sb, level + 1);
-            sb_append_cstr(sb, "else_block = ");
+            writer_cstr(w, ",\n");
+            indent(w, level + 1);
+            writer_cstr(w, "condition = ");
+            ast_print_expr(w, condition, level + 1);
+
+            writer_cstr(w, ",\n");
+            indent(w, level + 1);
+            writer_cstr(w, "if_branch = ");
+            ast_print_block(w, if_branch, level + 1);
+
+            writer_cstr(w, ",\n");
+            indent(w, level + 1);
+            writer_cstr(w, "else_block = ");
             if (else_block != NULL) {
-                ast_print_expr(sb, else_block, level + 1);
+                ast_print_expr(w, else_block, level + 1);
             } else {
-                sb_append_cstr(sb, "NULL");
+                writer_cstr(w, "NULL");
             }
         });
         bind(Block, (block) {
-            sb_append_cstr(sb, ",\n");
-            indent(sb, level + 1);
-            sb_append_cstr(sb, "block = ");
-            ast_print_block(sb, block, level + 1);
+            writer_cstr(w, ",\n");
+            indent(w, level + 1);
+            writer_cstr(w, "block = ");
+            ast_print_block(w, block, level + 1);
         });
         default: break;
     });
 
-    sb_append_cstr(sb, " }");
+    writer_cstr(w, " }");
 }
 
-void ast_print_path(String_Builder *sb, Ast_Path *path) {
+void ast_print_path(Writer *w, Ast_Path *path) {
     for (size_t i = 0; i < path->count; i++) {
         Ast_PathSegment *segment = &path->items[i];
-        da_append_many(sb, segment->ident.items, segment->ident.count);
+        writer_write(w, segment->ident.items, segment->ident.count);
         if (i < path->count - 1) {
-            da_append(sb, ':');
+            writer_char(w, ':');
         }
     }
 }
 
-void ast_print_stmt(String_Builder *sb, Ast_Stmt *stmt, uint32_t level) {
-    sb_append_cstr(sb, stmt_to_string(stmt->kind));
-    sb_append_cstr(sb, " { ");
+void ast_print_stmt(Writer *w, Ast_Stmt *stmt, uint32_t level) {
+    writer_cstr(w, stmt_to_string(stmt->kind));
+    writer_cstr(w, " { ");
 
-    sb_append_cstr(sb, "span = ");
-    lexer_print_span(sb, stmt->span);
+    writer_cstr(w, "span = ");
+    lexer_print_span(w, stmt->span);
 
     bswitch(stmt, {
         bind(Expr, (expr, semicolon) {
-            sb_append_cstr(sb, ", semi = ");
-            sb_append_cstr(sb, semicolon ? "true" : "false");
-            sb_append_cstr(sb, ",\n");
-            indent(sb, level + 1);
-            sb_append_cstr(sb, "expr = ");
-            ast_print_expr(sb, expr, level + 1);
+            writer_cstr(w, ", semi = ");
+            writer_cstr(w, semicolon ? "true" : "false");
+            writer_cstr(w, ",\n");
+            indent(w, level + 1);
+            writer_cstr(w, "expr = ");
+            ast_print_expr(w, expr, level + 1);
         });
         bind(Decl, (init, ident, mut, type) {
-            sb_append_cstr(sb, ", ident = ");
-            da_append_many(sb, ident.items, ident.count);
+            writer_cstr(w, ", ident = ");
+            writer_write(w, ident.items, ident.count);
 
-            sb_append_cstr(sb, ", mut = ");
-            sb_append_cstr(sb, mut == M_Mut ? "Mut" : "Const");
+            writer_cstr(w, ", mut = ");
+            writer_cstr(w, mut == M_Mut ? "Mut" : "Const");
 
-            sb_append_cstr(sb, ",\n");
-            indent(sb, level + 1);
-            sb_append_cstr(sb, "init = ");
+            writer_cstr(w, ",\n");
+            indent(w, level + 1);
+            writer_cstr(w, "init = ");
             if (init != NULL) {
-                ast_print_expr(sb, init, level + 1);
+                ast_print_expr(w, init, level + 1);
             } else {
-                sb_append_cstr(sb, "NULL");
+                writer_cstr(w, "NULL");
             }
 
-            sb_append_cstr(sb, ",\n");
-            indent(sb, level + 1);
-            sb_append_cstr(sb, "type = ");
-            ast_print_type(sb, type, level + 1);
+            writer_cstr(w, ",\n");
+            indent(w, level + 1);
+            writer_cstr(w, "type = ");
+            ast_print_type(w, type, level + 1);
         });
         default: break;
     });
 
-    sb_append_cstr(sb, " }");
+    writer_cstr(w, " }");
 }
 
-void ast_print_type(String_Builder *sb, Ast_Type *type, uint32_t level) {
-    sb_append_cstr(sb, type_to_string(type->kind));
+void ast_print_type(Writer *w, Ast_Type *type, uint32_t level) {
+    writer_cstr(w, type_to_string(type->kind));
 
     if (type->kind != Inferred_kind) {
-        sb_append_cstr(sb, " { ");
-        sb_append_cstr(sb, "span = ");
-        lexer_print_span(sb, type->span);
+        writer_cstr(w, " { ");
+        writer_cstr(w, "span = ");
+        lexer_print_span(w, type->span);
     }
 
 #define PRINT_MUT_TY \
 do {                                                    \
-    sb_append_cstr(sb, ", mut = ");                     \
-    sb_append_cstr(sb, mut == M_Mut ? "Mut" : "Const"); \
+    writer_cstr(w, ", mut = ");                     \
+    writer_cstr(w, mut == M_Mut ? "Mut" : "Const"); \
                                                         \
-    sb_append_cstr(sb, ", nullable = ");                \
-    sb_append_cstr(sb, nullable ? "true" : "false");    \
+    writer_cstr(w, ", nullable = ");                \
+    writer_cstr(w, nullable ? "true" : "false");    \
                                                         \
-    sb_append_cstr(sb, ",\n");                          \
-    indent(sb, level + 1);                              \
-    sb_append_cstr(sb, "ty = ");                        \
-    ast_print_type(sb, ty, level + 1);                  \
+    writer_cstr(w, ",\n");                          \
+    indent(w, level + 1);                              \
+    writer_cstr(w, "ty = ");                        \
+    ast_print_type(w, ty, level + 1);                  \
 } while(0);
 
 #define PRINT_TY \
 do {                                    \
-    sb_append_cstr(sb, ",\n");          \
-    indent(sb, level + 1);              \
-    sb_append_cstr(sb, "ty = ");        \
-    ast_print_type(sb, ty, level + 1);  \
+    writer_cstr(w, ",\n");          \
+    indent(w, level + 1);              \
+    writer_cstr(w, "ty = ");        \
+    ast_print_type(w, ty, level + 1);  \
 } while (0);
 
     bswitch(type, {
         bind(TyPath, (path) {
-            sb_append_cstr(sb, ", path = ");
-            ast_print_path(sb, &path);
+            writer_cstr(w, ", path = ");
+            ast_print_path(w, &path);
         });
         bind(Owned, (ty) {
             PRINT_TY
@@ -304,45 +309,43 @@ do {                                    \
             PRINT_MUT_TY
         });
         bind(TyArray, (ty, size) {
-            sb_append_cstr(sb, ", size = ");
-            char buffer[50] = {0};
-            sprintf(buffer, "%zu", size);
-            sb_append_cstr(sb, buffer);
-
-            sb_append_cstr(sb, ",\n");
-            indent(sb, level + 1);
-            sb_append_cstr(sb, "ty = ");
-            ast_print_type(sb, ty, level + 1);
+            writer_cstr(w, ", size = ");
+            writer_u64(w, size);
+
+            writer_cstr(w, ",\n");
+            indent(w, level + 1);
+            writer_cstr(w, "ty = ");
+            ast_print_type(w, ty, level + 1);
         });
         bind(TySlice, (ty) {
             PRINT_TY
         });
         bind(TyTuple, (types) {
-            sb_append_cstr(sb, ", types = [\n");
+            writer_cstr(w, ", types = [\n");
             for (size_t i = 0; i < types.count; i++) {
                 Ast_Type* type = types.items[i];
-                indent(sb, level + 1);
-                ast_print_type(sb, type, level + 1);
-                sb_append_cstr(sb, ",\n");
+                indent(w, level + 1);
+                ast_print_type(w, type, level + 1);
+                writer_cstr(w, ",\n");
             }
-            indent(sb, level);
-            sb_append_cstr(sb, "]");
+            indent(w, level);
+            writer_cstr(w, "]");
         });
         bind(Generic, (base, arguments) {
-            sb_append_cstr(sb, ",\n");
-            indent(sb, level + 1);
-            sb_append_cstr(sb, "base = ");
-            ast_print_type(sb, base, level + 1);
+            writer_cstr(w, ",\n");
+            indent(w, level + 1);
+            writer_cstr(w, "base = ");
+            ast_print_type(w, base, level + 1);
 
-            sb_append_cstr(sb, ", arguments = [\n");
+            writer_cstr(w, ", arguments = [\n");
             for (size_t i = 0; i < arguments.count; i++) {
                 Ast_Type* type = arguments.items[i];
-                indent(sb, level + 1);
-                ast_print_type(sb, type, level + 1);
-                sb_append_cstr(sb, ",\n");
+                indent(w, level + 1);
+                ast_print_type(w, type, level + 1);
+                writer_cstr(w, ",\n");
             }
-            indent(sb, level);
-            sb_append_cstr(sb, "]");
+            indent(w, level);
+            writer_cstr(w, "]");
         })
         bind(Nullable, (ty) {
             PRINT_TY
@@ -351,49 +354,57 @@ do {                                    \
     });
 
     if (type->kind != Inferred_kind)
-        sb_append_cstr(sb, " }");
+        writer_cstr(w, " }");
 }
 
-void ast_print_item(String_Builder *sb, Ast_Item *item, uint32_t level) {
-    sb_append_cstr(sb, item_to_string(item->kind));
-    sb_append_cstr(sb, " { ");
+void ast_print_item(Writer *w, Ast_Item *item, uint32_t level) {
+    writer_cstr(w, item_to_string(item->kind));
+    writer_cstr(w, " { ");
 
-    sb_append_cstr(sb, "span = ");
-    lexer_print_span(sb, item->span);
+    writer_cstr(w, "span = ");
+    lexer_print_span(w, item->span);
 
     bswitch(item, {
         bind(RunBlock, (block) {
-            sb_append_cstr(sb, ", ");
-            ast_print_block(sb, block, level + 1);
+            writer_cstr(w, ", ");
+            ast_print_block(w, block, level + 1);
+        });
+        bind(Include, (path) {
+            writer_cstr(w, ", path = ");
+            writer_write(w, path.items, path.count);
+        });
+        bind(Open, (path) {
+            writer_cstr(w, ", path = ");
+            writer_write(w, path.items, path.count);
         });
         default: break;
     });
 
-    sb_append_cstr(sb, " }");
+    writer_cstr(w, " }");
 }
 
-void ast_print_block(String_Builder *sb, Ast_Block *block, uint32_t level) {
-    sb_append_cstr(sb, "Block [\n");
+void ast_print_block(Writer *w, Ast_Block *block, uint32_t level) {
+    writer_cstr(w, "Block [\n");
 
     for (size_t i = 0; i < block->stmts.count; i++) {
         Ast_Stmt *stmt = block->stmts.items[i];
-        indent(sb, level + 1);
-        ast_print_stmt(sb, stmt, level + 1);
-        sb_append_cstr(sb, ",\n");
+        indent(w, level + 1);
+        ast_print_stmt(w, stmt, level + 1);
+        writer_cstr(w, ",\n");
     }
-    indent(sb, level);
-    sb_append_cstr(sb, "]");
+    indent(w, level);
+    writer_cstr(w, "]");
 }
 
-void ast_print_source(String_Builder *sb, Ast_Source *source, uint32_t level) {
-    sb_append_cstr(sb, "Source [\n");
+void ast_print_source(Writer *w, Ast_Source *source, uint32_t level) {
+    writer_cstr(w, "Source [\n");
 
     for (size_t i = 0; i < source->count; i++) {
         Ast_Item *item = source->items[i];
-        indent(sb, level + 1);
-        ast_print_item(sb, item, level + 1);
-        sb_append_cstr(sb, ",\n");
+        indent(w, level + 1);
+        ast_print_item(w, item, level + 1);
+        writer_cstr(w, ",\n");
     }
-    indent(sb, level);
-    sb_append_cstr(sb, "]");
+    indent(w, level);
+    writer_cstr(w, "]");
 }
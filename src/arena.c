@@ -0,0 +1,86 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+
+#define ARENA_ALIGN _Alignof(max_align_t)
+
+static inline
+size_t _align(size_t size) {
+    return (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+}
+
+static
+Arena_Block *_next_block(Arena *arena, size_t size) {
+    // blocks kept by arena_reset come first
+    Arena_Block *next = arena->last != NULL ? arena->last->next : NULL;
+    if (next != NULL && next->capacity >= size) {
+        arena->last = next;
+        return next;
+    }
+
+    size_t capacity = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+    Arena_Block *block = malloc(sizeof(Arena_Block) + capacity);
+    assert(block != NULL && "Buy more RAM lol");
+    block->next = next;
+    block->count = 0;
+    block->capacity = capacity;
+
+    if (arena->last == NULL) {
+        arena->first = block;
+    } else {
+        arena->last->next = block;
+    }
+    arena->last = block;
+    return block;
+}
+
+void *arena_alloc(Arena *arena, size_t size) {
+    size = _align(size);
+    Arena_Block *block = arena->last;
+    if (block == NULL || block->capacity - block->count < size) {
+        block = _next_block(arena, size);
+    }
+    void *result = block->data + block->count;
+    block->count += size;
+    return result;
+}
+
+void *arena_grow(Arena *arena, void *ptr, size_t old_size, size_t new_size) {
+    if (ptr == NULL) {
+        return arena_alloc(arena, new_size);
+    }
+
+    assert(new_size >= old_size && "arena allocations can only grow");
+    old_size = _align(old_size);
+    new_size = _align(new_size);
+    Arena_Block *block = arena->last;
+    char *end = block->data + block->count;
+    if ((char *)ptr + old_size == end && block->capacity - block->count >= new_size - old_size) {
+        block->count += new_size - old_size;
+        return ptr;
+    }
+
+    void *result = arena_alloc(arena, new_size);
+    memcpy(result, ptr, old_size);
+    return result;
+}
+
+void arena_reset(Arena *arena) {
+    for (Arena_Block *block = arena->first; block != NULL; block = block->next) {
+        block->count = 0;
+    }
+    arena->last = arena->first;
+}
+
+void arena_free(Arena *arena) {
+    Arena_Block *block = arena->first;
+    while (block != NULL) {
+        Arena_Block *next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->first = NULL;
+    arena->last = NULL;
+}
@@ -0,0 +1,49 @@
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <stddef.h>
+
+#define ARENA_BLOCK_SIZE (64*1024)
+#define ARENA_DA_INIT_CAP 2
+
+typedef struct _Arena_Block Arena_Block;
+
+struct _Arena_Block {
+    Arena_Block *next;
+    size_t count;
+    size_t capacity;
+    _Alignas(max_align_t) char data[];
+};
+
+// Bump allocator for data that lives as long as the arena, everything is
+// released at once by `arena_free`.
+typedef struct {
+    Arena_Block *first;
+    Arena_Block *last;
+} Arena;
+
+void *arena_alloc(Arena *arena, size_t size);
+// Resizes the allocation at `ptr`. It is extended in place if it is the last
+// allocation of the arena, otherwise it is copied and the old space is lost.
+void *arena_grow(Arena *arena, void *ptr, size_t old_size, size_t new_size);
+// Forgets every allocation but keeps the blocks, they are reused in order
+void arena_reset(Arena *arena);
+void arena_free(Arena *arena);
+
+// `da_append` for dynamic arrays whose items live in an arena. Small vectors
+// that are built without interruption grow in place and never touch malloc.
+#define arena_da_append(arena, da, item)                                             \
+    do {                                                                             \
+        if ((da)->count >= (da)->capacity) {                                         \
+            size_t __capacity =                                                      \
+                (da)->capacity == 0 ? ARENA_DA_INIT_CAP : (da)->capacity*2;          \
+            (da)->items = arena_grow((arena), (da)->items,                           \
+                                     (da)->capacity*sizeof(*(da)->items),            \
+                                     __capacity*sizeof(*(da)->items));               \
+            (da)->capacity = __capacity;                                             \
+        }                                                                            \
+                                                                                     \
+        (da)->items[(da)->count++] = (item);                                         \
+    } while (0)
+
+#endif // ARENA_H_
@@ -0,0 +1,57 @@
+#ifndef AST_BIN_H_
+#define AST_BIN_H_
+
+#include <stdint.h>
+
+// Binary AST format, as written by `--emit=ast-bin`.
+//
+// The file starts with `AST_BIN_MAGIC`, followed by one record per node in
+// post-order and ends with an `Ast_BinTrailer` pointing at the root. Every
+// record starts with an `Ast_BinHeader` holding its size in bytes and is
+// padded to 8 bytes, so records can be read in place from a mapped file:
+// casting `base + offset` to the record type for `klass`/`kind` is all there
+// is to decoding. Values are stored in host byte order.
+//
+// Children are referenced by their absolute file offset, 0 means there is
+// no child. Variable length data (strings, paths, child lists) is stored
+// behind the fixed part of the record and referenced by an `Ast_BinSlice`
+// relative to the start of the record.
+//
+// The record layouts of the nodes are generated into ast_export.generated.h,
+// which is all a reader has to include.
+
+#define AST_BIN_MAGIC "BANGAST1"
+#define AST_BIN_SOURCE 0xffff
+
+typedef struct {
+    uint32_t offset;
+    uint32_t count;
+} Ast_BinSlice;
+
+typedef struct {
+    uint32_t size;
+    // `Ast_NodeClass` or AST_BIN_SOURCE for the root
+    uint16_t klass;
+    uint16_t kind;
+    // start row, start col, end row, end col
+    uint32_t span[4];
+} Ast_BinHeader;
+
+typedef struct {
+    uint64_t root;
+    char magic[8];
+} Ast_BinTrailer;
+
+typedef struct {
+    Ast_BinHeader header;
+    // `count` child offsets
+    Ast_BinSlice items;
+} Ast_BinSource;
+
+typedef struct {
+    Ast_BinHeader header;
+    // `count` child offsets
+    Ast_BinSlice stmts;
+} Ast_BinBlock;
+
+#endif // AST_BIN_H_
@@ -0,0 +1,119 @@
+// this file was generated from ast_children.h.templ8
+#ifndef  AST_CHILDREN_H_
+#define  AST_CHILDREN_H_
+
+#ifndef  AST_CHILDREN_H_PREFIX
+#define  AST_CHILDREN_H_PREFIX
+#endif //AST_CHILDREN_H_PREFIX
+
+void ast_walk_push_children(Ast_WalkStack *stack, Ast_NodeClass klass, void *node);
+
+#ifdef   AST_CHILDREN_H_IMPLEMENTATION
+AST_CHILDREN_H_PREFIX
+void ast_walk_push_children(Ast_WalkStack *stack, Ast_NodeClass klass, void *node) {
+    // children are pushed in reverse, so they are popped in declaration order
+    switch (klass) {
+        case Node_Expr: {
+            Ast_Expr *expr = node;
+            switch (expr->kind) {
+                case Unary_kind:
+                    ast_walk_push(stack, Node_Expr, &expr->Unary.expr);
+                    break;
+                case Call_kind:
+                    ast_walk_push_list(stack, Node_Expr, expr->Call.arguments);
+                    ast_walk_push(stack, Node_Expr, &expr->Call.function);
+                    break;
+                case Subscript_kind:
+                    ast_walk_push(stack, Node_Expr, &expr->Subscript.subscript);
+                    ast_walk_push(stack, Node_Expr, &expr->Subscript.base);
+                    break;
+                case Member_kind:
+                    ast_walk_push(stack, Node_Expr, &expr->Member.expr);
+                    break;
+                case Paren_kind:
+                    ast_walk_push(stack, Node_Expr, &expr->Paren.expr);
+                    break;
+                case Binary_kind:
+                    ast_walk_push(stack, Node_Expr, &expr->Binary.rhs);
+                    ast_walk_push(stack, Node_Expr, &expr->Binary.lhs);
+                    break;
+                case Assign_kind:
+                    ast_walk_push(stack, Node_Expr, &expr->Assign.rhs);
+                    ast_walk_push(stack, Node_Expr, &expr->Assign.lhs);
+                    break;
+                case Refrence_kind:
+                    ast_walk_push(stack, Node_Expr, &expr->Refrence.expr);
+                    break;
+                case If_kind:
+                    ast_walk_push(stack, Node_Expr, &expr->If.else_block);
+                    ast_walk_push(stack, Node_Block, &expr->If.if_branch);
+                    ast_walk_push(stack, Node_Expr, &expr->If.condition);
+                    break;
+                case Block_kind:
+                    ast_walk_push(stack, Node_Block, &expr->Block.block);
+                    break;
+                default: break;
+            }
+        } break;
+        case Node_Type: {
+            Ast_Type *type = node;
+            switch (type->kind) {
+                case Owned_kind:
+                    ast_walk_push(stack, Node_Type, &type->Owned.ty);
+                    break;
+                case Ref_kind:
+                    ast_walk_push(stack, Node_Type, &type->Ref.ty);
+                    break;
+                case Ptr_kind:
+                    ast_walk_push(stack, Node_Type, &type->Ptr.ty);
+                    break;
+                case Generic_kind:
+                    ast_walk_push_list(stack, Node_Type, type->Generic.arguments);
+                    ast_walk_push(stack, Node_Type, &type->Generic.base);
+                    break;
+                case TyArray_kind:
+                    ast_walk_push(stack, Node_Type, &type->TyArray.ty);
+                    break;
+                case TySlice_kind:
+                    ast_walk_push(stack, Node_Type, &type->TySlice.ty);
+                    break;
+                case TyTuple_kind:
+                    ast_walk_push_list(stack, Node_Type, type->TyTuple.types);
+                    break;
+                case Nullable_kind:
+                    ast_walk_push(stack, Node_Type, &type->Nullable.ty);
+                    break;
+                default: break;
+            }
+        } break;
+        case Node_Stmt: {
+            Ast_Stmt *stmt = node;
+            switch (stmt->kind) {
+                case Expr_kind:
+                    ast_walk_push(stack, Node_Expr, &stmt->Expr.expr);
+                    break;
+                case Decl_kind:
+                    ast_walk_push(stack, Node_Type, &stmt->Decl.type);
+                    ast_walk_push(stack, Node_Expr, &stmt->Decl.init);
+                    break;
+                default: break;
+            }
+        } break;
+        case Node_Item: {
+            Ast_Item *item = node;
+            switch (item->kind) {
+                case RunBlock_kind:
+                    ast_walk_push(stack, Node_Block, &item->RunBlock.block);
+                    break;
+                default: break;
+            }
+        } break;
+        case Node_Block: {
+            Ast_Block *block = node;
+            ast_walk_push_list(stack, Node_Stmt, block->stmts);
+        } break;
+    }
+}
+#endif //AST_CHILDREN_H_IMPLEMENTATION
+
+#endif //AST_CHILDREN_H_
\ No newline at end of file
@@ -0,0 +1,312 @@
+#include <assert.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "AST.h"
+#include "ast_bin.h"
+#include "dynarray.h"
+#include "visitor.h"
+#include "writer.h"
+
+// Both exporters run on the visitor, so arbitrarily deep trees are written
+// without recursion. The per-node code is generated from the node X-macros
+// in ast_export.h.templ8.
+
+typedef struct {
+    Ast_NodeClass klass;
+    void *node;
+    // next child field and the position within it, if it is a list
+    uint32_t field;
+    uint32_t index;
+} Ast_JsonFrame;
+
+typedef struct {
+    Ast_JsonFrame *items;
+    size_t count;
+    size_t capacity;
+} Ast_JsonFrames;
+
+typedef struct {
+    Writer *w;
+    Ast_JsonFrames frames;
+    size_t items;
+} Ast_JsonExport;
+
+typedef struct {
+    uint32_t *items;
+    size_t count;
+    size_t capacity;
+} Ast_BinOffsets;
+
+typedef struct {
+    Writer *w;
+    // number of bytes written so far
+    uint64_t offset;
+    // offsets of the written nodes whose parent is still open
+    Ast_BinOffsets offsets;
+    // the record currently being built
+    String_Builder record;
+} Ast_BinExport;
+
+static
+const char *_mutability_to_string(Ast_Mutability mut) {
+    return mut == M_Mut ? "Mut" : "Const";
+}
+
+static
+int _literal_union_member(Ast_Expr *expr) {
+    switch (expr->Literal.kind) {
+        case L_String: return 0;
+        case L_Char: return 1;
+        case L_Boolean: return 2;
+        case L_Integer: return 3;
+        case L_Float: return 4;
+        case L_Nil: return -1;
+    }
+    return -1;
+}
+
+static
+void _json_string(Writer *w, const char *data, size_t count) {
+    static const char hex[] = "0123456789abcdef";
+    writer_char(w, '"');
+    size_t start = 0;
+    for (size_t i = 0; i < count; i++) {
+        unsigned char chr = data[i];
+        if (chr >= 0x20 && chr != '"' && chr != '\\') {
+            continue;
+        }
+        // copy runs of plain characters in one go
+        writer_write(w, data + start, i - start);
+        start = i + 1;
+        switch (chr) {
+            case '"': writer_cstr(w, "\\\""); break;
+            case '\\': writer_cstr(w, "\\\\"); break;
+            case '\n': writer_cstr(w, "\\n"); break;
+            case '\r': writer_cstr(w, "\\r"); break;
+            case '\t': writer_cstr(w, "\\t"); break;
+            default: {
+                char escape[6] = { '\\', 'u', '0', '0', hex[chr >> 4], hex[chr & 0xf] };
+                writer_write(w, escape, sizeof(escape));
+            } break;
+        }
+    }
+    writer_write(w, data + start, count - start);
+    writer_char(w, '"');
+}
+
+static inline
+void _json_cstr(Writer *w, const char *cstr) {
+    _json_string(w, cstr, strlen(cstr));
+}
+
+static
+void _json_f64(Writer *w, double value) {
+    if (!isfinite(value)) {
+        writer_cstr(w, "null");
+        return;
+    }
+    char buffer[32];
+    int count = snprintf(buffer, sizeof(buffer), "%.17g", value);
+    assert(count >= 0 && (size_t)count < sizeof(buffer));
+    writer_write(w, buffer, count);
+}
+
+static
+void _json_span(Writer *w, Lex_Span span) {
+    writer_cstr(w, ",\"span\":[");
+    writer_u64(w, span.start.row);
+    writer_char(w, ',');
+    writer_u64(w, span.start.col);
+    writer_char(w, ',');
+    writer_u64(w, span.end.row);
+    writer_char(w, ',');
+    writer_u64(w, span.end.col);
+    writer_char(w, ']');
+}
+
+static
+void _json_path(Writer *w, Ast_Path *path) {
+    writer_char(w, '[');
+    for (size_t i = 0; i < path->count; i++) {
+        if (i > 0) {
+            writer_char(w, ',');
+        }
+        String_Builder *ident = &path->items[i].ident;
+        _json_string(w, ident->items, ident->count);
+    }
+    writer_char(w, ']');
+}
+
+static inline
+Ast_BinHeader _bin_header(Ast_NodeClass klass, uint32_t kind, Lex_Span span) {
+    return (Ast_BinHeader) {
+        .klass = klass,
+        .kind = kind,
+        .span = { span.start.row, span.start.col, span.end.row, span.end.col },
+    };
+}
+
+// Appends `size` zeroed bytes aligned to `align` to the current record and
+// returns their offset within it
+static
+uint32_t _bin_reserve(Ast_BinExport *e, size_t size, size_t align) {
+    String_Builder *record = &e->record;
+    size_t offset = (record->count + align - 1) & ~(align - 1);
+    size_t count = offset + size;
+    if (count > record->capacity) {
+        record->capacity = record->capacity == 0 ? 256 : record->capacity;
+        while (count > record->capacity) {
+            record->capacity *= 2;
+        }
+        record->items = realloc(record->items, record->capacity);
+        assert(record->items != NULL && "Buy more RAM lol");
+    }
+    memset(record->items + record->count, 0, count - record->count);
+    record->count = count;
+    assert(offset <= UINT32_MAX && "record too large for the binary format");
+    return offset;
+}
+
+static inline
+void _bin_begin(Ast_BinExport *e, size_t fixed_size) {
+    e->record.count = 0;
+    _bin_reserve(e, fixed_size, 8);
+}
+
+static
+Ast_BinSlice _bin_string(Ast_BinExport *e, const char *data, size_t count) {
+    uint32_t offset = _bin_reserve(e, count, 1);
+    memcpy(e->record.items + offset, data, count);
+    return (Ast_BinSlice) { .offset = offset, .count = count };
+}
+
+static
+Ast_BinSlice _bin_path(Ast_BinExport *e, Ast_Path *path) {
+    uint32_t offset = _bin_reserve(e, path->count * sizeof(Ast_BinSlice), 4);
+    for (size_t i = 0; i < path->count; i++) {
+        String_Builder *ident = &path->items[i].ident;
+        Ast_BinSlice segment = _bin_string(e, ident->items, ident->count);
+        // the record may have moved while appending the string
+        memcpy(e->record.items + offset + i * sizeof(Ast_BinSlice), &segment, sizeof(segment));
+    }
+    return (Ast_BinSlice) { .offset = offset, .count = path->count };
+}
+
+static inline
+uint32_t _bin_child(Ast_BinExport *e, size_t *child, const void *node) {
+    if (node == NULL) {
+        return 0;
+    }
+    return e->offsets.items[(*child)++];
+}
+
+static
+Ast_BinSlice _bin_children(Ast_BinExport *e, size_t *child, size_t count) {
+    uint32_t offset = _bin_reserve(e, count * sizeof(uint32_t), 4);
+    memcpy(e->record.items + offset, e->offsets.items + *child, count * sizeof(uint32_t));
+    *child += count;
+    return (Ast_BinSlice) { .offset = offset, .count = count };
+}
+
+// Writes out the current record with `fixed` as its head and replaces the
+// offsets of its children with its own
+static
+void _bin_end(Ast_BinExport *e, const void *fixed, size_t fixed_size, size_t first_child) {
+    _bin_reserve(e, 0, 8);
+    uint32_t size = e->record.count;
+    memcpy(e->record.items, fixed, fixed_size);
+    memcpy(e->record.items + offsetof(Ast_BinHeader, size), &size, sizeof(size));
+
+    assert(e->offset <= UINT32_MAX && "AST too large for the binary format");
+    e->offsets.count = first_child;
+    da_append(&e->offsets, (uint32_t)e->offset);
+
+    writer_write(e->w, e->record.items, size);
+    e->offset += size;
+}
+
+#define AST_EXPORT_H_IMPLEMENTATION
+#include "ast_export.generated.h"
+
+static
+Ast_VisitResult _json_pre(Ast_Visitor *visitor, Ast_Node node) {
+    Ast_JsonExport *e = visitor->data;
+    if (e->frames.count > 0) {
+        bool has_child = _json_next_child(e->w, &e->frames.items[e->frames.count - 1]);
+        assert(has_child && "json exporter out of sync with the walk");
+        (void)has_child;
+    } else if (e->items++ > 0) {
+        writer_char(e->w, ',');
+    }
+
+    _json_node_begin(e->w, node.klass, node.ptr);
+    Ast_JsonFrame frame = { .klass = node.klass, .node = node.ptr };
+    da_append(&e->frames, frame);
+    return Visit_Continue;
+}
+
+static
+Ast_VisitResult _json_post(Ast_Visitor *visitor, Ast_Node node) {
+    (void)node;
+    Ast_JsonExport *e = visitor->data;
+    Ast_JsonFrame *frame = &e->frames.items[--e->frames.count];
+    bool has_child = _json_next_child(e->w, frame);
+    assert(!has_child && "json exporter out of sync with the walk");
+    (void)has_child;
+    writer_char(e->w, '}');
+    return Visit_Continue;
+}
+
+void ast_export_json(Writer *w, Ast_Source *source) {
+    Ast_JsonExport e = { .w = w };
+    Ast_Visitor visitor = {
+        .pre = _json_pre,
+        .post = _json_post,
+        .data = &e,
+    };
+
+    writer_cstr(w, "{\"items\":[");
+    ast_walk_source(&visitor, source);
+    writer_cstr(w, "]}\n");
+
+    ast_visitor_free(&visitor);
+    free(e.frames.items);
+}
+
+static
+Ast_VisitResult _bin_post(Ast_Visitor *visitor, Ast_Node node) {
+    _bin_write_node(visitor->data, node.klass, node.ptr);
+    return Visit_Continue;
+}
+
+void ast_export_bin(Writer *w, Ast_Source *source) {
+    Ast_BinExport e = { .w = w };
+    Ast_Visitor visitor = {
+        .post = _bin_post,
+        .data = &e,
+    };
+
+    writer_write(w, AST_BIN_MAGIC, 8);
+    e.offset = 8;
+    ast_walk_source(&visitor, source);
+
+    Ast_BinSource record;
+    memset(&record, 0, sizeof(record));
+    record.header.klass = AST_BIN_SOURCE;
+    size_t child = 0;
+    _bin_begin(&e, sizeof(record));
+    record.items = _bin_children(&e, &child, source->count);
+    _bin_end(&e, &record, sizeof(record), 0);
+
+    Ast_BinTrailer trailer = { .root = e.offsets.items[0] };
+    memcpy(trailer.magic, AST_BIN_MAGIC, sizeof(trailer.magic));
+    writer_write(w, (const char *)&trailer, sizeof(trailer));
+
+    ast_visitor_free(&visitor);
+    free(e.offsets.items);
+    free(e.record.items);
+}
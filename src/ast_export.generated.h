@@ -0,0 +1,1156 @@
+// this file was generated from ast_export.h.templ8
+#ifndef  AST_EXPORT_H_
+#define  AST_EXPORT_H_
+
+#ifndef  AST_EXPORT_H_PREFIX
+#define  AST_EXPORT_H_PREFIX
+#endif //AST_EXPORT_H_PREFIX
+
+#include "ast_bin.h"
+
+// Record layouts of the nodes, see ast_bin.h for the format
+typedef struct {
+    Ast_BinHeader header;
+    uint32_t kind;
+    union {
+        Ast_BinSlice string;
+        uint32_t wchar;
+        uint32_t boolean;
+        uint64_t integer;
+        double floating;
+    };
+    uint32_t nclass;
+} Ast_BinExpr_Literal;
+
+typedef struct {
+    Ast_BinHeader header;
+    Ast_BinSlice path;
+} Ast_BinExpr_Path;
+
+typedef struct {
+    Ast_BinHeader header;
+    uint32_t op;
+    uint32_t expr;
+} Ast_BinExpr_Unary;
+
+typedef struct {
+    Ast_BinHeader header;
+    uint32_t function;
+    Ast_BinSlice arguments;
+} Ast_BinExpr_Call;
+
+typedef struct {
+    Ast_BinHeader header;
+    uint32_t base;
+    uint32_t subscript;
+} Ast_BinExpr_Subscript;
+
+typedef struct {
+    Ast_BinHeader header;
+    uint32_t expr;
+    Ast_BinSlice ident;
+} Ast_BinExpr_Member;
+
+typedef struct {
+    Ast_BinHeader header;
+    uint32_t expr;
+} Ast_BinExpr_Paren;
+
+typedef struct {
+    Ast_BinHeader header;
+    uint32_t op;
+    uint32_t lhs;
+    uint32_t rhs;
+} Ast_BinExpr_Binary;
+
+typedef struct {
+    Ast_BinHeader header;
+    uint32_t op;
+    uint32_t lhs;
+    uint32_t rhs;
+} Ast_BinExpr_Assign;
+
+typedef struct {
+    Ast_BinHeader header;
+    uint32_t expr;
+} Ast_BinExpr_Refrence;
+
+typedef struct {
+    Ast_BinHeader header;
+    uint32_t condition;
+    uint32_t if_branch;
+    uint32_t else_block;
+} Ast_BinExpr_If;
+
+typedef struct {
+    Ast_BinHeader header;
+    uint32_t block;
+} Ast_BinExpr_Block;
+
+typedef struct {
+    Ast_BinHeader header;
+    Ast_BinSlice path;
+} Ast_BinType_TyPath;
+
+typedef struct {
+    Ast_BinHeader header;
+    uint32_t ty;
+} Ast_BinType_Owned;
+
+typedef struct {
+    Ast_BinHeader header;
+    uint32_t ty;
+    uint32_t mut;
+    uint32_t nullable;
+} Ast_BinType_Ref;
+
+typedef struct {
+    Ast_BinHeader header;
+    uint32_t ty;
+    uint32_t mut;
+    uint32_t nullable;
+} Ast_BinType_Ptr;
+
+typedef struct {
+    Ast_BinHeader header;
+    uint32_t base;
+    Ast_BinSlice arguments;
+} Ast_BinType_Generic;
+
+typedef struct {
+    Ast_BinHeader header;
+    uint32_t ty;
+    uint64_t size;
+} Ast_BinType_TyArray;
+
+typedef struct {
+    Ast_BinHeader header;
+    uint32_t ty;
+} Ast_BinType_TySlice;
+
+typedef struct {
+    Ast_BinHeader header;
+    Ast_BinSlice types;
+} Ast_BinType_TyTuple;
+
+typedef struct {
+    Ast_BinHeader header;
+} Ast_BinType_Inferred;
+
+typedef struct {
+    Ast_BinHeader header;
+    uint32_t ty;
+} Ast_BinType_Nullable;
+
+typedef struct {
+    Ast_BinHeader header;
+    uint32_t expr;
+    uint32_t semicolon;
+} Ast_BinStmt_Expr;
+
+typedef struct {
+    Ast_BinHeader header;
+    uint32_t mut;
+    Ast_BinSlice ident;
+    uint32_t init;
+    uint32_t type;
+} Ast_BinStmt_Decl;
+
+typedef struct {
+    Ast_BinHeader header;
+    uint32_t block;
+} Ast_BinItem_RunBlock;
+
+typedef struct {
+    Ast_BinHeader header;
+    Ast_BinSlice path;
+} Ast_BinItem_Include;
+
+typedef struct {
+    Ast_BinHeader header;
+    Ast_BinSlice path;
+} Ast_BinItem_Open;
+
+#ifdef   AST_EXPORT_H_IMPLEMENTATION
+AST_EXPORT_H_PREFIX
+// Writes the opening of a JSON object for `node` up to its first child
+static
+void _json_node_begin(Writer *w, Ast_NodeClass klass, void *node) {
+    switch (klass) {
+        case Node_Expr: {
+            Ast_Expr *expr = node;
+            switch (expr->kind) {
+                case Literal_kind:
+                    writer_cstr(w, "{\"node\":\"expr.Literal\"");
+                    _json_span(w, expr->span);
+                    writer_cstr(w, ",\"kind\":");
+                    _json_cstr(w, (const char *[]){ "L_String", "L_Char", "L_Integer", "L_Float", "L_Boolean", "L_Nil" }[expr->Literal.kind]);
+                    writer_cstr(w, ",\"nclass\":");
+                    _json_cstr(w, number_class_to_string(expr->Literal.nclass));
+                    switch (_literal_union_member(expr)) {
+                        case 0:
+                            writer_cstr(w, ",\"string\":");
+                            _json_string(w, expr->Literal.string.items, expr->Literal.string.count);
+                            break;
+                        case 1:
+                            writer_cstr(w, ",\"wchar\":");
+                            writer_u64(w, expr->Literal.wchar);
+                            break;
+                        case 2:
+                            writer_cstr(w, ",\"boolean\":");
+                            writer_cstr(w, expr->Literal.boolean ? "true" : "false");
+                            break;
+                        case 3:
+                            writer_cstr(w, ",\"integer\":");
+                            writer_u64(w, expr->Literal.integer);
+                            break;
+                        case 4:
+                            writer_cstr(w, ",\"floating\":");
+                            _json_f64(w, expr->Literal.floating);
+                            break;
+                        default: break;
+                    }
+                    break;
+                case Path_kind:
+                    writer_cstr(w, "{\"node\":\"expr.Path\"");
+                    _json_span(w, expr->span);
+                    writer_cstr(w, ",\"path\":");
+                    _json_path(w, &expr->Path.path);
+                    break;
+                case Unary_kind:
+                    writer_cstr(w, "{\"node\":\"expr.Unary\"");
+                    _json_span(w, expr->span);
+                    writer_cstr(w, ",\"op\":");
+                    _json_cstr(w, unary_op_to_string(expr->Unary.op));
+                    break;
+                case Call_kind:
+                    writer_cstr(w, "{\"node\":\"expr.Call\"");
+                    _json_span(w, expr->span);
+                    break;
+                case Subscript_kind:
+                    writer_cstr(w, "{\"node\":\"expr.Subscript\"");
+                    _json_span(w, expr->span);
+                    break;
+                case Member_kind:
+                    writer_cstr(w, "{\"node\":\"expr.Member\"");
+                    _json_span(w, expr->span);
+                    writer_cstr(w, ",\"ident\":");
+                    _json_string(w, expr->Member.ident.items, expr->Member.ident.count);
+                    break;
+                case Paren_kind:
+                    writer_cstr(w, "{\"node\":\"expr.Paren\"");
+                    _json_span(w, expr->span);
+                    break;
+                case Binary_kind:
+                    writer_cstr(w, "{\"node\":\"expr.Binary\"");
+                    _json_span(w, expr->span);
+                    writer_cstr(w, ",\"op\":");
+                    _json_cstr(w, binary_op_to_string(expr->Binary.op));
+                    break;
+                case Assign_kind:
+                    writer_cstr(w, "{\"node\":\"expr.Assign\"");
+                    _json_span(w, expr->span);
+                    writer_cstr(w, ",\"op\":");
+                    _json_cstr(w, assignment_op_to_string(expr->Assign.op));
+                    break;
+                case Refrence_kind:
+                    writer_cstr(w, "{\"node\":\"expr.Refrence\"");
+                    _json_span(w, expr->span);
+                    break;
+                case If_kind:
+                    writer_cstr(w, "{\"node\":\"expr.If\"");
+                    _json_span(w, expr->span);
+                    break;
+                case Block_kind:
+                    writer_cstr(w, "{\"node\":\"expr.Block\"");
+                    _json_span(w, expr->span);
+                    break;
+                default: break;
+            }
+        } break;
+        case Node_Type: {
+            Ast_Type *type = node;
+            switch (type->kind) {
+                case TyPath_kind:
+                    writer_cstr(w, "{\"node\":\"type.TyPath\"");
+                    _json_span(w, type->span);
+                    writer_cstr(w, ",\"path\":");
+                    _json_path(w, &type->TyPath.path);
+                    break;
+                case Owned_kind:
+                    writer_cstr(w, "{\"node\":\"type.Owned\"");
+                    _json_span(w, type->span);
+                    break;
+                case Ref_kind:
+                    writer_cstr(w, "{\"node\":\"type.Ref\"");
+                    _json_span(w, type->span);
+                    writer_cstr(w, ",\"mut\":");
+                    _json_cstr(w, _mutability_to_string(type->Ref.mut));
+                    writer_cstr(w, ",\"nullable\":");
+                    writer_cstr(w, type->Ref.nullable ? "true" : "false");
+                    break;
+                case Ptr_kind:
+                    writer_cstr(w, "{\"node\":\"type.Ptr\"");
+                    _json_span(w, type->span);
+                    writer_cstr(w, ",\"mut\":");
+                    _json_cstr(w, _mutability_to_string(type->Ptr.mut));
+                    writer_cstr(w, ",\"nullable\":");
+                    writer_cstr(w, type->Ptr.nullable ? "true" : "false");
+                    break;
+                case Generic_kind:
+                    writer_cstr(w, "{\"node\":\"type.Generic\"");
+                    _json_span(w, type->span);
+                    break;
+                case TyArray_kind:
+                    writer_cstr(w, "{\"node\":\"type.TyArray\"");
+                    _json_span(w, type->span);
+                    writer_cstr(w, ",\"size\":");
+                    writer_u64(w, type->TyArray.size);
+                    break;
+                case TySlice_kind:
+                    writer_cstr(w, "{\"node\":\"type.TySlice\"");
+                    _json_span(w, type->span);
+                    break;
+                case TyTuple_kind:
+                    writer_cstr(w, "{\"node\":\"type.TyTuple\"");
+                    _json_span(w, type->span);
+                    break;
+                case Inferred_kind:
+                    writer_cstr(w, "{\"node\":\"type.Inferred\"");
+                    _json_span(w, type->span);
+                    break;
+                case Nullable_kind:
+                    writer_cstr(w, "{\"node\":\"type.Nullable\"");
+                    _json_span(w, type->span);
+                    break;
+                default: break;
+            }
+        } break;
+        case Node_Stmt: {
+            Ast_Stmt *stmt = node;
+            switch (stmt->kind) {
+                case Expr_kind:
+                    writer_cstr(w, "{\"node\":\"stmt.Expr\"");
+                    _json_span(w, stmt->span);
+                    writer_cstr(w, ",\"semicolon\":");
+                    writer_cstr(w, stmt->Expr.semicolon ? "true" : "false");
+                    break;
+                case Decl_kind:
+                    writer_cstr(w, "{\"node\":\"stmt.Decl\"");
+                    _json_span(w, stmt->span);
+                    writer_cstr(w, ",\"mut\":");
+                    _json_cstr(w, _mutability_to_string(stmt->Decl.mut));
+                    writer_cstr(w, ",\"ident\":");
+                    _json_string(w, stmt->Decl.ident.items, stmt->Decl.ident.count);
+                    break;
+                default: break;
+            }
+        } break;
+        case Node_Item: {
+            Ast_Item *item = node;
+            switch (item->kind) {
+                case RunBlock_kind:
+                    writer_cstr(w, "{\"node\":\"item.RunBlock\"");
+                    _json_span(w, item->span);
+                    break;
+                case Include_kind:
+                    writer_cstr(w, "{\"node\":\"item.Include\"");
+                    _json_span(w, item->span);
+                    writer_cstr(w, ",\"path\":");
+                    _json_string(w, item->Include.path.items, item->Include.path.count);
+                    break;
+                case Open_kind:
+                    writer_cstr(w, "{\"node\":\"item.Open\"");
+                    _json_span(w, item->span);
+                    writer_cstr(w, ",\"path\":");
+                    _json_string(w, item->Open.path.items, item->Open.path.count);
+                    break;
+                default: break;
+            }
+        } break;
+        case Node_Block: {
+            Ast_Block *block = node;
+            writer_cstr(w, "{\"node\":\"block\"");
+            _json_span(w, block->span);
+        } break;
+    }
+}
+
+// Writes everything in front of the next child of `frame` and returns true,
+// or writes the rest of the object and returns false after the last child
+static
+bool _json_next_child(Writer *w, Ast_JsonFrame *frame) {
+    switch (frame->klass) {
+        case Node_Expr: {
+            Ast_Expr *expr = frame->node;
+            switch (expr->kind) {
+                case Unary_kind:
+                    switch (frame->field) {
+                        case 0:
+                            writer_cstr(w, ",\"expr\":");
+                            if (expr->Unary.expr != NULL) {
+                                frame->field++;
+                                return true;
+                            }
+                            writer_cstr(w, "null");
+                            frame->field++;
+                            __attribute__((fallthrough));
+                        default: break;
+                    }
+                    break;
+                case Call_kind:
+                    switch (frame->field) {
+                        case 0:
+                            writer_cstr(w, ",\"function\":");
+                            if (expr->Call.function != NULL) {
+                                frame->field++;
+                                return true;
+                            }
+                            writer_cstr(w, "null");
+                            frame->field++;
+                            __attribute__((fallthrough));
+                        case 1:
+                            if (frame->index == 0) {
+                                writer_cstr(w, ",\"arguments\":[");
+                            }
+                            if (frame->index < expr->Call.arguments.count) {
+                                if (frame->index > 0) {
+                                    writer_char(w, ',');
+                                }
+                                frame->index++;
+                                return true;
+                            }
+                            writer_char(w, ']');
+                            frame->index = 0;
+                            frame->field++;
+                            __attribute__((fallthrough));
+                        default: break;
+                    }
+                    break;
+                case Subscript_kind:
+                    switch (frame->field) {
+                        case 0:
+                            writer_cstr(w, ",\"base\":");
+                            if (expr->Subscript.base != NULL) {
+                                frame->field++;
+                                return true;
+                            }
+                            writer_cstr(w, "null");
+                            frame->field++;
+                            __attribute__((fallthrough));
+                        case 1:
+                            writer_cstr(w, ",\"subscript\":");
+                            if (expr->Subscript.subscript != NULL) {
+                                frame->field++;
+                                return true;
+                            }
+                            writer_cstr(w, "null");
+                            frame->field++;
+                            __attribute__((fallthrough));
+                        default: break;
+                    }
+                    break;
+                case Member_kind:
+                    switch (frame->field) {
+                        case 0:
+                            writer_cstr(w, ",\"expr\":");
+                            if (expr->Member.expr != NULL) {
+                                frame->field++;
+                                return true;
+                            }
+                            writer_cstr(w, "null");
+                            frame->field++;
+                            __attribute__((fallthrough));
+                        default: break;
+                    }
+                    break;
+                case Paren_kind:
+                    switch (frame->field) {
+                        case 0:
+                            writer_cstr(w, ",\"expr\":");
+                            if (expr->Paren.expr != NULL) {
+                                frame->field++;
+                                return true;
+                            }
+                            writer_cstr(w, "null");
+                            frame->field++;
+                            __attribute__((fallthrough));
+                        default: break;
+                    }
+                    break;
+                case Binary_kind:
+                    switch (frame->field) {
+                        case 0:
+                            writer_cstr(w, ",\"lhs\":");
+                            if (expr->Binary.lhs != NULL) {
+                                frame->field++;
+                                return true;
+                            }
+                            writer_cstr(w, "null");
+                            frame->field++;
+                            __attribute__((fallthrough));
+                        case 1:
+                            writer_cstr(w, ",\"rhs\":");
+                            if (expr->Binary.rhs != NULL) {
+                                frame->field++;
+                                return true;
+                            }
+                            writer_cstr(w, "null");
+                            frame->field++;
+                            __attribute__((fallthrough));
+                        default: break;
+                    }
+                    break;
+                case Assign_kind:
+                    switch (frame->field) {
+                        case 0:
+                            writer_cstr(w, ",\"lhs\":");
+                            if (expr->Assign.lhs != NULL) {
+                                frame->field++;
+                                return true;
+                            }
+                            writer_cstr(w, "null");
+                            frame->field++;
+                            __attribute__((fallthrough));
+                        case 1:
+                            writer_cstr(w, ",\"rhs\":");
+                            if (expr->Assign.rhs != NULL) {
+                                frame->field++;
+                                return true;
+                            }
+                            writer_cstr(w, "null");
+                            frame->field++;
+                            __attribute__((fallthrough));
+                        default: break;
+                    }
+                    break;
+                case Refrence_kind:
+                    switch (frame->field) {
+                        case 0:
+                            writer_cstr(w, ",\"expr\":");
+                            if (expr->Refrence.expr != NULL) {
+                                frame->field++;
+                                return true;
+                            }
+                            writer_cstr(w, "null");
+                            frame->field++;
+                            __attribute__((fallthrough));
+                        default: break;
+                    }
+                    break;
+                case If_kind:
+                    switch (frame->field) {
+                        case 0:
+                            writer_cstr(w, ",\"condition\":");
+                            if (expr->If.condition != NULL) {
+                                frame->field++;
+                                return true;
+                            }
+                            writer_cstr(w, "null");
+                            frame->field++;
+                            __attribute__((fallthrough));
+                        case 1:
+                            writer_cstr(w, ",\"if_branch\":");
+                            if (expr->If.if_branch != NULL) {
+                                frame->field++;
+                                return true;
+                            }
+                            writer_cstr(w, "null");
+                            frame->field++;
+                            __attribute__((fallthrough));
+                        case 2:
+                            writer_cstr(w, ",\"else_block\":");
+                            if (expr->If.else_block != NULL) {
+                                frame->field++;
+                                return true;
+                            }
+                            writer_cstr(w, "null");
+                            frame->field++;
+                            __attribute__((fallthrough));
+                        default: break;
+                    }
+                    break;
+                case Block_kind:
+                    switch (frame->field) {
+                        case 0:
+                            writer_cstr(w, ",\"block\":");
+                            if (expr->Block.block != NULL) {
+                                frame->field++;
+                                return true;
+                            }
+                            writer_cstr(w, "null");
+                            frame->field++;
+                            __attribute__((fallthrough));
+                        default: break;
+                    }
+                    break;
+                default: break;
+            }
+        } break;
+        case Node_Type: {
+            Ast_Type *type = frame->node;
+            switch (type->kind) {
+                case Owned_kind:
+                    switch (frame->field) {
+                        case 0:
+                            writer_cstr(w, ",\"ty\":");
+                            if (type->Owned.ty != NULL) {
+                                frame->field++;
+                                return true;
+                            }
+                            writer_cstr(w, "null");
+                            frame->field++;
+                            __attribute__((fallthrough));
+                        default: break;
+                    }
+                    break;
+                case Ref_kind:
+                    switch (frame->field) {
+                        case 0:
+                            writer_cstr(w, ",\"ty\":");
+                            if (type->Ref.ty != NULL) {
+                                frame->field++;
+                                return true;
+                            }
+                            writer_cstr(w, "null");
+                            frame->field++;
+                            __attribute__((fallthrough));
+                        default: break;
+                    }
+                    break;
+                case Ptr_kind:
+                    switch (frame->field) {
+                        case 0:
+                            writer_cstr(w, ",\"ty\":");
+                            if (type->Ptr.ty != NULL) {
+                                frame->field++;
+                                return true;
+                            }
+                            writer_cstr(w, "null");
+                            frame->field++;
+                            __attribute__((fallthrough));
+                        default: break;
+                    }
+                    break;
+                case Generic_kind:
+                    switch (frame->field) {
+                        case 0:
+                            writer_cstr(w, ",\"base\":");
+                            if (type->Generic.base != NULL) {
+                                frame->field++;
+                                return true;
+                            }
+                            writer_cstr(w, "null");
+                            frame->field++;
+                            __attribute__((fallthrough));
+                        case 1:
+                            if (frame->index == 0) {
+                                writer_cstr(w, ",\"arguments\":[");
+                            }
+                            if (frame->index < type->Generic.arguments.count) {
+                                if (frame->index > 0) {
+                                    writer_char(w, ',');
+                                }
+                                frame->index++;
+                                return true;
+                            }
+                            writer_char(w, ']');
+                            frame->index = 0;
+                            frame->field++;
+                            __attribute__((fallthrough));
+                        default: break;
+                    }
+                    break;
+                case TyArray_kind:
+                    switch (frame->field) {
+                        case 0:
+                            writer_cstr(w, ",\"ty\":");
+                            if (type->TyArray.ty != NULL) {
+                                frame->field++;
+                                return true;
+                            }
+                            writer_cstr(w, "null");
+                            frame->field++;
+                            __attribute__((fallthrough));
+                        default: break;
+                    }
+                    break;
+                case TySlice_kind:
+                    switch (frame->field) {
+                        case 0:
+                            writer_cstr(w, ",\"ty\":");
+                            if (type->TySlice.ty != NULL) {
+                                frame->field++;
+                                return true;
+                            }
+                            writer_cstr(w, "null");
+                            frame->field++;
+                            __attribute__((fallthrough));
+                        default: break;
+                    }
+                    break;
+                case TyTuple_kind:
+                    switch (frame->field) {
+                        case 0:
+                            if (frame->index == 0) {
+                                writer_cstr(w, ",\"types\":[");
+                            }
+                            if (frame->index < type->TyTuple.types.count) {
+                                if (frame->index > 0) {
+                                    writer_char(w, ',');
+                                }
+                                frame->index++;
+                                return true;
+                            }
+                            writer_char(w, ']');
+                            frame->index = 0;
+                            frame->field++;
+                            __attribute__((fallthrough));
+                        default: break;
+                    }
+                    break;
+                case Nullable_kind:
+                    switch (frame->field) {
+                        case 0:
+                            writer_cstr(w, ",\"ty\":");
+                            if (type->Nullable.ty != NULL) {
+                                frame->field++;
+                                return true;
+                            }
+                            writer_cstr(w, "null");
+                            frame->field++;
+                            __attribute__((fallthrough));
+                        default: break;
+                    }
+                    break;
+                default: break;
+            }
+        } break;
+        case Node_Stmt: {
+            Ast_Stmt *stmt = frame->node;
+            switch (stmt->kind) {
+                case Expr_kind:
+                    switch (frame->field) {
+                        case 0:
+                            writer_cstr(w, ",\"expr\":");
+                            if (stmt->Expr.expr != NULL) {
+                                frame->field++;
+                                return true;
+                            }
+                            writer_cstr(w, "null");
+                            frame->field++;
+                            __attribute__((fallthrough));
+                        default: break;
+                    }
+                    break;
+                case Decl_kind:
+                    switch (frame->field) {
+                        case 0:
+                            writer_cstr(w, ",\"init\":");
+                            if (stmt->Decl.init != NULL) {
+                                frame->field++;
+                                return true;
+                            }
+                            writer_cstr(w, "null");
+                            frame->field++;
+                            __attribute__((fallthrough));
+                        case 1:
+                            writer_cstr(w, ",\"type\":");
+                            if (stmt->Decl.type != NULL) {
+                                frame->field++;
+                                return true;
+                            }
+                            writer_cstr(w, "null");
+                            frame->field++;
+                            __attribute__((fallthrough));
+                        default: break;
+                    }
+                    break;
+                default: break;
+            }
+        } break;
+        case Node_Item: {
+            Ast_Item *item = frame->node;
+            switch (item->kind) {
+                case RunBlock_kind:
+                    switch (frame->field) {
+                        case 0:
+                            writer_cstr(w, ",\"block\":");
+                            if (item->RunBlock.block != NULL) {
+                                frame->field++;
+                                return true;
+                            }
+                            writer_cstr(w, "null");
+                            frame->field++;
+                            __attribute__((fallthrough));
+                        default: break;
+                    }
+                    break;
+                default: break;
+            }
+        } break;
+        case Node_Block: {
+            Ast_Block *block = frame->node;
+            if (frame->index == 0) {
+                writer_cstr(w, ",\"stmts\":[");
+            }
+            if (frame->index < block->stmts.count) {
+                if (frame->index > 0) {
+                    writer_char(w, ',');
+                }
+                frame->index++;
+                return true;
+            }
+            writer_char(w, ']');
+        } break;
+    }
+    return false;
+}
+
+// Writes the record for `node`, whose children have all been written
+// already and left their offsets on `e->offsets`
+static
+void _bin_write_node(Ast_BinExport *e, Ast_NodeClass klass, void *node) {
+    switch (klass) {
+        case Node_Expr: {
+            Ast_Expr *expr = node;
+            switch (expr->kind) {
+                case Literal_kind: {
+                    Ast_BinExpr_Literal record;
+                    memset(&record, 0, sizeof(record));
+                    record.header = _bin_header(Node_Expr, expr->kind, expr->span);
+                    size_t first_child = e->offsets.count - (0);
+                    _bin_begin(e, sizeof(record));
+                    record.kind = expr->Literal.kind;
+                    record.nclass = expr->Literal.nclass;
+                    switch (_literal_union_member(expr)) {
+                        case 0:
+                            record.string = _bin_string(e, expr->Literal.string.items, expr->Literal.string.count);
+                            break;
+                        case 1:
+                            record.wchar = expr->Literal.wchar;
+                            break;
+                        case 2:
+                            record.boolean = expr->Literal.boolean;
+                            break;
+                        case 3:
+                            record.integer = expr->Literal.integer;
+                            break;
+                        case 4:
+                            record.floating = expr->Literal.floating;
+                            break;
+                        default: break;
+                    }
+                    _bin_end(e, &record, sizeof(record), first_child);
+                } break;
+                case Path_kind: {
+                    Ast_BinExpr_Path record;
+                    memset(&record, 0, sizeof(record));
+                    record.header = _bin_header(Node_Expr, expr->kind, expr->span);
+                    size_t first_child = e->offsets.count - (0);
+                    _bin_begin(e, sizeof(record));
+                    record.path = _bin_path(e, &expr->Path.path);
+                    _bin_end(e, &record, sizeof(record), first_child);
+                } break;
+                case Unary_kind: {
+                    Ast_BinExpr_Unary record;
+                    memset(&record, 0, sizeof(record));
+                    record.header = _bin_header(Node_Expr, expr->kind, expr->span);
+                    size_t first_child = e->offsets.count - ((expr->Unary.expr != NULL));
+                    size_t child = first_child;
+                    _bin_begin(e, sizeof(record));
+                    record.op = expr->Unary.op;
+                    record.expr = _bin_child(e, &child, expr->Unary.expr);
+                    _bin_end(e, &record, sizeof(record), first_child);
+                } break;
+                case Call_kind: {
+                    Ast_BinExpr_Call record;
+                    memset(&record, 0, sizeof(record));
+                    record.header = _bin_header(Node_Expr, expr->kind, expr->span);
+                    size_t first_child = e->offsets.count - ((expr->Call.function != NULL) + expr->Call.arguments.count);
+                    size_t child = first_child;
+                    _bin_begin(e, sizeof(record));
+                    record.function = _bin_child(e, &child, expr->Call.function);
+                    record.arguments = _bin_children(e, &child, expr->Call.arguments.count);
+                    _bin_end(e, &record, sizeof(record), first_child);
+                } break;
+                case Subscript_kind: {
+                    Ast_BinExpr_Subscript record;
+                    memset(&record, 0, sizeof(record));
+                    record.header = _bin_header(Node_Expr, expr->kind, expr->span);
+                    size_t first_child = e->offsets.count - ((expr->Subscript.base != NULL) + (expr->Subscript.subscript != NULL));
+                    size_t child = first_child;
+                    _bin_begin(e, sizeof(record));
+                    record.base = _bin_child(e, &child, expr->Subscript.base);
+                    record.subscript = _bin_child(e, &child, expr->Subscript.subscript);
+                    _bin_end(e, &record, sizeof(record), first_child);
+                } break;
+                case Member_kind: {
+                    Ast_BinExpr_Member record;
+                    memset(&record, 0, sizeof(record));
+                    record.header = _bin_header(Node_Expr, expr->kind, expr->span);
+                    size_t first_child = e->offsets.count - ((expr->Member.expr != NULL));
+                    size_t child = first_child;
+                    _bin_begin(e, sizeof(record));
+                    record.expr = _bin_child(e, &child, expr->Member.expr);
+                    record.ident = _bin_string(e, expr->Member.ident.items, expr->Member.ident.count);
+                    _bin_end(e, &record, sizeof(record), first_child);
+                } break;
+                case Paren_kind: {
+                    Ast_BinExpr_Paren record;
+                    memset(&record, 0, sizeof(record));
+                    record.header = _bin_header(Node_Expr, expr->kind, expr->span);
+                    size_t first_child = e->offsets.count - ((expr->Paren.expr != NULL));
+                    size_t child = first_child;
+                    _bin_begin(e, sizeof(record));
+                    record.expr = _bin_child(e, &child, expr->Paren.expr);
+                    _bin_end(e, &record, sizeof(record), first_child);
+                } break;
+                case Binary_kind: {
+                    Ast_BinExpr_Binary record;
+                    memset(&record, 0, sizeof(record));
+                    record.header = _bin_header(Node_Expr, expr->kind, expr->span);
+                    size_t first_child = e->offsets.count - ((expr->Binary.lhs != NULL) + (expr->Binary.rhs != NULL));
+                    size_t child = first_child;
+                    _bin_begin(e, sizeof(record));
+                    record.op = expr->Binary.op;
+                    record.lhs = _bin_child(e, &child, expr->Binary.lhs);
+                    record.rhs = _bin_child(e, &child, expr->Binary.rhs);
+                    _bin_end(e, &record, sizeof(record), first_child);
+                } break;
+                case Assign_kind: {
+                    Ast_BinExpr_Assign record;
+                    memset(&record, 0, sizeof(record));
+                    record.header = _bin_header(Node_Expr, expr->kind, expr->span);
+                    size_t first_child = e->offsets.count - ((expr->Assign.lhs != NULL) + (expr->Assign.rhs != NULL));
+                    size_t child = first_child;
+                    _bin_begin(e, sizeof(record));
+                    record.op = expr->Assign.op;
+                    record.lhs = _bin_child(e, &child, expr->Assign.lhs);
+                    record.rhs = _bin_child(e, &child, expr->Assign.rhs);
+                    _bin_end(e, &record, sizeof(record), first_child);
+                } break;
+                case Refrence_kind: {
+                    Ast_BinExpr_Refrence record;
+                    memset(&record, 0, sizeof(record));
+                    record.header = _bin_header(Node_Expr, expr->kind, expr->span);
+                    size_t first_child = e->offsets.count - ((expr->Refrence.expr != NULL));
+                    size_t child = first_child;
+                    _bin_begin(e, sizeof(record));
+                    record.expr = _bin_child(e, &child, expr->Refrence.expr);
+                    _bin_end(e, &record, sizeof(record), first_child);
+                } break;
+                case If_kind: {
+                    Ast_BinExpr_If record;
+                    memset(&record, 0, sizeof(record));
+                    record.header = _bin_header(Node_Expr, expr->kind, expr->span);
+                    size_t first_child = e->offsets.count - ((expr->If.condition != NULL) + (expr->If.if_branch != NULL) + (expr->If.else_block != NULL));
+                    size_t child = first_child;
+                    _bin_begin(e, sizeof(record));
+                    record.condition = _bin_child(e, &child, expr->If.condition);
+                    record.if_branch = _bin_child(e, &child, expr->If.if_branch);
+                    record.else_block = _bin_child(e, &child, expr->If.else_block);
+                    _bin_end(e, &record, sizeof(record), first_child);
+                } break;
+                case Block_kind: {
+                    Ast_BinExpr_Block record;
+                    memset(&record, 0, sizeof(record));
+                    record.header = _bin_header(Node_Expr, expr->kind, expr->span);
+                    size_t first_child = e->offsets.count - ((expr->Block.block != NULL));
+                    size_t child = first_child;
+                    _bin_begin(e, sizeof(record));
+                    record.block = _bin_child(e, &child, expr->Block.block);
+                    _bin_end(e, &record, sizeof(record), first_child);
+                } break;
+                default: break;
+            }
+        } break;
+        case Node_Type: {
+            Ast_Type *type = node;
+            switch (type->kind) {
+                case TyPath_kind: {
+                    Ast_BinType_TyPath record;
+                    memset(&record, 0, sizeof(record));
+                    record.header = _bin_header(Node_Type, type->kind, type->span);
+                    size_t first_child = e->offsets.count - (0);
+                    _bin_begin(e, sizeof(record));
+                    record.path = _bin_path(e, &type->TyPath.path);
+                    _bin_end(e, &record, sizeof(record), first_child);
+                } break;
+                case Owned_kind: {
+                    Ast_BinType_Owned record;
+                    memset(&record, 0, sizeof(record));
+                    record.header = _bin_header(Node_Type, type->kind, type->span);
+                    size_t first_child = e->offsets.count - ((type->Owned.ty != NULL));
+                    size_t child = first_child;
+                    _bin_begin(e, sizeof(record));
+                    record.ty = _bin_child(e, &child, type->Owned.ty);
+                    _bin_end(e, &record, sizeof(record), first_child);
+                } break;
+                case Ref_kind: {
+                    Ast_BinType_Ref record;
+                    memset(&record, 0, sizeof(record));
+                    record.header = _bin_header(Node_Type, type->kind, type->span);
+                    size_t first_child = e->offsets.count - ((type->Ref.ty != NULL));
+                    size_t child = first_child;
+                    _bin_begin(e, sizeof(record));
+                    record.ty = _bin_child(e, &child, type->Ref.ty);
+                    record.mut = type->Ref.mut;
+                    record.nullable = type->Ref.nullable;
+                    _bin_end(e, &record, sizeof(record), first_child);
+                } break;
+                case Ptr_kind: {
+                    Ast_BinType_Ptr record;
+                    memset(&record, 0, sizeof(record));
+                    record.header = _bin_header(Node_Type, type->kind, type->span);
+                    size_t first_child = e->offsets.count - ((type->Ptr.ty != NULL));
+                    size_t child = first_child;
+                    _bin_begin(e, sizeof(record));
+                    record.ty = _bin_child(e, &child, type->Ptr.ty);
+                    record.mut = type->Ptr.mut;
+                    record.nullable = type->Ptr.nullable;
+                    _bin_end(e, &record, sizeof(record), first_child);
+                } break;
+                case Generic_kind: {
+                    Ast_BinType_Generic record;
+                    memset(&record, 0, sizeof(record));
+                    record.header = _bin_header(Node_Type, type->kind, type->span);
+                    size_t first_child = e->offsets.count - ((type->Generic.base != NULL) + type->Generic.arguments.count);
+                    size_t child = first_child;
+                    _bin_begin(e, sizeof(record));
+                    record.base = _bin_child(e, &child, type->Generic.base);
+                    record.arguments = _bin_children(e, &child, type->Generic.arguments.count);
+                    _bin_end(e, &record, sizeof(record), first_child);
+                } break;
+                case TyArray_kind: {
+                    Ast_BinType_TyArray record;
+                    memset(&record, 0, sizeof(record));
+                    record.header = _bin_header(Node_Type, type->kind, type->span);
+                    size_t first_child = e->offsets.count - ((type->TyArray.ty != NULL));
+                    size_t child = first_child;
+                    _bin_begin(e, sizeof(record));
+                    record.ty = _bin_child(e, &child, type->TyArray.ty);
+                    record.size = type->TyArray.size;
+                    _bin_end(e, &record, sizeof(record), first_child);
+                } break;
+                case TySlice_kind: {
+                    Ast_BinType_TySlice record;
+                    memset(&record, 0, sizeof(record));
+                    record.header = _bin_header(Node_Type, type->kind, type->span);
+                    size_t first_child = e->offsets.count - ((type->TySlice.ty != NULL));
+                    size_t child = first_child;
+                    _bin_begin(e, sizeof(record));
+                    record.ty = _bin_child(e, &child, type->TySlice.ty);
+                    _bin_end(e, &record, sizeof(record), first_child);
+                } break;
+                case TyTuple_kind: {
+                    Ast_BinType_TyTuple record;
+                    memset(&record, 0, sizeof(record));
+                    record.header = _bin_header(Node_Type, type->kind, type->span);
+                    size_t first_child = e->offsets.count - (type->TyTuple.types.count);
+                    size_t child = first_child;
+                    _bin_begin(e, sizeof(record));
+                    record.types = _bin_children(e, &child, type->TyTuple.types.count);
+                    _bin_end(e, &record, sizeof(record), first_child);
+                } break;
+                case Inferred_kind: {
+                    Ast_BinType_Inferred record;
+                    memset(&record, 0, sizeof(record));
+                    record.header = _bin_header(Node_Type, type->kind, type->span);
+                    size_t first_child = e->offsets.count - (0);
+                    _bin_begin(e, sizeof(record));
+                    _bin_end(e, &record, sizeof(record), first_child);
+                } break;
+                case Nullable_kind: {
+                    Ast_BinType_Nullable record;
+                    memset(&record, 0, sizeof(record));
+                    record.header = _bin_header(Node_Type, type->kind, type->span);
+                    size_t first_child = e->offsets.count - ((type->Nullable.ty != NULL));
+                    size_t child = first_child;
+                    _bin_begin(e, sizeof(record));
+                    record.ty = _bin_child(e, &child, type->Nullable.ty);
+                    _bin_end(e, &record, sizeof(record), first_child);
+                } break;
+                default: break;
+            }
+        } break;
+        case Node_Stmt: {
+            Ast_Stmt *stmt = node;
+            switch (stmt->kind) {
+                case Expr_kind: {
+                    Ast_BinStmt_Expr record;
+                    memset(&record, 0, sizeof(record));
+                    record.header = _bin_header(Node_Stmt, stmt->kind, stmt->span);
+                    size_t first_child = e->offsets.count - ((stmt->Expr.expr != NULL));
+                    size_t child = first_child;
+                    _bin_begin(e, sizeof(record));
+                    record.expr = _bin_child(e, &child, stmt->Expr.expr);
+                    record.semicolon = stmt->Expr.semicolon;
+                    _bin_end(e, &record, sizeof(record), first_child);
+                } break;
+                case Decl_kind: {
+                    Ast_BinStmt_Decl record;
+                    memset(&record, 0, sizeof(record));
+                    record.header = _bin_header(Node_Stmt, stmt->kind, stmt->span);
+                    size_t first_child = e->offsets.count - ((stmt->Decl.init != NULL) + (stmt->Decl.type != NULL));
+                    size_t child = first_child;
+                    _bin_begin(e, sizeof(record));
+                    record.mut = stmt->Decl.mut;
+                    record.ident = _bin_string(e, stmt->Decl.ident.items, stmt->Decl.ident.count);
+                    record.init = _bin_child(e, &child, stmt->Decl.init);
+                    record.type = _bin_child(e, &child, stmt->Decl.type);
+                    _bin_end(e, &record, sizeof(record), first_child);
+                } break;
+                default: break;
+            }
+        } break;
+        case Node_Item: {
+            Ast_Item *item = node;
+            switch (item->kind) {
+                case RunBlock_kind: {
+                    Ast_BinItem_RunBlock record;
+                    memset(&record, 0, sizeof(record));
+                    record.header = _bin_header(Node_Item, item->kind, item->span);
+                    size_t first_child = e->offsets.count - ((item->RunBlock.block != NULL));
+                    size_t child = first_child;
+                    _bin_begin(e, sizeof(record));
+                    record.block = _bin_child(e, &child, item->RunBlock.block);
+                    _bin_end(e, &record, sizeof(record), first_child);
+                } break;
+                case Include_kind: {
+                    Ast_BinItem_Include record;
+                    memset(&record, 0, sizeof(record));
+                    record.header = _bin_header(Node_Item, item->kind, item->span);
+                    size_t first_child = e->offsets.count - (0);
+                    _bin_begin(e, sizeof(record));
+                    record.path = _bin_string(e, item->Include.path.items, item->Include.path.count);
+                    _bin_end(e, &record, sizeof(record), first_child);
+                } break;
+                case Open_kind: {
+                    Ast_BinItem_Open record;
+                    memset(&record, 0, sizeof(record));
+                    record.header = _bin_header(Node_Item, item->kind, item->span);
+                    size_t first_child = e->offsets.count - (0);
+                    _bin_begin(e, sizeof(record));
+                    record.path = _bin_string(e, item->Open.path.items, item->Open.path.count);
+                    _bin_end(e, &record, sizeof(record), first_child);
+                } break;
+                default: break;
+            }
+        } break;
+        case Node_Block: {
+            Ast_Block *block = node;
+            Ast_BinBlock record;
+            memset(&record, 0, sizeof(record));
+            record.header = _bin_header(Node_Block, 0, block->span);
+            size_t first_child = e->offsets.count - block->stmts.count;
+            size_t child = first_child;
+            _bin_begin(e, sizeof(record));
+            record.stmts = _bin_children(e, &child, block->stmts.count);
+            _bin_end(e, &record, sizeof(record), first_child);
+        } break;
+    }
+}
+#endif //AST_EXPORT_H_IMPLEMENTATION
+
+#endif //AST_EXPORT_H_
\ No newline at end of file
@@ -0,0 +1,370 @@
+// this file was generated from ast_nodes.h.templ8
+#ifndef  AST_NODES_H_
+#define  AST_NODES_H_
+
+#ifndef  AST_NODES_H_PREFIX
+#define  AST_NODES_H_PREFIX
+#endif //AST_NODES_H_PREFIX
+
+// One constructor per node kind, the node only gets the size of its variant
+static inline
+Ast_Expr *ast_new_expr_literal(Ast_Pool *pool, Lex_Span span, Ast_LiteralExpr node) {
+    Ast_Expr *expr = ast_pool_alloc(pool, ast_node_size(Ast_Expr, Literal));
+    expr->kind = Literal_kind;
+    expr->id = pool->ids++;
+    expr->span = span;
+    expr->Literal = node;
+    return expr;
+}
+
+static inline
+Ast_Expr *ast_new_expr_path(Ast_Pool *pool, Lex_Span span, Ast_PathExpr node) {
+    Ast_Expr *expr = ast_pool_alloc(pool, ast_node_size(Ast_Expr, Path));
+    expr->kind = Path_kind;
+    expr->id = pool->ids++;
+    expr->span = span;
+    expr->Path = node;
+    return expr;
+}
+
+static inline
+Ast_Expr *ast_new_expr_unary(Ast_Pool *pool, Lex_Span span, Ast_UnaryExpr node) {
+    Ast_Expr *expr = ast_pool_alloc(pool, ast_node_size(Ast_Expr, Unary));
+    expr->kind = Unary_kind;
+    expr->id = pool->ids++;
+    expr->span = span;
+    expr->Unary = node;
+    return expr;
+}
+
+static inline
+Ast_Expr *ast_new_expr_call(Ast_Pool *pool, Lex_Span span, Ast_CallExpr node) {
+    Ast_Expr *expr = ast_pool_alloc(pool, ast_node_size(Ast_Expr, Call));
+    expr->kind = Call_kind;
+    expr->id = pool->ids++;
+    expr->span = span;
+    expr->Call = node;
+    return expr;
+}
+
+static inline
+Ast_Expr *ast_new_expr_subscript(Ast_Pool *pool, Lex_Span span, Ast_SubscriptExpr node) {
+    Ast_Expr *expr = ast_pool_alloc(pool, ast_node_size(Ast_Expr, Subscript));
+    expr->kind = Subscript_kind;
+    expr->id = pool->ids++;
+    expr->span = span;
+    expr->Subscript = node;
+    return expr;
+}
+
+static inline
+Ast_Expr *ast_new_expr_member(Ast_Pool *pool, Lex_Span span, Ast_MemberExpr node) {
+    Ast_Expr *expr = ast_pool_alloc(pool, ast_node_size(Ast_Expr, Member));
+    expr->kind = Member_kind;
+    expr->id = pool->ids++;
+    expr->span = span;
+    expr->Member = node;
+    return expr;
+}
+
+static inline
+Ast_Expr *ast_new_expr_paren(Ast_Pool *pool, Lex_Span span, Ast_ParenExpr node) {
+    Ast_Expr *expr = ast_pool_alloc(pool, ast_node_size(Ast_Expr, Paren));
+    expr->kind = Paren_kind;
+    expr->id = pool->ids++;
+    expr->span = span;
+    expr->Paren = node;
+    return expr;
+}
+
+static inline
+Ast_Expr *ast_new_expr_binary(Ast_Pool *pool, Lex_Span span, Ast_BinaryExpr node) {
+    Ast_Expr *expr = ast_pool_alloc(pool, ast_node_size(Ast_Expr, Binary));
+    expr->kind = Binary_kind;
+    expr->id = pool->ids++;
+    expr->span = span;
+    expr->Binary = node;
+    return expr;
+}
+
+static inline
+Ast_Expr *ast_new_expr_assign(Ast_Pool *pool, Lex_Span span, Ast_AssignExpr node) {
+    Ast_Expr *expr = ast_pool_alloc(pool, ast_node_size(Ast_Expr, Assign));
+    expr->kind = Assign_kind;
+    expr->id = pool->ids++;
+    expr->span = span;
+    expr->Assign = node;
+    return expr;
+}
+
+static inline
+Ast_Expr *ast_new_expr_refrence(Ast_Pool *pool, Lex_Span span, Ast_RefrenceExpr node) {
+    Ast_Expr *expr = ast_pool_alloc(pool, ast_node_size(Ast_Expr, Refrence));
+    expr->kind = Refrence_kind;
+    expr->id = pool->ids++;
+    expr->span = span;
+    expr->Refrence = node;
+    return expr;
+}
+
+static inline
+Ast_Expr *ast_new_expr_if(Ast_Pool *pool, Lex_Span span, Ast_IfExpr node) {
+    Ast_Expr *expr = ast_pool_alloc(pool, ast_node_size(Ast_Expr, If));
+    expr->kind = If_kind;
+    expr->id = pool->ids++;
+    expr->span = span;
+    expr->If = node;
+    return expr;
+}
+
+static inline
+Ast_Expr *ast_new_expr_block(Ast_Pool *pool, Lex_Span span, Ast_BlockExpr node) {
+    Ast_Expr *expr = ast_pool_alloc(pool, ast_node_size(Ast_Expr, Block));
+    expr->kind = Block_kind;
+    expr->id = pool->ids++;
+    expr->span = span;
+    expr->Block = node;
+    return expr;
+}
+
+static inline
+Ast_Type *ast_new_type_ty_path(Ast_Pool *pool, Lex_Span span, Ast_TyPathType node) {
+    Ast_Type *type = ast_pool_alloc(pool, ast_node_size(Ast_Type, TyPath));
+    type->kind = TyPath_kind;
+    type->id = pool->ids++;
+    type->span = span;
+    type->TyPath = node;
+    return type;
+}
+
+static inline
+Ast_Type *ast_new_type_owned(Ast_Pool *pool, Lex_Span span, Ast_OwnedType node) {
+    Ast_Type *type = ast_pool_alloc(pool, ast_node_size(Ast_Type, Owned));
+    type->kind = Owned_kind;
+    type->id = pool->ids++;
+    type->span = span;
+    type->Owned = node;
+    return type;
+}
+
+static inline
+Ast_Type *ast_new_type_ref(Ast_Pool *pool, Lex_Span span, Ast_RefType node) {
+    Ast_Type *type = ast_pool_alloc(pool, ast_node_size(Ast_Type, Ref));
+    type->kind = Ref_kind;
+    type->id = pool->ids++;
+    type->span = span;
+    type->Ref = node;
+    return type;
+}
+
+static inline
+Ast_Type *ast_new_type_ptr(Ast_Pool *pool, Lex_Span span, Ast_PtrType node) {
+    Ast_Type *type = ast_pool_alloc(pool, ast_node_size(Ast_Type, Ptr));
+    type->kind = Ptr_kind;
+    type->id = pool->ids++;
+    type->span = span;
+    type->Ptr = node;
+    return type;
+}
+
+static inline
+Ast_Type *ast_new_type_generic(Ast_Pool *pool, Lex_Span span, Ast_GenericType node) {
+    Ast_Type *type = ast_pool_alloc(pool, ast_node_size(Ast_Type, Generic));
+    type->kind = Generic_kind;
+    type->id = pool->ids++;
+    type->span = span;
+    type->Generic = node;
+    return type;
+}
+
+static inline
+Ast_Type *ast_new_type_ty_array(Ast_Pool *pool, Lex_Span span, Ast_TyArrayType node) {
+    Ast_Type *type = ast_pool_alloc(pool, ast_node_size(Ast_Type, TyArray));
+    type->kind = TyArray_kind;
+    type->id = pool->ids++;
+    type->span = span;
+    type->TyArray = node;
+    return type;
+}
+
+static inline
+Ast_Type *ast_new_type_ty_slice(Ast_Pool *pool, Lex_Span span, Ast_TySliceType node) {
+    Ast_Type *type = ast_pool_alloc(pool, ast_node_size(Ast_Type, TySlice));
+    type->kind = TySlice_kind;
+    type->id = pool->ids++;
+    type->span = span;
+    type->TySlice = node;
+    return type;
+}
+
+static inline
+Ast_Type *ast_new_type_ty_tuple(Ast_Pool *pool, Lex_Span span, Ast_TyTupleType node) {
+    Ast_Type *type = ast_pool_alloc(pool, ast_node_size(Ast_Type, TyTuple));
+    type->kind = TyTuple_kind;
+    type->id = pool->ids++;
+    type->span = span;
+    type->TyTuple = node;
+    return type;
+}
+
+static inline
+Ast_Type *ast_new_type_inferred(Ast_Pool *pool, Lex_Span span, Ast_InferredType node) {
+    Ast_Type *type = ast_pool_alloc(pool, ast_node_size(Ast_Type, Inferred));
+    type->kind = Inferred_kind;
+    type->id = pool->ids++;
+    type->span = span;
+    type->Inferred = node;
+    return type;
+}
+
+static inline
+Ast_Type *ast_new_type_nullable(Ast_Pool *pool, Lex_Span span, Ast_NullableType node) {
+    Ast_Type *type = ast_pool_alloc(pool, ast_node_size(Ast_Type, Nullable));
+    type->kind = Nullable_kind;
+    type->id = pool->ids++;
+    type->span = span;
+    type->Nullable = node;
+    return type;
+}
+
+static inline
+Ast_Stmt *ast_new_stmt_expr(Ast_Pool *pool, Lex_Span span, Ast_ExprStmt node) {
+    Ast_Stmt *stmt = ast_pool_alloc(pool, ast_node_size(Ast_Stmt, Expr));
+    stmt->kind = Expr_kind;
+    stmt->id = pool->ids++;
+    stmt->span = span;
+    stmt->Expr = node;
+    return stmt;
+}
+
+static inline
+Ast_Stmt *ast_new_stmt_decl(Ast_Pool *pool, Lex_Span span, Ast_DeclStmt node) {
+    Ast_Stmt *stmt = ast_pool_alloc(pool, ast_node_size(Ast_Stmt, Decl));
+    stmt->kind = Decl_kind;
+    stmt->id = pool->ids++;
+    stmt->span = span;
+    stmt->Decl = node;
+    return stmt;
+}
+
+static inline
+Ast_Item *ast_new_item_run_block(Ast_Pool *pool, Lex_Span span, Ast_RunBlockItem node) {
+    Ast_Item *item = ast_pool_alloc(pool, ast_node_size(Ast_Item, RunBlock));
+    item->kind = RunBlock_kind;
+    item->id = pool->ids++;
+    item->span = span;
+    item->RunBlock = node;
+    return item;
+}
+
+static inline
+Ast_Item *ast_new_item_include(Ast_Pool *pool, Lex_Span span, Ast_IncludeItem node) {
+    Ast_Item *item = ast_pool_alloc(pool, ast_node_size(Ast_Item, Include));
+    item->kind = Include_kind;
+    item->id = pool->ids++;
+    item->span = span;
+    item->Include = node;
+    return item;
+}
+
+static inline
+Ast_Item *ast_new_item_open(Ast_Pool *pool, Lex_Span span, Ast_OpenItem node) {
+    Ast_Item *item = ast_pool_alloc(pool, ast_node_size(Ast_Item, Open));
+    item->kind = Open_kind;
+    item->id = pool->ids++;
+    item->span = span;
+    item->Open = node;
+    return item;
+}
+
+// Allocated size of `node`, which depends on its variant
+size_t ast_sizeof_node(Ast_NodeClass klass, void *node);
+
+static inline
+void ast_release_expr(Ast_Pool *pool, Ast_Expr **expr) {
+    ast_pool_release_tree(pool, Node_Expr, (void **)expr);
+}
+
+static inline
+void ast_release_type(Ast_Pool *pool, Ast_Type **type) {
+    ast_pool_release_tree(pool, Node_Type, (void **)type);
+}
+
+static inline
+void ast_release_stmt(Ast_Pool *pool, Ast_Stmt **stmt) {
+    ast_pool_release_tree(pool, Node_Stmt, (void **)stmt);
+}
+
+static inline
+void ast_release_item(Ast_Pool *pool, Ast_Item **item) {
+    ast_pool_release_tree(pool, Node_Item, (void **)item);
+}
+
+static inline
+void ast_release_block(Ast_Pool *pool, Ast_Block **block) {
+    ast_pool_release_tree(pool, Node_Block, (void **)block);
+}
+
+#ifdef   AST_NODES_H_IMPLEMENTATION
+AST_NODES_H_PREFIX
+size_t ast_sizeof_node(Ast_NodeClass klass, void *node) {
+    switch (klass) {
+        case Node_Expr: {
+            Ast_Expr *expr = node;
+            switch (expr->kind) {
+                case Literal_kind: return ast_node_size(Ast_Expr, Literal);
+                case Path_kind: return ast_node_size(Ast_Expr, Path);
+                case Unary_kind: return ast_node_size(Ast_Expr, Unary);
+                case Call_kind: return ast_node_size(Ast_Expr, Call);
+                case Subscript_kind: return ast_node_size(Ast_Expr, Subscript);
+                case Member_kind: return ast_node_size(Ast_Expr, Member);
+                case Paren_kind: return ast_node_size(Ast_Expr, Paren);
+                case Binary_kind: return ast_node_size(Ast_Expr, Binary);
+                case Assign_kind: return ast_node_size(Ast_Expr, Assign);
+                case Refrence_kind: return ast_node_size(Ast_Expr, Refrence);
+                case If_kind: return ast_node_size(Ast_Expr, If);
+                case Block_kind: return ast_node_size(Ast_Expr, Block);
+                default: break;
+            }
+        } break;
+        case Node_Type: {
+            Ast_Type *type = node;
+            switch (type->kind) {
+                case TyPath_kind: return ast_node_size(Ast_Type, TyPath);
+                case Owned_kind: return ast_node_size(Ast_Type, Owned);
+                case Ref_kind: return ast_node_size(Ast_Type, Ref);
+                case Ptr_kind: return ast_node_size(Ast_Type, Ptr);
+                case Generic_kind: return ast_node_size(Ast_Type, Generic);
+                case TyArray_kind: return ast_node_size(Ast_Type, TyArray);
+                case TySlice_kind: return ast_node_size(Ast_Type, TySlice);
+                case TyTuple_kind: return ast_node_size(Ast_Type, TyTuple);
+                case Inferred_kind: return ast_node_size(Ast_Type, Inferred);
+                case Nullable_kind: return ast_node_size(Ast_Type, Nullable);
+                default: break;
+            }
+        } break;
+        case Node_Stmt: {
+            Ast_Stmt *stmt = node;
+            switch (stmt->kind) {
+                case Expr_kind: return ast_node_size(Ast_Stmt, Expr);
+                case Decl_kind: return ast_node_size(Ast_Stmt, Decl);
+                default: break;
+            }
+        } break;
+        case Node_Item: {
+            Ast_Item *item = node;
+            switch (item->kind) {
+                case RunBlock_kind: return ast_node_size(Ast_Item, RunBlock);
+                case Include_kind: return ast_node_size(Ast_Item, Include);
+                case Open_kind: return ast_node_size(Ast_Item, Open);
+                default: break;
+            }
+        } break;
+        case Node_Block:
+            return sizeof(Ast_Block);
+    }
+    assert(false && "unreachable");
+}
+#endif //AST_NODES_H_IMPLEMENTATION
+
+#endif //AST_NODES_H_
\ No newline at end of file
@@ -0,0 +1,51 @@
+#include <assert.h>
+#include <string.h>
+
+#define AST_NODES_H_IMPLEMENTATION
+#include "ast_pool.h"
+
+static_assert(sizeof(Ast_Expr) <= AST_POOL_MAX_SIZE, "raise AST_POOL_MAX_SIZE");
+static_assert(sizeof(Ast_Type) <= AST_POOL_MAX_SIZE, "raise AST_POOL_MAX_SIZE");
+static_assert(sizeof(Ast_Stmt) <= AST_POOL_MAX_SIZE, "raise AST_POOL_MAX_SIZE");
+static_assert(sizeof(Ast_Item) <= AST_POOL_MAX_SIZE, "raise AST_POOL_MAX_SIZE");
+static_assert(sizeof(Ast_Block) <= AST_POOL_MAX_SIZE, "raise AST_POOL_MAX_SIZE");
+
+void *_ast_pool_refill(Ast_Pool *pool, size_t size) {
+    // the rest of the old chunk is lost, it is smaller than `size` anyway
+    pool->chunk = arena_alloc(&pool->arena, AST_POOL_CHUNK_SIZE);
+    pool->chunk_left = AST_POOL_CHUNK_SIZE;
+
+    void *result = pool->chunk;
+    pool->chunk += size;
+    pool->chunk_left -= size;
+    return result;
+}
+
+static
+Ast_VisitResult _release_node(Ast_Visitor *visitor, Ast_Node node) {
+    // post order, the children are released already
+    Ast_Pool *pool = visitor->data;
+    ast_pool_release(pool, node.ptr, ast_sizeof_node(node.klass, node.ptr));
+    *node.slot = NULL;
+    return Visit_Continue;
+}
+
+void ast_pool_release_tree(Ast_Pool *pool, Ast_NodeClass klass, void **slot) {
+    pool->releaser.post = _release_node;
+    pool->releaser.data = pool;
+    ast_walk(&pool->releaser, klass, slot);
+}
+
+void ast_pool_reset(Ast_Pool *pool) {
+    arena_reset(&pool->arena);
+    pool->chunk = NULL;
+    pool->chunk_left = 0;
+    pool->ids = 0;
+    memset(pool->free, 0, sizeof(pool->free));
+}
+
+void ast_pool_free(Ast_Pool *pool) {
+    ast_visitor_free(&pool->releaser);
+    arena_free(&pool->arena);
+    *pool = (Ast_Pool) {0};
+}
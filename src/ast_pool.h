@@ -0,0 +1,85 @@
+#ifndef AST_POOL_H_
+#define AST_POOL_H_
+
+#include "AST.h"
+#include "arena.h"
+#include "visitor.h"
+
+#define AST_POOL_ALIGN _Alignof(void *)
+#define AST_POOL_CHUNK_SIZE (16*1024)
+// largest node rounded up to AST_POOL_ALIGN, checked in ast_pool.c
+#define AST_POOL_MAX_SIZE 136
+#define AST_POOL_CLASSES (AST_POOL_MAX_SIZE / AST_POOL_ALIGN + 1)
+
+typedef struct _Ast_FreeNode Ast_FreeNode;
+
+struct _Ast_FreeNode {
+    Ast_FreeNode *next;
+};
+
+// Owns the nodes of an AST together with the vectors inside them. Nodes are
+// bumped out of chunks of `arena` with the size of their variant instead of
+// the full node; released nodes go onto a free list per size and are reused
+// by the next node of that size. `ast_pool_free` drops the whole AST at once.
+typedef struct {
+    Arena arena;
+    char *chunk;
+    size_t chunk_left;
+    Ast_FreeNode *free[AST_POOL_CLASSES];
+    // ids handed out to the nodes, which are dense and fill the padding
+    // after `kind`; passes keep what they know about a node in side arrays
+    // indexed by id instead of growing the nodes
+    uint32_t ids;
+    // reused between releases of a subtree
+    Ast_Visitor releaser;
+} Ast_Pool;
+
+void *_ast_pool_refill(Ast_Pool *pool, size_t size);
+
+static inline
+void *ast_pool_alloc(Ast_Pool *pool, size_t size) {
+    size = (size + AST_POOL_ALIGN - 1) & ~(AST_POOL_ALIGN - 1);
+    Ast_FreeNode **list = &pool->free[size / AST_POOL_ALIGN];
+    if (*list != NULL) {
+        Ast_FreeNode *node = *list;
+        *list = node->next;
+        return node;
+    }
+    if (pool->chunk_left < size) {
+        return _ast_pool_refill(pool, size);
+    }
+    void *result = pool->chunk;
+    pool->chunk += size;
+    pool->chunk_left -= size;
+    return result;
+}
+
+// Puts a single node of `size` bytes onto its free list, its children are
+// left alone
+static inline
+void ast_pool_release(Ast_Pool *pool, void *node, size_t size) {
+    size = (size + AST_POOL_ALIGN - 1) & ~(AST_POOL_ALIGN - 1);
+    Ast_FreeNode *free_node = node;
+    free_node->next = pool->free[size / AST_POOL_ALIGN];
+    pool->free[size / AST_POOL_ALIGN] = free_node;
+}
+
+// Releases the node in `*slot` and everything below it and clears the slot.
+// The vectors of the released nodes stay in the arena until `ast_pool_free`.
+void ast_pool_release_tree(Ast_Pool *pool, Ast_NodeClass klass, void **slot);
+// Drops the AST but keeps the memory for the next one
+void ast_pool_reset(Ast_Pool *pool);
+void ast_pool_free(Ast_Pool *pool);
+
+static inline
+Ast_Block *ast_new_block(Ast_Pool *pool, Lex_Span span, Ast_Stmts stmts) {
+    Ast_Block *block = ast_pool_alloc(pool, sizeof(Ast_Block));
+    block->stmts = stmts;
+    block->span = span;
+    return block;
+}
+
+// typed constructors and release functions for every node kind
+#include "ast_nodes.generated.h"
+
+#endif // AST_POOL_H_
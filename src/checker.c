@@ -0,0 +1,602 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "checker.h"
+#include "dynarray.h"
+#include "metrics.h"
+
+// The binary operator of every compound assignment
+static const BinaryOp assignment_operators[Ao_NumberOfElements] = {
+    [Ao_Assign] = Bo_Invalid,
+    [Ao_WalrusAssign] = Bo_Invalid,
+    [Ao_PlusAssign] = Bo_Plus,
+    [Ao_MinusAssing] = Bo_Minus,
+    [Ao_MulAssign] = Bo_Mul,
+    [Ao_DivAssign] = Bo_Div,
+    [Ao_ModAssign] = Bo_Mod,
+    [Ao_BOrAssign] = Bo_BOr,
+    [Ao_BAndAssign] = Bo_BAnd,
+    [Ao_BXorAssign] = Bo_BXor,
+    [Ao_ShlAssign] = Bo_Shl,
+    [Ao_ShrAssign] = Bo_Shr,
+    [Ao_AndAssign] = Bo_And,
+    [Ao_OrAssign] = Bo_Or,
+};
+
+static inline
+Type_Id *_type_of(Checker *checker, uint32_t id) {
+    return &checker->types.items[id];
+}
+
+static
+void _begin_error(Checker *checker) {
+    checker->errors++;
+    writer_cstr(checker->err, "ERROR: ");
+}
+
+static
+void _end_error(Checker *checker, Lex_Span span) {
+    writer_cstr(checker->err, " at ");
+    lexer_print_span(checker->err, span);
+    writer_char(checker->err, '\n');
+}
+
+static
+void _quoted(Checker *checker, Type_Id type) {
+    writer_char(checker->err, '`');
+    types_print(checker->err, &checker->table, type);
+    writer_char(checker->err, '`');
+}
+
+static
+void _expected(Checker *checker, Type_Id expected, Type_Id found, Lex_Span span) {
+    _begin_error(checker);
+    writer_cstr(checker->err, "Expected ");
+    _quoted(checker, expected);
+    writer_cstr(checker->err, ", found ");
+    _quoted(checker, found);
+    _end_error(checker, span);
+}
+
+// `op` is printed like --emit=ast does, as `enum_name::op`
+static
+void _invalid_operand(Checker *checker, const char *enum_name, const char *op, Type_Id type, Lex_Span span) {
+    _begin_error(checker);
+    writer_cstr(checker->err, "Invalid operand ");
+    _quoted(checker, type);
+    writer_cstr(checker->err, " for ");
+    writer_cstr(checker->err, enum_name);
+    writer_cstr(checker->err, "::");
+    writer_cstr(checker->err, op);
+    _end_error(checker, span);
+}
+
+// The integer literal `expr` is, within parentheses and negated or not,
+// NULL for any other expression
+static
+Ast_Expr *_integer_literal(Ast_Expr *expr, bool *negated) {
+    *negated = false;
+    while (expr->kind == Paren_kind) {
+        expr = expr->Paren.expr;
+    }
+    if (expr->kind == Unary_kind && expr->Unary.op == Uo_Minus) {
+        *negated = true;
+        expr = expr->Unary.expr;
+        while (expr->kind == Paren_kind) {
+            expr = expr->Paren.expr;
+        }
+    }
+    return expr->kind == Literal_kind && expr->Literal.kind == L_Integer ? expr : NULL;
+}
+
+// A plain Number is never folded, so it is still the magnitude as written
+static
+bool _magnitude_fits(Lex_NumberClass nclass, uint64_t magnitude, bool negated) {
+    int bits = types_class_bits(nclass);
+    if (IS_UNSIGNED_CLASS(nclass)) {
+        return negated ? magnitude == 0 : bits == 64 || magnitude >> bits == 0;
+    }
+    uint64_t limit = (uint64_t)1 << (bits - 1);
+    return negated ? magnitude <= limit : magnitude < limit;
+}
+
+// An integer literal has to fit into the class it ends up with, which is
+// its suffix or the type a plain Number adopts. `-<literal>` is one negative
+// value, `-128i8` is in range where `128i8` is not
+static
+void _check_literal(Checker *checker, Ast_Expr *expr, Type_Id type) {
+    bool negated;
+    Ast_Expr *literal = _integer_literal(expr, &negated);
+    if (literal == NULL || !types_is_integer(type)) {
+        return;
+    }
+    Lex_NumberClass nclass = types_info(&checker->table, type)->nclass;
+    // until it adopts a class from where it is used
+    if (nclass == Nc_Number) {
+        return;
+    }
+    uint64_t value = literal->Literal.integer;
+    bool fits = literal->Literal.nclass == Nc_Number
+        ? _magnitude_fits(nclass, value, negated)
+        : types_class_fits(nclass, negated ? -value : value);
+    if (!fits) {
+        _begin_error(checker);
+        writer_cstr(checker->err, "Literal out of range for ");
+        _quoted(checker, type);
+        _end_error(checker, expr->span);
+    }
+}
+
+static
+bool _is_number(Type_Id type) {
+    return types_is_integer(type) || types_is_float(type);
+}
+
+// The type both operands of an arithmetic operator are evaluated in, a
+// plain Number adopts any number class and a plain FloatingPointNumber the
+// float classes
+static
+bool _unify(Type_Id lhs, Type_Id rhs, Type_Id *result) {
+    if (lhs == rhs) {
+        *result = lhs;
+        return true;
+    }
+    for (int i = 0; i < 2; i++) {
+        Type_Id plain = i == 0 ? lhs : rhs;
+        Type_Id other = i == 0 ? rhs : lhs;
+        if ((plain == TYPE_NUMBER(Nc_Number) && _is_number(other))
+                || (plain == TYPE_NUMBER(Nc_FloatingPointNumber) && types_is_float(other))) {
+            *result = other;
+            return true;
+        }
+    }
+    return false;
+}
+
+// A value of `from` can be stored in a place of `to`
+static
+bool _assignable(Checker *checker, Type_Id from, Type_Id to) {
+    Type_Id unified;
+    if (from == to || from == Type_Error || to == Type_Error) {
+        return true;
+    }
+    if (_unify(from, to, &unified) && unified == to) {
+        return true;
+    }
+    Type_Info *target = types_info(&checker->table, to);
+    Type_Info *source = types_info(&checker->table, from);
+    bool pointer = target->kind == Ty_Ref || target->kind == Ty_Ptr;
+    if (from == Type_Nil) {
+        return target->kind == Ty_Nullable || (pointer && target->nullable);
+    }
+    // a `let` pointer can be used as a constant one and any one as nullable
+    if (pointer && source->kind == target->kind) {
+        return source->inner == target->inner
+            && (source->mut || !target->mut)
+            && (!source->nullable || target->nullable);
+    }
+    if (target->kind == Ty_Nullable) {
+        return _assignable(checker, from, target->inner);
+    }
+    return false;
+}
+
+static
+bool _accepts(BinaryOp op, Type_Id type) {
+    switch (op) {
+        case Bo_Mul: case Bo_Div: case Bo_Mod: case Bo_Plus: case Bo_Minus:
+            return _is_number(type);
+        case Bo_BAnd: case Bo_BXor: case Bo_BOr:
+            return types_is_integer(type) || type == Type_Bool;
+        case Bo_Shl: case Bo_Shr:
+            return types_is_integer(type);
+        case Bo_Gt: case Bo_Ge: case Bo_Lt: case Bo_Le:
+            return _is_number(type) || type == Type_Char;
+        case Bo_Eq: case Bo_Ne:
+            return type != Type_Void;
+        case Bo_And: case Bo_Or:
+            return type == Type_Bool;
+        default:
+            return false;
+    }
+}
+
+static
+Type_Id _check_operator(Checker *checker, BinaryOp op, Type_Id lhs, Type_Id rhs, Lex_Span span) {
+    if (lhs == Type_Error || rhs == Type_Error) {
+        return Type_Error;
+    }
+    if (!_accepts(op, lhs) || !_accepts(op, rhs)) {
+        _invalid_operand(checker, "BinaryOp", binary_op_to_string(op), _accepts(op, lhs) ? rhs : lhs, span);
+        return Type_Error;
+    }
+
+    Type_Id unified;
+    switch (op) {
+        case Bo_Shl: case Bo_Shr:
+            // the shift amount may have any integer type
+            return lhs;
+        case Bo_And: case Bo_Or:
+            return Type_Bool;
+        case Bo_Eq: case Bo_Ne:
+            if (_unify(lhs, rhs, &unified) || _assignable(checker, lhs, rhs) || _assignable(checker, rhs, lhs)) {
+                return Type_Bool;
+            }
+            break;
+        default:
+            if (_unify(lhs, rhs, &unified)) {
+                return op >= Bo_Gt && op <= Bo_Le ? Type_Bool : unified;
+            }
+            break;
+    }
+    _begin_error(checker);
+    writer_cstr(checker->err, "Mismatched types ");
+    _quoted(checker, lhs);
+    writer_cstr(checker->err, " and ");
+    _quoted(checker, rhs);
+    writer_cstr(checker->err, " for BinaryOp::");
+    writer_cstr(checker->err, binary_op_to_string(op));
+    _end_error(checker, span);
+    return Type_Error;
+}
+
+static
+Type_Id _check_unary(Checker *checker, Ast_Expr *expr) {
+    Type_Id operand = *_type_of(checker, expr->Unary.expr->id);
+    if (operand == Type_Error) {
+        return Type_Error;
+    }
+    UnaryOp op = expr->Unary.op;
+    Type_Info *info = types_info(&checker->table, operand);
+    bool valid = false;
+    switch (op) {
+        case Uo_Plus:
+            valid = _is_number(operand);
+            break;
+        case Uo_Minus:
+            valid = _is_number(operand) && !IS_UNSIGNED_CLASS(info->nclass);
+            break;
+        case Uo_BitwiseNot:
+            valid = types_is_integer(operand);
+            break;
+        case Uo_Not:
+            valid = operand == Type_Bool;
+            break;
+        case Uo_Deref:
+            if (info->kind == Ty_Ref || info->kind == Ty_Ptr) {
+                return info->inner;
+            }
+            break;
+        default:
+            break;
+    }
+    if (!valid) {
+        _invalid_operand(checker, "UnaryOp", unary_op_to_string(op), operand, expr->span);
+        return Type_Error;
+    }
+    return operand;
+}
+
+// The type of the expression a block ends in without a semicolon
+static
+Type_Id _block_type(Checker *checker, Ast_Block *block) {
+    if (block->stmts.count == 0) {
+        return Type_Void;
+    }
+    Ast_Stmt *last = block->stmts.items[block->stmts.count - 1];
+    if (last->kind != Expr_kind || last->Expr.semicolon) {
+        return Type_Void;
+    }
+    return *_type_of(checker, last->Expr.expr->id);
+}
+
+static
+Type_Id _check_if(Checker *checker, Ast_Expr *expr) {
+    Type_Id condition = *_type_of(checker, expr->If.condition->id);
+    if (!_assignable(checker, condition, Type_Bool)) {
+        _expected(checker, Type_Bool, condition, expr->If.condition->span);
+    }
+    Type_Id then = _block_type(checker, expr->If.if_branch);
+    if (expr->If.else_block == NULL) {
+        return Type_Void;
+    }
+    Type_Id otherwise = *_type_of(checker, expr->If.else_block->id);
+    Type_Id unified;
+    if (then == Type_Error || otherwise == Type_Error) {
+        return Type_Error;
+    }
+    if (_unify(then, otherwise, &unified)) {
+        return unified;
+    }
+    _begin_error(checker);
+    writer_cstr(checker->err, "Mismatched branches ");
+    _quoted(checker, then);
+    writer_cstr(checker->err, " and ");
+    _quoted(checker, otherwise);
+    _end_error(checker, expr->span);
+    return Type_Error;
+}
+
+static
+Type_Id _check_expr(Checker *checker, Ast_Expr *expr) {
+    switch (expr->kind) {
+        case Literal_kind:
+            switch (expr->Literal.kind) {
+                case L_String: return Type_Str;
+                case L_Char: return Type_Char;
+                case L_Integer:
+                    // see _checker_pre
+                    if (expr != checker->negated) {
+                        _check_literal(checker, expr, TYPE_NUMBER(expr->Literal.nclass));
+                    }
+                    return TYPE_NUMBER(expr->Literal.nclass);
+                case L_Float: return TYPE_NUMBER(expr->Literal.nclass);
+                case L_Boolean: return Type_Bool;
+                case L_Nil: return Type_Nil;
+            }
+            break;
+        case Path_kind: {
+            Ast_Stmt *decl = expr->Path.path.decl;
+            return decl != NULL ? *_type_of(checker, decl->id) : Type_Error;
+        }
+        case Unary_kind: {
+            Type_Id type = _check_unary(checker, expr);
+            bool negated;
+            Ast_Expr *literal = _integer_literal(expr, &negated);
+            if (literal == checker->negated && type != Type_Error) {
+                _check_literal(checker, expr, type);
+            }
+            return type;
+        }
+        case Binary_kind: {
+            Type_Id lhs = *_type_of(checker, expr->Binary.lhs->id);
+            Type_Id rhs = *_type_of(checker, expr->Binary.rhs->id);
+            Type_Id type = _check_operator(checker, expr->Binary.op, lhs, rhs, expr->span);
+            Type_Id unified;
+            if (_unify(lhs, rhs, &unified)) {
+                _check_literal(checker, expr->Binary.lhs, unified);
+                _check_literal(checker, expr->Binary.rhs, unified);
+            }
+            return type;
+        }
+        case Assign_kind: {
+            Type_Id lhs = *_type_of(checker, expr->Assign.lhs->id);
+            Type_Id rhs = *_type_of(checker, expr->Assign.rhs->id);
+            BinaryOp op = assignment_operators[expr->Assign.op];
+            if (op != Bo_Invalid) {
+                rhs = _check_operator(checker, op, lhs, rhs, expr->span);
+            }
+            if (!_assignable(checker, rhs, lhs)) {
+                _expected(checker, lhs, rhs, expr->Assign.rhs->span);
+            }
+            _check_literal(checker, expr->Assign.rhs, lhs);
+            return lhs;
+        }
+        case Subscript_kind: {
+            Type_Id base = *_type_of(checker, expr->Subscript.base->id);
+            Type_Id index = *_type_of(checker, expr->Subscript.subscript->id);
+            if (index != Type_Error && !types_is_integer(index)) {
+                _expected(checker, TYPE_NUMBER(Nc_usize), index, expr->Subscript.subscript->span);
+            }
+            Type_Info *info = types_info(&checker->table, base);
+            if (info->kind == Ty_Array || info->kind == Ty_Slice) {
+                return info->inner;
+            }
+            if (base != Type_Error) {
+                _begin_error(checker);
+                writer_cstr(checker->err, "Cannot index ");
+                _quoted(checker, base);
+                _end_error(checker, expr->span);
+            }
+            return Type_Error;
+        }
+        case Paren_kind:
+            return *_type_of(checker, expr->Paren.expr->id);
+        case Refrence_kind: {
+            Type_Id inner = *_type_of(checker, expr->Refrence.expr->id);
+            if (inner == Type_Error) {
+                return Type_Error;
+            }
+            return types_pointer(&checker->table, Ty_Ref, inner, false, false);
+        }
+        case If_kind:
+            return _check_if(checker, expr);
+        case Block_kind:
+            return _block_type(checker, expr->Block.block);
+        case Call_kind:
+        case Member_kind:
+            // nothing declares functions or structs yet
+            return Type_Error;
+        default:
+            break;
+    }
+    assert(false && "unreachable");
+}
+
+static
+Type_Id _primitive(String_Builder name) {
+    static const struct { const char *name; Type_Id type; } names[] = {
+        { "bool", Type_Bool },
+        { "char", Type_Char },
+        { "str", Type_Str },
+        { "void", Type_Void },
+    };
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (strlen(names[i].name) == name.count && memcmp(names[i].name, name.items, name.count) == 0) {
+            return names[i].type;
+        }
+    }
+    // the identifiers are interned, so NUL terminated
+    Lex_NumberClass nclass = number_class_resolve(name.items);
+    if (nclass != Nc_Invalid && nclass != Nc_Number && nclass != Nc_FloatingPointNumber) {
+        return TYPE_NUMBER(nclass);
+    }
+    return Type_Error;
+}
+
+static
+Type_Id _check_type(Checker *checker, Ast_Type *type) {
+    Type_Table *table = &checker->table;
+    switch (type->kind) {
+        case TyPath_kind: {
+            Ast_Path *path = &type->TyPath.path;
+            Type_Id primitive = path->count == 1 ? _primitive(path->items[0].ident) : Type_Error;
+            if (primitive == Type_Error) {
+                _begin_error(checker);
+                writer_cstr(checker->err, "Unknown type `");
+                ast_print_path(checker->err, path);
+                writer_char(checker->err, '`');
+                _end_error(checker, type->span);
+            }
+            return primitive;
+        }
+        case Owned_kind:
+        case Nullable_kind:
+        case TySlice_kind: {
+            // all three keep their inner type in `ty`
+            Type_Id inner = *_type_of(checker, type->Owned.ty->id);
+            Type_Kind kind = type->kind == Owned_kind ? Ty_Owned
+                : type->kind == Nullable_kind ? Ty_Nullable : Ty_Slice;
+            return types_intern(table, (Type_Info) { .kind = kind, .inner = inner }, NULL, 0);
+        }
+        case Ref_kind:
+        case Ptr_kind: {
+            Type_Id inner = *_type_of(checker, type->Ref.ty->id);
+            Type_Kind kind = type->kind == Ref_kind ? Ty_Ref : Ty_Ptr;
+            return types_pointer(table, kind, inner, type->Ref.mut == M_Mut, type->Ref.nullable);
+        }
+        case TyArray_kind: {
+            Type_Info info = {
+                .kind = Ty_Array,
+                .inner = *_type_of(checker, type->TyArray.ty->id),
+                .size = type->TyArray.size,
+            };
+            return types_intern(table, info, NULL, 0);
+        }
+        case TyTuple_kind: {
+            checker->scratch.count = 0;
+            for (size_t i = 0; i < type->TyTuple.types.count; i++) {
+                da_append(&checker->scratch, *_type_of(checker, type->TyTuple.types.items[i]->id));
+            }
+            Type_Info info = { .kind = Ty_Tuple };
+            return types_intern(table, info, checker->scratch.items, checker->scratch.count);
+        }
+        case Generic_kind:
+            // nothing declares generic types yet
+        case Inferred_kind:
+            // see _check_decl
+            return Type_Error;
+        default:
+            break;
+    }
+    assert(false && "unreachable");
+}
+
+static
+Type_Id _check_decl(Checker *checker, Ast_Stmt *stmt) {
+    Ast_Expr *init = stmt->Decl.init;
+    Type_Id init_type = init != NULL ? *_type_of(checker, init->id) : Type_Error;
+    if (stmt->Decl.type->kind != Inferred_kind) {
+        Type_Id declared = *_type_of(checker, stmt->Decl.type->id);
+        if (!_assignable(checker, init_type, declared)) {
+            _expected(checker, declared, init_type, init->span);
+        } else if (init != NULL) {
+            _check_literal(checker, init, declared);
+        }
+        return declared;
+    }
+
+    if (init == NULL) {
+        _begin_error(checker);
+        writer_cstr(checker->err, "Cannot infer the type of `");
+        writer_write(checker->err, stmt->Decl.ident.items, stmt->Decl.ident.count);
+        writer_char(checker->err, '`');
+        _end_error(checker, stmt->span);
+        return Type_Error;
+    }
+    if (init_type == TYPE_NUMBER(Nc_Number)) {
+        _check_literal(checker, init, TYPE_NUMBER(Nc_i64));
+        return TYPE_NUMBER(Nc_i64);
+    }
+    if (init_type == TYPE_NUMBER(Nc_FloatingPointNumber)) {
+        return TYPE_NUMBER(Nc_f64);
+    }
+    return init_type;
+}
+
+// The literal of `-<literal>` is checked together with its minus, by the
+// Unary instead of on its own
+static
+Ast_VisitResult _checker_pre(Ast_Visitor *visitor, Ast_Node node) {
+    Checker *checker = visitor->data;
+    if (node.klass == Node_Expr && node.expr->kind == Unary_kind && node.expr->Unary.op == Uo_Minus) {
+        bool negated;
+        Ast_Expr *literal = _integer_literal(node.expr, &negated);
+        if (literal != NULL) {
+            checker->negated = literal;
+        }
+    }
+    return Visit_Continue;
+}
+
+// Post order, the children are typed already
+static
+Ast_VisitResult _checker_post(Ast_Visitor *visitor, Ast_Node node) {
+    Checker *checker = visitor->data;
+    switch (node.klass) {
+        case Node_Expr:
+            *_type_of(checker, node.expr->id) = _check_expr(checker, node.expr);
+            checker->checked++;
+            break;
+        case Node_Type:
+            *_type_of(checker, node.type->id) = _check_type(checker, node.type);
+            break;
+        case Node_Stmt:
+            *_type_of(checker, node.stmt->id) = node.stmt->kind == Decl_kind
+                ? _check_decl(checker, node.stmt) : Type_Void;
+            break;
+        case Node_Block:
+        case Node_Item:
+            break;
+    }
+    return Visit_Continue;
+}
+
+BinaryOp check_compound_operator(AssignmentOp op) {
+    return assignment_operators[op];
+}
+
+bool check_source(Checker *checker, Ast_Pool *pool, Ast_Source *source, Writer *err) {
+    if (checker->table.infos.count == 0) {
+        types_init(&checker->table);
+    }
+    // every slot is written before it is read, the walk is post order and
+    // a Decl comes before the paths bound to it
+    if (checker->types.capacity < pool->ids) {
+        free(checker->types.items);
+        checker->types.capacity = pool->ids;
+        checker->types.items = malloc(pool->ids * sizeof(Type_Id));
+        assert(checker->types.items != NULL && "Buy more RAM lol");
+    }
+    checker->types.count = pool->ids;
+    checker->err = err;
+    checker->errors = 0;
+    checker->checked = 0;
+
+    checker->negated = NULL;
+    checker->visitor.pre = _checker_pre;
+    checker->visitor.post = _checker_post;
+    checker->visitor.data = checker;
+    ast_walk_source(&checker->visitor, source);
+    METRICS_COUNT_CHECK(checker->checked);
+    return checker->errors == 0;
+}
+
+void checker_free(Checker *checker) {
+    types_free(&checker->table);
+    free(checker->types.items);
+    free(checker->scratch.items);
+    ast_visitor_free(&checker->visitor);
+    *checker = (Checker) {0};
+}
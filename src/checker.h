@@ -0,0 +1,51 @@
+#ifndef CHECKER_H_
+#define CHECKER_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "AST.h"
+#include "ast_pool.h"
+#include "types.h"
+#include "visitor.h"
+#include "writer.h"
+
+// Gives every expression, type and statement of a source a type from the
+// checker's type table in a single post order walk, so the types of the
+// children are known when a node is reached. The types live in a side
+// array indexed by node id, a Decl has the type of the variable it
+// declares. Paths are typed through the Decl the resolver bound them to,
+// so the source has to be resolved first.
+//
+// Declarations without a type take the type of their initializer, a plain
+// `Number` becomes an i64 and a plain `FloatingPointNumber` an f64. Calls
+// and members are not typed yet, like everything built on a type error
+// they get `Type_Error`, which is compatible with every type and never
+// reported twice.
+typedef struct {
+    // kept for all sources checked with this checker
+    Type_Table table;
+    // by node id, only valid for the ids of the last checked source
+    Type_Ids types;
+    // the elements of the tuple type being built
+    Type_Ids scratch;
+    Ast_Visitor visitor;
+    Writer *err;
+    size_t errors;
+    // expressions typed by the last check_source
+    size_t checked;
+    // the operand of the innermost `-<literal>` walked into
+    Ast_Expr *negated;
+} Checker;
+
+// The operator of a compound assignment, Bo_Invalid for `=` and `:=`
+BinaryOp check_compound_operator(AssignmentOp op);
+bool check_source(Checker *checker, Ast_Pool *pool, Ast_Source *source, Writer *err);
+void checker_free(Checker *checker);
+
+static inline
+Type_Id check_type_of(Checker *checker, uint32_t id) {
+    return checker->types.items[id];
+}
+
+#endif // CHECKER_H_
@@ -0,0 +1,73 @@
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "driver.h"
+
+#define return_defer(value) \
+    do { result = (value); goto defer; } while (0)
+
+bool read_entire_file(const char *filename, String_Builder *sb, Writer *err) {
+    bool result = true;
+    FILE *file = fopen(filename, "r");
+    if (file == NULL) {
+        return_defer(false);
+    }
+
+    if (fseek(file, 0L, SEEK_END) != 0) {
+        return_defer(false);
+    }
+    long fsize = ftell(file);
+    if (fsize == -1) {
+        return_defer(false);
+    }
+
+    if (sb->capacity - sb->count < (size_t)fsize) {
+        sb->items = realloc(sb->items, sb->count + fsize);
+        sb->capacity = sb->count + fsize;
+    }
+
+    if (fseek(file, 0L, SEEK_SET) != 0) {
+        return_defer(false);
+    }
+    if (fread(sb->items + sb->count, 1, fsize, file) == 0 && fsize > 0) {
+        return_defer(false);
+    }
+    sb->count += fsize;
+
+    // if (errno)
+
+    if (fclose(file) != 0) {
+        return_defer(false);
+    }
+
+defer:
+    if (!result) {
+        writer_cstr(err, "ERROR: Could not read file: ");
+        writer_cstr(err, filename);
+        writer_cstr(err, ": ");
+        writer_cstr(err, strerror(errno));
+        writer_char(err, '\n');
+    }
+    return result;
+}
+
+void emit_source(Writer *out, Emit_Kind emit, Ast_Source *source) {
+    switch (emit) {
+        case Emit_Ast:
+            ast_print_source(out, source, 0);
+            writer_char(out, '\n');
+            break;
+        case Emit_AstJson:
+            ast_export_json(out, source);
+            break;
+        case Emit_AstBin:
+            ast_export_bin(out, source);
+            break;
+        case Emit_Ssa:
+            assert(false && "lowered in process_file");
+            break;
+    }
+}
@@ -0,0 +1,25 @@
+#ifndef DRIVER_H_
+#define DRIVER_H_
+
+#include <stdbool.h>
+
+#include "AST.h"
+#include "strings.h"
+#include "writer.h"
+
+// Shared by the command line driver in main.c and the compile server
+
+typedef enum {
+    Emit_Ast,
+    Emit_AstJson,
+    Emit_AstBin,
+    // the #entrypoints in SSA form, which needs a checked source so only
+    // the command line driver emits it
+    Emit_Ssa,
+} Emit_Kind;
+
+// Appends the content of `filename` to `sb`, failures are reported to `err`
+bool read_entire_file(const char *filename, String_Builder *sb, Writer *err);
+void emit_source(Writer *out, Emit_Kind emit, Ast_Source *source);
+
+#endif // DRIVER_H_
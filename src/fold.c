@@ -0,0 +1,300 @@
+#include <stdint.h>
+
+#include "fold.h"
+#include "types.h"
+
+// The class both operands are evaluated in, a plain `untyped` literal
+// adopts the class of the other one
+static
+bool _unify(Lex_NumberClass lhs, Lex_NumberClass rhs, Lex_NumberClass untyped, Lex_NumberClass *nclass) {
+    if (lhs == rhs || rhs == untyped) {
+        *nclass = lhs;
+    } else if (lhs == untyped) {
+        *nclass = rhs;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static inline
+Ast_LiteralExpr _boolean(bool value) {
+    return (Ast_LiteralExpr) { .kind = L_Boolean, .boolean = value };
+}
+
+static
+bool _fold_signed(BinaryOp op, int64_t a, int64_t b, int bits, Ast_LiteralExpr *result) {
+    int64_t value;
+    switch (op) {
+        case Bo_Plus:
+            if (__builtin_add_overflow(a, b, &value)) return false;
+            break;
+        case Bo_Minus:
+            if (__builtin_sub_overflow(a, b, &value)) return false;
+            break;
+        case Bo_Mul:
+            if (__builtin_mul_overflow(a, b, &value)) return false;
+            break;
+        case Bo_Div:
+        case Bo_Mod:
+            if (b == 0 || (a == INT64_MIN && b == -1)) return false;
+            value = op == Bo_Div ? a / b : a % b;
+            break;
+        case Bo_Shl:
+            if (b < 0 || b >= bits) return false;
+            value = (int64_t)((uint64_t)a << b);
+            // bits shifted out or into the sign
+            if (value >> b != a) return false;
+            break;
+        case Bo_Shr:
+            if (b < 0 || b >= bits) return false;
+            value = a >> b;
+            break;
+        case Bo_BAnd: value = a & b; break;
+        case Bo_BXor: value = a ^ b; break;
+        case Bo_BOr: value = a | b; break;
+        case Bo_Eq: *result = _boolean(a == b); return true;
+        case Bo_Ne: *result = _boolean(a != b); return true;
+        case Bo_Gt: *result = _boolean(a > b); return true;
+        case Bo_Ge: *result = _boolean(a >= b); return true;
+        case Bo_Lt: *result = _boolean(a < b); return true;
+        case Bo_Le: *result = _boolean(a <= b); return true;
+        default: return false;
+    }
+    result->integer = (uint64_t)value;
+    return true;
+}
+
+static
+bool _fold_unsigned(BinaryOp op, uint64_t a, uint64_t b, int bits, Ast_LiteralExpr *result) {
+    uint64_t value;
+    switch (op) {
+        case Bo_Plus:
+            if (__builtin_add_overflow(a, b, &value)) return false;
+            break;
+        case Bo_Minus:
+            if (__builtin_sub_overflow(a, b, &value)) return false;
+            break;
+        case Bo_Mul:
+            if (__builtin_mul_overflow(a, b, &value)) return false;
+            break;
+        case Bo_Div:
+        case Bo_Mod:
+            if (b == 0) return false;
+            value = op == Bo_Div ? a / b : a % b;
+            break;
+        case Bo_Shl:
+            if (b >= (uint64_t)bits) return false;
+            value = a << b;
+            if (value >> b != a) return false;
+            break;
+        case Bo_Shr:
+            if (b >= (uint64_t)bits) return false;
+            value = a >> b;
+            break;
+        case Bo_BAnd: value = a & b; break;
+        case Bo_BXor: value = a ^ b; break;
+        case Bo_BOr: value = a | b; break;
+        case Bo_Eq: *result = _boolean(a == b); return true;
+        case Bo_Ne: *result = _boolean(a != b); return true;
+        case Bo_Gt: *result = _boolean(a > b); return true;
+        case Bo_Ge: *result = _boolean(a >= b); return true;
+        case Bo_Lt: *result = _boolean(a < b); return true;
+        case Bo_Le: *result = _boolean(a <= b); return true;
+        default: return false;
+    }
+    result->integer = value;
+    return true;
+}
+
+static
+bool _fold_integer(BinaryOp op, Ast_LiteralExpr *lhs, Ast_LiteralExpr *rhs, Ast_LiteralExpr *result) {
+    Lex_NumberClass nclass;
+    if (op == Bo_Shl || op == Bo_Shr) {
+        // the shift amount may have any class
+        nclass = lhs->nclass;
+    } else if (!_unify(lhs->nclass, rhs->nclass, Nc_Number, &nclass)) {
+        return false;
+    }
+    // the class of a plain Number comes from where it is used, which only
+    // the checker knows
+    if (nclass == Nc_Number) {
+        return false;
+    }
+    Lex_NumberClass evaluated = nclass;
+    if (!types_class_fits(evaluated, lhs->integer) || !types_class_fits(rhs->nclass == Nc_Number ? evaluated : rhs->nclass, rhs->integer)) {
+        return false;
+    }
+
+    *result = (Ast_LiteralExpr) { .kind = L_Integer, .nclass = nclass };
+    int bits = types_class_bits(evaluated);
+    bool folded = IS_UNSIGNED_CLASS(evaluated)
+        ? _fold_unsigned(op, lhs->integer, rhs->integer, bits, result)
+        : _fold_signed(op, (int64_t)lhs->integer, (int64_t)rhs->integer, bits, result);
+    return folded && (result->kind == L_Boolean || types_class_fits(evaluated, result->integer));
+}
+
+static
+bool _fold_float(BinaryOp op, Ast_LiteralExpr *lhs, Ast_LiteralExpr *rhs, Ast_LiteralExpr *result) {
+    Lex_NumberClass nclass;
+    if (!_unify(lhs->nclass, rhs->nclass, Nc_FloatingPointNumber, &nclass)) {
+        return false;
+    }
+    double a = lhs->floating, b = rhs->floating;
+    double value;
+    switch (op) {
+        case Bo_Plus: value = a + b; break;
+        case Bo_Minus: value = a - b; break;
+        case Bo_Mul: value = a * b; break;
+        case Bo_Div: value = a / b; break;
+        case Bo_Eq: *result = _boolean(a == b); return true;
+        case Bo_Ne: *result = _boolean(a != b); return true;
+        case Bo_Gt: *result = _boolean(a > b); return true;
+        case Bo_Ge: *result = _boolean(a >= b); return true;
+        case Bo_Lt: *result = _boolean(a < b); return true;
+        case Bo_Le: *result = _boolean(a <= b); return true;
+        default: return false;
+    }
+    if (nclass == Nc_f32) {
+        value = (float)value;
+    }
+    *result = (Ast_LiteralExpr) { .kind = L_Float, .floating = value, .nclass = nclass };
+    return true;
+}
+
+static
+bool _fold_boolean(BinaryOp op, bool a, bool b, Ast_LiteralExpr *result) {
+    switch (op) {
+        case Bo_Eq: *result = _boolean(a == b); return true;
+        case Bo_Ne: *result = _boolean(a != b); return true;
+        case Bo_And: *result = _boolean(a && b); return true;
+        case Bo_Or: *result = _boolean(a || b); return true;
+        default: return false;
+    }
+}
+
+// Writes the result into `lhs`, which is left alone if the operation can
+// not be folded
+static
+bool _fold_binary(BinaryOp op, Ast_LiteralExpr *lhs, Ast_LiteralExpr *rhs) {
+    Ast_LiteralExpr result;
+    bool folded = false;
+    if (lhs->kind == L_Integer && rhs->kind == L_Integer) {
+        folded = _fold_integer(op, lhs, rhs, &result);
+    } else if (lhs->kind == L_Float && rhs->kind == L_Float) {
+        folded = _fold_float(op, lhs, rhs, &result);
+    } else if (lhs->kind == L_Boolean && rhs->kind == L_Boolean) {
+        folded = _fold_boolean(op, lhs->boolean, rhs->boolean, &result);
+    }
+    if (folded) {
+        *lhs = result;
+    }
+    return folded;
+}
+
+static
+bool _fold_unary(UnaryOp op, Ast_LiteralExpr *operand) {
+    switch (operand->kind) {
+        case L_Integer: {
+            Lex_NumberClass evaluated = operand->nclass;
+            // see _fold_integer, an operand out of range is the checker's to
+            // report, `-128i8` as a whole included
+            if (evaluated == Nc_Number || !types_class_fits(evaluated, operand->integer)) {
+                return false;
+            }
+            if (op == Uo_Plus) {
+                return true;
+            }
+            if (op == Uo_BitwiseNot) {
+                uint64_t value = ~operand->integer;
+                if (IS_UNSIGNED_CLASS(evaluated) && types_class_bits(evaluated) < 64) {
+                    value &= ((uint64_t)1 << types_class_bits(evaluated)) - 1;
+                }
+                operand->integer = value;
+                return true;
+            }
+            // an unsigned negation is left for the later phases to reject
+            if (op != Uo_Minus || IS_UNSIGNED_CLASS(evaluated)) {
+                return false;
+            }
+            int64_t value = (int64_t)operand->integer;
+            if (value == INT64_MIN || !types_class_fits(evaluated, (uint64_t)-value)) {
+                return false;
+            }
+            operand->integer = (uint64_t)-value;
+            return true;
+        }
+        case L_Float:
+            if (op == Uo_Minus) {
+                operand->floating = -operand->floating;
+            }
+            return op == Uo_Minus || op == Uo_Plus;
+        case L_Boolean:
+            if (op == Uo_Not) {
+                operand->boolean = !operand->boolean;
+            }
+            return op == Uo_Not;
+        default:
+            return false;
+    }
+}
+
+static inline
+bool _is_literal(Ast_Expr *expr) {
+    return expr->kind == Literal_kind;
+}
+
+// Post order, so the operands are folded already
+static
+Ast_VisitResult _folder_post(Ast_Visitor *visitor, Ast_Node node) {
+    if (node.klass != Node_Expr) {
+        return Visit_Continue;
+    }
+    Folder *folder = visitor->data;
+    Ast_Expr *expr = node.expr;
+    Ast_Expr *result = NULL;
+    switch (expr->kind) {
+        case Paren_kind:
+            if (_is_literal(expr->Paren.expr)) {
+                result = expr->Paren.expr;
+            }
+            break;
+        case Unary_kind:
+            if (_is_literal(expr->Unary.expr) && _fold_unary(expr->Unary.op, &expr->Unary.expr->Literal)) {
+                result = expr->Unary.expr;
+            }
+            break;
+        case Binary_kind: {
+            Ast_Expr *lhs = expr->Binary.lhs;
+            Ast_Expr *rhs = expr->Binary.rhs;
+            if (_is_literal(lhs) && _is_literal(rhs) && _fold_binary(expr->Binary.op, &lhs->Literal, &rhs->Literal)) {
+                result = lhs;
+                ast_pool_release(folder->pool, rhs, ast_sizeof_node(Node_Expr, rhs));
+                folder->released++;
+            }
+        } break;
+        default:
+            break;
+    }
+    if (result != NULL) {
+        result->span = expr->span;
+        *node.slot = result;
+        ast_pool_release(folder->pool, expr, ast_sizeof_node(Node_Expr, expr));
+        folder->released++;
+    }
+    return Visit_Continue;
+}
+
+void fold_source(Folder *folder, Ast_Pool *pool, Ast_Source *source) {
+    folder->pool = pool;
+    folder->released = 0;
+    folder->visitor.pre = NULL;
+    folder->visitor.post = _folder_post;
+    folder->visitor.data = folder;
+    ast_walk_source(&folder->visitor, source);
+}
+
+void folder_free(Folder *folder) {
+    ast_visitor_free(&folder->visitor);
+    *folder = (Folder) {0};
+}
@@ -0,0 +1,33 @@
+#ifndef FOLD_H_
+#define FOLD_H_
+
+#include <stddef.h>
+
+#include "AST.h"
+#include "ast_pool.h"
+#include "visitor.h"
+
+// Replaces every Unary, Binary and Paren expression whose operands are
+// literals by the literal it evaluates to, in a single post order walk. The
+// result is written into the node of an operand, which takes the place of
+// the expression in its parent, and the other nodes go back to the pool, so
+// folding never allocates.
+//
+// Integers are evaluated in the width of their number class and a plain
+// `Number` adopts the class of the other operand. Plain Numbers on their own
+// are left alone, their class depends on where they are used. So is an
+// operation that overflows its class, divides by zero, shifts by the width
+// or more or mixes classes: it behaves as it would have without folding,
+// the checker reports what it rejects and the rest wraps at runtime. Floats
+// are evaluated as f64 and rounded to f32 for that class.
+typedef struct {
+    Ast_Pool *pool;
+    Ast_Visitor visitor;
+    // nodes released by the last fold_source
+    size_t released;
+} Folder;
+
+void fold_source(Folder *folder, Ast_Pool *pool, Ast_Source *source);
+void folder_free(Folder *folder);
+
+#endif // FOLD_H_
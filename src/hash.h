@@ -0,0 +1,77 @@
+#ifndef HASH_H_
+#define HASH_H_
+
+// Fast non-cryptographic hash in the style of wyhash, for the generated
+// perfect hashes and the identifier interner. Unlike SipHash it makes no
+// promise against crafted collisions, both users hash trusted or fixed key
+// sets. `fast_hash` in Generators/phf_generator.py computes the same values,
+// keep the two in sync.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define HASH_P0 0xa0761d6478bd642full
+#define HASH_P1 0xe7037ed1a0b428dbull
+
+// 64x64 -> 128 bit multiply, folded back to 64 bits
+static inline
+uint64_t hash_mix(uint64_t a, uint64_t b) {
+    __uint128_t r = (__uint128_t)a * b;
+    return (uint64_t)r ^ (uint64_t)(r >> 64);
+}
+
+static inline
+uint64_t _hash_read8(const uint8_t *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline
+uint64_t _hash_read4(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline
+uint64_t hash_bytes(const void *key, size_t len, uint64_t seed) {
+    const uint8_t *p = key;
+    uint64_t a, b;
+    seed ^= hash_mix(seed ^ HASH_P0, HASH_P1);
+    if (len <= 16) {
+        if (len >= 4) {
+            // two overlapping reads from each end cover 4 to 16 bytes
+            const size_t shift = (len >> 3) << 2;
+            a = (_hash_read4(p) << 32) | _hash_read4(p + shift);
+            b = (_hash_read4(p + len - 4) << 32) | _hash_read4(p + len - 4 - shift);
+        } else if (len > 0) {
+            a = ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) | p[len - 1];
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t i = len;
+        for (; i > 16; i -= 16, p += 16) {
+            seed = hash_mix(_hash_read8(p) ^ HASH_P1, _hash_read8(p + 8) ^ seed);
+        }
+        a = _hash_read8(p + i - 16);
+        b = _hash_read8(p + i - 8);
+    }
+    __uint128_t r = (__uint128_t)(a ^ HASH_P1) * (b ^ seed);
+    return hash_mix((uint64_t)r ^ HASH_P0 ^ len, (uint64_t)(r >> 64) ^ HASH_P1);
+}
+
+// hash_bytes(&key, 4, seed) without the length dispatch, e.g. for a packed
+// punctuator
+static inline
+uint64_t hash_u32(uint32_t key, uint64_t seed) {
+    seed ^= hash_mix(seed ^ HASH_P0, HASH_P1);
+    uint64_t a = ((uint64_t)key << 32) | key;
+    __uint128_t r = (__uint128_t)(a ^ HASH_P1) * (a ^ seed);
+    return hash_mix((uint64_t)r ^ HASH_P0 ^ 4, (uint64_t)(r >> 64) ^ HASH_P1);
+}
+
+#endif // HASH_H_
@@ -0,0 +1,79 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "intern.h"
+
+#ifdef INTERN_SIPHASH
+uint64_t thirdparty_siphash24(const void *src, unsigned long src_sz, const char key[16]);
+
+static const char intern_key[16] = "bang interner 01";
+
+static inline
+uint64_t _hash(String_View string) {
+    return thirdparty_siphash24(string.data, string.count, intern_key);
+}
+#else
+#include "hash.h"
+
+static inline
+uint64_t _hash(String_View string) {
+    return hash_bytes(string.data, string.count, 0x62616e67696e7465ull);
+}
+#endif // INTERN_SIPHASH
+
+// linear probing in a power of two table, kept at most half full
+static
+Intern_Entry *_find(Intern_Entry *entries, size_t capacity, uint64_t hash, String_View string) {
+    size_t mask = capacity - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        Intern_Entry *entry = &entries[i];
+        if (entry->string.data == NULL) {
+            return entry;
+        }
+        if (entry->hash == hash && sv_eq(entry->string, string)) {
+            return entry;
+        }
+    }
+}
+
+static
+void _grow(Intern_Table *table) {
+    size_t capacity = table->capacity == 0 ? INTERN_INIT_CAP : table->capacity*2;
+    Intern_Entry *entries = calloc(capacity, sizeof(Intern_Entry));
+    assert(entries != NULL && "Buy more RAM lol");
+    for (size_t i = 0; i < table->capacity; i++) {
+        Intern_Entry *entry = &table->entries[i];
+        if (entry->string.data != NULL) {
+            *_find(entries, capacity, entry->hash, entry->string) = *entry;
+        }
+    }
+    free(table->entries);
+    table->entries = entries;
+    table->capacity = capacity;
+}
+
+String_View intern_string(Intern_Table *table, String_View string) {
+    if (2*(table->count + 1) > table->capacity) {
+        _grow(table);
+    }
+    uint64_t hash = _hash(string);
+    Intern_Entry *entry = _find(table->entries, table->capacity, hash, string);
+    if (entry->string.data == NULL) {
+        char *copy = arena_alloc(&table->strings, string.count + 1);
+        memcpy(copy, string.data, string.count);
+        copy[string.count] = '\0';
+        *entry = (Intern_Entry) {
+            .hash = hash,
+            .string = { .count = string.count, .data = copy }
+        };
+        table->count++;
+    }
+    return entry->string;
+}
+
+void intern_free(Intern_Table *table) {
+    free(table->entries);
+    arena_free(&table->strings);
+    *table = (Intern_Table) {0};
+}
@@ -0,0 +1,31 @@
+#ifndef INTERN_H_
+#define INTERN_H_
+
+#include <stdint.h>
+
+#include "arena.h"
+#include "strings.h"
+
+// Strings are hashed with hash_bytes from hash.h, build with
+// -DINTERN_SIPHASH to use SipHash-2-4 instead
+#define INTERN_INIT_CAP 1024
+
+typedef struct {
+    uint64_t hash;
+    String_View string;
+} Intern_Entry;
+
+// Deduplicates strings: interning the same bytes twice returns the same
+// pointer, so interned strings compare by `data`. The copies are NUL
+// terminated and live until `intern_free`.
+typedef struct {
+    Intern_Entry *entries;
+    size_t count;
+    size_t capacity;
+    Arena strings;
+} Intern_Table;
+
+String_View intern_string(Intern_Table *table, String_View string);
+void intern_free(Intern_Table *table);
+
+#endif // INTERN_H_
@@ -1,16 +1,23 @@
 #include <assert.h>
+#include <errno.h>
 #include <string.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 #include "dynarray.h"
+#include "intern.h"
 
 #define LEXERC_H_IMPLEMENTATION
 #define OPERATORS_H_IMPLEMENTATION
 #include "lexer.h"
+#include "metrics.h"
 #include "strings.h"
 
+// identifier names of every source tokenized on this thread, see
+// lexer_free_interned
+static _Thread_local Intern_Table lexer_interner;
+
 typedef struct {
     bool is_some;
     char value;
@@ -110,7 +117,8 @@ typedef struct {
 
 static
 Char_Result lookahead(Lexer_State *ls) {
-    if (ls->input_pos + 1 == ls->input.count - 1) {
+    // the last character is never a lookahead, past it there is nothing
+    if (ls->input_pos + 2 >= ls->input.count) {
         return NONE;
     }
     return SOME(ls->input.data[ls->input_pos+1]);
@@ -276,32 +284,29 @@ Consume_Result consume_comment(Lexer_State *ls) {
     return Unmatched;
 }
 
+// interned strings are NUL terminated, the resolve functions take them as is
 static
 bool _match_directive(String_View sv, Lex_Directive *res) {
-    char *str = malloc(sv.count + 1);
-
-    memcpy(str, sv.data, sv.count);
-    str[sv.count] = 0;
-
-    *res = directive_resolve(str);
-
-    free(str);
+    *res = directive_resolve(intern_string(&lexer_interner, sv).data);
     return *res != D_Invalid;
 }
 
 static
-bool _match_keyword(String_View sv, Lex_Keyword *res) {
-    char *str = malloc(sv.count + 1);
-
-    memcpy(str, sv.data, sv.count);
-    str[sv.count] = 0;
-
-    *res = keyword_resolve(str);
-
-    free(str);
+bool _match_keyword(String_View interned, Lex_Keyword *res) {
+    *res = keyword_resolve(interned.data);
     return *res != K_Invalid;
 }
 
+static
+String_Builder interned_to_string(String_View interned) {
+    // capacity 0, the interner owns the memory
+    return (String_Builder) {
+        .items = (char *)interned.data,
+        .count = interned.count,
+        .capacity = 0
+    };
+}
+
 static
 Consume_Result consume_identifier(Lexer_State *ls, bool simple) {
     char curr = current(ls);
@@ -329,16 +334,20 @@ Consume_Result consume_identifier(Lexer_State *ls, bool simple) {
                 MATCHED(Directive, .directive = d)
             }
             FAIL(UnknownDirective);
-        } else if (!sv_startswith(identifier, '$')) {
+        }
+        String_View interned = intern_string(&lexer_interner, identifier);
+        if (!sv_startswith(identifier, '$')) {
             // check keyword
             Lex_Keyword k;
-            if (_match_keyword(identifier, &k)) {
+            if (_match_keyword(interned, &k)) {
                 MATCHED(Keyword, .keyword = k)
             }
         }
+        MATCHED(Ident, .name = interned_to_string(interned))
     }
 end:
-    MATCHED(Ident, .name = window_to_string(ls->window))
+    create_window(ls);
+    MATCHED(Ident, .name = interned_to_string(intern_string(&lexer_interner, ls->window)))
 }
 
 static
@@ -364,8 +373,10 @@ bool _is_float_suffix(String_View sv) {
     return sv_eq_cstr(sv, "f32") || sv_eq_cstr(sv, "f64");
 }
 
+// Integers are read as the unsigned magnitude, whether it fits its class is
+// up to the checker, which knows if it is negated
 static
-bool _end_parse_number(Lexer_State *ls, int base, size_t number_end_pos, Lex_NumberClass class) {
+bool _end_parse_number(Lexer_State *ls, int base, size_t number_end_pos, Lex_NumberClass class, Lex_Error *error) {
     create_window(ls);
     int start = 0;
     if (base != 10) {
@@ -381,6 +392,7 @@ bool _end_parse_number(Lexer_State *ls, int base, size_t number_end_pos, Lex_Num
     if (base == 2 || base == 8) {
         sv_for_each(&number_sv, chr, {
             if (!CHR_IN_RANGE(chr, base)) {
+                *error = UnsupportedDigitForBase;
                 return false;
             }
         });
@@ -396,7 +408,13 @@ bool _end_parse_number(Lexer_State *ls, int base, size_t number_end_pos, Lex_Num
     if (IS_FLOAT_CLASS(class)) {
         number.floating = strtod(number_str, &endptr);
     } else {
-        number.integer = strtol(number_str, &endptr, base);
+        errno = 0;
+        number.integer = strtoull(number_str, &endptr, base);
+        if (errno == ERANGE) {
+            free(number_str);
+            *error = IntegerOutOfRange;
+            return false;
+        }
     }
 
     ls->token = (Lex_Token) {
@@ -478,7 +496,7 @@ while (true) {
     if (!is_eof(ls) && current(ls) == '.') {                                                                   \
         if (_check_multiple_dots_end(ls)) {                                                                    \
             FAIL_COMMON_FLOAT_ERRORS;                                                                          \
-            FAIL_BASE_UNSUPPORTED_CHR(ls, base, ls->input_pos, is_float ? Nc_FloatingPointNumber : Nc_Number); \
+            FAIL_INVALID_NUMBER(ls, base, ls->input_pos, is_float ? Nc_FloatingPointNumber : Nc_Number); \
             return Matched;                                                                                    \
         }                                                                                                      \
     } else {                                                                                                   \
@@ -493,8 +511,8 @@ if (base != 10 && is_float) {             \
 if (multiple_dots_in_float) {             \
     FAIL(MultipleDotsInFloat);            \
 }
-#define FAIL_BASE_UNSUPPORTED_CHR(...) \
-   if(!_end_parse_number(__VA_ARGS__)) { FAIL(UnsupportedDigitForBase); }
+#define FAIL_INVALID_NUMBER(...) \
+   { Lex_Error error; if(!_end_parse_number(__VA_ARGS__, &error)) { FAIL(error); } }
 
     int found;
     ITER_DIGITS(found, base == 16 && IS_HEX(curr));
@@ -510,7 +528,7 @@ if (multiple_dots_in_float) {             \
                 return Unmatched;
             }
             bump(ls);
-            FAIL_BASE_UNSUPPORTED_CHR(ls, base, ls->input_pos, Nc_FloatingPointNumber);
+            FAIL_INVALID_NUMBER(ls, base, ls->input_pos, Nc_FloatingPointNumber);
             return Matched;
         }
         if (_check_multiple_dots_end(ls)) {
@@ -518,7 +536,7 @@ if (multiple_dots_in_float) {             \
                 // we haven't matched anything yet
                 return Unmatched;
             }
-            FAIL_BASE_UNSUPPORTED_CHR(ls, base, ls->input_pos, Nc_Number);
+            FAIL_INVALID_NUMBER(ls, base, ls->input_pos, Nc_Number);
             return Matched;
         }
         is_float = true;
@@ -530,7 +548,7 @@ if (multiple_dots_in_float) {             \
 
     if (is_eof(ls)) {
         FAIL_COMMON_FLOAT_ERRORS;
-        FAIL_BASE_UNSUPPORTED_CHR(ls, base, ls->input_pos, is_float ? Nc_FloatingPointNumber : Nc_Number);
+        FAIL_INVALID_NUMBER(ls, base, ls->input_pos, is_float ? Nc_FloatingPointNumber : Nc_Number);
         return Matched;
     }
 
@@ -552,7 +570,7 @@ if (multiple_dots_in_float) {             \
 
     if (is_eof(ls)) {
         FAIL_COMMON_FLOAT_ERRORS;
-        FAIL_BASE_UNSUPPORTED_CHR(ls, base, ls->input_pos, is_float ? Nc_FloatingPointNumber : Nc_Number);
+        FAIL_INVALID_NUMBER(ls, base, ls->input_pos, is_float ? Nc_FloatingPointNumber : Nc_Number);
         return Matched;
     }
 
@@ -625,13 +643,13 @@ if (multiple_dots_in_float) {             \
         }
     }
 
-    FAIL_BASE_UNSUPPORTED_CHR(ls, base, number_end_pos, class);
+    FAIL_INVALID_NUMBER(ls, base, number_end_pos, class);
     return Matched;
 
 #undef ITER_DIGITS
 #undef MULTIPLE_DOTS_END 
 #undef FAIL_COMMON_FLOAT_ERRORS
-#undef FAIL_BASE_UNSUPPORTED_CHR
+#undef FAIL_INVALID_NUMBER
 }
 
 static
@@ -645,10 +663,11 @@ Consume_Result consume_punctuators(Lexer_State *ls) {
 
     int i = remaing_count;
     bool found = false;
-    char punct[3] = {0};
+    // one more than the longest punctuator, for the terminating NUL
+    char punct[4] = {0};
 
     for (; i > 0; i--) {
-        memset(punct, 0, 3);
+        memset(punct, 0, sizeof(punct));
         memcpy(punct, string, i);
 
         if (check_is_punctuator(punct)) {
@@ -926,17 +945,52 @@ Lex_Delimiter _delimiter_from_char(char delim) {
     assert(false && "char is not a delimiter");
 }
 
+// Where the tree takes its tokens from. Instrumented builds lex the whole
+// input up front, so `Lex` is timed once and not around every token, the
+// others lex a token whenever the tree needs one
+typedef struct {
+#ifdef BANG_INSTRUMENT
+    Lex_Token *items;
+    size_t count;
+    size_t capacity;
+    // the next one the tree takes
+    size_t pos;
+#else
+    Lexer_State *lexer;
+#endif
+    // of the token taken last
+    Lex_Span span;
+} Lex_Tokens;
+
+static
+bool _take_token(Lex_Tokens *tokens, Lex_Token *token) {
+#ifdef BANG_INSTRUMENT
+    if (tokens->pos == tokens->count) {
+        return false;
+    }
+    *token = tokens->items[tokens->pos++];
+#else
+    if (is_eof(tokens->lexer)) {
+        return false;
+    }
+    lexer_next(tokens->lexer);
+    *token = tokens->lexer->token;
+#endif
+    tokens->span = token->span;
+    return true;
+}
+
 #define ERROR_SUCCESS (Lex_Error)-1
-Lex_TokenStream _recursively_get_stream(Lexer_State *lexer, Lex_Delimiter delimiter, Lex_StreamError *error) {
+Lex_TokenStream _recursively_get_stream(Lex_Tokens *tokens, Lex_Delimiter delimiter, Lex_StreamError *error) {
     Lex_TokenStream stream = {0};
 
     while (true) {
-        if (is_eof(lexer)) {
+        Lex_Token token;
+        if (!_take_token(tokens, &token)) {
             goto end;
         }
-        lexer_next(lexer);
-        Lex_Token token = lexer->token;
         Lex_TokenTree tree = {0};
+        METRICS_COUNT_TOKEN(token.kind);
 
         switch ((int)token.kind) {
             case '(': 
@@ -945,12 +999,13 @@ Lex_TokenStream _recursively_get_stream(Lexer_State *lexer, Lex_Delimiter delimi
             {
                 Lex_StreamError inner_error = { .type = ERROR_SUCCESS, .span = token.span };
                 Lex_Delimiter delim = _delimiter_from_char((char)token.kind);
-                Lex_TokenStream recursed = _recursively_get_stream(lexer, delim, &inner_error);
+                Lex_TokenStream recursed = _recursively_get_stream(tokens, delim, &inner_error);
                 if (inner_error.type != ERROR_SUCCESS) {
                     *error = inner_error;
                     goto error;
                 }
 
+                METRICS_COUNT_DELIMITED();
                 tree = (Lex_TokenTree) {
                     .type = Tt_Delimited,
                     .Tt_Delimited = (Lex_Delimited) {
@@ -958,7 +1013,7 @@ Lex_TokenStream _recursively_get_stream(Lexer_State *lexer, Lex_Delimiter delimi
                         .stream = recursed,
                         .span = {
                             .open = token.span,
-                            .close = lexer->token.span
+                            .close = tokens->span
                         }
                     }
                 };
@@ -1023,8 +1078,31 @@ error:
 Lex_TokenizeResult lexer_tokenize_source(String_View filename, String_View content, bool *success) {
     Lexer_State lexer = lexer_init(filename, content);
 
+#ifdef BANG_INSTRUMENT
+    // timed once for the whole input, a timer around every token would cost
+    // more than lexing it
+    Lex_Tokens tokens = {0};
+    METRICS_TIME_BEGIN(Lex);
+    while (!is_eof(&lexer)) {
+        lexer_next(&lexer);
+        da_append(&tokens, lexer.token);
+    }
+    METRICS_TIME_END(Lex);
+#else
+    Lex_Tokens tokens = { .lexer = &lexer };
+#endif
+
     Lex_StreamError error = { .type = ERROR_SUCCESS, .span = {{0}} };
-    Lex_TokenStream stream =  _recursively_get_stream(&lexer, /* delimiter */ 0, &error);
+    Lex_TokenStream stream =  _recursively_get_stream(&tokens, /* delimiter */ 0, &error);
+
+#ifdef BANG_INSTRUMENT
+    // the tree stops at the first error, the tokens after it are not owned
+    // by anything
+    for (size_t i = tokens.pos; i < tokens.count; i++) {
+        lexer_token_free(tokens.items[i]);
+    }
+    free(tokens.items);
+#endif
 
     if (error.type != ERROR_SUCCESS) {
         *success = false;
@@ -1046,14 +1124,22 @@ void lexer_token_free(Lex_Token token) {
             String_Builder string = token.kind == Tk_Note ? token.Tk_Note.note : token.Tk_String.string;
             free(string.items);
         } break;
-        case Tk_Ident:
-        {
-            free(token.Tk_Ident.name.items);
-        } break;
+        case Tk_BlockComment:
+            free(token.Tk_BlockComment.body.items);
+            break;
+        // identifier names are interned
         default: break;
     }
 }
 
+void lexer_free_interned(void) {
+    intern_free(&lexer_interner);
+}
+
+size_t lexer_interned_count(void) {
+    return lexer_interner.count;
+}
+
 void lexer_token_stream_free(Lex_TokenStream *stream) {
     for (size_t i = 0; i < stream->count; i++) {
         Lex_TokenTree tree = stream->items[i];
@@ -1071,59 +1157,49 @@ void lexer_token_stream_free(Lex_TokenStream *stream) {
     stream->capacity = 0;
 }
 
-void lexer_print_pos(String_Builder *sb, Lex_Pos pos) {
-    char buffer[32];
-    memset(buffer, 0, sizeof(buffer));
-    sprintf(buffer, "%zu", pos.row);
-    sb_append_cstr(sb, buffer);
-
-    da_append(sb, ':');
-
-    memset(buffer, 0, sizeof(buffer));
-    sprintf(buffer, "%zu", pos.col);
-    sb_append_cstr(sb, buffer);
+void lexer_print_pos(Writer *w, Lex_Pos pos) {
+    writer_u64(w, pos.row);
+    writer_char(w, ':');
+    writer_u64(w, pos.col);
 }
 
-void lexer_print_span(String_Builder *sb, Lex_Span span) {
-    da_append(sb, '[');
-    lexer_print_pos(sb, span.start);
-    sb_append_cstr(sb, "..");
-    lexer_print_pos(sb, span.end);
-    da_append(sb, ']');
+void lexer_print_span(Writer *w, Lex_Span span) {
+    writer_char(w, '[');
+    lexer_print_pos(w, span.start);
+    writer_cstr(w, "..");
+    lexer_print_pos(w, span.end);
+    writer_char(w, ']');
 }
 
 static
-void _sprintf_number(union _64_bit_number number, Lex_NumberClass class, String_Builder *sb) {
-    char buffer[100];
-    memset(buffer, 0, sizeof(buffer));
+void _print_number(Writer *w, union _64_bit_number number, Lex_NumberClass class) {
     if (IS_FLOAT_CLASS(class)) {
-        sprintf(buffer, "%f", number.floating);
+        writer_f64(w, number.floating);
     } else {
-        sprintf(buffer, "%zu", number.integer);
+        writer_u64(w, number.integer);
     }
-    sb_append_cstr(sb, buffer);
 }
 
-void lexer_print_delimited(String_Builder *sb, Lex_Delimited *token) {
-    sb_append_cstr(sb, "Delimited { ");
-    sb_append_cstr(sb, "type = ");
+void lexer_print_delimited(Writer *w, Lex_Delimited *token) {
+    writer_cstr(w, "Delimited { ");
+    writer_cstr(w, "type = ");
     switch (token->delimiter) {
         case Dl_Paren: 
-            sb_append_cstr(sb, "Paren, ");
+            writer_cstr(w, "Paren, ");
             break;
         case Dl_Brace: 
-            sb_append_cstr(sb, "Brace, ");
+            writer_cstr(w, "Brace, ");
             break;
         case Dl_Bracket: 
-            sb_append_cstr(sb, "Bracket, ");
+            writer_cstr(w, "Bracket, ");
             break;
     }
 
-    sb_append_cstr(sb, "open = ");
-    lexer_print_span(sb, token->span.open);
-    sb_append_cstr(sb, ", close = ");
-    lexer_print_span(sb, token->span.close);
-    sb_append_cstr(sb, " }");
+    writer_cstr(w, "open = ");
+    lexer_print_span(w, token->span.open);
+    writer_cstr(w, ", close = ");
+    lexer_print_span(w, token->span.close);
+    writer_cstr(w, " }");
 }
 
 static inline
@@ -1151,93 +1227,94 @@ const char *error_to_string(Lex_Error in) {
     return lexer_error_names[in];
 }
 
-void lexer_print_token(String_Builder *sb, Lex_Token *token) { 
-    sb_append_cstr(sb, "Token { ");
-    sb_append_cstr(sb, "type = ");
-    Lex_TokenKind kind = token->kind;
-
+void lexer_print_kind(Writer *w, Lex_TokenKind kind) {
     if (kind == Tk_INIT) {
-        sb_append_cstr(sb, "Init");
+        writer_cstr(w, "Init");
     } else if (kind < 0x80) {
-        da_append(sb, (char)kind);
+        writer_char(w, (char)kind);
     } else if (kind <= 0xff) {
-        sb_append_cstr(sb, tokenkind_to_string(kind));
+        writer_cstr(w, tokenkind_to_string(kind));
     } else if (kind <= 0xffff) {
-        da_append_many(sb, (char*)&kind, 2);
+        writer_write(w, (char*)&kind, 2);
     } else if (kind <= 0xffffff) {
-        da_append_many(sb, (char*)&kind, 3);
+        writer_write(w, (char*)&kind, 3);
     } else if (kind <= 0x7fffffff) {
-        da_append_many(sb, (char*)&kind, 4);
+        writer_write(w, (char*)&kind, 4);
     }
+}
+
+void lexer_print_token(Writer *w, Lex_Token *token) { 
+    writer_cstr(w, "Token { ");
+    writer_cstr(w, "type = ");
+    Lex_TokenKind kind = token->kind;
+    lexer_print_kind(w, kind);
 
-    sb_append_cstr(sb, ", span = ");
-    lexer_print_span(sb, token->span);
+    writer_cstr(w, ", span = ");
+    lexer_print_span(w, token->span);
 
     switch (kind) {
         case Tk_Number: 
         {
             Lex_TokenNumber num = token->Tk_Number;
-            sb_append_cstr(sb, ", class = ");
-            sb_append_cstr(sb, number_class_to_string(num.nclass));
-            sb_append_cstr(sb, ", number = ");
-            _sprintf_number(num.number, num.nclass, sb);
+            writer_cstr(w, ", class = ");
+            writer_cstr(w, number_class_to_string(num.nclass));
+            writer_cstr(w, ", number = ");
+            _print_number(w, num.number, num.nclass);
         } 
         break;
         case Tk_Directive:
         {
             Lex_TokenDirective dir = token->Tk_Directive;
-            sb_append_cstr(sb, ", directive = ");
-            sb_append_cstr(sb, directive_to_string(dir.directive));
+            writer_cstr(w, ", directive = ");
+            writer_cstr(w, directive_to_string(dir.directive));
         }
         break;
         case Tk_Keyword:
         {
             Lex_TokenKeyword key = token->Tk_Keyword;
-            sb_append_cstr(sb, ", keyword = ");
-            sb_append_cstr(sb, keyword_to_string(key.keyword));
+            writer_cstr(w, ", keyword = ");
+            writer_cstr(w, keyword_to_string(key.keyword));
         }
         break;
         case Tk_Ident:
         {
             Lex_TokenIdent ident = token->Tk_Ident;
-            sb_append_cstr(sb, ", ident = ");
-            da_append_many(sb, ident.name.items, ident.name.count);
+            writer_cstr(w, ", ident = ");
+            writer_write(w, ident.name.items, ident.name.count);
         }
         break;
         case Tk_Char:
         {
             Lex_TokenChar tchar = token->Tk_Char;
-            char buffer[4];
-            sprintf(buffer, "0x%x", tchar.wchar);
-            sb_append_cstr(sb, ", char = ");
-            sb_append_cstr(sb, buffer);
+            writer_cstr(w, ", char = 0x");
+            writer_hex(w, tchar.wchar);
         }
         break;
         case Tk_String:
         case Tk_Note:
         {
             String_Builder string = kind == Tk_Note ? token->Tk_Note.note : token->Tk_String.string;
-            sb_append_cstr(sb, ", ");
-            sb_append_cstr(sb, kind == Tk_Note ? "note" : "string");
-            sb_append_cstr(sb, " = ");
-            da_append_many(sb, string.items, string.count);
+            writer_cstr(w, ", ");
+            writer_cstr(w, kind == Tk_Note ? "note" : "string");
+            writer_cstr(w, " = ");
+            writer_write(w, string.items, string.count);
         }
         break;
         case Tk_Error: 
         {
             Lex_TokenError err = token->Tk_Error;
-            sb_append_cstr(sb, ", error = ");
-            sb_append_cstr(sb, error_to_string(err.error));
+            writer_cstr(w, ", error = ");
+            writer_cstr(w, error_to_string(err.error));
         } 
         break;
         default: break;
     }
 
-    sb_append_cstr(sb, " }");
+    writer_cstr(w, " }");
 
 }
 
-void lexer_print_error(String_Builder *sb, Lex_Error *error) {
-    sb_append_cstr(sb, error_to_string(*error));
+void lexer_print_error(Writer *w, Lex_Error *error) {
+    writer_cstr(w, error_to_string(*error));
 }
 
@@ -6,6 +6,7 @@
 #include <stdbool.h>
 
 #include "strings.h"
+#include "writer.h"
 #include "lexerc.generated.h"
 #include "operators.generated.h"
 
@@ -60,6 +61,7 @@ typedef Keyword Lex_Keyword;
     _E(SientificFloatWithoutExponent)\
     _E(MultipleDotsInFloat)          \
     _E(UnsupportedDigitForBase)      \
+    _E(IntegerOutOfRange)            \
     _E(UnknownPunctuator)            \
     _E(InvalidEscape)                \
     _E(UnknownDirective)             \
@@ -86,6 +88,8 @@ ENUMERATE_LEXER_TOKENS
 
 #define IS_FLOAT_CLASS(class) \
     (class) == Nc_f32 || (class) == Nc_f64 || (class) == Nc_FloatingPointNumber
+#define IS_UNSIGNED_CLASS(class) \
+    ((class) == Nc_u8 || (class) == Nc_u16 || (class) == Nc_u32 || (class) == Nc_u64 || (class) == Nc_usize)
 
 #define IS_TOKEN_KIND(kind) \
     ((kind) == -1 || ((kind) >= 0x80 && (kind) <= 0xff))
@@ -183,11 +187,18 @@ Lex_TokenizeResult lexer_tokenize_source(String_View filename, String_View conte
 
 void lexer_token_free(Lex_Token token);
 void lexer_token_stream_free(Lex_TokenStream *stream);
-
-void lexer_print_pos(String_Builder *sb, Lex_Pos pos);
-void lexer_print_span(String_Builder *sb, Lex_Span span);
-void lexer_print_token(String_Builder *sb, Lex_Token *token);
-void lexer_print_error(String_Builder *sb, Lex_Error *error);
-void lexer_print_delimited(String_Builder *sb, Lex_Delimited *token);
+// Identifier names are interned per thread and outlive their token stream,
+// they are only released by this, all at once for the calling thread
+void lexer_free_interned(void);
+// Distinct names interned on the calling thread since the last release
+size_t lexer_interned_count(void);
+
+void lexer_print_pos(Writer *w, Lex_Pos pos);
+void lexer_print_span(Writer *w, Lex_Span span);
+// A punctuator as written, the other kinds by name
+void lexer_print_kind(Writer *w, Lex_TokenKind kind);
+void lexer_print_token(Writer *w, Lex_Token *token);
+void lexer_print_error(Writer *w, Lex_Error *error);
+void lexer_print_delimited(Writer *w, Lex_Delimited *token);
 
 #endif // LEXER_H_
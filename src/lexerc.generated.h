@@ -7,10 +7,9 @@
 #define  LEXERC_H_PREFIX
 #endif //LEXERC_H_PREFIX
 #include <stdint.h>
+#include "hash.h"
 #include <string.h>
 
-uint64_t thirdparty_siphash24(const void *src, unsigned long src_sz, const char key[16]);
-
 #define NUM_ENTRIES_KEYWORD 16
 
 typedef enum {
@@ -71,30 +70,30 @@ Keyword keyword_resolve(const char * in);
 LEXERC_H_PREFIX
 Keyword keyword_resolve(const char * in) {
     static const struct _k_struct_tuple { const char * _0; Keyword _1; } _k_entries[NUM_ENTRIES_KEYWORD] = {
+        { "for", K_For },
+        { "nil", K_Nil },
+        { "true", K_True },
+        { "let", K_Let },
+        { "break", K_Break },
+        { "fn", K_Fn },
         { "continue", K_Continue },
-        { "while", K_While },
         { "const", K_Const },
-        { "if", K_If },
+        { "loop", K_Loop },
         { "struct", K_Struct },
-        { "true", K_True },
+        { "enum", K_Enum },
         { "false", K_False },
-        { "loop", K_Loop },
         { "variant", K_Variant },
-        { "enum", K_Enum },
-        { "for", K_For },
-        { "fn", K_Fn },
-        { "nil", K_Nil },
+        { "while", K_While },
+        { "if", K_If },
         { "else", K_Else },
-        { "break", K_Break },
-        { "let", K_Let },
     };
     
 #define NUM_K_DISPS 4
     static const uint32_t _k_disps[NUM_K_DISPS][2] = 
-        { { 4, 0 }, { 0, 0 }, { 10, 6 }, { 0, 6 },  };
-    static const char* _k_hashkey = "\x00\x00\x00\x00\x00\x00\x00\x00P\xdb\xb1\xeb\x9a\xa1K\x95";
+        { { 0, 1 }, { 2, 2 }, { 2, 14 }, { 0, 0 },  };
+    static const uint64_t _k_hashkey = 0x38242ec9718a9a01ull;
 
-    uint64_t hash = thirdparty_siphash24(in, strlen(in), _k_hashkey);
+    uint64_t hash = hash_bytes(in, strlen(in), _k_hashkey);
     const uint32_t lower = hash & 0xffffffff;
     const uint32_t upper = (hash >> 32) & 0xffffffff;
 
@@ -115,6 +114,169 @@ Keyword keyword_resolve(const char * in) {
 }
 #endif //LEXERC_H_IMPLEMENTATION
 
+#ifdef   LEXERC_H_LOOKUP_STRATEGIES
+static inline Keyword keyword_resolve_switch(const char * in) {
+    switch (in[0]) {
+    case 'b':
+        if (strcmp(in, "break") == 0) return K_Break;
+        break;
+    case 'c':
+        if (strcmp(in, "continue") == 0) return K_Continue;
+        if (strcmp(in, "const") == 0) return K_Const;
+        break;
+    case 'e':
+        if (strcmp(in, "else") == 0) return K_Else;
+        if (strcmp(in, "enum") == 0) return K_Enum;
+        break;
+    case 'f':
+        if (strcmp(in, "false") == 0) return K_False;
+        if (strcmp(in, "for") == 0) return K_For;
+        if (strcmp(in, "fn") == 0) return K_Fn;
+        break;
+    case 'i':
+        if (strcmp(in, "if") == 0) return K_If;
+        break;
+    case 'l':
+        if (strcmp(in, "loop") == 0) return K_Loop;
+        if (strcmp(in, "let") == 0) return K_Let;
+        break;
+    case 'n':
+        if (strcmp(in, "nil") == 0) return K_Nil;
+        break;
+    case 's':
+        if (strcmp(in, "struct") == 0) return K_Struct;
+        break;
+    case 't':
+        if (strcmp(in, "true") == 0) return K_True;
+        break;
+    case 'v':
+        if (strcmp(in, "variant") == 0) return K_Variant;
+        break;
+    case 'w':
+        if (strcmp(in, "while") == 0) return K_While;
+        break;
+    }
+    return K_Invalid;
+}
+
+static inline Keyword keyword_resolve_length(const char * in) {
+    static const struct _keyword_resolve_entry { const char * _0; Keyword _1; } entries[16] = {
+        { "if", K_If },
+        { "fn", K_Fn },
+        { "nil", K_Nil },
+        { "for", K_For },
+        { "let", K_Let },
+        { "true", K_True },
+        { "else", K_Else },
+        { "loop", K_Loop },
+        { "enum", K_Enum },
+        { "false", K_False },
+        { "while", K_While },
+        { "break", K_Break },
+        { "const", K_Const },
+        { "struct", K_Struct },
+        { "variant", K_Variant },
+        { "continue", K_Continue },
+    };
+    static const struct { uint8_t start; uint8_t count; } lengths[8 + 1] = {
+        [2] = { 0, 2 }, [3] = { 2, 3 }, [4] = { 5, 4 }, [5] = { 9, 4 }, [6] = { 13, 1 }, [7] = { 14, 1 }, [8] = { 15, 1 }, 
+    };
+
+    const size_t length = strlen(in);
+    if (length > 8) {
+        return K_Invalid;
+    }
+    for (size_t i = lengths[length].start; i < lengths[length].start + lengths[length].count; i++) {
+        if (memcmp(entries[i]._0, in, length) == 0) {
+            return entries[i]._1;
+        }
+    }
+    return K_Invalid;
+}
+
+static inline Keyword keyword_resolve_direct(const char * in) {
+    static const struct _keyword_resolve_entry { const char * _0; Keyword _1; } entries[16] = {
+        { "break", K_Break },
+        { "continue", K_Continue },
+        { "const", K_Const },
+        { "else", K_Else },
+        { "enum", K_Enum },
+        { "false", K_False },
+        { "for", K_For },
+        { "fn", K_Fn },
+        { "if", K_If },
+        { "loop", K_Loop },
+        { "let", K_Let },
+        { "nil", K_Nil },
+        { "struct", K_Struct },
+        { "true", K_True },
+        { "variant", K_Variant },
+        { "while", K_While },
+    };
+    static const struct { uint8_t start; uint8_t count; } firsts[256] = {
+        ['b'] = { 0, 1 }, ['c'] = { 1, 2 }, ['e'] = { 3, 2 }, ['f'] = { 5, 3 }, ['i'] = { 8, 1 }, ['l'] = { 9, 2 }, ['n'] = { 11, 1 }, ['s'] = { 12, 1 }, ['t'] = { 13, 1 }, ['v'] = { 14, 1 }, ['w'] = { 15, 1 }, 
+    };
+
+    const unsigned char first = in[0];
+    for (size_t i = firsts[first].start; i < firsts[first].start + firsts[first].count; i++) {
+        if (strcmp(entries[i]._0, in) == 0) {
+            return entries[i]._1;
+        }
+    }
+    return K_Invalid;
+}
+
+static inline Keyword keyword_resolve_mulshift(const char * in) {
+    // empty slots hold a key no lookup hits, mapped to the invalid value
+    static const struct _keyword_resolve_entry { const char * _0; Keyword _1; } table[32] = {
+        { "", K_Invalid },
+        { "", K_Invalid },
+        { "", K_Invalid },
+        { "", K_Invalid },
+        { "enum", K_Enum },
+        { "loop", K_Loop },
+        { "else", K_Else },
+        { "break", K_Break },
+        { "", K_Invalid },
+        { "while", K_While },
+        { "true", K_True },
+        { "continue", K_Continue },
+        { "", K_Invalid },
+        { "if", K_If },
+        { "let", K_Let },
+        { "", K_Invalid },
+        { "", K_Invalid },
+        { "", K_Invalid },
+        { "", K_Invalid },
+        { "variant", K_Variant },
+        { "const", K_Const },
+        { "for", K_For },
+        { "", K_Invalid },
+        { "struct", K_Struct },
+        { "false", K_False },
+        { "fn", K_Fn },
+        { "", K_Invalid },
+        { "nil", K_Nil },
+        { "", K_Invalid },
+        { "", K_Invalid },
+        { "", K_Invalid },
+        { "", K_Invalid },
+    };
+
+    // the first four bytes and the length, see lookup_generator.Entry.fold
+    const size_t length = strlen(in);
+    uint32_t x = 0;
+    memcpy(&x, in, length < 4 ? length : 4);
+    x ^= (uint32_t)length << 24;
+    const struct _keyword_resolve_entry entry = table[(uint32_t)(x * 3325435977u) >> 27];
+
+    if (strcmp(entry._0, in) != 0) {
+        return K_Invalid;
+    }
+    return entry._1;
+}
+#endif //LEXERC_H_LOOKUP_STRATEGIES
+
 #define NUM_ENTRIES_DIRECTIVE 4
 
 typedef enum {
@@ -151,18 +313,18 @@ Directive directive_resolve(const char * in);
 LEXERC_H_PREFIX
 Directive directive_resolve(const char * in) {
     static const struct _d_struct_tuple { const char * _0; Directive _1; } _d_entries[NUM_ENTRIES_DIRECTIVE] = {
-        { "entrypoint", D_Entrypoint },
+        { "open", D_Open },
         { "if", D_If },
+        { "entrypoint", D_Entrypoint },
         { "include", D_Include },
-        { "open", D_Open },
     };
     
 #define NUM_D_DISPS 1
     static const uint32_t _d_disps[NUM_D_DISPS][2] = 
         { { 3, 0 },  };
-    static const char* _d_hashkey = "\x00\x00\x00\x00\x00\x00\x00\x00\xa1#AA4\xfc\x13\xe2";
+    static const uint64_t _d_hashkey = 0x995e789ece8ffa74ull;
 
-    uint64_t hash = thirdparty_siphash24(in, strlen(in), _d_hashkey);
+    uint64_t hash = hash_bytes(in, strlen(in), _d_hashkey);
     const uint32_t lower = hash & 0xffffffff;
     const uint32_t upper = (hash >> 32) & 0xffffffff;
 
@@ -183,6 +345,89 @@ Directive directive_resolve(const char * in) {
 }
 #endif //LEXERC_H_IMPLEMENTATION
 
+#ifdef   LEXERC_H_LOOKUP_STRATEGIES
+static inline Directive directive_resolve_switch(const char * in) {
+    switch (in[0]) {
+    case 'e':
+        if (strcmp(in, "entrypoint") == 0) return D_Entrypoint;
+        break;
+    case 'i':
+        if (strcmp(in, "if") == 0) return D_If;
+        if (strcmp(in, "include") == 0) return D_Include;
+        break;
+    case 'o':
+        if (strcmp(in, "open") == 0) return D_Open;
+        break;
+    }
+    return D_Invalid;
+}
+
+static inline Directive directive_resolve_length(const char * in) {
+    static const struct _directive_resolve_entry { const char * _0; Directive _1; } entries[4] = {
+        { "if", D_If },
+        { "open", D_Open },
+        { "include", D_Include },
+        { "entrypoint", D_Entrypoint },
+    };
+    static const struct { uint8_t start; uint8_t count; } lengths[10 + 1] = {
+        [2] = { 0, 1 }, [4] = { 1, 1 }, [7] = { 2, 1 }, [10] = { 3, 1 }, 
+    };
+
+    const size_t length = strlen(in);
+    if (length > 10) {
+        return D_Invalid;
+    }
+    for (size_t i = lengths[length].start; i < lengths[length].start + lengths[length].count; i++) {
+        if (memcmp(entries[i]._0, in, length) == 0) {
+            return entries[i]._1;
+        }
+    }
+    return D_Invalid;
+}
+
+static inline Directive directive_resolve_direct(const char * in) {
+    static const struct _directive_resolve_entry { const char * _0; Directive _1; } entries[4] = {
+        { "entrypoint", D_Entrypoint },
+        { "if", D_If },
+        { "include", D_Include },
+        { "open", D_Open },
+    };
+    static const struct { uint8_t start; uint8_t count; } firsts[256] = {
+        ['e'] = { 0, 1 }, ['i'] = { 1, 2 }, ['o'] = { 3, 1 }, 
+    };
+
+    const unsigned char first = in[0];
+    for (size_t i = firsts[first].start; i < firsts[first].start + firsts[first].count; i++) {
+        if (strcmp(entries[i]._0, in) == 0) {
+            return entries[i]._1;
+        }
+    }
+    return D_Invalid;
+}
+
+static inline Directive directive_resolve_mulshift(const char * in) {
+    // empty slots hold a key no lookup hits, mapped to the invalid value
+    static const struct _directive_resolve_entry { const char * _0; Directive _1; } table[4] = {
+        { "include", D_Include },
+        { "entrypoint", D_Entrypoint },
+        { "if", D_If },
+        { "open", D_Open },
+    };
+
+    // the first four bytes and the length, see lookup_generator.Entry.fold
+    const size_t length = strlen(in);
+    uint32_t x = 0;
+    memcpy(&x, in, length < 4 ? length : 4);
+    x ^= (uint32_t)length << 24;
+    const struct _directive_resolve_entry entry = table[(uint32_t)(x * 2504761755u) >> 30];
+
+    if (strcmp(entry._0, in) != 0) {
+        return D_Invalid;
+    }
+    return entry._1;
+}
+#endif //LEXERC_H_LOOKUP_STRATEGIES
+
 #define NUM_ENTRIES_NUMBER_CLASS 14
 
 typedef enum {
@@ -239,28 +484,28 @@ NumberClass number_class_resolve(const char * in);
 LEXERC_H_PREFIX
 NumberClass number_class_resolve(const char * in) {
     static const struct _nc_struct_tuple { const char * _0; NumberClass _1; } _nc_entries[NUM_ENTRIES_NUMBER_CLASS] = {
-        { "u8", Nc_u8 },
-        { "i64", Nc_i64 },
-        { "i16", Nc_i16 },
-        { "number", Nc_Number },
-        { "f32", Nc_f32 },
-        { "i32", Nc_i32 },
         { "u32", Nc_u32 },
-        { "u64", Nc_u64 },
-        { "isize", Nc_isize },
-        { "floatingpointnumber", Nc_FloatingPointNumber },
         { "f64", Nc_f64 },
-        { "u16", Nc_u16 },
+        { "u64", Nc_u64 },
         { "i8", Nc_i8 },
+        { "floatingpointnumber", Nc_FloatingPointNumber },
+        { "u8", Nc_u8 },
+        { "f32", Nc_f32 },
+        { "i16", Nc_i16 },
+        { "isize", Nc_isize },
         { "usize", Nc_usize },
+        { "i32", Nc_i32 },
+        { "i64", Nc_i64 },
+        { "u16", Nc_u16 },
+        { "number", Nc_Number },
     };
     
 #define NUM_NC_DISPS 3
     static const uint32_t _nc_disps[NUM_NC_DISPS][2] = 
-        { { 10, 0 }, { 6, 12 }, { 0, 12 },  };
-    static const char* _nc_hashkey = "\x00\x00\x00\x00\x00\x00\x00\x00t\xfe\x86\xe4Q\xec\x10\xc1";
+        { { 13, 12 }, { 1, 0 }, { 0, 10 },  };
+    static const uint64_t _nc_hashkey = 0xc110ec51e486fe74ull;
 
-    uint64_t hash = thirdparty_siphash24(in, strlen(in), _nc_hashkey);
+    uint64_t hash = hash_bytes(in, strlen(in), _nc_hashkey);
     const uint32_t lower = hash & 0xffffffff;
     const uint32_t upper = (hash >> 32) & 0xffffffff;
 
@@ -281,4 +526,131 @@ NumberClass number_class_resolve(const char * in) {
 }
 #endif //LEXERC_H_IMPLEMENTATION
 
+#ifdef   LEXERC_H_LOOKUP_STRATEGIES
+static inline NumberClass number_class_resolve_switch(const char * in) {
+    switch (in[0]) {
+    case 'f':
+        if (strcmp(in, "f32") == 0) return Nc_f32;
+        if (strcmp(in, "f64") == 0) return Nc_f64;
+        if (strcmp(in, "floatingpointnumber") == 0) return Nc_FloatingPointNumber;
+        break;
+    case 'i':
+        if (strcmp(in, "i8") == 0) return Nc_i8;
+        if (strcmp(in, "i16") == 0) return Nc_i16;
+        if (strcmp(in, "i32") == 0) return Nc_i32;
+        if (strcmp(in, "i64") == 0) return Nc_i64;
+        if (strcmp(in, "isize") == 0) return Nc_isize;
+        break;
+    case 'n':
+        if (strcmp(in, "number") == 0) return Nc_Number;
+        break;
+    case 'u':
+        if (strcmp(in, "u8") == 0) return Nc_u8;
+        if (strcmp(in, "u16") == 0) return Nc_u16;
+        if (strcmp(in, "u32") == 0) return Nc_u32;
+        if (strcmp(in, "u64") == 0) return Nc_u64;
+        if (strcmp(in, "usize") == 0) return Nc_usize;
+        break;
+    }
+    return Nc_Invalid;
+}
+
+static inline NumberClass number_class_resolve_length(const char * in) {
+    static const struct _number_class_resolve_entry { const char * _0; NumberClass _1; } entries[14] = {
+        { "i8", Nc_i8 },
+        { "u8", Nc_u8 },
+        { "i16", Nc_i16 },
+        { "u16", Nc_u16 },
+        { "i32", Nc_i32 },
+        { "u32", Nc_u32 },
+        { "i64", Nc_i64 },
+        { "u64", Nc_u64 },
+        { "f32", Nc_f32 },
+        { "f64", Nc_f64 },
+        { "isize", Nc_isize },
+        { "usize", Nc_usize },
+        { "number", Nc_Number },
+        { "floatingpointnumber", Nc_FloatingPointNumber },
+    };
+    static const struct { uint8_t start; uint8_t count; } lengths[19 + 1] = {
+        [2] = { 0, 2 }, [3] = { 2, 8 }, [5] = { 10, 2 }, [6] = { 12, 1 }, [19] = { 13, 1 }, 
+    };
+
+    const size_t length = strlen(in);
+    if (length > 19) {
+        return Nc_Invalid;
+    }
+    for (size_t i = lengths[length].start; i < lengths[length].start + lengths[length].count; i++) {
+        if (memcmp(entries[i]._0, in, length) == 0) {
+            return entries[i]._1;
+        }
+    }
+    return Nc_Invalid;
+}
+
+static inline NumberClass number_class_resolve_direct(const char * in) {
+    static const struct _number_class_resolve_entry { const char * _0; NumberClass _1; } entries[14] = {
+        { "f32", Nc_f32 },
+        { "f64", Nc_f64 },
+        { "floatingpointnumber", Nc_FloatingPointNumber },
+        { "i8", Nc_i8 },
+        { "i16", Nc_i16 },
+        { "i32", Nc_i32 },
+        { "i64", Nc_i64 },
+        { "isize", Nc_isize },
+        { "number", Nc_Number },
+        { "u8", Nc_u8 },
+        { "u16", Nc_u16 },
+        { "u32", Nc_u32 },
+        { "u64", Nc_u64 },
+        { "usize", Nc_usize },
+    };
+    static const struct { uint8_t start; uint8_t count; } firsts[256] = {
+        ['f'] = { 0, 3 }, ['i'] = { 3, 5 }, ['n'] = { 8, 1 }, ['u'] = { 9, 5 }, 
+    };
+
+    const unsigned char first = in[0];
+    for (size_t i = firsts[first].start; i < firsts[first].start + firsts[first].count; i++) {
+        if (strcmp(entries[i]._0, in) == 0) {
+            return entries[i]._1;
+        }
+    }
+    return Nc_Invalid;
+}
+
+static inline NumberClass number_class_resolve_mulshift(const char * in) {
+    // empty slots hold a key no lookup hits, mapped to the invalid value
+    static const struct _number_class_resolve_entry { const char * _0; NumberClass _1; } table[16] = {
+        { "f64", Nc_f64 },
+        { "i32", Nc_i32 },
+        { "", Nc_Invalid },
+        { "u8", Nc_u8 },
+        { "number", Nc_Number },
+        { "usize", Nc_usize },
+        { "i64", Nc_i64 },
+        { "i16", Nc_i16 },
+        { "floatingpointnumber", Nc_FloatingPointNumber },
+        { "u32", Nc_u32 },
+        { "i8", Nc_i8 },
+        { "f32", Nc_f32 },
+        { "", Nc_Invalid },
+        { "isize", Nc_isize },
+        { "u64", Nc_u64 },
+        { "u16", Nc_u16 },
+    };
+
+    // the first four bytes and the length, see lookup_generator.Entry.fold
+    const size_t length = strlen(in);
+    uint32_t x = 0;
+    memcpy(&x, in, length < 4 ? length : 4);
+    x ^= (uint32_t)length << 24;
+    const struct _number_class_resolve_entry entry = table[(uint32_t)(x * 1978157889u) >> 28];
+
+    if (strcmp(entry._0, in) != 0) {
+        return Nc_Invalid;
+    }
+    return entry._1;
+}
+#endif //LEXERC_H_LOOKUP_STRATEGIES
+
 #endif //LEXERC_H_
\ No newline at end of file
@@ -2,142 +2,603 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <unistd.h>
 
+#include "driver.h"
+#include "dynarray.h"
 #include "lexer.h"
+#include "metrics.h"
+#include "modules.h"
 #include "strings.h"
 #include "parser.h"
+#include "checker.h"
+#include "fold.h"
+#include "resolver.h"
+#include "server.h"
+#include "ssa.h"
+#include "trace.h"
+#include "vm.h"
+#include "workers.h"
+#include "writer.h"
 
-void print_token_tree(String_Builder *sb, Lex_TokenTree tree) {
+void print_token_tree(Writer *w, Lex_TokenTree tree) {
     switch (tree.type) {
         case Tt_Token:
-            lexer_print_token(sb, &tree.Tt_Token);
+            lexer_print_token(w, &tree.Tt_Token);
             break;
         case Tt_Delimited:
-            lexer_print_delimited(sb, &tree.Tt_Delimited);
+            lexer_print_delimited(w, &tree.Tt_Delimited);
             break;
     }
-    printf(SV_FMT "\n", SV_ARG(sb_to_string_view(sb)));
+    writer_char(w, '\n');
 }
 
-void print_token_stream(Lex_TokenStream stream, int level) {
-    String_Builder sb = {0};
+void print_token_stream(Writer *w, Lex_TokenStream stream, int level) {
     for (size_t i = 0; i < stream.count; i++) {
         Lex_TokenTree tree = stream.items[i];
 
-        sb.count = 0;
         for (int j = 0; j < level; j++) {
-            sb_append_cstr(&sb, "    ");
+            writer_cstr(w, "    ");
         }
-        print_token_tree(&sb, tree);
+        print_token_tree(w, tree);
 
         if (tree.type == Tt_Delimited) {
-            print_token_stream(tree.Tt_Delimited.stream, level+1);
+            print_token_stream(w, tree.Tt_Delimited.stream, level+1);
         }
     }
-
-    free(sb.items);
 }
 
-#define return_defer(value) \
-    do { result = (value); goto defer; } while (0)
+// phases are both timed for --time-report and traced for --trace
+#define PHASE_BEGIN(phase) \
+    METRICS_TIME_BEGIN(phase); TRACE_BEGIN("phase", #phase)
+#define PHASE_END(phase) \
+    METRICS_TIME_END(phase); TRACE_END("phase", #phase)
 
-bool read_entire_file(const char *filename, String_Builder *sb) {
-    bool result = true;
-    FILE *file = fopen(filename, "r");
-    if (file == NULL) {
-        return_defer(false);
+const char *shift_args(char ***argv, int *argc) {
+    if (*argc <= 0) {
+        assert(false && "argv is empty");
     }
+    const char *result = (*argv)[0];
+    (*argv)++;
+    (*argc)--;
+    return result;
+}
 
-    if (fseek(file, 0L, SEEK_END) != 0) {
-        return_defer(false);
-    }
-    long fsize = ftell(file);
-    if (fsize == -1) {
-        return_defer(false);
-    }
+typedef struct {
+    const char **items;
+    size_t count;
+    size_t capacity;
+} Filenames;
 
-    if (sb->capacity - sb->count < (size_t)fsize) {
-        sb->items = realloc(sb->items, sb->count + fsize);
-        sb->capacity = sb->count + fsize;
-    }
+// Memory a worker keeps between files, so later files neither malloc nor
+// page fault for it
+typedef struct {
+    Ast_Pool pool;
+    String_Builder content;
+    Folder folder;
+    Resolver resolver;
+    Checker checker;
+    Vm_Compiler compiler;
+    Vm_Chunk chunk;
+    Vm vm;
+    Ssa_Lowerer lowerer;
+    Ssa_Function function;
+    Ssa_Optimizer optimizer;
+    Ssa_Values values;
+    Writer out;
+    Writer err;
+} Worker;
 
-    if (fseek(file, 0L, SEEK_SET) != 0) {
-        return_defer(false);
-    }
-    if (fread(sb->items + sb->count, 1, fsize, file) == 0 && fsize > 0) {
-        return_defer(false);
-    }
-    sb->count += fsize;
+typedef struct {
+    Emit_Kind emit;
+    // count the nodes of every file for --time-report
+    bool count_nodes;
+    // evaluate the constant expressions before emitting
+    bool fold;
+    // bind the names of the entrypoints before emitting
+    bool resolve;
+    // type the entrypoints after resolving them
+    bool check;
+    // run the entrypoints of the given files instead of emitting them
+    bool run;
+    // run them by interpreting their SSA form instead of as bytecode
+    bool run_ssa;
+    // run the passes of ssa_optimize over the SSA form
+    bool optimize;
+    // --cfg names for #if
+    Parser_Cfg cfg;
+} Options;
+
+typedef struct {
+    Options options;
+    Module_Graph *graph;
+    Worker *workers;
+    // a single root is written to stdout right away
+    bool stream;
+} Build;
 
-    // if (errno)
+void usage(const char *program) {
+    fprintf(stderr, "Usage: %s [--emit=ast|ast-json|ast-bin|ssa] [--time-report[=json]] [--trace=<file>] [--jobs=N] [--cfg=<name>]... [--fold] [--resolve] [--check] [--run[=vm|ssa]] [--optimize] <source file>... [@<response file>]...\n", program);
+    fprintf(stderr, "       %s --server=<socket>\n", program);
+    fprintf(stderr, "       %s --connect=<socket> [--emit=...] <source file>... | --stop\n", program);
+    fprintf(stderr, "    With several files, the outputs are printed in the order of the files\n");
+    fprintf(stderr, "    Files named by #include and #open are loaded once per build, only the given files are emitted\n");
+    fprintf(stderr, "    --cfg sets a name for #if conditions, names that are not set are false\n");
+    fprintf(stderr, "    --emit=ssa checks the files and prints every #entrypoint in SSA form\n");
+    fprintf(stderr, "    --run prints the locals of every #entrypoint after running it, if the file checks\n");
+    fprintf(stderr, "    --run=ssa runs the SSA form in its interpreter, --optimize optimizes it before it is printed or run\n");
+    fprintf(stderr, "    --connect falls back to compiling locally if no server is listening\n");
+}
 
-    if (fclose(file) != 0) {
-        return_defer(false);
+// Lowers an #entrypoint into `worker->function`, which --optimize optimizes.
+// The Lower phase is this alone, whether the function is run or printed
+bool lower_entrypoint(Worker *worker, Options *options, Ast_Block *block, Writer *err) {
+    PHASE_BEGIN(Lower);
+    bool success = ssa_lower(&worker->lowerer, &worker->checker, block, &worker->function, err);
+    if (success) {
+        METRICS_COUNT_LOWER(worker->function.order.count);
+    }
+    if (success && options->optimize) {
+        ssa_optimize(&worker->optimizer, &worker->function, &worker->checker.table);
+        METRICS_COUNT_OPTIMIZE(&worker->optimizer);
     }
+    PHASE_END(Lower);
+    return success;
+}
 
-defer:
-    if (!result) {
-        fprintf(stderr, "ERROR: Could not read file: %s: %s\n", filename, strerror(errno));
+// Every #entrypoint is compiled to bytecode, or lowered with --run=ssa, and
+// run on its own
+bool run_entrypoints(Worker *worker, Options *options, Ast_Source *source, Writer *out, Writer *err) {
+    bool success = true;
+    for (size_t i = 0; i < source->count; i++) {
+        Ast_Item *item = source->items[i];
+        if (item->kind != RunBlock_kind) {
+            continue;
+        }
+        writer_cstr(out, "#entrypoint at ");
+        lexer_print_span(out, item->span);
+        writer_char(out, '\n');
+        if (options->run_ssa) {
+            if (!lower_entrypoint(worker, options, item->RunBlock.block, err)) {
+                success = false;
+                continue;
+            }
+            PHASE_BEGIN(Run);
+            METRICS_COUNT_RUN(worker->function.order.count);
+            success = ssa_run(&worker->function, &worker->checker.table, &worker->values, out, err) && success;
+            PHASE_END(Run);
+            continue;
+        }
+        PHASE_BEGIN(Run);
+        if (vm_compile(&worker->compiler, &worker->checker, item->RunBlock.block, &worker->chunk, err)) {
+            METRICS_COUNT_RUN(worker->chunk.code.count);
+            success = vm_run(&worker->vm, &worker->chunk, &worker->checker.table, out, err) && success;
+        } else {
+            success = false;
+        }
+        PHASE_END(Run);
     }
-    return result;
+    return success;
 }
 
-const char *shift_args(char ***argv, int *argc) {
-    if (*argc <= 0) {
-        assert(false && "argv is empty");
+// Every #entrypoint is lowered and printed on its own
+bool emit_ssa(Worker *worker, Options *options, Ast_Source *source, Writer *out, Writer *err) {
+    bool success = true;
+    for (size_t i = 0; i < source->count; i++) {
+        Ast_Item *item = source->items[i];
+        if (item->kind != RunBlock_kind) {
+            continue;
+        }
+        writer_cstr(out, "#entrypoint at ");
+        lexer_print_span(out, item->span);
+        writer_char(out, '\n');
+        if (!lower_entrypoint(worker, options, item->RunBlock.block, err)) {
+            success = false;
+            continue;
+        }
+        PHASE_BEGIN(Emit);
+        ssa_print(out, &worker->function, &worker->checker.table);
+        PHASE_END(Emit);
     }
-    const char *result = (*argv)[0];
-    (*argv)++;
-    (*argc)--;
-    return result;
+    return success;
 }
 
-int main(int argc, char **argv) {
-    const char* program = shift_args(&argv, &argc);
-    if (argc <= 0) {
-        fprintf(stderr, "Usage: %s <source file>\n", program);
-        fprintf(stderr, "ERROR: No input files\n");
-        return 1;
+// A file that can not be tokenized or parsed is reported in place of the
+// output of a root, an included one to `err`. Both are named unless the
+// root is the only file
+static
+Writer *_begin_file_error(Module *module, Build *build, Writer *out, Writer *err) {
+    Writer *diagnostics = module->root ? out : err;
+    if (!module->root || !build->stream) {
+        writer_cstr(diagnostics, "ERROR: ");
+        writer_cstr(diagnostics, module->name);
+        writer_cstr(diagnostics, ": ");
     }
+    return diagnostics;
+}
 
-    const char* filename = shift_args(&argv, &argc);
+// Only roots are emitted, the other modules are loaded for their includes
+// and report to `err`
+bool process_file(Module *module, Build *build, Worker *worker, Writer *out, Writer *err) {
+    const char *filename = module->name;
+    Options options = build->options;
+    TRACE_BEGIN("file", filename);
 
-    String_Builder content = {0};
-    if (!read_entire_file(filename, &content)) {
-        return 1;
+    PHASE_BEGIN(Read);
+    String_Builder *content = &worker->content;
+    content->count = 0;
+    if (!read_entire_file(filename, content, err)) {
+        PHASE_END(Read);
+        TRACE_END("file", filename);
+        return false;
     }
+    PHASE_END(Read);
 
     bool success;
+    PHASE_BEGIN(Tree);
     Lex_TokenizeResult result = 
         lexer_tokenize_source(
             sv_from_cstring(filename, strlen(filename)), 
-            sb_to_string_view(&content),
+            sb_to_string_view(content),
             &success
         );
+    PHASE_END(Tree);
 
     if (!success) {
-        String_Builder sb = {0};
-        lexer_print_error(&sb, &result.error.type);
-        sb_append_cstr(&sb, " at ");
-        lexer_print_span(&sb, result.error.span);
-
-        printf(SV_FMT "\n", SV_ARG(sb_to_string_view(&sb)));
-        free(sb.items);
-        free(content.items);
-        exit(1);
+        Writer *diagnostics = _begin_file_error(module, build, out, err);
+        lexer_print_error(diagnostics, &result.error.type);
+        writer_cstr(diagnostics, " at ");
+        lexer_print_span(diagnostics, result.error.span);
+        writer_char(diagnostics, '\n');
+        TRACE_END("file", filename);
+        return false;
     }
     Lex_TokenStream stream = result.stream;
-    // print_token_stream(stream, 0);
+    // print_token_stream(out, stream, 0);
 
-    Ast_Source source = parser_parse_source(stream);
-    String_Builder sb = {0};
-    ast_print_source(&sb, &source, 0);
+    PHASE_BEGIN(Parse);
+    Ast_Source source;
+    Parser_Error error;
+    success = parser_parse_source(&worker->pool, stream, &options.cfg, &source, &error);
+    PHASE_END(Parse);
+    if (!success) {
+        Writer *diagnostics = _begin_file_error(module, build, out, err);
+        parser_print_error(diagnostics, &error);
+        writer_cstr(diagnostics, " at ");
+        lexer_print_span(diagnostics, error.span);
+        writer_char(diagnostics, '\n');
+        TRACE_END("file", filename);
+        ast_pool_reset(&worker->pool);
+        lexer_token_stream_free(&stream);
+        lexer_free_interned();
+        return false;
+    }
+    modules_discover(build->graph, worker - build->workers, module, &source);
+
+    if (options.fold) {
+        PHASE_BEGIN(Fold);
+        fold_source(&worker->folder, &worker->pool, &source);
+        METRICS_COUNT_FOLD(worker->folder.released);
+        PHASE_END(Fold);
+    }
+
+    // the tree was built, so `success` is still true here
+    if (options.resolve) {
+        PHASE_BEGIN(Resolve);
+        success = resolve_source(&worker->resolver, &source, err);
+        PHASE_END(Resolve);
+    }
+
+    // unresolved names are typed as errors and already reported
+    if (options.check) {
+        PHASE_BEGIN(Check);
+        success = check_source(&worker->checker, &worker->pool, &source, err) && success;
+        PHASE_END(Check);
+    }
+
+    // nothing is run unless the whole file checks, the entrypoints time
+    // their own phases
+    if (module->root && (options.run || options.emit == Emit_Ssa)) {
+        if (success) {
+            success = options.run
+                ? run_entrypoints(worker, &options, &source, out, err)
+                : emit_ssa(worker, &options, &source, out, err);
+        }
+        PHASE_BEGIN(Emit);
+        writer_flush(out);
+        PHASE_END(Emit);
+    } else if (module->root) {
+        PHASE_BEGIN(Emit);
+        emit_source(out, options.emit, &source);
+        writer_flush(out);
+        PHASE_END(Emit);
+    }
 
-    printf(SV_FMT"\n", SV_ARG(sb_to_string_view(&sb)));
+    if (options.count_nodes) {
+        METRICS_COUNT_SOURCE(&source);
+    }
+    TRACE_END("file", filename);
 
+    ast_pool_reset(&worker->pool);
     lexer_token_stream_free(&stream);
-    free(content.items);
+    lexer_free_interned();
+    return success;
+}
 
+void _load_module(void *data, size_t worker_id, Module *module) {
+    Build *build = data;
+    Worker *worker = &build->workers[worker_id];
+    if (build->stream && module->root) {
+        writer_init(&worker->out, STDOUT_FILENO);
+        writer_init(&worker->err, STDERR_FILENO);
+    } else {
+        writer_init_sink(&worker->out, &module->out);
+        writer_init_sink(&worker->err, &module->err);
+    }
+    module->success = process_file(module, build, worker, &worker->out, &worker->err);
+    writer_flush(&worker->out);
+    writer_flush(&worker->err);
+    // a single root writes to stdout and stderr itself
+    module->success &= !worker->out.failed && !worker->err.failed;
+    METRICS_COLLECT();
+}
+
+static
+int _compare_paths(const void *a, const void *b) {
+    return strcmp((*(Module **)a)->path, (*(Module **)b)->path);
+}
+
+// The files and everything they include are loaded into a Module_Graph,
+// every worker writes into memory and the outputs are printed in the order
+// of the files once all of them are done
+bool process_build(Filenames *filenames, Options options, size_t jobs) {
+    Module_Graph graph;
+    modules_init(&graph);
+    Modules roots = {0};
+    for (size_t i = 0; i < filenames->count; i++) {
+        da_append(&roots, modules_add_root(&graph, filenames->items[i]));
+    }
+    Build build = {
+        .options = options,
+        .graph = &graph,
+        .workers = calloc(jobs, sizeof(Worker)),
+        .stream = filenames->count == 1,
+    };
+    assert(build.workers != NULL && "Buy more RAM lol");
+
+    modules_load(&graph, jobs, _load_module, &build);
+
+    static Writer out, err;
+    writer_init(&out, STDOUT_FILENO);
+    writer_init(&err, STDERR_FILENO);
+    bool success = true;
+    for (size_t i = 0; i < roots.count; i++) {
+        Module *module = roots.items[i];
+        writer_write(&out, module->out.items, module->out.count);
+        writer_write(&err, module->err.items, module->err.count);
+        success &= module->success;
+    }
+    // the modules only reached over includes were claimed in whatever order
+    // the workers got to them
+    Modules included = {0};
+    for (size_t i = 0; i < graph.modules.count; i++) {
+        if (!graph.modules.items[i]->root) {
+            da_append(&included, graph.modules.items[i]);
+        }
+    }
+    if (included.count > 0) {
+        qsort(included.items, included.count, sizeof(Module *), _compare_paths);
+    }
+    for (size_t i = 0; i < included.count; i++) {
+        Module *module = included.items[i];
+        writer_write(&err, module->err.items, module->err.count);
+        success &= module->success;
+    }
+    success &= modules_check_cycles(&graph, &err);
+    writer_flush(&out);
+    writer_flush(&err);
+    success &= !out.failed && !err.failed;
+
+    for (size_t i = 0; i < jobs; i++) {
+        ast_pool_free(&build.workers[i].pool);
+        free(build.workers[i].content.items);
+        folder_free(&build.workers[i].folder);
+        resolver_free(&build.workers[i].resolver);
+        checker_free(&build.workers[i].checker);
+        vm_compiler_free(&build.workers[i].compiler);
+        vm_chunk_free(&build.workers[i].chunk);
+        vm_free(&build.workers[i].vm);
+        ssa_lowerer_free(&build.workers[i].lowerer);
+        ssa_function_free(&build.workers[i].function);
+        ssa_optimizer_free(&build.workers[i].optimizer);
+        free(build.workers[i].values.items);
+    }
+    free(build.workers);
+    free(included.items);
+    free(roots.items);
+    modules_free(&graph);
+    return success;
+}
+
+// One filename per line, the lines are kept in `content` and have to
+// outlive the filenames
+bool read_response_file(const char *filename, String_Builder *content, Filenames *filenames) {
+    static Writer err;
+    writer_init(&err, STDERR_FILENO);
+    if (!read_entire_file(filename, content, &err)) {
+        writer_flush(&err);
+        return false;
+    }
+    da_append(content, '\n');
+    char *line = content->items;
+    char *end = content->items + content->count;
+    while (line < end) {
+        char *newline = memchr(line, '\n', end - line);
+        *newline = '\0';
+        if (newline > line) {
+            da_append(filenames, line);
+        }
+        line = newline + 1;
+    }
+    return true;
+}
+
+// The server does not share our working directory, so it gets absolute
+// paths. Returns -1 if there is no server.
+int forward_to_server(const char *socket_path, Emit_Kind emit, Filenames *filenames) {
+    Filenames absolute = {0};
+    for (size_t i = 0; i < filenames->count; i++) {
+        char *path = realpath(filenames->items[i], NULL);
+        // the server reports files that do not exist like bangc would
+        da_append(&absolute, path != NULL ? path : strdup(filenames->items[i]));
+    }
+    int status = server_forward(socket_path, Server_Check, emit, absolute.items, absolute.count);
+    for (size_t i = 0; i < absolute.count; i++) {
+        free((char *)absolute.items[i]);
+    }
+    free(absolute.items);
+    return status;
+}
+
+int main(int argc, char **argv) {
+    const char* program = shift_args(&argv, &argc);
+
+    Options options = { .emit = Emit_Ast };
+    bool time_report = false;
+    bool time_report_json = false;
+    const char *trace_file = NULL;
+    size_t jobs = workers_default_count();
+    const char *server_socket = NULL;
+    const char *connect_socket = NULL;
+    bool stop_server = false;
+    Filenames filenames = {0};
+    while (argc > 0) {
+        const char *arg = shift_args(&argv, &argc);
+        if (strncmp(arg, "--emit=", 7) == 0) {
+            const char *kind = arg + 7;
+            if (strcmp(kind, "ast") == 0) {
+                options.emit = Emit_Ast;
+            } else if (strcmp(kind, "ast-json") == 0) {
+                options.emit = Emit_AstJson;
+            } else if (strcmp(kind, "ast-bin") == 0) {
+                options.emit = Emit_AstBin;
+            } else if (strcmp(kind, "ssa") == 0) {
+                // only checked code is lowered
+                options.emit = Emit_Ssa;
+                options.resolve = true;
+                options.check = true;
+            } else {
+                usage(program);
+                fprintf(stderr, "ERROR: Unknown emit kind: %s\n", kind);
+                return 1;
+            }
+        } else if (strcmp(arg, "--time-report") == 0 || strcmp(arg, "--time-report=json") == 0) {
+            time_report = true;
+            time_report_json = arg[13] == '=';
+        } else if (strncmp(arg, "--trace=", 8) == 0) {
+            trace_file = arg + 8;
+        } else if (strncmp(arg, "--jobs=", 7) == 0) {
+            char *end;
+            jobs = strtoul(arg + 7, &end, 10);
+            if (*end != '\0' || jobs == 0) {
+                usage(program);
+                fprintf(stderr, "ERROR: Invalid number of jobs: %s\n", arg + 7);
+                return 1;
+            }
+        } else if (strncmp(arg, "--server=", 9) == 0) {
+            server_socket = arg + 9;
+        } else if (strncmp(arg, "--connect=", 10) == 0) {
+            connect_socket = arg + 10;
+        } else if (strncmp(arg, "--cfg=", 6) == 0 && arg[6] != '\0') {
+            da_append(&options.cfg, arg + 6);
+        } else if (strcmp(arg, "--fold") == 0) {
+            options.fold = true;
+        } else if (strcmp(arg, "--resolve") == 0) {
+            options.resolve = true;
+        } else if (strcmp(arg, "--check") == 0) {
+            // paths are typed through their Decl
+            options.resolve = true;
+            options.check = true;
+        } else if (strcmp(arg, "--run") == 0 || strcmp(arg, "--run=vm") == 0 || strcmp(arg, "--run=ssa") == 0) {
+            // only checked code is compiled
+            options.resolve = true;
+            options.check = true;
+            options.run = true;
+            options.run_ssa = strcmp(arg, "--run=ssa") == 0;
+        } else if (strcmp(arg, "--optimize") == 0) {
+            options.optimize = true;
+        } else if (strcmp(arg, "--stop") == 0) {
+            stop_server = true;
+        } else if (arg[0] == '@') {
+            // every response file gets its own buffer, the filenames point
+            // into it
+            String_Builder *content = calloc(1, sizeof(String_Builder));
+            if (!read_response_file(arg + 1, content, &filenames)) {
+                return 1;
+            }
+        } else if (arg[0] == '-' && arg[1] != '\0') {
+            usage(program);
+            fprintf(stderr, "ERROR: Unexpected argument: %s\n", arg);
+            return 1;
+        } else {
+            da_append(&filenames, arg);
+        }
+    }
+
+    if (server_socket != NULL) {
+        return server_run(server_socket);
+    }
+    if (stop_server) {
+        if (connect_socket == NULL || server_forward(connect_socket, Server_Stop, options.emit, NULL, 0) < 0) {
+            fprintf(stderr, "ERROR: No server to stop\n");
+            return 1;
+        }
+        return 0;
+    }
+
+    if (filenames.count == 0) {
+        usage(program);
+        fprintf(stderr, "ERROR: No input files\n");
+        return 1;
+    }
+#ifndef BANG_INSTRUMENT
+    if (time_report) {
+        fprintf(stderr, "ERROR: --time-report needs a build with instrumentation (make INSTRUMENT=1)\n");
+        return 1;
+    }
+    if (trace_file != NULL) {
+        fprintf(stderr, "ERROR: --trace needs a build with instrumentation (make INSTRUMENT=1)\n");
+        return 1;
+    }
+#else
+    trace_enabled = trace_file != NULL;
+#endif
+    options.count_nodes = time_report;
+
+    // the server parses without any --cfg and neither folds, resolves, checks nor runs
+    if (connect_socket != NULL && !time_report && trace_file == NULL && options.cfg.count == 0 && !options.fold && !options.resolve) {
+        int status = forward_to_server(connect_socket, options.emit, &filenames);
+        if (status >= 0) {
+            free(filenames.items);
+            return status;
+        }
+    }
+
+    bool success = process_build(&filenames, options, jobs);
+
+    if (success && time_report) {
+        static Writer out;
+        writer_init(&out, STDERR_FILENO);
+        METRICS_REPORT(&out, time_report_json);
+        success = !out.failed;
+    }
+#ifdef BANG_INSTRUMENT
+    if (trace_file != NULL && !trace_dump(trace_file)) {
+        return 1;
+    }
+#endif
 
-    return 0;
+    free(options.cfg.items);
+    free(filenames.items);
+    return success ? 0 : 1;
 }
@@ -0,0 +1,255 @@
+#ifdef BANG_INSTRUMENT
+
+#include <malloc.h>
+#include <pthread.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#include "metrics.h"
+#include "visitor.h"
+
+_Thread_local Metrics metrics;
+
+static Metrics metrics_total;
+static pthread_mutex_t metrics_lock = PTHREAD_MUTEX_INITIALIZER;
+
+uint64_t metrics_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// Instrumented builds are linked with `--wrap=malloc` (and friends), which
+// routes every allocation of the compiler through these.
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+    metrics.allocations++;
+    metrics.bytes_allocated += size;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    metrics.allocations++;
+    metrics.bytes_allocated += count * size;
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    // only the growth is new memory
+    size_t old = ptr != NULL ? malloc_usable_size(ptr) : 0;
+    metrics.allocations++;
+    metrics.bytes_allocated += size > old ? size - old : 0;
+    return __real_realloc(ptr, size);
+}
+
+static
+Ast_VisitResult _count_node(Ast_Visitor *visitor, Ast_Node node) {
+    (void)visitor;
+    switch (node.klass) {
+        case Node_Expr: metrics.exprs[node.expr->kind]++; break;
+        case Node_Type: metrics.types[node.type->kind]++; break;
+        case Node_Stmt: metrics.stmts[node.stmt->kind]++; break;
+        case Node_Item: metrics.items[node.item->kind]++; break;
+        case Node_Block: metrics.blocks++; break;
+    }
+    return Visit_Continue;
+}
+
+void metrics_count_source(Ast_Source *source) {
+    Ast_Visitor visitor = { .pre = _count_node };
+    ast_walk_source(&visitor, source);
+    ast_visitor_free(&visitor);
+}
+
+void metrics_count_optimize(Ssa_Optimizer *optimizer) {
+    for (size_t i = 0; i < Ssa_NumberOfPasses; i++) {
+        metrics.pass_removed[i] += optimizer->stats[i].removed;
+        metrics.pass_ns[i] += optimizer->stats[i].ns;
+    }
+}
+
+void metrics_collect(void) {
+    // Metrics is nothing but counters
+    uint64_t *from = (uint64_t *)&metrics;
+    uint64_t *to = (uint64_t *)&metrics_total;
+    pthread_mutex_lock(&metrics_lock);
+    for (size_t i = 0; i < sizeof(Metrics) / sizeof(uint64_t); i++) {
+        to[i] += from[i];
+    }
+    pthread_mutex_unlock(&metrics_lock);
+    metrics = (Metrics) {0};
+}
+
+static const char *phase_names[] = {
+#define _PHASE(name) #name,
+    ENUMERATE_PHASES
+#undef _PHASE
+};
+
+static const char *token_names[] = {
+    "EOF",
+#define VARIANT(name, ...) #name,
+    ENUMERATE_LEXER_TOKENS
+#undef VARIANT
+    "Punctuator",
+};
+
+static const char *expr_names[] = {
+#define _NODE(name, ...) #name,
+    ENUMERATE_EXPR_NODES
+#undef _NODE
+};
+
+static const char *type_names[] = {
+#define _NODE(name, ...) #name,
+    ENUMERATE_TYPE_NODES
+#undef _NODE
+};
+
+static const char *stmt_names[] = {
+#define _NODE(name, ...) #name,
+    ENUMERATE_STMT_NODES
+#undef _NODE
+};
+
+static const char *item_names[] = {
+#define _NODE(name, ...) #name,
+    ENUMERATE_ITEM_NODES
+#undef _NODE
+};
+
+typedef struct {
+    Writer *w;
+    bool json;
+    bool first;
+} Report;
+
+static
+void _section(Report *r, const char *name) {
+    if (r->json) {
+        writer_cstr(r->w, r->first ? "{\"" : "},\"");
+        writer_cstr(r->w, name);
+        writer_cstr(r->w, "\":{");
+    } else {
+        writer_cstr(r->w, r->first ? "" : "\n");
+        writer_cstr(r->w, name);
+        writer_char(r->w, '\n');
+    }
+    r->first = true;
+}
+
+static
+void _row(Report *r, const char *prefix, const char *name, uint64_t value, const char *unit) {
+    Writer *w = r->w;
+    if (r->json) {
+        writer_cstr(w, r->first ? "\"" : ",\"");
+        writer_cstr(w, prefix);
+        writer_cstr(w, name);
+        writer_cstr(w, "\":");
+        writer_u64(w, value);
+    } else {
+        size_t width = strlen(prefix) + strlen(name);
+        writer_cstr(w, "    ");
+        writer_cstr(w, prefix);
+        writer_cstr(w, name);
+        for (size_t i = width; i < 28; i++) {
+            writer_char(w, ' ');
+        }
+        writer_u64(w, value);
+        writer_cstr(w, unit);
+        writer_char(w, '\n');
+    }
+    r->first = false;
+}
+
+static
+void _rows(Report *r, const char *prefix, const char **names, uint64_t *values, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (values[i] != 0) {
+            _row(r, prefix, names[i], values[i], "");
+        }
+    }
+}
+
+void metrics_report(Writer *w, bool json) {
+    Report report = { .w = w, .json = json, .first = true };
+    Report *r = &report;
+    // the totals of all threads
+    Metrics metrics = metrics_total;
+
+    uint64_t phases[Phase_NumberOfElements];
+    memcpy(phases, metrics.phase_ns, sizeof(phases));
+    phases[Phase_Tree] -= phases[Phase_Lex];
+
+    uint64_t total = 0;
+    _section(r, json ? "phases_us" : "phase");
+    for (size_t i = 0; i < Phase_NumberOfElements; i++) {
+        _row(r, "", phase_names[i], phases[i] / 1000, " us");
+        total += phases[i];
+    }
+    _row(r, "", "Total", total / 1000, " us");
+
+    _section(r, "tokens");
+    _rows(r, "", token_names, metrics.tokens, METRICS_TOKEN_KINDS);
+    _row(r, "", "Delimited", metrics.delimited, "");
+
+    _section(r, "nodes");
+    _rows(r, "expr.", expr_names, metrics.exprs, Expr_NumberOfElements);
+    _rows(r, "type.", type_names, metrics.types, Type_NumberOfElements);
+    _rows(r, "stmt.", stmt_names, metrics.stmts, Stmt_NumberOfElements);
+    _rows(r, "item.", item_names, metrics.items, Item_NumberOfElements);
+    _row(r, "", "block", metrics.blocks, "");
+
+    if (metrics.folded_nodes > 0) {
+        _section(r, "fold");
+        _row(r, "", "released", metrics.folded_nodes, "");
+    }
+
+    if (metrics.resolved_uses > 0) {
+        _section(r, "resolve");
+        _row(r, "", "uses", metrics.resolved_uses, "");
+        _row(r, "", "probes", metrics.resolver_probes, "");
+    }
+
+    if (metrics.checked_exprs > 0) {
+        _section(r, "check");
+        _row(r, "", "exprs", metrics.checked_exprs, "");
+    }
+
+    if (metrics.lowered_instrs > 0) {
+        _section(r, "lower");
+        _row(r, "", "instrs", metrics.lowered_instrs, "");
+    }
+
+    uint64_t passes_ns = 0;
+    for (size_t i = 0; i < Ssa_NumberOfPasses; i++) {
+        passes_ns += metrics.pass_ns[i];
+    }
+    if (passes_ns > 0) {
+        _section(r, "optimize");
+        for (size_t i = 0; i < Ssa_NumberOfPasses; i++) {
+            _row(r, ssa_pass_names[i], ".removed", metrics.pass_removed[i], "");
+            _row(r, ssa_pass_names[i], ".us", metrics.pass_ns[i] / 1000, " us");
+        }
+    }
+
+    if (metrics.run_instrs > 0) {
+        _section(r, "run");
+        _row(r, "", "instrs", metrics.run_instrs, "");
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    _section(r, "memory");
+    _row(r, "", "allocations", metrics.allocations, "");
+    _row(r, "", "bytes_allocated", metrics.bytes_allocated, " B");
+    _row(r, "", "peak_rss", (uint64_t)usage.ru_maxrss * 1024, " B");
+
+    writer_cstr(w, json ? "}}\n" : "");
+    writer_flush(w);
+}
+
+#endif // BANG_INSTRUMENT
@@ -0,0 +1,121 @@
+#ifndef METRICS_H_
+#define METRICS_H_
+
+// Phase timers and counters for `--time-report`. Everything in here only
+// exists in builds with BANG_INSTRUMENT defined (`make INSTRUMENT=1`), in
+// all other builds the macros expand to nothing.
+
+#ifdef BANG_INSTRUMENT
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "AST.h"
+#include "lexer.h"
+#include "ssa.h"
+#include "writer.h"
+
+// `Tree` is timed around lexer_tokenize_source and so includes `Lex`, which
+// metrics_report subtracts: the reported `Tree` is building the trees alone
+#define ENUMERATE_PHASES \
+    _PHASE(Read)         \
+    _PHASE(Lex)          \
+    _PHASE(Tree)         \
+    _PHASE(Parse)        \
+    _PHASE(Fold)         \
+    _PHASE(Resolve)      \
+    _PHASE(Check)        \
+    _PHASE(Lower)        \
+    _PHASE(Run)          \
+    _PHASE(Emit)
+
+typedef enum {
+#define _PHASE(name) Phase_##name,
+    ENUMERATE_PHASES
+#undef _PHASE
+    Phase_NumberOfElements
+} Metrics_Phase;
+
+// named token kinds, followed by one bucket for all punctuators
+#define METRICS_TOKEN_KINDS (Tk_NumberOfTokens - Tk_EOF + 1)
+
+typedef struct {
+    uint64_t phase_ns[Phase_NumberOfElements];
+
+    uint64_t tokens[METRICS_TOKEN_KINDS];
+    uint64_t delimited;
+
+    uint64_t exprs[Expr_NumberOfElements];
+    uint64_t types[Type_NumberOfElements];
+    uint64_t stmts[Stmt_NumberOfElements];
+    uint64_t items[Item_NumberOfElements];
+    uint64_t blocks;
+
+    // nodes the folder released
+    uint64_t folded_nodes;
+    // names looked up by the resolver and the table slots it probed for them
+    uint64_t resolved_uses;
+    uint64_t resolver_probes;
+    // expressions given a type by the checker
+    uint64_t checked_exprs;
+    // SSA instructions of the lowered entrypoints
+    uint64_t lowered_instrs;
+    // what every pass of ssa_optimize removed and the time it took
+    uint64_t pass_removed[Ssa_NumberOfPasses];
+    uint64_t pass_ns[Ssa_NumberOfPasses];
+    // instructions compiled for the entrypoints that were run
+    uint64_t run_instrs;
+
+    uint64_t allocations;
+    uint64_t bytes_allocated;
+} Metrics;
+
+// Every thread counts into its own metrics, `metrics_collect` adds them to
+// the totals that `metrics_report` prints
+extern _Thread_local Metrics metrics;
+
+uint64_t metrics_now(void);
+void metrics_count_source(Ast_Source *source);
+void metrics_count_optimize(Ssa_Optimizer *optimizer);
+void metrics_collect(void);
+void metrics_report(Writer *w, bool json);
+
+#define METRICS_TIME_BEGIN(phase) \
+    uint64_t __metrics_start_##phase = metrics_now()
+#define METRICS_TIME_END(phase) \
+    (metrics.phase_ns[Phase_##phase] += metrics_now() - __metrics_start_##phase)
+
+#define METRICS_COUNT_TOKEN(kind)                              \
+    (metrics.tokens[(kind) >= Tk_EOF && (kind) < Tk_NumberOfTokens \
+        ? (kind) - Tk_EOF : METRICS_TOKEN_KINDS - 1]++)
+#define METRICS_COUNT_DELIMITED() (metrics.delimited++)
+#define METRICS_COUNT_FOLD(released) (metrics.folded_nodes += (released))
+#define METRICS_COUNT_RESOLVE(uses, probes) \
+    (metrics.resolved_uses += (uses), metrics.resolver_probes += (probes))
+#define METRICS_COUNT_CHECK(exprs) (metrics.checked_exprs += (exprs))
+#define METRICS_COUNT_LOWER(instrs) (metrics.lowered_instrs += (instrs))
+#define METRICS_COUNT_OPTIMIZE(optimizer) metrics_count_optimize(optimizer)
+#define METRICS_COUNT_RUN(instrs) (metrics.run_instrs += (instrs))
+#define METRICS_COUNT_SOURCE(source) metrics_count_source(source)
+#define METRICS_COLLECT() metrics_collect()
+#define METRICS_REPORT(w, json) metrics_report((w), (json))
+
+#else
+
+#define METRICS_TIME_BEGIN(phase)
+#define METRICS_TIME_END(phase)
+#define METRICS_COUNT_TOKEN(kind)
+#define METRICS_COUNT_DELIMITED()
+#define METRICS_COUNT_FOLD(released)
+#define METRICS_COUNT_RESOLVE(uses, probes)
+#define METRICS_COUNT_CHECK(exprs)
+#define METRICS_COUNT_LOWER(instrs)
+#define METRICS_COUNT_OPTIMIZE(optimizer)
+#define METRICS_COUNT_RUN(instrs)
+#define METRICS_COUNT_SOURCE(source)
+#define METRICS_COLLECT()
+#define METRICS_REPORT(w, json) ((void)(w), (void)(json))
+
+#endif // BANG_INSTRUMENT
+
+#endif // METRICS_H_
@@ -0,0 +1,270 @@
+#include <assert.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dynarray.h"
+#include "hash.h"
+#include "modules.h"
+
+#define MODULES_TABLE_INIT_CAP 64
+#define MODULES_HASH_SEED 0x62616e676d6f6473ull
+
+typedef struct {
+    Modules_LoadFn load;
+    void *data;
+} Modules_Loader;
+
+void modules_init(Module_Graph *graph) {
+    *graph = (Module_Graph) {0};
+    pthread_mutex_init(&graph->lock, NULL);
+}
+
+static
+void _table_insert(Module_Graph *graph, uint64_t hash, size_t index) {
+    size_t mask = graph->slots_capacity - 1;
+    size_t slot = hash & mask;
+    while (graph->slots[slot] != 0) {
+        slot = (slot + 1) & mask;
+    }
+    graph->slots[slot] = index + 1;
+}
+
+static
+void _table_grow(Module_Graph *graph) {
+    free(graph->slots);
+    graph->slots_capacity = graph->slots_capacity == 0 ? MODULES_TABLE_INIT_CAP : graph->slots_capacity * 2;
+    graph->slots = calloc(graph->slots_capacity, sizeof(size_t));
+    assert(graph->slots != NULL && "Buy more RAM lol");
+    for (size_t i = 0; i < graph->modules.count; i++) {
+        _table_insert(graph, graph->modules.items[i]->path_hash, i);
+    }
+}
+
+// Returns the module of `path`, which is created if the path was never seen
+// before, the caller has it loaded then. Takes ownership of `path`; has to
+// be called with the lock held.
+static
+Module *_claim(Module_Graph *graph, char *path, bool *created) {
+    *created = false;
+    uint64_t hash = hash_bytes(path, strlen(path), MODULES_HASH_SEED);
+    if (graph->slots_capacity > 0) {
+        size_t mask = graph->slots_capacity - 1;
+        for (size_t slot = hash & mask; graph->slots[slot] != 0; slot = (slot + 1) & mask) {
+            Module *module = graph->modules.items[graph->slots[slot] - 1];
+            if (module->path_hash == hash && strcmp(module->path, path) == 0) {
+                free(path);
+                return module;
+            }
+        }
+    }
+
+    // kept at most half full
+    if (2 * (graph->modules.count + 1) > graph->slots_capacity) {
+        _table_grow(graph);
+    }
+    Module *module = calloc(1, sizeof(Module));
+    assert(module != NULL && "Buy more RAM lol");
+    module->path = path;
+    module->path_hash = hash;
+    module->name = path;
+    module->index = graph->modules.count;
+    da_append(&graph->modules, module);
+    _table_insert(graph, hash, module->index);
+    *created = true;
+    return module;
+}
+
+// Files that do not exist keep the path they were named by, loading them
+// reports the error
+static
+char *_canonical_path(const char *path) {
+    char *canonical = realpath(path, NULL);
+    return canonical != NULL ? canonical : strdup(path);
+}
+
+Module *modules_add_root(Module_Graph *graph, const char *name) {
+    pthread_mutex_lock(&graph->lock);
+    bool created;
+    Module *module = _claim(graph, _canonical_path(name), &created);
+    if (created) {
+        da_append(&graph->queue, module);
+    }
+    if (!module->root) {
+        module->root = true;
+        module->name = name;
+    }
+    pthread_mutex_unlock(&graph->lock);
+    return module;
+}
+
+// `path` relative to the directory of `module`
+static
+char *_resolve(Module *module, String_Builder path) {
+    // string tokens keep their quotes
+    assert(path.count >= 2 && "string token without quotes");
+    path.items++;
+    path.count -= 2;
+
+    char joined[PATH_MAX];
+    const char *slash = strrchr(module->path, '/');
+    int directory = slash != NULL ? (int)(slash - module->path + 1) : 0;
+    if (path.count > 0 && path.items[0] == '/') {
+        directory = 0;
+    }
+    int length = snprintf(joined, sizeof(joined), "%.*s%.*s",
+                          directory, module->path, (int)path.count, path.items);
+    assert(length >= 0 && (size_t)length < sizeof(joined) && "include path too long");
+    return _canonical_path(joined);
+}
+
+void modules_discover(Module_Graph *graph, size_t worker, Module *module, Ast_Source *source) {
+    for (size_t i = 0; i < source->count; i++) {
+        Ast_Item *item = source->items[i];
+        String_Builder path;
+        if (item->kind == Include_kind) {
+            path = item->Include.path;
+        } else if (item->kind == Open_kind) {
+            path = item->Open.path;
+        } else {
+            continue;
+        }
+        // resolved outside of the lock, it touches the file system
+        char *resolved = _resolve(module, path);
+
+        pthread_mutex_lock(&graph->lock);
+        bool created;
+        Module *dependency = _claim(graph, resolved, &created);
+        pthread_mutex_unlock(&graph->lock);
+        if (created) {
+            workers_push(graph->workers, worker, dependency);
+        }
+
+        Module_Dependency entry = {
+            .module = dependency,
+            .span = item->span,
+            .include = item->kind == Include_kind,
+        };
+        // only the loading thread touches the module
+        da_append(&module->deps, entry);
+    }
+}
+
+static
+void _load(void *data, size_t worker, void *task) {
+    Modules_Loader *loader = data;
+    loader->load(loader->data, worker, task);
+}
+
+void modules_load(Module_Graph *graph, size_t jobs, Modules_LoadFn load, void *data) {
+    Modules_Loader loader = { .load = load, .data = data };
+    Workers workers;
+    workers_init(&workers, jobs, _load, &loader);
+    // every worker starts with its own contiguous run of the roots, the
+    // latest discovered module is loaded first, which keeps long include
+    // chains going
+    for (size_t i = 0; i < graph->queue.count; i++) {
+        workers_push(&workers, i * jobs / graph->queue.count, graph->queue.items[i]);
+    }
+    graph->queue.count = 0;
+    graph->workers = &workers;
+    workers_run(&workers);
+    graph->workers = NULL;
+    workers_free(&workers);
+}
+
+typedef struct {
+    Module *module;
+    // next dependency to visit
+    size_t dep;
+} Modules_Frame;
+
+typedef struct {
+    Modules_Frame *items;
+    size_t count;
+    size_t capacity;
+} Modules_Frames;
+
+enum {
+    Visit_New,
+    Visit_Active,
+    Visit_Done,
+};
+
+static
+void _report_cycle(Writer *err, Modules_Frames *stack, Module *target) {
+    size_t start = stack->count;
+    while (stack->items[start - 1].module != target) {
+        start--;
+    }
+    writer_cstr(err, "ERROR: Include cycle: ");
+    for (size_t i = start - 1; i < stack->count; i++) {
+        writer_cstr(err, stack->items[i].module->name);
+        writer_cstr(err, " -> ");
+    }
+    writer_cstr(err, target->name);
+    writer_char(err, '\n');
+}
+
+// A depth first search over the #include edges, every edge back onto the
+// current path closes a cycle. Done after loading and linear in the size of
+// the graph.
+bool modules_check_cycles(Module_Graph *graph, Writer *err) {
+    uint8_t *state = calloc(graph->modules.count + 1, sizeof(uint8_t));
+    assert(state != NULL && "Buy more RAM lol");
+    Modules_Frames stack = {0};
+    bool success = true;
+
+    for (size_t i = 0; i < graph->modules.count; i++) {
+        Module *root = graph->modules.items[i];
+        if (state[root->index] != Visit_New) {
+            continue;
+        }
+        state[root->index] = Visit_Active;
+        da_append(&stack, ((Modules_Frame) { .module = root, .dep = 0 }));
+        while (stack.count > 0) {
+            Modules_Frame *frame = &stack.items[stack.count - 1];
+            if (frame->dep == frame->module->deps.count) {
+                state[frame->module->index] = Visit_Done;
+                stack.count--;
+                continue;
+            }
+            Module_Dependency *dep = &frame->module->deps.items[frame->dep++];
+            if (!dep->include) {
+                continue;
+            }
+            switch (state[dep->module->index]) {
+                case Visit_New:
+                    state[dep->module->index] = Visit_Active;
+                    da_append(&stack, ((Modules_Frame) { .module = dep->module, .dep = 0 }));
+                    break;
+                case Visit_Active:
+                    _report_cycle(err, &stack, dep->module);
+                    success = false;
+                    break;
+                case Visit_Done:
+                    break;
+            }
+        }
+    }
+
+    free(stack.items);
+    free(state);
+    return success;
+}
+
+void modules_free(Module_Graph *graph) {
+    for (size_t i = 0; i < graph->modules.count; i++) {
+        Module *module = graph->modules.items[i];
+        free(module->path);
+        free(module->deps.items);
+        free(module->out.items);
+        free(module->err.items);
+        free(module);
+    }
+    free(graph->modules.items);
+    free(graph->queue.items);
+    free(graph->slots);
+    pthread_mutex_destroy(&graph->lock);
+}
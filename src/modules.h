@@ -0,0 +1,100 @@
+#ifndef MODULES_H_
+#define MODULES_H_
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "AST.h"
+#include "workers.h"
+#include "writer.h"
+
+// `#include "file";` and `#open "file";` name other files relative to the
+// directory of the file they are in. The Module_Graph gives every file of a
+// build a single Module keyed by its canonical path, so a file reached over
+// any number of paths through the include graph is loaded exactly once.
+// It does not keep the trees: the load function parses a module into a pool
+// it resets afterwards, what stays of a module is its dependencies, for the
+// cycle check, and its output.
+//
+// Loading is driven by the includes themselves: as soon as a module is
+// parsed, `modules_discover` claims the files it names and pushes the ones
+// nobody claimed before onto the deque of the worker that parsed it, see
+// src/workers.h, so independent modules load concurrently and a wide graph
+// takes about as long as its deepest include chain. A module
+// never waits for its dependencies, which is why cycles cannot deadlock the
+// loader; they are reported by `modules_check_cycles` once the whole graph
+// is known.
+
+typedef struct _Module Module;
+
+typedef struct {
+    Module *module;
+    Lex_Span span;
+    // #include, otherwise #open
+    bool include;
+} Module_Dependency;
+
+typedef struct {
+    Module_Dependency *items;
+    size_t count;
+    size_t capacity;
+} Module_Dependencies;
+
+struct _Module {
+    // canonical if the file exists, the key of the graph
+    char *path;
+    uint64_t path_hash;
+    // as given on the command line for roots, `path` otherwise
+    const char *name;
+    // position in `Module_Graph.modules`
+    size_t index;
+    // in the order the directives appear in
+    Module_Dependencies deps;
+    bool root;
+    // set by the load function, failed modules are not discovered from
+    bool success;
+    // diagnostics and output of the load function
+    String_Builder out;
+    String_Builder err;
+};
+
+typedef struct {
+    Module **items;
+    size_t count;
+    size_t capacity;
+} Modules;
+
+typedef struct {
+    // every module in the order it was claimed in
+    Modules modules;
+    // open addressing on `path_hash`, module index + 1 and 0 for empty slots
+    size_t *slots;
+    size_t slots_capacity;
+
+    pthread_mutex_t lock;
+    // the roots, claimed before modules_load
+    Modules queue;
+    // while modules_load runs
+    Workers *workers;
+} Module_Graph;
+
+// Reads, tokenizes and parses `module` and calls `modules_discover` on the
+// result. `worker` is in [0, jobs) and identifies the calling thread.
+typedef void (*Modules_LoadFn)(void *data, size_t worker, Module *module);
+
+void modules_init(Module_Graph *graph);
+// `name` has to outlive the graph
+Module *modules_add_root(Module_Graph *graph, const char *name);
+// Loads the roots and everything they include on `jobs` threads, the
+// calling thread being worker 0
+void modules_load(Module_Graph *graph, size_t jobs, Modules_LoadFn load, void *data);
+// Records the #include and #open items of `source` as dependencies of
+// `module`, the files loaded for the first time are pushed onto the deque of
+// `worker`, the one loading `module`
+void modules_discover(Module_Graph *graph, size_t worker, Module *module, Ast_Source *source);
+// Reports every #include cycle to `err`, #open may be cyclic
+bool modules_check_cycles(Module_Graph *graph, Writer *err);
+void modules_free(Module_Graph *graph);
+
+#endif // MODULES_H_
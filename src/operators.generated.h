@@ -7,9 +7,8 @@
 #define  OPERATORS_H_PREFIX
 #endif //OPERATORS_H_PREFIX
 #include <stdint.h>
-
-uint64_t thirdparty_siphash24(const void *src, unsigned long src_sz, const char key[16]);
 #include <stdbool.h>
+#include "hash.h"
 #include <string.h>
 
 #define NUM_ENTRIES_BINARY_OP 18
@@ -88,52 +87,192 @@ BinaryOp binary_op_resolve(uint32_t in);
 #ifdef   OPERATORS_H_IMPLEMENTATION
 OPERATORS_H_PREFIX
 BinaryOp binary_op_resolve(uint32_t in) {
-    static const struct _bo_struct_tuple { uint32_t _0; BinaryOp _1; } _bo_entries[NUM_ENTRIES_BINARY_OP] = {
-        { 0x0000003c, Bo_Lt },
-        { 0x0000007c, Bo_BOr },
+    // multiply-shift perfect hash, empty slots hold the key 0 and Invalid
+    static const struct _bo_entry { uint32_t _0; BinaryOp _1; } table[32] = {
+        { 0x00003d3e, Bo_Ge },
         { 0x00003c3c, Bo_Shl },
+        { 0x0000002a, Bo_Mul },
+        { 0x0000007c, Bo_BOr },
+        { 0, Bo_Invalid },
+        { 0x0000002b, Bo_Plus },
+        { 0, Bo_Invalid },
+        { 0x00002626, Bo_And },
+        { 0, Bo_Invalid },
         { 0x0000002d, Bo_Minus },
-        { 0x00003d3e, Bo_Ge },
-        { 0x00003d3d, Bo_Eq },
-        { 0x00000026, Bo_BAnd },
-        { 0x00000025, Bo_Mod },
+        { 0, Bo_Invalid },
+        { 0, Bo_Invalid },
+        { 0, Bo_Invalid },
+        { 0x0000003c, Bo_Lt },
+        { 0x0000002f, Bo_Div },
+        { 0, Bo_Invalid },
+        { 0, Bo_Invalid },
         { 0x0000003e, Bo_Gt },
-        { 0x00002626, Bo_And },
+        { 0, Bo_Invalid },
+        { 0, Bo_Invalid },
+        { 0, Bo_Invalid },
+        { 0x00007c7c, Bo_Or },
+        { 0, Bo_Invalid },
+        { 0x00000025, Bo_Mod },
+        { 0, Bo_Invalid },
+        { 0x00000026, Bo_BAnd },
+        { 0x00003e3e, Bo_Shr },
+        { 0x00003d3c, Bo_Le },
+        { 0x00003d21, Bo_Ne },
         { 0x0000005e, Bo_BXor },
+        { 0x00003d3d, Bo_Eq },
+        { 0, Bo_Invalid },
+    };
+
+    const struct _bo_entry entry = table[(uint32_t)(in * 315867175u) >> 27];
+    if (entry._0 != in) {
+        return Bo_Invalid;
+    }
+    return entry._1;
+}
+#endif //OPERATORS_H_IMPLEMENTATION
+
+#ifdef   OPERATORS_H_LOOKUP_STRATEGIES
+static inline BinaryOp binary_op_resolve_switch(uint32_t in) {
+    switch (in) {
+    case 0x0000002a: return Bo_Mul;
+    case 0x0000002f: return Bo_Div;
+    case 0x00000025: return Bo_Mod;
+    case 0x0000002b: return Bo_Plus;
+    case 0x0000002d: return Bo_Minus;
+    case 0x00003c3c: return Bo_Shl;
+    case 0x00003e3e: return Bo_Shr;
+    case 0x00000026: return Bo_BAnd;
+    case 0x0000005e: return Bo_BXor;
+    case 0x0000007c: return Bo_BOr;
+    case 0x00003d3d: return Bo_Eq;
+    case 0x00003d21: return Bo_Ne;
+    case 0x0000003e: return Bo_Gt;
+    case 0x00003d3e: return Bo_Ge;
+    case 0x0000003c: return Bo_Lt;
+    case 0x00003d3c: return Bo_Le;
+    case 0x00002626: return Bo_And;
+    case 0x00007c7c: return Bo_Or;
+    }
+    return Bo_Invalid;
+}
+
+static inline BinaryOp binary_op_resolve_length(uint32_t in) {
+    static const struct _binary_op_resolve_entry { uint32_t _0; BinaryOp _1; } entries[18] = {
         { 0x0000002a, Bo_Mul },
         { 0x0000002f, Bo_Div },
+        { 0x00000025, Bo_Mod },
+        { 0x0000002b, Bo_Plus },
+        { 0x0000002d, Bo_Minus },
+        { 0x00000026, Bo_BAnd },
+        { 0x0000005e, Bo_BXor },
+        { 0x0000007c, Bo_BOr },
+        { 0x0000003e, Bo_Gt },
+        { 0x0000003c, Bo_Lt },
+        { 0x00003c3c, Bo_Shl },
         { 0x00003e3e, Bo_Shr },
+        { 0x00003d3d, Bo_Eq },
+        { 0x00003d21, Bo_Ne },
+        { 0x00003d3e, Bo_Ge },
         { 0x00003d3c, Bo_Le },
-        { 0x0000002b, Bo_Plus },
+        { 0x00002626, Bo_And },
         { 0x00007c7c, Bo_Or },
+    };
+    static const struct { uint8_t start; uint8_t count; } lengths[2 + 1] = {
+        [1] = { 0, 10 }, [2] = { 10, 8 }, 
+    };
+
+    const size_t length = in == 0 ? 0 : 4 - __builtin_clz(in) / 8;
+    if (length > 2) {
+        return Bo_Invalid;
+    }
+    for (size_t i = lengths[length].start; i < lengths[length].start + lengths[length].count; i++) {
+        if (entries[i]._0 == in) {
+            return entries[i]._1;
+        }
+    }
+    return Bo_Invalid;
+}
+
+static inline BinaryOp binary_op_resolve_direct(uint32_t in) {
+    static const struct _binary_op_resolve_entry { uint32_t _0; BinaryOp _1; } entries[18] = {
         { 0x00003d21, Bo_Ne },
+        { 0x00000025, Bo_Mod },
+        { 0x00000026, Bo_BAnd },
+        { 0x00002626, Bo_And },
+        { 0x0000002a, Bo_Mul },
+        { 0x0000002b, Bo_Plus },
+        { 0x0000002d, Bo_Minus },
+        { 0x0000002f, Bo_Div },
+        { 0x00003c3c, Bo_Shl },
+        { 0x0000003c, Bo_Lt },
+        { 0x00003d3c, Bo_Le },
+        { 0x00003d3d, Bo_Eq },
+        { 0x00003e3e, Bo_Shr },
+        { 0x0000003e, Bo_Gt },
+        { 0x00003d3e, Bo_Ge },
+        { 0x0000005e, Bo_BXor },
+        { 0x0000007c, Bo_BOr },
+        { 0x00007c7c, Bo_Or },
+    };
+    static const struct { uint8_t start; uint8_t count; } firsts[256] = {
+        ['!'] = { 0, 1 }, ['%'] = { 1, 1 }, ['&'] = { 2, 2 }, ['*'] = { 4, 1 }, ['+'] = { 5, 1 }, ['-'] = { 6, 1 }, ['/'] = { 7, 1 }, ['<'] = { 8, 3 }, ['='] = { 11, 1 }, ['>'] = { 12, 3 }, ['^'] = { 15, 1 }, ['|'] = { 16, 2 }, 
     };
-    
-#define NUM_BO_DISPS 4
-    static const uint32_t _bo_disps[NUM_BO_DISPS][2] = 
-        { { 1, 6 }, { 10, 11 }, { 2, 0 }, { 1, 2 },  };
-    static const char* _bo_hashkey = "\x00\x00\x00\x00\x00\x00\x00\x00\x01\x9a\x8aq\xc9.$8";
 
-    uint64_t hash = thirdparty_siphash24(&in, sizeof(in), _bo_hashkey);
-    const uint32_t lower = hash & 0xffffffff;
-    const uint32_t upper = (hash >> 32) & 0xffffffff;
+    const unsigned char first = in & 0xff;
+    for (size_t i = firsts[first].start; i < firsts[first].start + firsts[first].count; i++) {
+        if (entries[i]._0 == in) {
+            return entries[i]._1;
+        }
+    }
+    return Bo_Invalid;
+}
 
-    const uint32_t g = (lower >> 16);
-    const uint32_t f1 = lower;
-    const uint32_t f2 = upper;
+static inline BinaryOp binary_op_resolve_mulshift(uint32_t in) {
+    // empty slots hold a key no lookup hits, mapped to the invalid value
+    static const struct _binary_op_resolve_entry { uint32_t _0; BinaryOp _1; } table[32] = {
+        { 0x00003d3e, Bo_Ge },
+        { 0x00003c3c, Bo_Shl },
+        { 0x0000002a, Bo_Mul },
+        { 0x0000007c, Bo_BOr },
+        { 0, Bo_Invalid },
+        { 0x0000002b, Bo_Plus },
+        { 0, Bo_Invalid },
+        { 0x00002626, Bo_And },
+        { 0, Bo_Invalid },
+        { 0x0000002d, Bo_Minus },
+        { 0, Bo_Invalid },
+        { 0, Bo_Invalid },
+        { 0, Bo_Invalid },
+        { 0x0000003c, Bo_Lt },
+        { 0x0000002f, Bo_Div },
+        { 0, Bo_Invalid },
+        { 0, Bo_Invalid },
+        { 0x0000003e, Bo_Gt },
+        { 0, Bo_Invalid },
+        { 0, Bo_Invalid },
+        { 0, Bo_Invalid },
+        { 0x00007c7c, Bo_Or },
+        { 0, Bo_Invalid },
+        { 0x00000025, Bo_Mod },
+        { 0, Bo_Invalid },
+        { 0x00000026, Bo_BAnd },
+        { 0x00003e3e, Bo_Shr },
+        { 0x00003d3c, Bo_Le },
+        { 0x00003d21, Bo_Ne },
+        { 0x0000005e, Bo_BXor },
+        { 0x00003d3d, Bo_Eq },
+        { 0, Bo_Invalid },
+    };
 
-    const uint32_t *d = _bo_disps[(g % NUM_BO_DISPS)];
-    const uint32_t idx = (d[1] + f1 * d[0] + f2) % NUM_ENTRIES_BINARY_OP;
-    const struct _bo_struct_tuple entry = _bo_entries[idx];
+    const uint32_t x = in;
+    const struct _binary_op_resolve_entry entry = table[(uint32_t)(x * 315867175u) >> 27];
 
     if (entry._0 != in) {
         return Bo_Invalid;
     }
     return entry._1;
-
-#undef NUM_BO_DISPS
 }
-#endif //OPERATORS_H_IMPLEMENTATION
+#endif //OPERATORS_H_LOOKUP_STRATEGIES
 
 #define NUM_ENTRIES_ASSIGNMENT_OP 14
 
@@ -190,48 +329,180 @@ AssignmentOp assignment_op_resolve(uint32_t in);
 #ifdef   OPERATORS_H_IMPLEMENTATION
 OPERATORS_H_PREFIX
 AssignmentOp assignment_op_resolve(uint32_t in) {
-    static const struct _ao_struct_tuple { uint32_t _0; AssignmentOp _1; } _ao_entries[NUM_ENTRIES_ASSIGNMENT_OP] = {
-        { 0x003d3e3e, Ao_ShrAssign },
+    // multiply-shift perfect hash, empty slots hold the key 0 and Invalid
+    static const struct _ao_entry { uint32_t _0; AssignmentOp _1; } table[32] = {
+        { 0, Ao_Invalid },
         { 0x00003d2b, Ao_PlusAssign },
-        { 0x00003d2f, Ao_DivAssign },
-        { 0x00003d26, Ao_AndAssign },
-        { 0x003d3c3c, Ao_ShlAssign },
+        { 0x0000003d, Ao_Assign },
+        { 0, Ao_Invalid },
+        { 0, Ao_Invalid },
+        { 0x00003d2a, Ao_MulAssign },
+        { 0x00003d7c, Ao_OrAssign },
+        { 0, Ao_Invalid },
+        { 0, Ao_Invalid },
+        { 0, Ao_Invalid },
+        { 0, Ao_Invalid },
         { 0x003d2626, Ao_BAndAssign },
+        { 0, Ao_Invalid },
         { 0x003d7c7c, Ao_BOrAssign },
+        { 0x00003d2f, Ao_DivAssign },
+        { 0, Ao_Invalid },
+        { 0, Ao_Invalid },
+        { 0x003d3e3e, Ao_ShrAssign },
         { 0x00003d5e, Ao_BXorAssign },
+        { 0x003d3c3c, Ao_ShlAssign },
+        { 0, Ao_Invalid },
+        { 0, Ao_Invalid },
+        { 0, Ao_Invalid },
+        { 0x00003d2d, Ao_MinusAssing },
+        { 0x00003d26, Ao_AndAssign },
+        { 0, Ao_Invalid },
+        { 0, Ao_Invalid },
         { 0x00003d3a, Ao_WalrusAssign },
+        { 0, Ao_Invalid },
         { 0x00003d25, Ao_ModAssign },
+        { 0, Ao_Invalid },
+        { 0, Ao_Invalid },
+    };
+
+    const struct _ao_entry entry = table[(uint32_t)(in * 3667697167u) >> 27];
+    if (entry._0 != in) {
+        return Ao_Invalid;
+    }
+    return entry._1;
+}
+#endif //OPERATORS_H_IMPLEMENTATION
+
+#ifdef   OPERATORS_H_LOOKUP_STRATEGIES
+static inline AssignmentOp assignment_op_resolve_switch(uint32_t in) {
+    switch (in) {
+    case 0x0000003d: return Ao_Assign;
+    case 0x00003d3a: return Ao_WalrusAssign;
+    case 0x00003d2b: return Ao_PlusAssign;
+    case 0x00003d2d: return Ao_MinusAssing;
+    case 0x00003d2a: return Ao_MulAssign;
+    case 0x00003d2f: return Ao_DivAssign;
+    case 0x00003d25: return Ao_ModAssign;
+    case 0x003d7c7c: return Ao_BOrAssign;
+    case 0x003d2626: return Ao_BAndAssign;
+    case 0x00003d5e: return Ao_BXorAssign;
+    case 0x003d3c3c: return Ao_ShlAssign;
+    case 0x003d3e3e: return Ao_ShrAssign;
+    case 0x00003d26: return Ao_AndAssign;
+    case 0x00003d7c: return Ao_OrAssign;
+    }
+    return Ao_Invalid;
+}
+
+static inline AssignmentOp assignment_op_resolve_length(uint32_t in) {
+    static const struct _assignment_op_resolve_entry { uint32_t _0; AssignmentOp _1; } entries[14] = {
         { 0x0000003d, Ao_Assign },
+        { 0x00003d3a, Ao_WalrusAssign },
+        { 0x00003d2b, Ao_PlusAssign },
         { 0x00003d2d, Ao_MinusAssing },
+        { 0x00003d2a, Ao_MulAssign },
+        { 0x00003d2f, Ao_DivAssign },
+        { 0x00003d25, Ao_ModAssign },
+        { 0x00003d5e, Ao_BXorAssign },
+        { 0x00003d26, Ao_AndAssign },
         { 0x00003d7c, Ao_OrAssign },
+        { 0x003d7c7c, Ao_BOrAssign },
+        { 0x003d2626, Ao_BAndAssign },
+        { 0x003d3c3c, Ao_ShlAssign },
+        { 0x003d3e3e, Ao_ShrAssign },
+    };
+    static const struct { uint8_t start; uint8_t count; } lengths[3 + 1] = {
+        [1] = { 0, 1 }, [2] = { 1, 9 }, [3] = { 10, 4 }, 
+    };
+
+    const size_t length = in == 0 ? 0 : 4 - __builtin_clz(in) / 8;
+    if (length > 3) {
+        return Ao_Invalid;
+    }
+    for (size_t i = lengths[length].start; i < lengths[length].start + lengths[length].count; i++) {
+        if (entries[i]._0 == in) {
+            return entries[i]._1;
+        }
+    }
+    return Ao_Invalid;
+}
+
+static inline AssignmentOp assignment_op_resolve_direct(uint32_t in) {
+    static const struct _assignment_op_resolve_entry { uint32_t _0; AssignmentOp _1; } entries[14] = {
+        { 0x00003d25, Ao_ModAssign },
+        { 0x003d2626, Ao_BAndAssign },
+        { 0x00003d26, Ao_AndAssign },
         { 0x00003d2a, Ao_MulAssign },
+        { 0x00003d2b, Ao_PlusAssign },
+        { 0x00003d2d, Ao_MinusAssing },
+        { 0x00003d2f, Ao_DivAssign },
+        { 0x00003d3a, Ao_WalrusAssign },
+        { 0x003d3c3c, Ao_ShlAssign },
+        { 0x0000003d, Ao_Assign },
+        { 0x003d3e3e, Ao_ShrAssign },
+        { 0x00003d5e, Ao_BXorAssign },
+        { 0x003d7c7c, Ao_BOrAssign },
+        { 0x00003d7c, Ao_OrAssign },
+    };
+    static const struct { uint8_t start; uint8_t count; } firsts[256] = {
+        ['%'] = { 0, 1 }, ['&'] = { 1, 2 }, ['*'] = { 3, 1 }, ['+'] = { 4, 1 }, ['-'] = { 5, 1 }, ['/'] = { 6, 1 }, [':'] = { 7, 1 }, ['<'] = { 8, 1 }, ['='] = { 9, 1 }, ['>'] = { 10, 1 }, ['^'] = { 11, 1 }, ['|'] = { 12, 2 }, 
     };
-    
-#define NUM_AO_DISPS 3
-    static const uint32_t _ao_disps[NUM_AO_DISPS][2] = 
-        { { 1, 1 }, { 3, 0 }, { 8, 9 },  };
-    static const char* _ao_hashkey = "\x00\x00\x00\x00\x00\x00\x00\x00P\xdb\xb1\xeb\x9a\xa1K\x95";
 
-    uint64_t hash = thirdparty_siphash24(&in, sizeof(in), _ao_hashkey);
-    const uint32_t lower = hash & 0xffffffff;
-    const uint32_t upper = (hash >> 32) & 0xffffffff;
+    const unsigned char first = in & 0xff;
+    for (size_t i = firsts[first].start; i < firsts[first].start + firsts[first].count; i++) {
+        if (entries[i]._0 == in) {
+            return entries[i]._1;
+        }
+    }
+    return Ao_Invalid;
+}
 
-    const uint32_t g = (lower >> 16);
-    const uint32_t f1 = lower;
-    const uint32_t f2 = upper;
+static inline AssignmentOp assignment_op_resolve_mulshift(uint32_t in) {
+    // empty slots hold a key no lookup hits, mapped to the invalid value
+    static const struct _assignment_op_resolve_entry { uint32_t _0; AssignmentOp _1; } table[32] = {
+        { 0, Ao_Invalid },
+        { 0x00003d2b, Ao_PlusAssign },
+        { 0x0000003d, Ao_Assign },
+        { 0, Ao_Invalid },
+        { 0, Ao_Invalid },
+        { 0x00003d2a, Ao_MulAssign },
+        { 0x00003d7c, Ao_OrAssign },
+        { 0, Ao_Invalid },
+        { 0, Ao_Invalid },
+        { 0, Ao_Invalid },
+        { 0, Ao_Invalid },
+        { 0x003d2626, Ao_BAndAssign },
+        { 0, Ao_Invalid },
+        { 0x003d7c7c, Ao_BOrAssign },
+        { 0x00003d2f, Ao_DivAssign },
+        { 0, Ao_Invalid },
+        { 0, Ao_Invalid },
+        { 0x003d3e3e, Ao_ShrAssign },
+        { 0x00003d5e, Ao_BXorAssign },
+        { 0x003d3c3c, Ao_ShlAssign },
+        { 0, Ao_Invalid },
+        { 0, Ao_Invalid },
+        { 0, Ao_Invalid },
+        { 0x00003d2d, Ao_MinusAssing },
+        { 0x00003d26, Ao_AndAssign },
+        { 0, Ao_Invalid },
+        { 0, Ao_Invalid },
+        { 0x00003d3a, Ao_WalrusAssign },
+        { 0, Ao_Invalid },
+        { 0x00003d25, Ao_ModAssign },
+        { 0, Ao_Invalid },
+        { 0, Ao_Invalid },
+    };
 
-    const uint32_t *d = _ao_disps[(g % NUM_AO_DISPS)];
-    const uint32_t idx = (d[1] + f1 * d[0] + f2) % NUM_ENTRIES_ASSIGNMENT_OP;
-    const struct _ao_struct_tuple entry = _ao_entries[idx];
+    const uint32_t x = in;
+    const struct _assignment_op_resolve_entry entry = table[(uint32_t)(x * 3667697167u) >> 27];
 
     if (entry._0 != in) {
         return Ao_Invalid;
     }
     return entry._1;
-
-#undef NUM_AO_DISPS
 }
-#endif //OPERATORS_H_IMPLEMENTATION
+#endif //OPERATORS_H_LOOKUP_STRATEGIES
 
 #define NUM_ENTRIES_UNARY_OP 5
 
@@ -270,39 +541,105 @@ UnaryOp unary_op_resolve(uint32_t in);
 #ifdef   OPERATORS_H_IMPLEMENTATION
 OPERATORS_H_PREFIX
 UnaryOp unary_op_resolve(uint32_t in) {
-    static const struct _uo_struct_tuple { uint32_t _0; UnaryOp _1; } _uo_entries[NUM_ENTRIES_UNARY_OP] = {
-        { 0x0000002d, Uo_Minus },
+    // multiply-shift perfect hash, empty slots hold the key 0 and Invalid
+    static const struct _uo_entry { uint32_t _0; UnaryOp _1; } table[8] = {
+        { 0x0000007e, Uo_BitwiseNot },
+        { 0, Uo_Invalid },
         { 0x0000002b, Uo_Plus },
+        { 0, Uo_Invalid },
+        { 0x0000002d, Uo_Minus },
+        { 0x0000002a, Uo_Deref },
+        { 0, Uo_Invalid },
+        { 0x00000021, Uo_Not },
+    };
+
+    const struct _uo_entry entry = table[(uint32_t)(in * 2727734613u) >> 29];
+    if (entry._0 != in) {
+        return Uo_Invalid;
+    }
+    return entry._1;
+}
+#endif //OPERATORS_H_IMPLEMENTATION
+
+#ifdef   OPERATORS_H_LOOKUP_STRATEGIES
+static inline UnaryOp unary_op_resolve_switch(uint32_t in) {
+    switch (in) {
+    case 0x0000007e: return Uo_BitwiseNot;
+    case 0x00000021: return Uo_Not;
+    case 0x0000002b: return Uo_Plus;
+    case 0x0000002d: return Uo_Minus;
+    case 0x0000002a: return Uo_Deref;
+    }
+    return Uo_Invalid;
+}
+
+static inline UnaryOp unary_op_resolve_length(uint32_t in) {
+    static const struct _unary_op_resolve_entry { uint32_t _0; UnaryOp _1; } entries[5] = {
         { 0x0000007e, Uo_BitwiseNot },
         { 0x00000021, Uo_Not },
+        { 0x0000002b, Uo_Plus },
+        { 0x0000002d, Uo_Minus },
         { 0x0000002a, Uo_Deref },
     };
-    
-#define NUM_UO_DISPS 1
-    static const uint32_t _uo_disps[NUM_UO_DISPS][2] = 
-        { { 0, 0 },  };
-    static const char* _uo_hashkey = "\x00\x00\x00\x00\x00\x00\x00\x00D\x09~\x15\xca\xf7\xe3p";
+    static const struct { uint8_t start; uint8_t count; } lengths[1 + 1] = {
+        [1] = { 0, 5 }, 
+    };
 
-    uint64_t hash = thirdparty_siphash24(&in, sizeof(in), _uo_hashkey);
-    const uint32_t lower = hash & 0xffffffff;
-    const uint32_t upper = (hash >> 32) & 0xffffffff;
+    const size_t length = in == 0 ? 0 : 4 - __builtin_clz(in) / 8;
+    if (length > 1) {
+        return Uo_Invalid;
+    }
+    for (size_t i = lengths[length].start; i < lengths[length].start + lengths[length].count; i++) {
+        if (entries[i]._0 == in) {
+            return entries[i]._1;
+        }
+    }
+    return Uo_Invalid;
+}
 
-    const uint32_t g = (lower >> 16);
-    const uint32_t f1 = lower;
-    const uint32_t f2 = upper;
+static inline UnaryOp unary_op_resolve_direct(uint32_t in) {
+    static const struct _unary_op_resolve_entry { uint32_t _0; UnaryOp _1; } entries[5] = {
+        { 0x00000021, Uo_Not },
+        { 0x0000002a, Uo_Deref },
+        { 0x0000002b, Uo_Plus },
+        { 0x0000002d, Uo_Minus },
+        { 0x0000007e, Uo_BitwiseNot },
+    };
+    static const struct { uint8_t start; uint8_t count; } firsts[256] = {
+        ['!'] = { 0, 1 }, ['*'] = { 1, 1 }, ['+'] = { 2, 1 }, ['-'] = { 3, 1 }, ['~'] = { 4, 1 }, 
+    };
 
-    const uint32_t *d = _uo_disps[(g % NUM_UO_DISPS)];
-    const uint32_t idx = (d[1] + f1 * d[0] + f2) % NUM_ENTRIES_UNARY_OP;
-    const struct _uo_struct_tuple entry = _uo_entries[idx];
+    const unsigned char first = in & 0xff;
+    for (size_t i = firsts[first].start; i < firsts[first].start + firsts[first].count; i++) {
+        if (entries[i]._0 == in) {
+            return entries[i]._1;
+        }
+    }
+    return Uo_Invalid;
+}
+
+static inline UnaryOp unary_op_resolve_mulshift(uint32_t in) {
+    // empty slots hold a key no lookup hits, mapped to the invalid value
+    static const struct _unary_op_resolve_entry { uint32_t _0; UnaryOp _1; } table[8] = {
+        { 0x0000007e, Uo_BitwiseNot },
+        { 0, Uo_Invalid },
+        { 0x0000002b, Uo_Plus },
+        { 0, Uo_Invalid },
+        { 0x0000002d, Uo_Minus },
+        { 0x0000002a, Uo_Deref },
+        { 0, Uo_Invalid },
+        { 0x00000021, Uo_Not },
+    };
+
+    const uint32_t x = in;
+    const struct _unary_op_resolve_entry entry = table[(uint32_t)(x * 2727734613u) >> 29];
 
     if (entry._0 != in) {
         return Uo_Invalid;
     }
     return entry._1;
-
-#undef NUM_UO_DISPS
 }
-#endif //OPERATORS_H_IMPLEMENTATION
+#endif //OPERATORS_H_LOOKUP_STRATEGIES
 
 bool check_is_punctuator(const char * in);
 
@@ -310,15 +647,15 @@ bool check_is_punctuator(const char * in);
 OPERATORS_H_PREFIX
 bool check_is_punctuator(const char * in) {
     static const char * set_elements[48] = {
-        "[", "/=", "/", ";", ">>", "->", "+=", "=", "%", "|=", "<<", "*", "-=", ",", "<=", ".", "&", "<", ">", "*=", "^=", "==", "&=", "!=", ":", "|", "||", ">=", "~", ">>=", ":=", "]", "?", ")", "::", "^", "+", "<<=", "%=", "}", "&&=", "..", "&&", "||=", "-", "{", "!", "(", 
+        "->", "{", "+=", "<<", ")", "&", ">>=", "(", "/=", ",", "}", "[", ";", "!", "-=", "..", "<=", ">>", "=", ":", "|=", "+", "||=", "~", "?", "^", ":=", "&&=", "^=", "|", "!=", ">=", ">", "::", "==", "<", "&=", "&&", "%=", "%", "||", "*=", "<<=", "-", ".", "*", "]", "/", 
     };
 
 #define N_DISPS 10
     static const uint32_t displacements[N_DISPS][2] = 
-        { { 0, 8 }, { 0, 41 }, { 0, 8 }, { 0, 15 }, { 1, 5 }, { 4, 7 }, { 0, 36 }, { 1, 8 }, { 33, 14 }, { 0, 0 },  };
-    static const char* _check_is_punctuator_hashkey = "\x00\x00\x00\x00\x00\x00\x00\x00\xb9\x9d\xe1\xceY\x19lN";
+        { { 1, 20 }, { 0, 27 }, { 0, 38 }, { 0, 20 }, { 1, 1 }, { 3, 45 }, { 0, 8 }, { 0, 0 }, { 0, 35 }, { 0, 6 },  };
+    static const uint64_t _check_is_punctuator_hashkey = 0x29211146a295ed55ull;
 
-    uint64_t hash = thirdparty_siphash24(in, strlen(in), _check_is_punctuator_hashkey);
+    uint64_t hash = hash_bytes(in, strlen(in), _check_is_punctuator_hashkey);
     const uint32_t lower = hash & 0xffffffff;
     const uint32_t upper = (hash >> 32) & 0xffffffff;
 
@@ -335,6 +672,386 @@ bool check_is_punctuator(const char * in) {
 }
 #endif //OPERATORS_H_IMPLEMENTATION
 
+#ifdef   OPERATORS_H_LOOKUP_STRATEGIES
+static inline bool check_is_punctuator_switch(const char * in) {
+    switch (in[0]) {
+    case '!':
+        if (strcmp(in, "!") == 0) return true;
+        if (strcmp(in, "!=") == 0) return true;
+        break;
+    case '%':
+        if (strcmp(in, "%") == 0) return true;
+        if (strcmp(in, "%=") == 0) return true;
+        break;
+    case '&':
+        if (strcmp(in, "&") == 0) return true;
+        if (strcmp(in, "&&") == 0) return true;
+        if (strcmp(in, "&&=") == 0) return true;
+        if (strcmp(in, "&=") == 0) return true;
+        break;
+    case '(':
+        if (strcmp(in, "(") == 0) return true;
+        break;
+    case ')':
+        if (strcmp(in, ")") == 0) return true;
+        break;
+    case '*':
+        if (strcmp(in, "*") == 0) return true;
+        if (strcmp(in, "*=") == 0) return true;
+        break;
+    case '+':
+        if (strcmp(in, "+") == 0) return true;
+        if (strcmp(in, "+=") == 0) return true;
+        break;
+    case ',':
+        if (strcmp(in, ",") == 0) return true;
+        break;
+    case '-':
+        if (strcmp(in, "-") == 0) return true;
+        if (strcmp(in, "-=") == 0) return true;
+        if (strcmp(in, "->") == 0) return true;
+        break;
+    case '.':
+        if (strcmp(in, ".") == 0) return true;
+        if (strcmp(in, "..") == 0) return true;
+        break;
+    case '/':
+        if (strcmp(in, "/") == 0) return true;
+        if (strcmp(in, "/=") == 0) return true;
+        break;
+    case ':':
+        if (strcmp(in, ":") == 0) return true;
+        if (strcmp(in, "::") == 0) return true;
+        if (strcmp(in, ":=") == 0) return true;
+        break;
+    case ';':
+        if (strcmp(in, ";") == 0) return true;
+        break;
+    case '<':
+        if (strcmp(in, "<") == 0) return true;
+        if (strcmp(in, "<<") == 0) return true;
+        if (strcmp(in, "<<=") == 0) return true;
+        if (strcmp(in, "<=") == 0) return true;
+        break;
+    case '=':
+        if (strcmp(in, "=") == 0) return true;
+        if (strcmp(in, "==") == 0) return true;
+        break;
+    case '>':
+        if (strcmp(in, ">") == 0) return true;
+        if (strcmp(in, ">=") == 0) return true;
+        if (strcmp(in, ">>") == 0) return true;
+        if (strcmp(in, ">>=") == 0) return true;
+        break;
+    case '?':
+        if (strcmp(in, "?") == 0) return true;
+        break;
+    case '[':
+        if (strcmp(in, "[") == 0) return true;
+        break;
+    case ']':
+        if (strcmp(in, "]") == 0) return true;
+        break;
+    case '^':
+        if (strcmp(in, "^") == 0) return true;
+        if (strcmp(in, "^=") == 0) return true;
+        break;
+    case '{':
+        if (strcmp(in, "{") == 0) return true;
+        break;
+    case '|':
+        if (strcmp(in, "|") == 0) return true;
+        if (strcmp(in, "|=") == 0) return true;
+        if (strcmp(in, "||") == 0) return true;
+        if (strcmp(in, "||=") == 0) return true;
+        break;
+    case '}':
+        if (strcmp(in, "}") == 0) return true;
+        break;
+    case '~':
+        if (strcmp(in, "~") == 0) return true;
+        break;
+    }
+    return false;
+}
+
+static inline bool check_is_punctuator_length(const char * in) {
+    static const struct _check_is_punctuator_entry { const char * _0; bool _1; } entries[48] = {
+        { "!", true },
+        { "%", true },
+        { "&", true },
+        { "(", true },
+        { ")", true },
+        { "*", true },
+        { "+", true },
+        { ",", true },
+        { "-", true },
+        { ".", true },
+        { "/", true },
+        { ":", true },
+        { ";", true },
+        { "<", true },
+        { "=", true },
+        { ">", true },
+        { "?", true },
+        { "[", true },
+        { "]", true },
+        { "^", true },
+        { "{", true },
+        { "|", true },
+        { "}", true },
+        { "~", true },
+        { "!=", true },
+        { "%=", true },
+        { "&&", true },
+        { "&=", true },
+        { "*=", true },
+        { "+=", true },
+        { "-=", true },
+        { "->", true },
+        { "..", true },
+        { "/=", true },
+        { "::", true },
+        { ":=", true },
+        { "<<", true },
+        { "<=", true },
+        { "==", true },
+        { ">=", true },
+        { ">>", true },
+        { "^=", true },
+        { "|=", true },
+        { "||", true },
+        { "&&=", true },
+        { "<<=", true },
+        { ">>=", true },
+        { "||=", true },
+    };
+    static const struct { uint8_t start; uint8_t count; } lengths[3 + 1] = {
+        [1] = { 0, 24 }, [2] = { 24, 20 }, [3] = { 44, 4 }, 
+    };
+
+    const size_t length = strlen(in);
+    if (length > 3) {
+        return false;
+    }
+    for (size_t i = lengths[length].start; i < lengths[length].start + lengths[length].count; i++) {
+        if (memcmp(entries[i]._0, in, length) == 0) {
+            return entries[i]._1;
+        }
+    }
+    return false;
+}
+
+static inline bool check_is_punctuator_direct(const char * in) {
+    static const struct _check_is_punctuator_entry { const char * _0; bool _1; } entries[48] = {
+        { "!", true },
+        { "!=", true },
+        { "%", true },
+        { "%=", true },
+        { "&", true },
+        { "&&", true },
+        { "&&=", true },
+        { "&=", true },
+        { "(", true },
+        { ")", true },
+        { "*", true },
+        { "*=", true },
+        { "+", true },
+        { "+=", true },
+        { ",", true },
+        { "-", true },
+        { "-=", true },
+        { "->", true },
+        { ".", true },
+        { "..", true },
+        { "/", true },
+        { "/=", true },
+        { ":", true },
+        { "::", true },
+        { ":=", true },
+        { ";", true },
+        { "<", true },
+        { "<<", true },
+        { "<<=", true },
+        { "<=", true },
+        { "=", true },
+        { "==", true },
+        { ">", true },
+        { ">=", true },
+        { ">>", true },
+        { ">>=", true },
+        { "?", true },
+        { "[", true },
+        { "]", true },
+        { "^", true },
+        { "^=", true },
+        { "{", true },
+        { "|", true },
+        { "|=", true },
+        { "||", true },
+        { "||=", true },
+        { "}", true },
+        { "~", true },
+    };
+    static const struct { uint8_t start; uint8_t count; } firsts[256] = {
+        ['!'] = { 0, 2 }, ['%'] = { 2, 2 }, ['&'] = { 4, 4 }, ['('] = { 8, 1 }, [')'] = { 9, 1 }, ['*'] = { 10, 2 }, ['+'] = { 12, 2 }, [','] = { 14, 1 }, ['-'] = { 15, 3 }, ['.'] = { 18, 2 }, ['/'] = { 20, 2 }, [':'] = { 22, 3 }, [';'] = { 25, 1 }, ['<'] = { 26, 4 }, ['='] = { 30, 2 }, ['>'] = { 32, 4 }, ['?'] = { 36, 1 }, ['['] = { 37, 1 }, [']'] = { 38, 1 }, ['^'] = { 39, 2 }, ['{'] = { 41, 1 }, ['|'] = { 42, 4 }, ['}'] = { 46, 1 }, ['~'] = { 47, 1 }, 
+    };
+
+    const unsigned char first = in[0];
+    for (size_t i = firsts[first].start; i < firsts[first].start + firsts[first].count; i++) {
+        if (strcmp(entries[i]._0, in) == 0) {
+            return entries[i]._1;
+        }
+    }
+    return false;
+}
+
+static inline bool check_is_punctuator_mulshift(const char * in) {
+    // empty slots hold a key no lookup hits, mapped to the invalid value
+    static const struct _check_is_punctuator_entry { const char * _0; bool _1; } table[128] = {
+        { "", false },
+        { "(", true },
+        { "", false },
+        { "", false },
+        { "", false },
+        { "", false },
+        { "<=", true },
+        { "", false },
+        { "", false },
+        { "", false },
+        { ";", true },
+        { "/", true },
+        { "", false },
+        { "", false },
+        { "", false },
+        { "~", true },
+        { "", false },
+        { "", false },
+        { "+=", true },
+        { "||=", true },
+        { ">>=", true },
+        { "", false },
+        { "*", true },
+        { "", false },
+        { "", false },
+        { "&&", true },
+        { "", false },
+        { ">=", true },
+        { "", false },
+        { "&=", true },
+        { "", false },
+        { "=", true },
+        { "", false },
+        { "%", true },
+        { "..", true },
+        { "", false },
+        { "", false },
+        { "", false },
+        { "", false },
+        { "-=", true },
+        { "!=", true },
+        { "", false },
+        { "", false },
+        { ",", true },
+        { "|=", true },
+        { "", false },
+        { "::", true },
+        { "{", true },
+        { "", false },
+        { "||", true },
+        { ">>", true },
+        { "", false },
+        { "?", true },
+        { "", false },
+        { "", false },
+        { "", false },
+        { "", false },
+        { "", false },
+        { "", false },
+        { "", false },
+        { "^", true },
+        { "/=", true },
+        { "->", true },
+        { ":", true },
+        { ".", true },
+        { "", false },
+        { "", false },
+        { "", false },
+        { "}", true },
+        { "", false },
+        { "", false },
+        { "", false },
+        { "*=", true },
+        { "", false },
+        { "", false },
+        { ")", true },
+        { "", false },
+        { "", false },
+        { "", false },
+        { "", false },
+        { "", false },
+        { "==", true },
+        { "<<=", true },
+        { "%=", true },
+        { "<", true },
+        { "", false },
+        { "", false },
+        { "", false },
+        { "", false },
+        { "", false },
+        { "", false },
+        { "", false },
+        { "[", true },
+        { "", false },
+        { "", false },
+        { "", false },
+        { "+", true },
+        { "", false },
+        { "", false },
+        { "", false },
+        { "", false },
+        { "", false },
+        { "", false },
+        { "", false },
+        { "", false },
+        { ">", true },
+        { "", false },
+        { "&", true },
+        { "", false },
+        { "", false },
+        { "^=", true },
+        { "", false },
+        { "<<", true },
+        { ":=", true },
+        { "]", true },
+        { "", false },
+        { "", false },
+        { "-", true },
+        { "!", true },
+        { "", false },
+        { "", false },
+        { "", false },
+        { "|", true },
+        { "&&=", true },
+        { "", false },
+        { "", false },
+        { "", false },
+        { "", false },
+    };
+
+    // the first four bytes and the length, see lookup_generator.Entry.fold
+    const size_t length = strlen(in);
+    uint32_t x = 0;
+    memcpy(&x, in, length < 4 ? length : 4);
+    x ^= (uint32_t)length << 24;
+    const struct _check_is_punctuator_entry entry = table[(uint32_t)(x * 2502745779u) >> 25];
+
+    if (strcmp(entry._0, in) != 0) {
+        return false;
+    }
+    return entry._1;
+}
+#endif //OPERATORS_H_LOOKUP_STRATEGIES
 #define L_BRACE '{'
 #define R_BRACE '}'
 #define L_BRACKET '['
@@ -1,20 +1,12 @@
+#include <setjmp.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
 #include "parser.h"
+#include "ast_pool.h"
 #include "dynarray.h"
-
-#define New_Impl(type, expr) \
-    ({ type __value = (expr); heap_alloc(&__value, sizeof(__value)); })
-#define New(expr) (typeof((expr))*)New_Impl(typeof((expr)), (expr))
-
-static
-void *heap_alloc(void* src, size_t size) {
-    void *dest = malloc(size);
-    memcpy(dest, src, size);
-    return dest;
-}
+#include "trace.h"
 
 typedef struct {
     Lex_TokenStream stream;
@@ -41,9 +33,74 @@ typedef struct {
     TreeTriples stack;
 } TokenCursor;
 
+typedef struct {
+    enum {
+        Op_Assignment,
+        Op_Binary
+    } kind;
+    enum {
+        Assoc_Right,
+        Assoc_Left,
+    } accociativity;
+    union {
+        BinaryOp Op_Binary;
+        AssignmentOp Op_Assignment;
+    };
+    int precedence;
+} AssocOp;
+
+static_assert(Assoc_Left == 1, "Assoc_Left = 1");
+
+typedef struct {
+    AssocOp *items;
+    size_t count;
+    size_t capacity;
+} AssocOps;
+
+typedef struct {
+    enum {
+        Prefix_Unary,
+        Prefix_Ref
+    } kind;
+    UnaryOp op;
+    Lex_Pos start;
+    String_View filename;
+} PrefixOp;
+
+typedef struct {
+    PrefixOp *items;
+    size_t count;
+    size_t capacity;
+} PrefixOps;
+
+typedef struct {
+    const char **items;
+    size_t count;
+    size_t capacity;
+} TracedItems;
+
 typedef struct {
     Lex_Token token;
     TokenCursor cursor;
+
+    // owns the nodes and the vectors inside the AST
+    Ast_Pool *pool;
+    // names #if conditions test, NULL for none
+    const Parser_Cfg *cfg;
+
+    // explicit stacks of the expression parser, shared between nested
+    // expressions; every parse_expr_* call only touches the part above the
+    // count it found on entry
+    Ast_Exprs operands;
+    AssocOps operators;
+    PrefixOps prefixes;
+
+    // a syntax error jumps back to parser_parse_source with what was
+    // expected at `token`
+    jmp_buf error_jump;
+    Parser_Error error;
+    // the items whose trace events are open when it does
+    TracedItems traced;
 } Parser;
 
 static inline
@@ -106,6 +163,13 @@ Lex_Token _cursor_next(TokenCursor *c) {
     }
 }
 
+// The current token is the opening delimiter of a tree the cursor already
+// entered, continues after its closing delimiter without looking inside
+static
+void _cursor_skip_delimited(TokenCursor *c) {
+    c->tree_cursor = c->stack.items[--c->stack.count].cursor;
+}
+
 #define _U(v) (void)v
 
 static
@@ -117,9 +181,23 @@ bool is_eof(Parser *p) {
     return p->token.kind == Tk_EOF;
 }
 
+static _Noreturn
+void syntax_error(Parser *p, const char *expected) {
+    p->error.expected = expected;
+    longjmp(p->error_jump, 1);
+}
+
+static _Noreturn
+void syntax_error_kind(Parser *p, Lex_TokenKind expected) {
+    p->error.kind = expected;
+    longjmp(p->error_jump, 1);
+}
+
 static
 Lex_Token expect(Parser *p, Lex_TokenKind kind) {
-    assert(p->token.kind == kind && "Expected something else");
+    if (p->token.kind != kind) {
+        syntax_error_kind(p, kind);
+    }
     Lex_Token ret = p->token;
     next_token(p);
     return ret;
@@ -142,7 +220,7 @@ Ast_Path parse_path(Parser *p) {
         Ast_PathSegment segment = {
             .ident = ident.Tk_Ident.name
         };
-        da_append(&path, segment);
+        arena_da_append(&p->pool->arena, &path, segment);
         if (p->token.kind != ':') {
             span.end = ident.span.end;
             break;
@@ -155,8 +233,8 @@ Ast_Path parse_path(Parser *p) {
 }
 
 Ast_Block *parse_block(Parser *p);
-Ast_Expr *make_block_expr(Ast_Block *block) {
-    return New(create_expr(Block)(block->span, { .block = block }));
+Ast_Expr *make_block_expr(Parser *p, Ast_Block *block) {
+    return ast_new_expr_block(p->pool, block->span, (Ast_BlockExpr) { .block = block });
 }
 
 static
@@ -173,14 +251,14 @@ Ast_Expr *parse_if_expr(Parser *p) {
         .filename = body->span.filename
     };
 
-    Ast_Expr *if_expresssion = New(create_expr(If)(span, { .condition = cond, .if_branch = body }));
+    Ast_Expr *if_expresssion = ast_new_expr_if(p->pool, span, (Ast_IfExpr) { .condition = cond, .if_branch = body });
     if (p->token.kind == Tk_Keyword && p->token.Tk_Keyword.keyword == K_Else) {
         next_token(p); // skip `else`
         Ast_Expr *else_branch = NULL;
         if (p->token.kind == Tk_Keyword && p->token.Tk_Keyword.keyword == K_If)  {
             else_branch = parse_if_expr(p);
         } else {
-            else_branch = make_block_expr(parse_block(p));
+            else_branch = make_block_expr(p, parse_block(p));
         }
         if_expresssion->If.else_block = else_branch;
     }
@@ -198,43 +276,43 @@ Ast_Expr *parse_primary(Parser *p) {
     // TODO: with `lookahead()` check :EnumMember patterns
     switch ((int)token.kind) {
         case Tk_Char:
-            return_defer(New(create_expr(Literal)(token.span, {
+            return_defer(ast_new_expr_literal(p->pool, token.span, (Ast_LiteralExpr) {
                 .kind = L_Char,
                 .wchar = token.Tk_Char.wchar,
-            })));
+            }));
         case Tk_String:
             // TODO: unescape string
-            return_defer(New(create_expr(Literal)(token.span, {
+            return_defer(ast_new_expr_literal(p->pool, token.span, (Ast_LiteralExpr) {
                 .kind = L_String,
                 .string = token.Tk_String.string,
-            })));
+            }));
         case Tk_Number: {
             if (IS_FLOAT_CLASS(token.Tk_Number.nclass)) {
-                return_defer(New(create_expr(Literal)(token.span, {
+                return_defer(ast_new_expr_literal(p->pool, token.span, (Ast_LiteralExpr) {
                     .kind = L_Float,
                     .floating = token.Tk_Number.number.floating,
                     .nclass = token.Tk_Number.nclass
-                })));
+                }));
             }
-            return_defer(New(create_expr(Literal)(token.span, {
+            return_defer(ast_new_expr_literal(p->pool, token.span, (Ast_LiteralExpr) {
                 .kind = L_Integer,
                 .integer = token.Tk_Number.number.integer,
                 .nclass = token.Tk_Number.nclass
-            })));
+            }));
         }
         case Tk_Keyword: {
             Lex_Keyword keyword = token.Tk_Keyword.keyword;
             switch (keyword) {
                 case K_True:
                 case K_False:
-                    return_defer(New(create_expr(Literal)(token.span, {
+                    return_defer(ast_new_expr_literal(p->pool, token.span, (Ast_LiteralExpr) {
                         .kind = L_Boolean,
                         .boolean = keyword == K_True
-                    })));
+                    }));
                 case K_Nil:
-                    return_defer(New(create_expr(Literal)(token.span, {
+                    return_defer(ast_new_expr_literal(p->pool, token.span, (Ast_LiteralExpr) {
                         .kind = L_Nil,
-                    })));
+                    }));
                 case K_If:
                     return parse_if_expr(p);
                 default: break;
@@ -250,19 +328,19 @@ Ast_Expr *parse_primary(Parser *p) {
                 .end = endtoken.span.end,
                 .filename = token.span.filename
             };
-            return New(create_expr(Paren)(span, { .expr = expr }));
+            return ast_new_expr_paren(p->pool, span, (Ast_ParenExpr) { .expr = expr });
         } break;
         case '{': {
             Ast_Block *block = parse_block(p);
-            return New(create_expr(Block)(block->span, { .block = block }));
+            return ast_new_expr_block(p->pool, block->span, (Ast_BlockExpr) { .block = block });
         } break;
         case Tk_Ident: {
             Ast_Path path = parse_path(p);
-            return New(create_expr(Path)(path.span, { .path = path }));
+            return ast_new_expr_path(p->pool, path.span, (Ast_PathExpr) { .path = path });
         } break;
         default: break;
     }
-    assert(false && "SyntaxError: expected string, char, number, boolean, nil or identifier");
+    syntax_error(p, "an expression");
 defer: 
     next_token(p);
     return return_value;
@@ -281,7 +359,7 @@ Ast_Expr *parse_subscript(Parser *p, Ast_Expr *base) {
         .end = end,
         .filename = base->span.filename
     };
-    return New(create_expr(Subscript)(span, { .base = base, .subscript = subscript }));
+    return ast_new_expr_subscript(p->pool, span, (Ast_SubscriptExpr) { .base = base, .subscript = subscript });
 }
 
 static
@@ -294,10 +372,10 @@ Ast_Expr *parse_call(Parser *p, Ast_Expr *base) {
     }
     while (true) {
         Ast_Expr *arg = parse_expr_assoc(p, 0);
-        da_append(&arguments, arg);
+        arena_da_append(&p->pool->arena, &arguments, arg);
         Lex_TokenKind kind = p->token.kind;
         if (kind != ',' && kind != ')') {
-            assert(false && "Expected comma or closing parenthesis");
+            syntax_error(p, "`,` or `)`");
         }
         if (kind == ',') {
             next_token(p);
@@ -316,7 +394,7 @@ end:
         .end = end,
         .filename = base->span.filename
     };
-    return New(create_expr(Call)(span, { .function = base, .arguments = arguments }));
+    return ast_new_expr_call(p->pool, span, (Ast_CallExpr) { .function = base, .arguments = arguments });
 }
 }
 
@@ -341,30 +419,12 @@ Ast_Expr *parse_postfix(Parser *p, Ast_Expr *base, bool *matched) {
                 .end = ident.span.end,
                 .filename = ident.span.filename
             };
-            return New(create_expr(Member)(span, { .expr = base, .ident = ident.Tk_Ident.name }));
+            return ast_new_expr_member(p->pool, span, (Ast_MemberExpr) { .expr = base, .ident = ident.Tk_Ident.name });
         } break;
     }
     return base;
 }
 
-typedef struct {
-    enum {
-        Op_Assignment,
-        Op_Binary
-    } kind;
-    enum {
-        Assoc_Right,
-        Assoc_Left,
-    } accociativity;
-    union {
-        BinaryOp Op_Binary;
-        AssignmentOp Op_Assignment;
-    };
-    int precedence;
-} AssocOp;
-
-static_assert(Assoc_Left == 1, "Assoc_Left = 1");
-
 static
 bool is_associative_operator(Parser *p, AssocOp *op) {
     if (IS_TOKEN_KIND(p->token.kind)) {
@@ -389,38 +449,24 @@ bool is_associative_operator(Parser *p, AssocOp *op) {
     return false;
 }
 
-static
-Ast_Expr *parse_expr_prefix(Parser *p);
-
-static
-Ast_Expr *parse_ref(Parser *p, Lex_Pos start) {
-    // TODO: parse refrence modifier `let`
-    Ast_Expr *expr = parse_expr_prefix(p);
-    Lex_Span span = {
-        .start = start,
-        .end = expr->span.end,
-        .filename = expr->span.filename
-    };
-    return New(create_expr(Refrence)(span, { .expr = expr }));
-}
-
 static
 Ast_Expr *parse_expr_prefix(Parser *p) {
-    Lex_Token starttok = p->token;
-    if (!IS_TOKEN_KIND(p->token.kind)) {
+    size_t base = p->prefixes.count;
+    while (!IS_TOKEN_KIND(p->token.kind)) {
+        Lex_Token starttok = p->token;
+        PrefixOp prefix = {
+            .start = starttok.span.start,
+            .filename = starttok.span.filename
+        };
         UnaryOp unary = unary_op_resolve(p->token.kind);
         if (unary != Uo_Invalid) {
+            prefix.kind = Prefix_Unary;
+            prefix.op = unary;
             next_token(p);
-            Ast_Expr *expr = parse_expr_prefix(p);
-            Lex_Span span = {
-                .start = starttok.span.start,
-                .end = expr->span.end,
-                .filename = starttok.span.filename
-            };
-            return New(create_expr(Unary)(span, { .op = unary, .expr = expr }));
         } else if (p->token.kind == '&') {
+            // TODO: parse refrence modifier `let`
+            prefix.kind = Prefix_Ref;
             next_token(p);
-            return parse_ref(p, starttok.span.start);
         } else if (p->token.kind == DOUBLE_AND) {
             // Don't nex_token() the parser, replace `&&` with two seperate &-s
             Lex_Span span = {
@@ -435,9 +481,13 @@ Ast_Expr *parse_expr_prefix(Parser *p) {
                 .kind = '&',
                 .span = span
             };
-            return parse_ref(p, starttok.span.start);
+            prefix.kind = Prefix_Ref;
+        } else {
+            break;
         }
+        da_append(&p->prefixes, prefix);
     }
+
     Ast_Expr *expr = parse_primary(p);
     while (true) {
         bool matched = false;
@@ -447,12 +497,65 @@ Ast_Expr *parse_expr_prefix(Parser *p) {
         }
     }
 
+    // prefix operators bind tighter the closer they are to the operand
+    while (p->prefixes.count > base) {
+        PrefixOp prefix = p->prefixes.items[--p->prefixes.count];
+        switch (prefix.kind) {
+            case Prefix_Unary: {
+                Lex_Span span = {
+                    .start = prefix.start,
+                    .end = expr->span.end,
+                    .filename = prefix.filename
+                };
+                expr = ast_new_expr_unary(p->pool, span, (Ast_UnaryExpr) { .op = prefix.op, .expr = expr });
+            } break;
+            case Prefix_Ref: {
+                Lex_Span span = {
+                    .start = prefix.start,
+                    .end = expr->span.end,
+                    .filename = expr->span.filename
+                };
+                expr = ast_new_expr_refrence(p->pool, span, (Ast_RefrenceExpr) { .expr = expr });
+            } break;
+        }
+    }
+
     return expr;
 }
 
+static
+void reduce_operator(Parser *p) {
+    AssocOp op = p->operators.items[--p->operators.count];
+    Ast_Expr *rhs = p->operands.items[--p->operands.count];
+    Ast_Expr *lhs = p->operands.items[p->operands.count - 1];
+    Lex_Span span = {
+        .start = lhs->span.start,
+        .end = rhs->span.end,
+        .filename = lhs->span.filename
+    };
+
+    switch (op.kind) {
+        case Op_Assignment: {
+            lhs = ast_new_expr_assign(p->pool, span, (Ast_AssignExpr) { .op = op.Op_Assignment, .lhs = lhs, .rhs = rhs });
+        } break;
+        case Op_Binary: {
+            lhs = ast_new_expr_binary(p->pool, span, (Ast_BinaryExpr) { .op = op.Op_Binary, .lhs = lhs, .rhs = rhs });
+        } break;
+        default:
+            assert(false && "unreachable");
+    };
+    p->operands.items[p->operands.count - 1] = lhs;
+}
+
 static
 Ast_Expr *parse_expr_assoc(Parser *p, int min_prec) {
-    Ast_Expr *lhs = parse_expr_prefix(p);
+    size_t operand_base = p->operands.count;
+    size_t operator_base = p->operators.count;
+
+    // operands are parsed before appending; nested expressions use the
+    // same stack
+    Ast_Expr *operand = parse_expr_prefix(p);
+    da_append(&p->operands, operand);
 
     AssocOp op;
     while (is_associative_operator(p, &op)) {
@@ -464,25 +567,26 @@ Ast_Expr *parse_expr_assoc(Parser *p, int min_prec) {
 
         // TODO: detect chained comparison
 
-        Ast_Expr *rhs = parse_expr_assoc(p, prec + op.accociativity);
-        Lex_Span span = {
-            .start = lhs->span.start,
-            .end = rhs->span.end,
-            .filename = lhs->span.filename
-        };
+        // an operator on the stack owns everything up to the first operator,
+        // that would have been parsed with a lower minimum precedence
+        while (p->operators.count > operator_base) {
+            AssocOp top = p->operators.items[p->operators.count - 1];
+            if (prec >= top.precedence + (int)top.accociativity) {
+                break;
+            }
+            reduce_operator(p);
+        }
 
-        switch (op.kind) {
-            case Op_Assignment: {
-                lhs = New(create_expr(Assign)(span, { .op = op.Op_Assignment, .lhs = lhs, .rhs = rhs }));
-            } break;
-            case Op_Binary: {
-                lhs = New(create_expr(Binary)(span, { .op = op.Op_Binary, .lhs = lhs, .rhs = rhs }));
-            } break;
-            default:
-                assert(false && "unreachable");
-        };
+        da_append(&p->operators, op);
+        operand = parse_expr_prefix(p);
+        da_append(&p->operands, operand);
     }
-    return lhs;
+
+    while (p->operators.count > operator_base) {
+        reduce_operator(p);
+    }
+    assert(p->operands.count == operand_base + 1);
+    return p->operands.items[--p->operands.count];
 }
 
 bool is_block_expr(Ast_ExprKind kind) {
@@ -506,11 +610,11 @@ Ast_Type *parse_type(Parser *p) {
                 .end = end,
                 .filename = token.span.filename
             };
-            return New(create_type(Owned)(span, { .ty = inner }));
+            return ast_new_type_owned(p->pool, span, (Ast_OwnedType) { .ty = inner });
         } break;
         case Tk_Ident: {
             Ast_Path path = parse_path(p);
-            ty = New(create_type(TyPath)(path.span, { .path = path }));
+            ty = ast_new_type_ty_path(p->pool, path.span, (Ast_TyPathType) { .path = path });
         } break;
         case '[': {
             next_token(p);
@@ -529,9 +633,9 @@ Ast_Type *parse_type(Parser *p) {
                 .filename = token.span.filename
             };
             if (is_slice) {
-                return New(create_type(TySlice)(span, { .ty = ty }));
+                return ast_new_type_ty_slice(p->pool, span, (Ast_TySliceType) { .ty = ty });
             } else {
-                return New(create_type(TyArray)(span, { .ty = ty, .size = size }));
+                return ast_new_type_ty_array(p->pool, span, (Ast_TyArrayType) { .ty = ty, .size = size });
             }
         } break;
         case '(': {
@@ -543,11 +647,11 @@ Ast_Type *parse_type(Parser *p) {
                     if (types.count == 0)
                         ty = tuple_arg;
                     else
-                        da_append(&types, tuple_arg);
+                        arena_da_append(&p->pool->arena, &types, tuple_arg);
                     break;
                 } else if (p->token.kind == ',') {
                     next_token(p);
-                    da_append(&types, tuple_arg);
+                    arena_da_append(&p->pool->arena, &types, tuple_arg);
                 }
             }
             Lex_Pos end = p->token.span.end;
@@ -558,7 +662,7 @@ Ast_Type *parse_type(Parser *p) {
                     .end = end,
                     .filename = token.span.filename
                 };
-                ty = New(create_type(TyTuple)(span, { .types = types }));
+                ty = ast_new_type_ty_tuple(p->pool, span, (Ast_TyTupleType) { .types = types });
             }
         } break;
         case '&':
@@ -575,7 +679,7 @@ Ast_Type *parse_type(Parser *p) {
             bool nullable = false;
             if (ty->kind == Nullable_kind) {
                 Ast_Type *inner = ty->Nullable.ty;
-                free(ty);
+                ast_pool_release(p->pool, ty, ast_node_size(Ast_Type, Nullable));
                 ty = inner;
                 nullable = true;
             }
@@ -585,13 +689,12 @@ Ast_Type *parse_type(Parser *p) {
                 .filename = token.span.filename
             };
             if (token.kind == '&') {
-                return New(create_type(Ref)(span, { .ty = ty, .mut = mut, .nullable = nullable }));
+                return ast_new_type_ref(p->pool, span, (Ast_RefType) { .ty = ty, .mut = mut, .nullable = nullable });
             }
-            return New(create_type(Ptr)(span, { .ty = ty, .mut = mut, .nullable = nullable }));
+            return ast_new_type_ptr(p->pool, span, (Ast_PtrType) { .ty = ty, .mut = mut, .nullable = nullable });
         } break; 
         default:
-            assert(false && "Not a valid token to start a type");
-            break;
+            syntax_error(p, "a type");
     }
 
     if (p->token.kind == '(') {
@@ -604,7 +707,7 @@ Ast_Type *parse_type(Parser *p) {
             .end = p->token.span.end,
             .filename = p->token.span.filename,
         };
-        ty = New(create_type(Nullable)(span, { .ty = ty }));
+        ty = ast_new_type_nullable(p->pool, span, (Ast_NullableType) { .ty = ty });
         next_token(p);
     }
 
@@ -614,7 +717,7 @@ Ast_Type *parse_type(Parser *p) {
 Ast_Type *parse_generic(Parser *p, Ast_Type *base) {
     _U(p);
     _U(base);
-    assert(false && "parsing of genric tys not implemented");
+    syntax_error(p, "a type without arguments, generics are not supported");
 }
 
 Ast_Stmt *parse_decl_statement(Parser *p) {
@@ -642,7 +745,7 @@ Ast_Stmt *parse_decl_statement(Parser *p) {
         Lex_Span span = {
             .filename = start.filename
         };
-        type = New(create_type(Inferred)(span, {}));
+        type = ast_new_type_inferred(p->pool, span, (Ast_InferredType) {});
     }
 
     Ast_Expr *init = NULL;
@@ -657,7 +760,7 @@ Ast_Stmt *parse_decl_statement(Parser *p) {
         .end = end,
         .filename = start.filename
     };
-    return New(create_stmt(Decl)(span, { .mut = mut, .ident = ident, .init = init, .type = type }));
+    return ast_new_stmt_decl(p->pool, span, (Ast_DeclStmt) { .mut = mut, .ident = ident, .init = init, .type = type });
 }
 
 Ast_Stmt *parse_stmt(Parser *p) {
@@ -690,7 +793,7 @@ Ast_Stmt *parse_stmt(Parser *p) {
         .end = end,
         .filename = expr->span.filename
     };
-    return New(create_stmt(Expr)(span, { .expr = expr, .semicolon = !block_expr }));
+    return ast_new_stmt_expr(p->pool, span, (Ast_ExprStmt) { .expr = expr, .semicolon = !block_expr });
 }
 
 Ast_Block *parse_block(Parser *p) {
@@ -700,7 +803,7 @@ Ast_Block *parse_block(Parser *p) {
     bool is_empty_block = p->token.kind == '}';
     while (!is_empty_block) {
         Ast_Stmt *stmt = parse_stmt(p);
-        da_append(&stmts, stmt);
+        arena_da_append(&p->pool->arena, &stmts, stmt);
 
         if (p->token.kind == '}') {
             break;
@@ -713,7 +816,7 @@ Ast_Block *parse_block(Parser *p) {
         .end = endspan.end,
         .filename = endspan.filename
     };
-    return New(((Ast_Block) { .stmts = stmts, .span = span }));
+    return ast_new_block(p->pool, span, stmts);
 }
 
 Ast_Item *parse_directive_item(Parser *p) {
@@ -727,38 +830,174 @@ Ast_Item *parse_directive_item(Parser *p) {
                 .end = block->span.end,
                 .filename = token.span.filename
             };
-            return New(create_item(RunBlock)(span, { .block = block }));
+            return ast_new_item_run_block(p->pool, span, (Ast_RunBlockItem) { .block = block });
         } break;
         case D_Open:
-        case D_Include:
+        case D_Include: {
+            // #include "file"; or #open "file";, the path is relative to
+            // the directory of the current file, see modules.h
+            next_token(p);
+            String_Builder path = expect(p, Tk_String).Tk_String.string;
+            Lex_Span span = {
+                .start = token.span.start,
+                .end = expect(p, ';').span.end,
+                .filename = token.span.filename
+            };
+            if (token.Tk_Directive.directive == D_Include) {
+                return ast_new_item_include(p->pool, span, (Ast_IncludeItem) { .path = path });
+            }
+            return ast_new_item_open(p->pool, span, (Ast_OpenItem) { .path = path });
+        } break;
         case D_If:
-            assert(false && "#open, #include and #if not implemented yet");
+            assert(false && "#if is handled by parse_items");
             break;
         default:
             assert(false && "Unreachable");
     }
 }
 
-Ast_Source parse_source(Parser *p) {
-    Ast_Source source = {0};
+static
+bool _cfg_enabled(Parser *p, String_Builder name) {
+    if (p->cfg == NULL) {
+        return false;
+    }
+    for (size_t i = 0; i < p->cfg->count; i++) {
+        const char *cfg = p->cfg->items[i];
+        if (strlen(cfg) == name.count && memcmp(cfg, name.items, name.count) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static
+bool parse_cfg_or(Parser *p);
+
+// not := '!' not | '(' or ')' | ident
+static
+bool parse_cfg_not(Parser *p) {
+    if (p->token.kind == '!') {
+        next_token(p);
+        return !parse_cfg_not(p);
+    }
+    if (p->token.kind == '(') {
+        next_token(p);
+        bool result = parse_cfg_or(p);
+        expect(p, ')');
+        return result;
+    }
+    return _cfg_enabled(p, expect(p, Tk_Ident).Tk_Ident.name);
+}
+
+// and := not ('&&' not)*
+static
+bool parse_cfg_and(Parser *p) {
+    bool result = parse_cfg_not(p);
+    while (binary_op_resolve(p->token.kind) == Bo_And) {
+        next_token(p);
+        // every operand is parsed, there is no short circuit for tokens
+        result = parse_cfg_not(p) && result;
+    }
+    return result;
+}
+
+// or := and ('||' and)*
+static
+bool parse_cfg_or(Parser *p) {
+    bool result = parse_cfg_and(p);
+    while (binary_op_resolve(p->token.kind) == Bo_Or) {
+        next_token(p);
+        result = parse_cfg_and(p) || result;
+    }
+    return result;
+}
+
+static
+void parse_items(Parser *p, Ast_Source *source, Lex_TokenKind end);
+
+// The items of an active region go straight into `source`, an inactive one
+// is skipped as a whole token tree and never parsed
+static
+void parse_cfg_region(Parser *p, Ast_Source *source, bool active) {
+    if (p->token.kind != '{') {
+        syntax_error_kind(p, '{');
+    }
+    if (!active) {
+        _cursor_skip_delimited(&p->cursor);
+        next_token(p);
+        return;
+    }
+    next_token(p);
+    parse_items(p, source, '}');
+    expect(p, '}');
+}
+
+// #if cond { ... } [else #if cond { ... }]* [else { ... }], `taken` if an
+// earlier branch of the chain was active
+static
+void parse_if_directive(Parser *p, Ast_Source *source, bool taken) {
+    next_token(p); // skip #if
+    bool active = parse_cfg_or(p) && !taken;
+    parse_cfg_region(p, source, active);
+    taken |= active;
+
+    if (p->token.kind != Tk_Keyword || p->token.Tk_Keyword.keyword != K_Else) {
+        return;
+    }
+    next_token(p);
+    if (p->token.kind == Tk_Directive && p->token.Tk_Directive.directive == D_If) {
+        parse_if_directive(p, source, taken);
+        return;
+    }
+    parse_cfg_region(p, source, !taken);
+}
+
+static
+void parse_items(Parser *p, Ast_Source *source, Lex_TokenKind end) {
     while (true) {
         Lex_Token token = p->token;
-        if (token.kind == Tk_EOF) {
+        if (token.kind == end) {
             break;
         }
         switch ((int)token.kind) {
             case Tk_Directive: {
-                Ast_Item *item = parse_directive_item(p);
-                da_append(&source, item);
+                const char *name = directive_to_string(token.Tk_Directive.directive);
+                da_append(&p->traced, name);
+                TRACE_BEGIN("item", name);
+                if (token.Tk_Directive.directive == D_If) {
+                    parse_if_directive(p, source, false);
+                } else {
+                    Ast_Item *item = parse_directive_item(p);
+                    arena_da_append(&p->pool->arena, source, item);
+                }
+                TRACE_END("item", name);
+                p->traced.count--;
             } break;
             default:
-                assert(false && "Unkown token at top-level of module");
+                syntax_error(p, "a directive");
         }
     }
+}
+
+Ast_Source parse_source(Parser *p) {
+    Ast_Source source = {0};
+    parse_items(p, &source, Tk_EOF);
     return source;
 }
 
-Ast_Source parser_parse_source(Lex_TokenStream stream) {
+// Apart from parser_parse_source, whose locals would be indeterminate after
+// the jump
+static
+bool _parse_or_jump(Parser *p, Ast_Source *source) {
+    if (setjmp(p->error_jump) != 0) {
+        return false;
+    }
+    next_token(p);
+    *source = parse_source(p);
+    return true;
+}
+
+bool parser_parse_source(Ast_Pool *pool, Lex_TokenStream stream, const Parser_Cfg *cfg, Ast_Source *source, Parser_Error *error) {
     Parser p = {
         .token = {
             .kind = Tk_INIT,
@@ -767,9 +1006,51 @@ Ast_Source parser_parse_source(Lex_TokenStream stream) {
         .cursor = {
             .tree_cursor = { .stream = stream, .item = 0 },
             .stack = {0}
-        }
+        },
+        .pool = pool,
+        .cfg = cfg,
+        .error = { .kind = Tk_INIT }
     };
-    next_token(&p);
-    return parse_source(&p);
+    bool success = _parse_or_jump(&p, source);
+    if (!success) {
+        // not within TRACE_END, which expands to nothing in plain builds
+        while (p.traced.count > 0) {
+            p.traced.count--;
+            TRACE_END("item", p.traced.items[p.traced.count]);
+        }
+        p.error.found = p.token.kind;
+        if (p.token.kind == Tk_Error) {
+            p.error.lex_error = p.token.Tk_Error.error;
+        }
+        p.error.span = p.token.span;
+        *error = p.error;
+        // the nodes parsed so far stay in the pool until it is reset
+        *source = (Ast_Source) {0};
+    }
+
+    free(p.cursor.stack.items);
+    free(p.operands.items);
+    free(p.operators.items);
+    free(p.prefixes.items);
+    free(p.traced.items);
+    return success;
+}
+
+void parser_print_error(Writer *w, Parser_Error *error) {
+    if (error->found == Tk_Error) {
+        lexer_print_error(w, &error->lex_error);
+        return;
+    }
+    writer_cstr(w, "Expected ");
+    if (error->expected != NULL) {
+        writer_cstr(w, error->expected);
+    } else {
+        writer_char(w, '`');
+        lexer_print_kind(w, error->kind);
+        writer_char(w, '`');
+    }
+    writer_cstr(w, ", found `");
+    lexer_print_kind(w, error->found);
+    writer_char(w, '`');
 }
 
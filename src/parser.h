@@ -2,8 +2,34 @@
 #define PARSER_H_
 
 #include "AST.h"
+#include "ast_pool.h"
 #include "lexer.h"
 
-Ast_Source parser_parse_source(Lex_TokenStream stream);
+// The names set with --cfg, an `#if` condition is true for the ones in here
+typedef struct {
+    const char **items;
+    size_t count;
+    size_t capacity;
+} Parser_Cfg;
+
+// The first syntax error, parsing stops there
+typedef struct {
+    // what was expected, described or else the token `kind`
+    const char *expected;
+    Lex_TokenKind kind;
+    Lex_TokenKind found;
+    // of an Error token, which is reported instead
+    Lex_Error lex_error;
+    Lex_Span span;
+} Parser_Error;
+
+// The nodes of the tree and the vectors inside them are allocated in
+// `pool`. The inactive regions of `#if` are skipped by their token tree,
+// the items of the active ones take the place of the `#if`. `cfg` may be
+// NULL if nothing is set. A syntax error leaves `source` empty, the pool
+// has to be reset all the same.
+bool parser_parse_source(Ast_Pool *pool, Lex_TokenStream stream, const Parser_Cfg *cfg, Ast_Source *source, Parser_Error *error);
+// Without the span, like lexer_print_error
+void parser_print_error(Writer *w, Parser_Error *error);
 
 #endif // PRASER_H_
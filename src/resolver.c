@@ -0,0 +1,203 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "dynarray.h"
+#include "metrics.h"
+#include "resolver.h"
+
+// Fibonacci hashing, the interned pointers differ in their low bits only
+// and the high bits of the product depend on all of them
+static inline
+size_t _slot_of(Resolver *resolver, const char *symbol) {
+    uint64_t hash = (uint64_t)(uintptr_t)symbol * 0x9e3779b97f4a7c15ull;
+    return hash >> resolver->shift;
+}
+
+// Slots between the home slot of `symbol` and `entry`
+static inline
+size_t _distance(Resolver *resolver, const char *symbol, Resolver_Entry *entry) {
+    size_t slot = entry - resolver->entries;
+    return (slot - _slot_of(resolver, symbol)) & (resolver->capacity - 1);
+}
+
+// The slot of `symbol` or the empty slot it would go into
+static
+Resolver_Entry *_probe(Resolver *resolver, const char *symbol) {
+    size_t mask = resolver->capacity - 1;
+    size_t slot = _slot_of(resolver, symbol);
+    while (true) {
+        Resolver_Entry *entry = &resolver->entries[slot];
+        if (entry->symbol == symbol || entry->symbol == NULL) {
+            return entry;
+        }
+        slot = (slot + 1) & mask;
+    }
+}
+
+static
+void _grow(Resolver *resolver) {
+    Resolver_Entry *entries = resolver->entries;
+    size_t capacity = resolver->capacity;
+    resolver->capacity = capacity == 0 ? RESOLVER_INIT_CAP : capacity * 2;
+    resolver->shift = 64 - __builtin_ctzll(resolver->capacity);
+    resolver->entries = calloc(resolver->capacity, sizeof(Resolver_Entry));
+    assert(resolver->entries != NULL && "Buy more RAM lol");
+    resolver->count = 0;
+    for (size_t i = 0; i < capacity; i++) {
+        if (entries[i].symbol != NULL) {
+            *_probe(resolver, entries[i].symbol) = entries[i];
+            resolver->count++;
+        }
+    }
+    free(entries);
+}
+
+static
+void _declare(Resolver *resolver, Ast_Stmt *decl) {
+    // kept at most a quarter full, only the names in scope are in the table
+    // so it stays small anyway
+    if (4 * (resolver->count + 1) > resolver->capacity) {
+        _grow(resolver);
+    }
+    const char *symbol = decl->Decl.ident.items;
+    Resolver_Entry *entry = _probe(resolver, symbol);
+    // NULL for a new entry
+    if (entry->symbol == NULL) {
+        entry->symbol = symbol;
+        resolver->count++;
+    }
+    Resolver_Undo undo = { .symbol = symbol, .shadowed = entry->decl };
+    da_append(&resolver->undo, undo);
+    entry->decl = decl;
+}
+
+// Backward shift deletion: the entries after `entry` in its cluster move up
+// into the hole if that is not before their home slot, so no tombstones
+// are left behind for later probes to walk over
+static
+void _remove(Resolver *resolver, Resolver_Entry *entry) {
+    size_t mask = resolver->capacity - 1;
+    size_t hole = entry - resolver->entries;
+    size_t slot = hole;
+    while (true) {
+        slot = (slot + 1) & mask;
+        Resolver_Entry *next = &resolver->entries[slot];
+        if (next->symbol == NULL) {
+            break;
+        }
+        size_t home = _slot_of(resolver, next->symbol);
+        // home not cyclically in (hole, slot]
+        if (((slot - home) & mask) >= ((slot - hole) & mask)) {
+            resolver->entries[hole] = *next;
+            hole = slot;
+        }
+    }
+    resolver->entries[hole] = (Resolver_Entry) {0};
+    resolver->count--;
+}
+
+// Names whose last declaration goes out of scope leave the table, so it
+// only ever holds the names in scope
+static
+void _pop_scope(Resolver *resolver) {
+    size_t start = resolver->scopes.items[--resolver->scopes.count];
+    while (resolver->undo.count > start) {
+        Resolver_Undo undo = resolver->undo.items[--resolver->undo.count];
+        Resolver_Entry *entry = _probe(resolver, undo.symbol);
+        if (undo.shadowed == NULL) {
+            _remove(resolver, entry);
+        } else {
+            entry->decl = undo.shadowed;
+        }
+    }
+}
+
+static
+void _resolve_path(Resolver *resolver, Ast_Path *path) {
+    if (path->count != 1) {
+        return;
+    }
+    resolver->uses++;
+    const char *symbol = path->items[0].ident.items;
+    Resolver_Entry *entry = _probe(resolver, symbol);
+    resolver->probes += _distance(resolver, symbol, entry) + 1;
+    path->decl = entry->decl;
+    if (path->decl == NULL) {
+        da_append(&resolver->unresolved, path);
+    }
+}
+
+static
+Ast_VisitResult _resolver_pre(Ast_Visitor *visitor, Ast_Node node) {
+    Resolver *resolver = visitor->data;
+    switch (node.klass) {
+        case Node_Block:
+            da_append(&resolver->scopes, resolver->undo.count);
+            break;
+        case Node_Expr:
+            if (node.expr->kind == Path_kind) {
+                _resolve_path(resolver, &node.expr->Path.path);
+            }
+            break;
+        case Node_Type:
+            // type names are not local
+            return Visit_Skip;
+        case Node_Stmt:
+        case Node_Item:
+            break;
+    }
+    return Visit_Continue;
+}
+
+// A Decl is declared once its initializer and type were resolved, so
+// `let x = x;` refers to the outer `x`
+static
+Ast_VisitResult _resolver_post(Ast_Visitor *visitor, Ast_Node node) {
+    Resolver *resolver = visitor->data;
+    if (node.klass == Node_Block) {
+        _pop_scope(resolver);
+    } else if (node.klass == Node_Stmt && node.stmt->kind == Decl_kind) {
+        _declare(resolver, node.stmt);
+    }
+    return Visit_Continue;
+}
+
+bool resolve_source(Resolver *resolver, Ast_Source *source, Writer *err) {
+    if (resolver->capacity == 0) {
+        _grow(resolver);
+    }
+    resolver->undo.count = 0;
+    resolver->scopes.count = 0;
+    resolver->unresolved.count = 0;
+    resolver->uses = 0;
+    resolver->probes = 0;
+
+    resolver->visitor.pre = _resolver_pre;
+    resolver->visitor.post = _resolver_post;
+    resolver->visitor.data = resolver;
+    ast_walk_source(&resolver->visitor, source);
+    // every name was declared in a block, the names of this source are gone
+    // before the next one is interned
+    assert(resolver->scopes.count == 0 && resolver->count == 0 && "unbalanced scopes");
+    METRICS_COUNT_RESOLVE(resolver->uses, resolver->probes);
+
+    for (size_t i = 0; i < resolver->unresolved.count; i++) {
+        Ast_Path *path = resolver->unresolved.items[i];
+        writer_cstr(err, "ERROR: Unresolved name `");
+        ast_print_path(err, path);
+        writer_cstr(err, "` at ");
+        lexer_print_span(err, path->span);
+        writer_char(err, '\n');
+    }
+    return resolver->unresolved.count == 0;
+}
+
+void resolver_free(Resolver *resolver) {
+    free(resolver->entries);
+    free(resolver->undo.items);
+    free(resolver->scopes.items);
+    free(resolver->unresolved.items);
+    ast_visitor_free(&resolver->visitor);
+    *resolver = (Resolver) {0};
+}
@@ -0,0 +1,75 @@
+#ifndef RESOLVER_H_
+#define RESOLVER_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "AST.h"
+#include "visitor.h"
+#include "writer.h"
+
+#define RESOLVER_INIT_CAP 256
+
+// The innermost Decl of `symbol`
+typedef struct {
+    // interned, so names compare by pointer
+    const char *symbol;
+    Ast_Stmt *decl;
+} Resolver_Entry;
+
+// Undoes a declaration when its scope is popped
+typedef struct {
+    const char *symbol;
+    // the binding the declaration shadowed, NULL if there was none
+    Ast_Stmt *shadowed;
+} Resolver_Undo;
+
+typedef struct {
+    Resolver_Undo *items;
+    size_t count;
+    size_t capacity;
+} Resolver_UndoLog;
+
+typedef struct {
+    size_t *items;
+    size_t count;
+    size_t capacity;
+} Resolver_Scopes;
+
+typedef struct {
+    Ast_Path **items;
+    size_t count;
+    size_t capacity;
+} Resolver_Paths;
+
+// Binds the local names in the #entrypoint blocks to their Decl. There is a
+// single open addressing table for all scopes that maps every name to its
+// innermost declaration. Pushing a scope only remembers the length of the
+// undo log and popping it replays the log back to there, so blocks neither
+// allocate nor copy tables and a use costs one lookup however deep it is
+// nested. A resolver is meant to be reused for many sources.
+typedef struct {
+    Resolver_Entry *entries;
+    size_t count;
+    size_t capacity;
+    // 64 - log2(capacity)
+    int shift;
+
+    Resolver_UndoLog undo;
+    // undo log length at the start of every open block
+    Resolver_Scopes scopes;
+    Resolver_Paths unresolved;
+    Ast_Visitor visitor;
+
+    // the single segment paths and the slots probed to look them up
+    size_t uses;
+    size_t probes;
+} Resolver;
+
+// Sets `decl` of every single segment Path in `source`, the names that are
+// not declared are reported to `err`. Paths with more segments name things
+// outside of the function and are left alone.
+bool resolve_source(Resolver *resolver, Ast_Source *source, Writer *err);
+void resolver_free(Resolver *resolver);
+
+#endif // RESOLVER_H_
@@ -0,0 +1,443 @@
+#include <assert.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "ast_pool.h"
+#include "dynarray.h"
+#include "hash.h"
+#include "lexer.h"
+#include "parser.h"
+#include "server.h"
+
+#define SERVER_EMIT_KINDS (Emit_AstBin + 1)
+#define SERVER_TABLE_INIT_CAP 256
+#define SERVER_HASH_SEED 0x62616e67736f7572ull
+// distinct identifiers, past that every entry is parsed anew
+#define SERVER_INTERN_LIMIT (1 << 16)
+
+typedef struct {
+    char *path;
+    uint64_t path_hash;
+
+    // of `content`, an entry is only valid once it was checked
+    bool checked;
+    uint64_t hash;
+    String_Builder content;
+
+    // false if the content does not tokenize or parse, the error is in
+    // `outputs` and there is no stream
+    bool success;
+    Lex_TokenStream stream;
+    Ast_Pool pool;
+    Ast_Source source;
+
+    // rendered on first request per emit kind
+    String_Builder outputs[SERVER_EMIT_KINDS];
+    bool rendered[SERVER_EMIT_KINDS];
+} Server_Entry;
+
+typedef struct {
+    Server_Entry **items;
+    size_t count;
+    size_t capacity;
+} Server_Entries;
+
+typedef struct {
+    Server_Entries entries;
+    // open addressing on `path_hash`, entry index + 1 and 0 for empty slots
+    size_t *slots;
+    size_t slots_capacity;
+
+    // the next read, swapped with the content of an entry that changed
+    String_Builder scratch;
+    String_Builder out;
+    String_Builder err;
+    Writer writer;
+} Server;
+
+static volatile sig_atomic_t server_stop;
+// for _handle_crash, which can not get at anything else
+static char server_socket_path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+
+static
+void _handle_stop(int signal) {
+    (void)signal;
+    server_stop = 1;
+}
+
+// Installed with SA_RESETHAND, raising the signal again ends the process
+// the way it would have without the handler
+static
+void _handle_crash(int signal) {
+    unlink(server_socket_path);
+    raise(signal);
+}
+
+static
+bool _read_all(int fd, void *data, size_t count) {
+    char *cursor = data;
+    while (count > 0) {
+        ssize_t result = read(fd, cursor, count);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            return false;
+        }
+        cursor += result;
+        count -= result;
+    }
+    return true;
+}
+
+static
+bool _write_all(int fd, const void *data, size_t count) {
+    const char *cursor = data;
+    while (count > 0) {
+        ssize_t result = write(fd, cursor, count);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result < 0) {
+            return false;
+        }
+        cursor += result;
+        count -= result;
+    }
+    return true;
+}
+
+static
+void _table_insert(Server *server, uint64_t hash, size_t index) {
+    size_t mask = server->slots_capacity - 1;
+    size_t slot = hash & mask;
+    while (server->slots[slot] != 0) {
+        slot = (slot + 1) & mask;
+    }
+    server->slots[slot] = index + 1;
+}
+
+static
+void _table_grow(Server *server) {
+    free(server->slots);
+    server->slots_capacity = server->slots_capacity == 0 ? SERVER_TABLE_INIT_CAP : server->slots_capacity * 2;
+    server->slots = calloc(server->slots_capacity, sizeof(size_t));
+    assert(server->slots != NULL && "Buy more RAM lol");
+    for (size_t i = 0; i < server->entries.count; i++) {
+        _table_insert(server, server->entries.items[i]->path_hash, i);
+    }
+}
+
+static
+Server_Entry *_find_entry(Server *server, const char *path) {
+    size_t length = strlen(path);
+    uint64_t hash = hash_bytes(path, length, SERVER_HASH_SEED);
+    if (server->slots_capacity > 0) {
+        size_t mask = server->slots_capacity - 1;
+        for (size_t slot = hash & mask; server->slots[slot] != 0; slot = (slot + 1) & mask) {
+            Server_Entry *entry = server->entries.items[server->slots[slot] - 1];
+            if (entry->path_hash == hash && strcmp(entry->path, path) == 0) {
+                return entry;
+            }
+        }
+    }
+
+    // kept at most half full
+    if (2 * (server->entries.count + 1) > server->slots_capacity) {
+        _table_grow(server);
+    }
+    Server_Entry *entry = calloc(1, sizeof(Server_Entry));
+    assert(entry != NULL && "Buy more RAM lol");
+    entry->path = strdup(path);
+    entry->path_hash = hash;
+    da_append(&server->entries, entry);
+    _table_insert(server, hash, server->entries.count - 1);
+    return entry;
+}
+
+static
+void _release_entry(Server_Entry *entry) {
+    if (entry->checked && entry->success) {
+        lexer_token_stream_free(&entry->stream);
+        ast_pool_reset(&entry->pool);
+    }
+    entry->checked = false;
+}
+
+// The names in the streams and trees of every entry are interned in one
+// table, which is only released once no entry is left to point into it
+static
+void _release_interned(Server *server) {
+    for (size_t i = 0; i < server->entries.count; i++) {
+        _release_entry(server->entries.items[i]);
+    }
+    lexer_free_interned();
+}
+
+// The same diagnostic for every emit kind
+static
+void _fail_entry(Server_Entry *entry) {
+    for (size_t i = 1; i < SERVER_EMIT_KINDS; i++) {
+        da_append_many(&entry->outputs[i], entry->outputs[0].items, entry->outputs[0].count);
+    }
+    memset(entry->rendered, true, sizeof(entry->rendered));
+}
+
+static
+void _update_entry(Server *server, Server_Entry *entry, uint64_t hash) {
+    if (lexer_interned_count() > SERVER_INTERN_LIMIT) {
+        _release_interned(server);
+    }
+    _release_entry(entry);
+    // the old content goes back to be the next scratch buffer
+    String_Builder content = entry->content;
+    entry->content = server->scratch;
+    server->scratch = content;
+
+    entry->checked = true;
+    entry->hash = hash;
+    for (size_t i = 0; i < SERVER_EMIT_KINDS; i++) {
+        entry->outputs[i].count = 0;
+        entry->rendered[i] = false;
+    }
+
+    // the identifiers of replaced contents stay interned until
+    // _release_interned
+    Lex_TokenizeResult result = lexer_tokenize_source(
+        sv_from_cstring(entry->path, strlen(entry->path)),
+        sb_to_string_view(&entry->content),
+        &entry->success
+    );
+    Writer *w = &server->writer;
+    if (!entry->success) {
+        writer_init_sink(w, &entry->outputs[0]);
+        lexer_print_error(w, &result.error.type);
+        writer_cstr(w, " at ");
+        lexer_print_span(w, result.error.span);
+        writer_char(w, '\n');
+        writer_flush(w);
+        _fail_entry(entry);
+        return;
+    }
+    entry->stream = result.stream;
+    Parser_Error error;
+    entry->success = parser_parse_source(&entry->pool, entry->stream, NULL, &entry->source, &error);
+    if (!entry->success) {
+        lexer_token_stream_free(&entry->stream);
+        ast_pool_reset(&entry->pool);
+        writer_init_sink(w, &entry->outputs[0]);
+        parser_print_error(w, &error);
+        writer_cstr(w, " at ");
+        lexer_print_span(w, error.span);
+        writer_char(w, '\n');
+        writer_flush(w);
+        _fail_entry(entry);
+    }
+}
+
+static
+bool _check_file(Server *server, const char *path, Emit_Kind emit) {
+    Writer *w = &server->writer;
+    server->scratch.count = 0;
+    writer_init_sink(w, &server->err);
+    bool read = read_entire_file(path, &server->scratch, w);
+    writer_flush(w);
+    if (!read) {
+        return false;
+    }
+
+    Server_Entry *entry = _find_entry(server, path);
+    uint64_t hash = hash_bytes(server->scratch.items, server->scratch.count, SERVER_HASH_SEED);
+    bool unchanged = entry->checked && entry->hash == hash
+        && entry->content.count == server->scratch.count;
+    if (!unchanged) {
+        _update_entry(server, entry, hash);
+    }
+
+    String_Builder *output = &entry->outputs[emit];
+    if (!entry->rendered[emit]) {
+        writer_init_sink(w, output);
+        emit_source(w, emit, &entry->source);
+        writer_flush(w);
+        entry->rendered[emit] = true;
+    }
+    da_append_many(&server->out, output->items, output->count);
+    return entry->success;
+}
+
+// Returns false for a Server_Stop request
+static
+bool _serve(Server *server, int client) {
+    Server_Request request;
+    if (!_read_all(client, &request, sizeof(request)) || request.magic != SERVER_MAGIC) {
+        return true;
+    }
+    server->out.count = 0;
+    server->err.count = 0;
+    Server_Response response = {0};
+
+    if (request.kind == Server_Check && request.emit < SERVER_EMIT_KINDS) {
+        char path[SERVER_MAX_PATH + 1];
+        for (uint32_t i = 0; i < request.count; i++) {
+            uint32_t length;
+            if (!_read_all(client, &length, sizeof(length)) || length > SERVER_MAX_PATH
+                    || !_read_all(client, path, length)) {
+                return true;
+            }
+            path[length] = '\0';
+            if (!_check_file(server, path, request.emit)) {
+                response.status = 1;
+            }
+        }
+    }
+
+    response.out_count = server->out.count;
+    response.err_count = server->err.count;
+    // a client that went away is no reason to stop
+    (void)(_write_all(client, &response, sizeof(response))
+        && _write_all(client, server->out.items, server->out.count)
+        && _write_all(client, server->err.items, server->err.count));
+    return request.kind != Server_Stop;
+}
+
+static
+void _server_free(Server *server) {
+    for (size_t i = 0; i < server->entries.count; i++) {
+        Server_Entry *entry = server->entries.items[i];
+        _release_entry(entry);
+        ast_pool_free(&entry->pool);
+        free(entry->content.items);
+        for (size_t j = 0; j < SERVER_EMIT_KINDS; j++) {
+            free(entry->outputs[j].items);
+        }
+        free(entry->path);
+        free(entry);
+    }
+    free(server->entries.items);
+    free(server->slots);
+    free(server->scratch.items);
+    free(server->out.items);
+    free(server->err.items);
+    lexer_free_interned();
+}
+
+static
+bool _socket_address(const char *socket_path, struct sockaddr_un *address) {
+    if (strlen(socket_path) >= sizeof(address->sun_path)) {
+        fprintf(stderr, "ERROR: Socket path too long: %s\n", socket_path);
+        return false;
+    }
+    memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+    strcpy(address->sun_path, socket_path);
+    return true;
+}
+
+int server_run(const char *socket_path) {
+    struct sockaddr_un address;
+    if (!_socket_address(socket_path, &address)) {
+        return 1;
+    }
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    // a stale socket of a server that did not shut down cleanly
+    unlink(socket_path);
+    // (bind) as AST.h has a `bind` macro
+    if (listener < 0
+            || (bind)(listener, (struct sockaddr *)&address, sizeof(address)) != 0
+            || listen(listener, 16) != 0) {
+        fprintf(stderr, "ERROR: Could not listen on %s: %s\n", socket_path, strerror(errno));
+        return 1;
+    }
+
+    // without SA_RESTART, so a signal interrupts the accept
+    struct sigaction stop = { .sa_handler = _handle_stop };
+    sigaction(SIGINT, &stop, NULL);
+    sigaction(SIGTERM, &stop, NULL);
+    signal(SIGPIPE, SIG_IGN);
+    // a failed assert or a crash takes the socket with it as well
+    strcpy(server_socket_path, socket_path);
+    struct sigaction crash = { .sa_handler = _handle_crash, .sa_flags = SA_RESETHAND };
+    int fatal[] = { SIGABRT, SIGSEGV, SIGBUS, SIGFPE, SIGILL };
+    for (size_t i = 0; i < sizeof(fatal) / sizeof(fatal[0]); i++) {
+        sigaction(fatal[i], &crash, NULL);
+    }
+
+    static Server server;
+    bool running = true;
+    while (running && !server_stop) {
+        int client = accept(listener, NULL, NULL);
+        if (client < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            fprintf(stderr, "ERROR: Could not accept connection: %s\n", strerror(errno));
+            break;
+        }
+        running = _serve(&server, client);
+        close(client);
+    }
+
+    close(listener);
+    unlink(socket_path);
+    _server_free(&server);
+    return 0;
+}
+
+static
+bool _copy_to(int client, int fd, uint64_t count) {
+    char buffer[64*1024];
+    while (count > 0) {
+        size_t chunk = count < sizeof(buffer) ? count : sizeof(buffer);
+        if (!_read_all(client, buffer, chunk) || !_write_all(fd, buffer, chunk)) {
+            return false;
+        }
+        count -= chunk;
+    }
+    return true;
+}
+
+int server_forward(const char *socket_path, Server_RequestKind kind, Emit_Kind emit,
+                   const char **filenames, size_t count) {
+    struct sockaddr_un address;
+    if (!_socket_address(socket_path, &address)) {
+        return -1;
+    }
+    int client = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (client < 0 || connect(client, (struct sockaddr *)&address, sizeof(address)) != 0) {
+        if (client >= 0) {
+            close(client);
+        }
+        return -1;
+    }
+
+    Server_Request request = {
+        .magic = SERVER_MAGIC,
+        .kind = kind,
+        .emit = emit,
+        .count = count,
+    };
+    bool success = _write_all(client, &request, sizeof(request));
+    for (size_t i = 0; success && i < count; i++) {
+        uint32_t length = strlen(filenames[i]);
+        success = _write_all(client, &length, sizeof(length))
+            && _write_all(client, filenames[i], length);
+    }
+
+    Server_Response response;
+    success = success
+        && _read_all(client, &response, sizeof(response))
+        && _copy_to(client, STDOUT_FILENO, response.out_count)
+        && _copy_to(client, STDERR_FILENO, response.err_count);
+    close(client);
+    if (!success) {
+        fprintf(stderr, "ERROR: Lost connection to the server at %s\n", socket_path);
+        return 1;
+    }
+    return response.status;
+}
@@ -0,0 +1,49 @@
+#ifndef SERVER_H_
+#define SERVER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "driver.h"
+
+// `bangc --server=<socket>` keeps every file it was asked about in memory:
+// its content hash, token stream, AST and the outputs rendered from it.
+// A file whose content did not change is answered from memory after a
+// hash compare, a changed file is parsed again without touching the rest.
+// `bangc --connect=<socket>` forwards its files to the server.
+//
+// The server answers one client at a time, both ends are the same binary,
+// so the messages are plain structs.
+
+#define SERVER_MAGIC 0x676e6162
+#define SERVER_MAX_PATH 4096
+
+typedef enum {
+    Server_Check,
+    Server_Stop,
+} Server_RequestKind;
+
+// followed by `count` paths, each a uint32_t length and the bytes
+typedef struct {
+    uint32_t magic;
+    uint32_t kind;
+    uint32_t emit;
+    uint32_t count;
+} Server_Request;
+
+// followed by `out_count` bytes for stdout and `err_count` for stderr
+typedef struct {
+    uint64_t out_count;
+    uint64_t err_count;
+    uint32_t status;
+} Server_Response;
+
+// Serves until a Server_Stop request, SIGINT or SIGTERM, returns the exit
+// status of bangc
+int server_run(const char *socket_path);
+// Returns -1 if no server listens on `socket_path`, otherwise the exit
+// status for the request. Paths are sent as they are, make them absolute.
+int server_forward(const char *socket_path, Server_RequestKind kind, Emit_Kind emit,
+                   const char **filenames, size_t count);
+
+#endif // SERVER_H_
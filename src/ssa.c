@@ -0,0 +1,636 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dynarray.h"
+#include "ssa.h"
+
+static inline
+Ssa_Instr *_instr(Ssa_Builder *builder, Ssa_Id id) {
+    return &builder->function->instrs.items[id];
+}
+
+static inline
+Ssa_Block *_block(Ssa_Builder *builder, Ssa_BlockId id) {
+    return &builder->function->blocks.items[id];
+}
+
+Ssa_Id ssa_resolve(Ssa_Function *function, Ssa_Id id) {
+    while (id != SSA_NONE && function->instrs.items[id].op == Ssa_Nop) {
+        id = function->instrs.items[id].c;
+    }
+    return id;
+}
+
+// The value a removed phi was forwarded to
+static inline
+Ssa_Id _resolve(Ssa_Builder *builder, Ssa_Id id) {
+    return ssa_resolve(builder->function, id);
+}
+
+// The value of `var` at the end of `block`, SSA_NONE if there is none yet
+static inline
+Ssa_Id _lookup(Ssa_Builder *builder, Ssa_BlockId block, uint32_t var) {
+    Ssa_Defs *defs = &builder->vars.items[var];
+    if (block < defs->base || block - defs->base >= defs->count) {
+        return SSA_NONE;
+    }
+    return defs->items[block - defs->base];
+}
+
+static
+void _write(Ssa_Builder *builder, Ssa_BlockId block, uint32_t var, Ssa_Id value) {
+    Ssa_Defs *defs = &builder->vars.items[var];
+    if (defs->count == 0) {
+        defs->base = block;
+    }
+    // a block ahead of the first one written, a read does not usually go
+    // past the definition of the variable
+    if (block < defs->base) {
+        size_t shift = defs->base - block;
+        for (size_t i = 0; i < shift; i++) {
+            da_append(defs, SSA_NONE);
+        }
+        memmove(defs->items + shift, defs->items, (defs->count - shift) * sizeof(Ssa_Id));
+        for (size_t i = 0; i < shift; i++) {
+            defs->items[i] = SSA_NONE;
+        }
+        defs->base = block;
+    }
+    while (block - defs->base >= defs->count) {
+        da_append(defs, SSA_NONE);
+    }
+    defs->items[block - defs->base] = value;
+}
+
+static
+Ssa_Id _append(Ssa_Builder *builder, Ssa_BlockId block, Ssa_Op op, Type_Id type, Ssa_Id a, Ssa_Id b, Ssa_Id c) {
+    Ssa_Instr instr = { .op = op, .type = type, .a = a, .b = b, .c = c, .block = block };
+    da_append(&builder->function->instrs, instr);
+    return builder->function->instrs.count - 1;
+}
+
+// A phi with room for an operand per predecessor of `block`, which are
+// filled in later
+static
+Ssa_Id _new_phi(Ssa_Builder *builder, Ssa_BlockId block, Type_Id type) {
+    Ssa_Ids *operands = &builder->function->operands;
+    uint32_t count = _block(builder, block)->pred_count;
+    Ssa_Id phi = _append(builder, block, Ssa_Phi, type, operands->count, count, SSA_NONE);
+    for (uint32_t i = 0; i < count; i++) {
+        da_append(operands, SSA_NONE);
+    }
+    da_append(&builder->phis, phi);
+    return phi;
+}
+
+static
+bool _uses(Ssa_Builder *builder, Ssa_Id phi, Ssa_Id value) {
+    Ssa_Instr *instr = _instr(builder, phi);
+    for (uint32_t i = 0; i < instr->b; i++) {
+        if (builder->function->operands.items[instr->a + i] == value) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// A phi whose operands are itself and a single other value is that value.
+// The phis using a removed one may become trivial in turn, they are only
+// looked for if it was used by one at all.
+static
+Ssa_Id _remove_trivial(Ssa_Builder *builder, Ssa_Id phi) {
+    Ssa_Ids *worklist = &builder->worklist;
+    worklist->count = 0;
+    da_append(worklist, phi);
+    while (worklist->count > 0) {
+        Ssa_Id candidate = worklist->items[--worklist->count];
+        Ssa_Instr *instr = _instr(builder, candidate);
+        if (instr->op != Ssa_Phi) {
+            continue;
+        }
+        Ssa_Id same = SSA_NONE;
+        bool trivial = true;
+        for (uint32_t i = 0; i < instr->b && trivial; i++) {
+            Ssa_Id operand = _resolve(builder, builder->function->operands.items[instr->a + i]);
+            if (operand == same || operand == candidate) {
+                continue;
+            }
+            trivial = same == SSA_NONE;
+            same = operand;
+        }
+        if (!trivial) {
+            continue;
+        }
+        if (same == SSA_NONE) {
+            // only reachable through itself, or from the entry block
+            same = _append(builder, instr->block, Ssa_Undef, instr->type, 0, 0, SSA_NONE);
+            instr = _instr(builder, candidate);
+        }
+        instr->op = Ssa_Nop;
+        instr->c = same;
+        if (!instr->phi_user) {
+            continue;
+        }
+        for (size_t i = 0; i < builder->phis.count; i++) {
+            Ssa_Id user = builder->phis.items[i];
+            if (user != candidate && _instr(builder, user)->op == Ssa_Phi && _uses(builder, user, candidate)) {
+                da_append(worklist, user);
+            }
+        }
+    }
+    return _resolve(builder, phi);
+}
+
+static inline
+void _set_operand(Ssa_Builder *builder, Ssa_Id phi, uint32_t index, Ssa_Id value) {
+    builder->function->operands.items[_instr(builder, phi)->a + index] = value;
+    if (_instr(builder, value)->op == Ssa_Phi) {
+        _instr(builder, value)->phi_user = true;
+    }
+}
+
+// The definition of a join whose read is under way
+#define SSA_PENDING (SSA_NONE - 1)
+
+// The value of a join once all of its predecessors answered. Most joins of
+// a variable merge the same value, they get no phi unless a cycle needed one.
+static
+Ssa_Id _finish_join(Ssa_Builder *builder, Ssa_Frame *frame, Type_Id type) {
+    Ssa_Id *values = builder->values.items + frame->operand;
+    uint32_t count = builder->values.count - frame->operand;
+    builder->values.count = frame->operand;
+    if (frame->phi == SSA_NONE) {
+        bool same = true;
+        for (uint32_t i = 1; i < count && same; i++) {
+            same = values[i] == values[0];
+        }
+        if (same) {
+            return values[0];
+        }
+        frame->phi = _new_phi(builder, frame->block, type);
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        _set_operand(builder, frame->phi, i, values[i]);
+    }
+    return _remove_trivial(builder, frame->phi);
+}
+
+// readVariable of the paper, with the recursion over the predecessors on
+// an explicit stack. A join marks itself pending while its predecessors are
+// asked, a read that comes back to it makes its phi.
+static
+Ssa_Id _read(Ssa_Builder *builder, Ssa_BlockId block, uint32_t var, Type_Id type) {
+    Ssa_Frames *frames = &builder->frames;
+    size_t base = frames->count;
+    Ssa_Id result = SSA_NONE;
+    Ssa_Frame start = { .block = block, .phi = SSA_NONE, .edge = SSA_NONE };
+    da_append(frames, start);
+    // `result` is the value of the frame that was popped last
+    bool returned = false;
+    while (frames->count > base) {
+        Ssa_Frame *frame = &frames->items[frames->count - 1];
+        Ssa_Block *current = _block(builder, frame->block);
+        if (returned) {
+            returned = false;
+            if (!frame->join) {
+                _write(builder, frame->block, var, result);
+                frames->count--;
+                returned = true;
+                continue;
+            }
+            da_append(&builder->values, result);
+        } else {
+            Ssa_Id def = _lookup(builder, frame->block, var);
+            if (def == SSA_PENDING) {
+                // a cycle, the join it went through needs its phi now
+                Ssa_Frame *join = frame;
+                while (join->block != frame->block || !join->join) {
+                    join--;
+                }
+                join->phi = _new_phi(builder, join->block, type);
+                _write(builder, join->block, var, join->phi);
+                def = join->phi;
+            }
+            if (def != SSA_NONE) {
+                result = _resolve(builder, def);
+                frames->count--;
+                returned = true;
+                continue;
+            }
+            if (!current->sealed) {
+                result = _new_phi(builder, frame->block, type);
+                Ssa_Incomplete incomplete = { .var = var, .phi = result, .next = current->incomplete };
+                da_append(&builder->incomplete, incomplete);
+                _block(builder, frame->block)->incomplete = builder->incomplete.count - 1;
+                _write(builder, frame->block, var, result);
+                frames->count--;
+                returned = true;
+                continue;
+            }
+            if (current->pred_count == 0) {
+                result = _append(builder, frame->block, Ssa_Undef, type, 0, 0, SSA_NONE);
+                _write(builder, frame->block, var, result);
+                frames->count--;
+                returned = true;
+                continue;
+            }
+            if (current->pred_count > 1) {
+                frame->join = true;
+                frame->operand = builder->values.count;
+                _write(builder, frame->block, var, SSA_PENDING);
+            }
+            frame->edge = current->preds;
+        }
+
+        // the next predecessor to ask, or the last one was answered
+        if (frame->edge == SSA_NONE) {
+            result = _finish_join(builder, frame, type);
+            _write(builder, frame->block, var, result);
+            frames->count--;
+            returned = true;
+            continue;
+        }
+        Ssa_Edge edge = builder->function->edges.items[frame->edge];
+        frame->edge = edge.next;
+        if (!frame->join) {
+            // a single predecessor, the frame is done when it answers
+            frame->edge = SSA_NONE;
+        }
+        Ssa_Frame pred = { .block = edge.from, .phi = SSA_NONE, .edge = SSA_NONE };
+        da_append(frames, pred);
+    }
+    return result;
+}
+
+void ssa_begin(Ssa_Builder *builder, Ssa_Function *function) {
+    function->instrs.count = 0;
+    function->operands.count = 0;
+    function->blocks.count = 0;
+    function->edges.count = 0;
+    function->order.count = 0;
+    function->locals.count = 0;
+    function->traps.count = 0;
+    builder->function = function;
+    builder->var_count = 0;
+    builder->incomplete.count = 0;
+    builder->phis.count = 0;
+    builder->frames.count = 0;
+    builder->values.count = 0;
+    builder->block = ssa_new_block(builder);
+    ssa_seal(builder, builder->block);
+}
+
+Ssa_BlockId ssa_new_block(Ssa_Builder *builder) {
+    Ssa_Block block = { .preds = SSA_NONE, .last_pred = SSA_NONE, .incomplete = SSA_NONE };
+    da_append(&builder->function->blocks, block);
+    return builder->function->blocks.count - 1;
+}
+
+void ssa_switch_to(Ssa_Builder *builder, Ssa_BlockId block) {
+    builder->block = block;
+}
+
+// addPhiOperands of the paper for every phi that was waiting for `block`
+void ssa_seal(Ssa_Builder *builder, Ssa_BlockId block) {
+    uint32_t next = _block(builder, block)->incomplete;
+    _block(builder, block)->sealed = true;
+    while (next != SSA_NONE) {
+        Ssa_Incomplete incomplete = builder->incomplete.items[next];
+        Ssa_Id phi = incomplete.phi;
+        Type_Id type = _instr(builder, phi)->type;
+        // the phi was made when the block had fewer predecessors
+        Ssa_Ids *operands = &builder->function->operands;
+        _instr(builder, phi)->a = operands->count;
+        _instr(builder, phi)->b = _block(builder, block)->pred_count;
+        for (uint32_t i = 0; i < _block(builder, block)->pred_count; i++) {
+            da_append(operands, SSA_NONE);
+        }
+        uint32_t index = 0;
+        for (uint32_t edge = _block(builder, block)->preds; edge != SSA_NONE; edge = builder->function->edges.items[edge].next) {
+            Ssa_Id value = _read(builder, builder->function->edges.items[edge].from, incomplete.var, type);
+            _set_operand(builder, phi, index++, value);
+        }
+        _remove_trivial(builder, phi);
+        next = incomplete.next;
+    }
+    _block(builder, block)->incomplete = SSA_NONE;
+}
+
+Ssa_Id ssa_emit(Ssa_Builder *builder, Ssa_Op op, Type_Id type, Ssa_Id a, Ssa_Id b) {
+    return _append(builder, builder->block, op, type, a, b, SSA_NONE);
+}
+
+Ssa_Id ssa_const(Ssa_Builder *builder, Type_Id type, uint64_t value) {
+    return ssa_emit(builder, Ssa_Const, type, (uint32_t)value, (uint32_t)(value >> 32));
+}
+
+Ssa_Id ssa_phi(Ssa_Builder *builder, Type_Id type, const Ssa_Id *values, size_t count) {
+    assert(count == _block(builder, builder->block)->pred_count && "a value per predecessor");
+    Ssa_Id phi = _new_phi(builder, builder->block, type);
+    for (size_t i = 0; i < count; i++) {
+        _set_operand(builder, phi, i, values[i]);
+    }
+    return _remove_trivial(builder, phi);
+}
+
+static
+void _add_pred(Ssa_Builder *builder, Ssa_BlockId block, Ssa_BlockId pred) {
+    Ssa_Block *target = _block(builder, block);
+    assert(!target->sealed && "all predecessors of a sealed block are known");
+    Ssa_Edge edge = { .from = pred, .next = SSA_NONE };
+    da_append(&builder->function->edges, edge);
+    uint32_t id = builder->function->edges.count - 1;
+    if (target->last_pred == SSA_NONE) {
+        target->preds = id;
+    } else {
+        builder->function->edges.items[target->last_pred].next = id;
+    }
+    target->last_pred = id;
+    target->pred_count++;
+}
+
+void ssa_jump(Ssa_Builder *builder, Ssa_BlockId target) {
+    ssa_emit(builder, Ssa_Jump, Type_Void, target, SSA_NONE);
+    _add_pred(builder, target, builder->block);
+}
+
+void ssa_branch(Ssa_Builder *builder, Ssa_Id condition, Ssa_BlockId then, Ssa_BlockId otherwise) {
+    _append(builder, builder->block, Ssa_Branch, Type_Void, condition, then, otherwise);
+    _add_pred(builder, then, builder->block);
+    _add_pred(builder, otherwise, builder->block);
+}
+
+void ssa_ret(Ssa_Builder *builder, const Ssa_Id *values, size_t count) {
+    Ssa_Ids *operands = &builder->function->operands;
+    ssa_emit(builder, Ssa_Ret, Type_Void, operands->count, count);
+    da_append_many(operands, values, count);
+}
+
+uint32_t ssa_new_var(Ssa_Builder *builder) {
+    if (builder->var_count == builder->vars.count) {
+        Ssa_Defs defs = {0};
+        da_append(&builder->vars, defs);
+    }
+    builder->vars.items[builder->var_count].count = 0;
+    return builder->var_count++;
+}
+
+void ssa_write(Ssa_Builder *builder, uint32_t var, Ssa_Id value) {
+    _write(builder, builder->block, var, value);
+}
+
+Ssa_Id ssa_read(Ssa_Builder *builder, uint32_t var, Type_Id type) {
+    return _read(builder, builder->block, var, type);
+}
+
+uint32_t ssa_operand_count(Ssa_Instr *instr) {
+    switch (instr->op) {
+        case Ssa_Phi: case Ssa_Ret:
+            return instr->b;
+        case Ssa_Const: case Ssa_Undef: case Ssa_Jump: case Ssa_Nop:
+            return 0;
+        case Ssa_Neg: case Ssa_BNot: case Ssa_Not: case Ssa_Cast: case Ssa_Branch:
+            return 1;
+        default:
+            return 2;
+    }
+}
+
+Ssa_Id *ssa_operand(Ssa_Function *function, Ssa_Instr *instr, uint32_t index) {
+    if (instr->op == Ssa_Phi || instr->op == Ssa_Ret) {
+        return &function->operands.items[instr->a + index];
+    }
+    return index == 0 ? &instr->a : &instr->b;
+}
+
+uint32_t ssa_successors(Ssa_Instr *instr, Ssa_BlockId successors[2]) {
+    switch (instr->op) {
+        case Ssa_Jump:
+            successors[0] = instr->a;
+            return 1;
+        case Ssa_Branch:
+            successors[0] = instr->b;
+            successors[1] = instr->c;
+            return 2;
+        default:
+            return 0;
+    }
+}
+
+void ssa_finish(Ssa_Builder *builder) {
+    ssa_compact(builder->function);
+}
+
+static inline
+int _group(uint8_t op) {
+    switch (op) {
+        case Ssa_Phi: case Ssa_Undef:
+            return 0;
+        case Ssa_Jump: case Ssa_Branch: case Ssa_Ret:
+            return 2;
+        default:
+            return 1;
+    }
+}
+
+void ssa_compact(Ssa_Function *function) {
+    for (size_t i = 0; i < function->operands.count; i++) {
+        function->operands.items[i] = ssa_resolve(function, function->operands.items[i]);
+    }
+    // counting sort by block. Phis and undefs are made whenever a read
+    // needs them, they go ahead of the rest of their block. The terminator
+    // goes last, a phi the optimizer made a constant may come after it.
+    for (size_t i = 0; i < function->blocks.count; i++) {
+        function->blocks.items[i].start = 0;
+        function->blocks.items[i].count = 0;
+    }
+    for (size_t i = 0; i < function->instrs.count; i++) {
+        Ssa_Instr *instr = &function->instrs.items[i];
+        if (instr->op == Ssa_Nop) {
+            continue;
+        }
+        if (instr->op != Ssa_Phi && instr->op != Ssa_Ret) {
+            for (uint32_t j = 0; j < ssa_operand_count(instr); j++) {
+                Ssa_Id *operand = ssa_operand(function, instr, j);
+                *operand = ssa_resolve(function, *operand);
+            }
+        }
+        function->blocks.items[instr->block].count++;
+    }
+    uint32_t start = 0;
+    for (size_t i = 0; i < function->blocks.count; i++) {
+        function->blocks.items[i].start = start;
+        start += function->blocks.items[i].count;
+        function->blocks.items[i].count = 0;
+    }
+    if (function->order.capacity < start) {
+        free(function->order.items);
+        function->order.capacity = start;
+        function->order.items = malloc(start * sizeof(Ssa_Id));
+        assert(function->order.items != NULL && "Buy more RAM lol");
+    }
+    function->order.count = start;
+    for (int group = 0; group < 3; group++) {
+        for (size_t i = 0; i < function->instrs.count; i++) {
+            Ssa_Instr *instr = &function->instrs.items[i];
+            if (instr->op == Ssa_Nop || _group(instr->op) != group) {
+                continue;
+            }
+            Ssa_Block *block = &function->blocks.items[instr->block];
+            function->order.items[block->start + block->count++] = i;
+        }
+    }
+}
+
+static const char *op_names[] = {
+#define _OP(name) #name,
+    ENUMERATE_SSA_OPS
+#undef _OP
+};
+
+static
+void _print_value(Writer *w, Ssa_Id *numbers, Ssa_Id id) {
+    writer_char(w, '%');
+    writer_u64(w, numbers[id]);
+}
+
+static
+void _print_block(Writer *w, Ssa_BlockId block) {
+    writer_char(w, 'b');
+    writer_u64(w, block);
+}
+
+static
+void _print_const(Writer *w, Type_Table *types, Ssa_Instr *instr) {
+    uint64_t value = instr->a | (uint64_t)instr->b << 32;
+    if (instr->type == Type_Bool) {
+        writer_cstr(w, value ? "true" : "false");
+    } else if (types_is_float(instr->type)) {
+        union { uint64_t u; double f; } bits = { .u = value };
+        writer_f64(w, bits.f);
+    } else if (instr->type == Type_Char || instr->type == Type_Nil || instr->type == Type_Void
+            || IS_UNSIGNED_CLASS(types_info(types, instr->type)->nclass)) {
+        writer_u64(w, value);
+    } else {
+        writer_i64(w, (int64_t)value);
+    }
+}
+
+// The values are numbered in the order they are printed
+void ssa_print(Writer *w, Ssa_Function *function, Type_Table *types) {
+    Ssa_Id *numbers = malloc((function->instrs.count + 1) * sizeof(Ssa_Id));
+    assert(numbers != NULL && "Buy more RAM lol");
+    Ssa_Id number = 0;
+    for (size_t i = 0; i < function->order.count; i++) {
+        Ssa_Id id = function->order.items[i];
+        if (function->instrs.items[id].type != Type_Void) {
+            numbers[id] = number++;
+        }
+    }
+    Ssa_Id *operands = function->operands.items;
+
+    for (size_t b = 0; b < function->blocks.count; b++) {
+        Ssa_Block *block = &function->blocks.items[b];
+        // unreachable, every other block ends in a terminator
+        if (block->count == 0) {
+            continue;
+        }
+        _print_block(w, b);
+        writer_char(w, ':');
+        for (uint32_t edge = block->preds; edge != SSA_NONE; edge = function->edges.items[edge].next) {
+            writer_cstr(w, edge == block->preds ? " ; preds " : ", ");
+            _print_block(w, function->edges.items[edge].from);
+        }
+        writer_char(w, '\n');
+
+        for (uint32_t i = 0; i < block->count; i++) {
+            Ssa_Id id = function->order.items[block->start + i];
+            Ssa_Instr *instr = &function->instrs.items[id];
+            writer_cstr(w, "    ");
+            if (instr->type != Type_Void) {
+                _print_value(w, numbers, id);
+                writer_cstr(w, " = ");
+            }
+            writer_cstr(w, op_names[instr->op]);
+            switch (instr->op) {
+                case Ssa_Const:
+                    writer_char(w, ' ');
+                    _print_const(w, types, instr);
+                    break;
+                case Ssa_Phi: {
+                    Ssa_Edge *edges = function->edges.items;
+                    uint32_t edge = block->preds;
+                    for (uint32_t j = 0; j < instr->b; j++, edge = edges[edge].next) {
+                        writer_cstr(w, j == 0 ? " [" : ", [");
+                        _print_value(w, numbers, operands[instr->a + j]);
+                        writer_cstr(w, ", ");
+                        _print_block(w, edges[edge].from);
+                        writer_char(w, ']');
+                    }
+                } break;
+                case Ssa_Jump:
+                    writer_char(w, ' ');
+                    _print_block(w, instr->a);
+                    break;
+                case Ssa_Branch:
+                    writer_char(w, ' ');
+                    _print_value(w, numbers, instr->a);
+                    writer_cstr(w, ", ");
+                    _print_block(w, instr->b);
+                    writer_cstr(w, ", ");
+                    _print_block(w, instr->c);
+                    break;
+                case Ssa_Ret:
+                    for (uint32_t j = 0; j < instr->b; j++) {
+                        Ssa_Local *local = &function->locals.items[j];
+                        writer_cstr(w, j == 0 ? " " : ", ");
+                        writer_write(w, local->name.items, local->name.count);
+                        writer_cstr(w, " = ");
+                        if (operands[instr->a + j] == SSA_NONE) {
+                            writer_cstr(w, "()");
+                        } else {
+                            _print_value(w, numbers, operands[instr->a + j]);
+                        }
+                    }
+                    break;
+                default:
+                    for (uint32_t j = 0; j < ssa_operand_count(instr); j++) {
+                        writer_cstr(w, j == 0 ? " " : ", ");
+                        _print_value(w, numbers, j == 0 ? instr->a : instr->b);
+                    }
+                    break;
+            }
+            if (instr->type != Type_Void) {
+                writer_cstr(w, " : ");
+                types_print(w, types, instr->type);
+            }
+            writer_char(w, '\n');
+        }
+    }
+    free(numbers);
+}
+
+void ssa_function_free(Ssa_Function *function) {
+    free(function->instrs.items);
+    free(function->operands.items);
+    free(function->blocks.items);
+    free(function->edges.items);
+    free(function->order.items);
+    free(function->locals.items);
+    free(function->traps.items);
+    *function = (Ssa_Function) {0};
+}
+
+void ssa_builder_free(Ssa_Builder *builder) {
+    for (size_t i = 0; i < builder->vars.count; i++) {
+        free(builder->vars.items[i].items);
+    }
+    free(builder->vars.items);
+    free(builder->incomplete.items);
+    free(builder->phis.items);
+    free(builder->frames.items);
+    free(builder->values.items);
+    free(builder->worklist.items);
+    *builder = (Ssa_Builder) {0};
+}
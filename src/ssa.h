@@ -0,0 +1,438 @@
+#ifndef SSA_H_
+#define SSA_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "AST.h"
+#include "checker.h"
+#include "types.h"
+#include "writer.h"
+
+// An SSA function is built from flat arrays that refer to each other by
+// 32 bit ids: a value is the index of the instruction computing it and a
+// block the index of its Ssa_Block. Phis and returns take any number of
+// operands, they keep them in `Ssa_Function.operands`.
+//
+// It is built with the algorithm of Braun et al., "Simple and Efficient
+// Construction of Static Single Assignment Form": a variable is written by
+// recording its value for the current block, a read looks for the value in
+// the block and otherwise asks the predecessors, placing a phi where they
+// meet. A block is sealed once all its predecessors are known, the phis of
+// reads in unsealed blocks get their operands at that point. Phis that turn
+// out to merge a single value are forwarded to it and dropped at the end.
+typedef uint32_t Ssa_Id;
+typedef uint32_t Ssa_BlockId;
+
+// no value, like that of a void expression
+#define SSA_NONE UINT32_MAX
+
+// The type of an instruction is the type of its value, the operands of a
+// comparison have the type of the instruction they come from. Integers wrap
+// around at the width of their type.
+#define ENUMERATE_SSA_OPS               \
+    /* (a | b << 32) is the value */    \
+    _OP(Const)                          \
+    /* a variable read before it */     \
+    /* was written */                   \
+    _OP(Undef)                          \
+    /* operands[a..a+b], one per */     \
+    /* predecessor in their order */    \
+    _OP(Phi)                            \
+    /* a op b */                        \
+    _OP(Add)                            \
+    _OP(Sub)                            \
+    _OP(Mul)                            \
+    _OP(Div)                            \
+    _OP(Mod)                            \
+    _OP(Shl)                            \
+    _OP(Shr)                            \
+    _OP(BAnd)                           \
+    _OP(BOr)                            \
+    _OP(BXor)                           \
+    _OP(Eq)                             \
+    _OP(Ne)                             \
+    _OP(Lt)                             \
+    _OP(Le)                             \
+    _OP(Gt)                             \
+    _OP(Ge)                             \
+    /* op a */                          \
+    _OP(Neg)                            \
+    _OP(BNot)                           \
+    _OP(Not)                            \
+    /* a converted to the type */       \
+    _OP(Cast)                           \
+    /* to block a */                    \
+    _OP(Jump)                           \
+    /* to block b if a, else c */       \
+    _OP(Branch)                         \
+    /* the locals, operands[a..a+b], */ \
+    /* SSA_NONE for a void one */       \
+    _OP(Ret)                            \
+    /* a removed phi, forwarded to */   \
+    /* c until the function is done */  \
+    _OP(Nop)
+
+typedef enum {
+#define _OP(name) Ssa_##name,
+    ENUMERATE_SSA_OPS
+#undef _OP
+    Ssa_NumberOfOps
+} Ssa_Op;
+
+typedef struct {
+    uint8_t op;
+    // a phi that is an operand of another phi, it has users to revisit
+    // when it is removed
+    bool phi_user;
+    Type_Id type;
+    Ssa_Id a, b, c;
+    Ssa_BlockId block;
+} Ssa_Instr;
+
+typedef struct {
+    Ssa_Instr *items;
+    size_t count;
+    size_t capacity;
+} Ssa_Instrs;
+
+typedef struct {
+    Ssa_Id *items;
+    size_t count;
+    size_t capacity;
+} Ssa_Ids;
+
+// An edge from `from`, the predecessors of a block are a list of them
+typedef struct {
+    Ssa_BlockId from;
+    uint32_t next;
+} Ssa_Edge;
+
+typedef struct {
+    Ssa_Edge *items;
+    size_t count;
+    size_t capacity;
+} Ssa_Edges;
+
+typedef struct {
+    // edges in the order they were added, SSA_NONE terminated
+    uint32_t preds;
+    uint32_t last_pred;
+    uint32_t pred_count;
+    // the phis waiting for the block to be sealed, see Ssa_Incomplete
+    uint32_t incomplete;
+    bool sealed;
+    // `Ssa_Function.order[start..start+count]` once the function is done,
+    // the phis first
+    uint32_t start;
+    uint32_t count;
+} Ssa_Block;
+
+typedef struct {
+    Ssa_Block *items;
+    size_t count;
+    size_t capacity;
+} Ssa_Blocks;
+
+// A local of the outermost block, the operands of the Ret are their values
+typedef struct {
+    String_Builder name;
+    Type_Id type;
+} Ssa_Local;
+
+typedef struct {
+    Ssa_Local *items;
+    size_t count;
+    size_t capacity;
+} Ssa_Locals;
+
+// An instruction that can fail, an integer division or remainder
+typedef struct {
+    Ssa_Id instr;
+    Lex_Span span;
+} Ssa_Trap;
+
+typedef struct {
+    Ssa_Trap *items;
+    size_t count;
+    size_t capacity;
+} Ssa_Traps;
+
+typedef struct {
+    Ssa_Instrs instrs;
+    Ssa_Ids operands;
+    Ssa_Blocks blocks;
+    Ssa_Edges edges;
+    // the instructions grouped by block, see Ssa_Block.start. A block the
+    // optimizer found unreachable has none.
+    Ssa_Ids order;
+    Ssa_Locals locals;
+    // by ascending instruction, for the errors of the interpreter
+    Ssa_Traps traps;
+} Ssa_Function;
+
+// A phi of `var` in a block that was not sealed yet
+typedef struct {
+    uint32_t var;
+    Ssa_Id phi;
+    uint32_t next;
+} Ssa_Incomplete;
+
+typedef struct {
+    Ssa_Incomplete *items;
+    size_t count;
+    size_t capacity;
+} Ssa_Incompletes;
+
+// The values of a variable at the end of the blocks, or the last one written
+// so far in the current block, SSA_NONE if it was not looked up there yet.
+// A read asks the blocks from the current one back to its definition, which
+// are close together, so they are indexed by block from the first one.
+typedef struct {
+    Ssa_Id *items;
+    size_t count;
+    size_t capacity;
+    Ssa_BlockId base;
+} Ssa_Defs;
+
+typedef struct {
+    Ssa_Defs *items;
+    size_t count;
+    size_t capacity;
+} Ssa_Vars;
+
+// A pending read of the variable, the explicit stack keeps long chains of
+// blocks from overflowing the C stack
+typedef struct {
+    Ssa_BlockId block;
+    // a block with more than one predecessor collects their values
+    bool join;
+    // the phi of a join, made once a read comes back to it through a cycle
+    // or the values turn out to differ
+    Ssa_Id phi;
+    uint32_t edge;
+    // where the values of a join start in `Ssa_Builder.values`
+    uint32_t operand;
+} Ssa_Frame;
+
+typedef struct {
+    Ssa_Frame *items;
+    size_t count;
+    size_t capacity;
+} Ssa_Frames;
+
+typedef struct {
+    Ssa_Function *function;
+    Ssa_BlockId block;
+
+    // the variables of the function, the ones past it keep their buffers
+    // for the next one
+    Ssa_Vars vars;
+    uint32_t var_count;
+
+    Ssa_Incompletes incomplete;
+    // every phi, for the users of a removed one
+    Ssa_Ids phis;
+    Ssa_Frames frames;
+    Ssa_Ids values;
+    Ssa_Ids worklist;
+} Ssa_Builder;
+
+// Starts an empty function in `function`, the current block is the entry
+// block, which has no predecessors and is sealed
+void ssa_begin(Ssa_Builder *builder, Ssa_Function *function);
+Ssa_BlockId ssa_new_block(Ssa_Builder *builder);
+void ssa_switch_to(Ssa_Builder *builder, Ssa_BlockId block);
+// All predecessors of `block` are known
+void ssa_seal(Ssa_Builder *builder, Ssa_BlockId block);
+
+Ssa_Id ssa_emit(Ssa_Builder *builder, Ssa_Op op, Type_Id type, Ssa_Id a, Ssa_Id b);
+Ssa_Id ssa_const(Ssa_Builder *builder, Type_Id type, uint64_t value);
+// A phi of `values`, one per predecessor of the current block
+Ssa_Id ssa_phi(Ssa_Builder *builder, Type_Id type, const Ssa_Id *values, size_t count);
+void ssa_jump(Ssa_Builder *builder, Ssa_BlockId target);
+void ssa_branch(Ssa_Builder *builder, Ssa_Id condition, Ssa_BlockId then, Ssa_BlockId otherwise);
+void ssa_ret(Ssa_Builder *builder, const Ssa_Id *values, size_t count);
+
+// A new variable, numbered from 0 in each function
+uint32_t ssa_new_var(Ssa_Builder *builder);
+void ssa_write(Ssa_Builder *builder, uint32_t var, Ssa_Id value);
+// The value of `var` in the current block, `type` is the type of the
+// variable for the phis it may need
+Ssa_Id ssa_read(Ssa_Builder *builder, uint32_t var, Type_Id type);
+
+// Forwards the operands of removed phis and groups the instructions by
+// block, every block has to be sealed
+void ssa_finish(Ssa_Builder *builder);
+
+// Forwards the operands of Nops and groups the instructions by block again,
+// after ssa_finish or a pass of the optimizer
+void ssa_compact(Ssa_Function *function);
+// The value a Nop was forwarded to
+Ssa_Id ssa_resolve(Ssa_Function *function, Ssa_Id id);
+// The operands of `instr` that are values, in `Ssa_Function.operands` for a
+// Phi and a Ret, in `a` and `b` for the others
+uint32_t ssa_operand_count(Ssa_Instr *instr);
+Ssa_Id *ssa_operand(Ssa_Function *function, Ssa_Instr *instr, uint32_t index);
+// The blocks the terminator `instr` goes to, returns their number
+uint32_t ssa_successors(Ssa_Instr *instr, Ssa_BlockId successors[2]);
+
+void ssa_print(Writer *w, Ssa_Function *function, Type_Table *types);
+void ssa_function_free(Ssa_Function *function);
+void ssa_builder_free(Ssa_Builder *builder);
+
+// An expression or a block being lowered, like a Vm_Frame. A frame that is
+// done leaves its value in Ssa_Lowerer.value for the one below it
+typedef struct {
+    // `block` is set instead of `expr` for a block
+    Ast_Expr *expr;
+    Ast_Block *block;
+    Type_Id as;
+    int step;
+    // kept from one step to the next, what for depends on the node
+    Type_Id type;
+    Type_Id operand;
+    uint32_t var;
+    Ssa_Id values[2];
+    Ssa_BlockId otherwise;
+    Ssa_BlockId join;
+    size_t index;
+} Ssa_LowerFrame;
+
+typedef struct {
+    Ssa_LowerFrame *items;
+    size_t count;
+    size_t capacity;
+} Ssa_LowerFrames;
+
+// Lowers the #entrypoint blocks checked by a Checker
+typedef struct {
+    Checker *checker;
+    Ssa_Builder builder;
+    Ssa_LowerFrames frames;
+    // of the frame done last
+    Ssa_Id value;
+    // nesting of the blocks, the locals at depth 1 are returned
+    int depth;
+    // the variable of each Decl, by node id like the types of the checker
+    Ssa_Ids vars;
+    // the variables of the depth 1 Decls in the order of Ssa_Function.locals
+    Ssa_Ids returned;
+    Writer *err;
+    bool failed;
+} Ssa_Lowerer;
+
+// Lowers `block`, which has to be checked by `checker`, into `function`.
+// Expressions without a lowering yet, like calls, are reported to `err`.
+bool ssa_lower(Ssa_Lowerer *lowerer, Checker *checker, Ast_Block *block, Ssa_Function *function, Writer *err);
+void ssa_lowerer_free(Ssa_Lowerer *lowerer);
+
+// The bits of a value, like a register of the VM
+typedef union {
+    uint64_t u;
+    int64_t i;
+    double f;
+} Ssa_Value;
+
+typedef struct {
+    Ssa_Value *items;
+    size_t count;
+    size_t capacity;
+} Ssa_Values;
+
+// `value` wrapped around to the width of `type`, or rounded for f32
+Ssa_Value ssa_normalize(Type_Table *types, Type_Id type, Ssa_Value value);
+// The value of the arithmetic, comparison or Cast `op` of `type` on operands
+// of `operand_type`, the same as the VM computes it. False for a division by
+// zero, which traps.
+bool ssa_fold(Type_Table *types, Ssa_Op op, Type_Id type, Type_Id operand_type, Ssa_Value a, Ssa_Value b, Ssa_Value *result);
+
+// Interprets `function`, `values` gets the value of every instruction.
+// Returns the instruction that failed, or -1 once it returned.
+int64_t ssa_execute(Ssa_Function *function, Type_Table *types, Ssa_Values *values);
+// Interprets `function` and prints its locals to `out` like vm_run does
+bool ssa_run(Ssa_Function *function, Type_Table *types, Ssa_Values *values, Writer *out, Writer *err);
+
+// The passes of ssa_optimize, in the order they run
+#define ENUMERATE_SSA_PASSES                                               \
+    /* sparse conditional constant propagation: folds the values that   */ \
+    /* are constant on every path that can be taken, turns branches on  */ \
+    /* constants into jumps and drops the blocks that are not reached   */ \
+    _PASS(Sccp)                                                            \
+    /* global value numbering: an instruction computing what one in a   */ \
+    /* dominating block already did is replaced by it, a phi merging a  */ \
+    /* single value by that value                                       */ \
+    _PASS(Gvn)                                                             \
+    /* dead code elimination: drops what the locals and the control     */ \
+    /* flow do not depend on, a division that may trap stays            */ \
+    _PASS(Dce)                                                             \
+    /* block merging: a block whose only predecessor jumps to it is     */ \
+    /* appended to that predecessor, the jump dropped                   */ \
+    _PASS(Merge)
+
+typedef enum {
+#define _PASS(name) Ssa_Pass_##name,
+    ENUMERATE_SSA_PASSES
+#undef _PASS
+    Ssa_NumberOfPasses
+} Ssa_Pass;
+
+extern const char *ssa_pass_names[Ssa_NumberOfPasses];
+
+typedef struct {
+    uint64_t runs;
+    // instructions the pass dropped
+    uint64_t removed;
+    uint64_t ns;
+} Ssa_PassStats;
+
+// What the passes keep between functions
+typedef struct {
+    Type_Table *types;
+    Ssa_Function *function;
+
+    // the users of every value, users[user_start[v]..user_start[v+1]]
+    Ssa_Ids user_start;
+    Ssa_Ids users;
+    Ssa_Ids worklist;
+    Ssa_Ids stack;
+
+    // by instruction: the lattice of SCCP with the constant of a value that
+    // is one, and what DCE found live
+    uint8_t *lattice;
+    Ssa_Value *constants;
+    bool *live;
+    size_t capacity;
+    // the blocks and edges SCCP found to run
+    bool *reached;
+    size_t block_capacity;
+    bool *taken;
+    size_t edge_capacity;
+    // the blocks merging appends to their predecessor
+    bool *merged;
+
+    // GVN, the blocks in reverse postorder, their immediate dominators and
+    // the children of every block in the dominator tree
+    Ssa_Ids rpo;
+    Ssa_Ids rpo_index;
+    Ssa_Ids idom;
+    Ssa_Ids child_start;
+    Ssa_Ids children;
+    // the values of the dominating blocks, the slots they were inserted
+    // into are undone when the walk leaves a block
+    Ssa_Id *table;
+    size_t table_capacity;
+    Ssa_Ids inserted;
+
+    // of the last ssa_optimize
+    Ssa_PassStats stats[Ssa_NumberOfPasses];
+    uint32_t rounds;
+} Ssa_Optimizer;
+
+// Runs the passes over `function`, which has to be finished, until none of
+// them changes it any more
+void ssa_optimize(Ssa_Optimizer *optimizer, Ssa_Function *function, Type_Table *types);
+void ssa_optimizer_free(Ssa_Optimizer *optimizer);
+
+#endif // SSA_H_
@@ -0,0 +1,208 @@
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include "ssa.h"
+#include "vm.h"
+
+Ssa_Value ssa_normalize(Type_Table *types, Type_Id type, Ssa_Value value) {
+    if (type == TYPE_NUMBER(Nc_f32)) {
+        value.f = (float)value.f;
+        return value;
+    }
+    if (!types_is_integer(type)) {
+        return value;
+    }
+    Lex_NumberClass nclass = types_info(types, type)->nclass;
+    int bits = types_class_bits(nclass);
+    if (bits == 64) {
+        return value;
+    }
+    if (IS_UNSIGNED_CLASS(nclass)) {
+        value.u &= ((uint64_t)1 << bits) - 1;
+    } else {
+        value.i = (int64_t)(value.u << (64 - bits)) >> (64 - bits);
+    }
+    return value;
+}
+
+bool ssa_fold(Type_Table *types, Ssa_Op op, Type_Id type, Type_Id operand_type, Ssa_Value a, Ssa_Value b, Ssa_Value *result) {
+    bool is_float = types_is_float(operand_type);
+    bool is_unsigned = types_is_integer(operand_type)
+        && IS_UNSIGNED_CLASS(types_info(types, operand_type)->nclass);
+    Ssa_Value r = {0};
+    switch (op) {
+        // integers wrap around like the unsigned ones
+        case Ssa_Add: if (is_float) r.f = a.f + b.f; else r.u = a.u + b.u; break;
+        case Ssa_Sub: if (is_float) r.f = a.f - b.f; else r.u = a.u - b.u; break;
+        case Ssa_Mul: if (is_float) r.f = a.f * b.f; else r.u = a.u * b.u; break;
+        case Ssa_Div:
+            if (is_float) {
+                r.f = a.f / b.f;
+            } else if (is_unsigned) {
+                if (b.u == 0) return false;
+                r.u = a.u / b.u;
+            } else {
+                if (b.i == 0) return false;
+                // INT64_MIN / -1 wraps around
+                r.i = b.i == -1 ? (int64_t)-a.u : a.i / b.i;
+            }
+            break;
+        case Ssa_Mod:
+            if (is_float) {
+                r.f = fmod(a.f, b.f);
+            } else if (is_unsigned) {
+                if (b.u == 0) return false;
+                r.u = a.u % b.u;
+            } else {
+                if (b.i == 0) return false;
+                r.i = b.i == -1 ? 0 : a.i % b.i;
+            }
+            break;
+        case Ssa_Shl: r.u = a.u << (b.u & 63); break;
+        case Ssa_Shr:
+            if (is_unsigned) r.u = a.u >> (b.u & 63); else r.i = a.i >> (b.u & 63);
+            break;
+        case Ssa_BAnd: r.u = a.u & b.u; break;
+        case Ssa_BOr: r.u = a.u | b.u; break;
+        case Ssa_BXor: r.u = a.u ^ b.u; break;
+
+        case Ssa_Eq: r.i = is_float ? a.f == b.f : a.u == b.u; break;
+        case Ssa_Ne: r.i = is_float ? a.f != b.f : a.u != b.u; break;
+        case Ssa_Lt: r.i = is_float ? a.f < b.f : is_unsigned ? a.u < b.u : a.i < b.i; break;
+        case Ssa_Le: r.i = is_float ? a.f <= b.f : is_unsigned ? a.u <= b.u : a.i <= b.i; break;
+        case Ssa_Gt: r.i = is_float ? a.f > b.f : is_unsigned ? a.u > b.u : a.i > b.i; break;
+        case Ssa_Ge: r.i = is_float ? a.f >= b.f : is_unsigned ? a.u >= b.u : a.i >= b.i; break;
+
+        case Ssa_Neg: if (is_float) r.f = -a.f; else r.u = -a.u; break;
+        case Ssa_BNot: r.u = ~a.u; break;
+        case Ssa_Not: r.i = !a.i; break;
+        case Ssa_Cast:
+            // only plain numbers are converted, a float never becomes an
+            // integer
+            if (types_is_float(type) && !is_float) r.f = (double)a.i; else r = a;
+            break;
+        default:
+            assert(false && "not an arithmetic instruction");
+    }
+    *result = ssa_normalize(types, type, r);
+    return true;
+}
+
+int64_t ssa_execute(Ssa_Function *function, Type_Table *types, Ssa_Values *values) {
+    size_t count = function->instrs.count;
+    if (values->capacity < count) {
+        free(values->items);
+        values->capacity = count;
+        values->items = malloc(values->capacity * sizeof(Ssa_Value));
+        assert(values->items != NULL && "Buy more RAM lol");
+    }
+    values->count = count;
+
+    Ssa_Instr *instrs = function->instrs.items;
+    Ssa_Id *operands = function->operands.items;
+    Ssa_BlockId block = 0;
+    Ssa_BlockId from = SSA_NONE;
+    while (true) {
+        Ssa_Block *current = &function->blocks.items[block];
+        Ssa_Id *order = function->order.items + current->start;
+        uint32_t i = 0;
+        if (from != SSA_NONE) {
+            uint32_t index = 0;
+            for (uint32_t edge = current->preds; function->edges.items[edge].from != from; edge = function->edges.items[edge].next) {
+                index++;
+            }
+            // the phis take the values from the end of `from` all at once,
+            // one may be the operand of another
+            uint32_t phis = 0;
+            while (phis < current->count && instrs[order[phis]].op == Ssa_Phi) {
+                phis++;
+            }
+            if (values->capacity < count + phis) {
+                values->capacity = count + phis;
+                values->items = realloc(values->items, values->capacity * sizeof(Ssa_Value));
+                assert(values->items != NULL && "Buy more RAM lol");
+            }
+            for (uint32_t j = 0; j < phis; j++) {
+                values->items[count + j] = values->items[operands[instrs[order[j]].a + index]];
+            }
+            for (uint32_t j = 0; j < phis; j++) {
+                values->items[order[j]] = values->items[count + j];
+            }
+            i = phis;
+        }
+
+        Ssa_Value *v = values->items;
+        for (; i < current->count; i++) {
+            Ssa_Id id = order[i];
+            Ssa_Instr *instr = &instrs[id];
+            switch (instr->op) {
+                case Ssa_Const: {
+                    Ssa_Value value = { .u = instr->a | (uint64_t)instr->b << 32 };
+                    v[id] = ssa_normalize(types, instr->type, value);
+                } break;
+                case Ssa_Undef:
+                    v[id].u = 0;
+                    break;
+                case Ssa_Jump:
+                    from = block;
+                    block = instr->a;
+                    break;
+                case Ssa_Branch:
+                    from = block;
+                    block = v[instr->a].i ? instr->b : instr->c;
+                    break;
+                case Ssa_Ret:
+                    return -1;
+                case Ssa_Phi:
+                case Ssa_Nop:
+                    assert(false && "unreachable");
+                    break;
+                default: {
+                    Ssa_Value b = ssa_operand_count(instr) == 2 ? v[instr->b] : (Ssa_Value) {0};
+                    if (!ssa_fold(types, instr->op, instr->type, instrs[instr->a].type, v[instr->a], b, &v[id])) {
+                        return id;
+                    }
+                } break;
+            }
+        }
+    }
+}
+
+static
+int _compare_traps(const void *key, const void *item) {
+    Ssa_Id instr = *(const Ssa_Id *)key;
+    Ssa_Id other = ((const Ssa_Trap *)item)->instr;
+    return (instr > other) - (instr < other);
+}
+
+bool ssa_run(Ssa_Function *function, Type_Table *types, Ssa_Values *values, Writer *out, Writer *err) {
+    int64_t failed = ssa_execute(function, types, values);
+    if (failed >= 0) {
+        Ssa_Id instr = failed;
+        Ssa_Trap *trap = bsearch(&instr, function->traps.items, function->traps.count, sizeof(Ssa_Trap), _compare_traps);
+        assert(trap != NULL && "only divisions fail");
+        writer_cstr(err, "ERROR: Division by zero at ");
+        lexer_print_span(err, trap->span);
+        writer_char(err, '\n');
+        return false;
+    }
+    // the last instruction lowered
+    Ssa_Id ret = function->instrs.count - 1;
+    while (function->instrs.items[ret].op != Ssa_Ret) {
+        ret--;
+    }
+    Ssa_Instr *instr = &function->instrs.items[ret];
+    for (uint32_t i = 0; i < instr->b; i++) {
+        Ssa_Local *local = &function->locals.items[i];
+        Ssa_Id value = function->operands.items[instr->a + i];
+        Vm_Value bits = { .u = value != SSA_NONE ? values->items[value].u : 0 };
+        writer_write(out, local->name.items, local->name.count);
+        writer_cstr(out, ": ");
+        types_print(out, types, local->type);
+        writer_cstr(out, " = ");
+        vm_print_value(out, bits, types, local->type);
+        writer_char(out, '\n');
+    }
+    return true;
+}
@@ -0,0 +1,550 @@
+#include <assert.h>
+#include <stdlib.h>
+
+#include "dynarray.h"
+#include "ssa.h"
+
+static inline
+Type_Id _type_of(Ssa_Lowerer *lowerer, uint32_t id) {
+    return check_type_of(lowerer->checker, id);
+}
+
+static inline
+bool _is_plain(Type_Id type) {
+    return type == TYPE_NUMBER(Nc_Number) || type == TYPE_NUMBER(Nc_FloatingPointNumber);
+}
+
+// The type values of a plain number type are computed in
+static inline
+Type_Id _default(Type_Id type) {
+    if (type == TYPE_NUMBER(Nc_Number)) {
+        return TYPE_NUMBER(Nc_i64);
+    }
+    if (type == TYPE_NUMBER(Nc_FloatingPointNumber)) {
+        return TYPE_NUMBER(Nc_f64);
+    }
+    return type;
+}
+
+// The type a literal of `type` has when it goes into a place of `as`
+static
+Type_Id _place(Type_Id type, Type_Id as) {
+    if (type == TYPE_NUMBER(Nc_Number) && (types_is_integer(as) || types_is_float(as))) {
+        return _default(as);
+    }
+    if (type == TYPE_NUMBER(Nc_FloatingPointNumber) && types_is_float(as)) {
+        return _default(as);
+    }
+    return _default(type);
+}
+
+static
+Ssa_Id _unsupported(Ssa_Lowerer *lowerer, const char *what, Lex_Span span, Type_Id type) {
+    lowerer->failed = true;
+    writer_cstr(lowerer->err, "ERROR: Cannot lower ");
+    writer_cstr(lowerer->err, what);
+    writer_cstr(lowerer->err, " at ");
+    lexer_print_span(lowerer->err, span);
+    writer_char(lowerer->err, '\n');
+    return ssa_emit(&lowerer->builder, Ssa_Undef, _default(type), SSA_NONE, SSA_NONE);
+}
+
+// A value of a plain number type takes the type of the place it goes to,
+// like the VM does
+static
+Ssa_Id _convert(Ssa_Lowerer *lowerer, Ssa_Id value, Type_Id from, Type_Id to) {
+    if (value == SSA_NONE || !_is_plain(from)) {
+        return value;
+    }
+    Type_Id target = _place(from, to);
+    if (target == _default(from)) {
+        return value;
+    }
+    return ssa_emit(&lowerer->builder, Ssa_Cast, target, value, SSA_NONE);
+}
+
+// The same as _unified of the VM
+static
+Type_Id _unified(Type_Id lhs, Type_Id rhs) {
+    if (lhs == TYPE_NUMBER(Nc_Number) || (lhs == TYPE_NUMBER(Nc_FloatingPointNumber) && rhs != TYPE_NUMBER(Nc_Number))) {
+        return rhs;
+    }
+    return lhs;
+}
+
+// Lowers `expr` as a value of `as`, the place it goes to. Only its frame is
+// pushed, _lower_frames runs it, the frame on top first
+static
+void _lower_expr(Ssa_Lowerer *lowerer, Ast_Expr *expr, Type_Id as) {
+    Ssa_LowerFrame frame = { .expr = expr, .as = as };
+    da_append(&lowerer->frames, frame);
+}
+
+static
+void _lower_block(Ssa_Lowerer *lowerer, Ast_Block *block, Type_Id as) {
+    Ssa_LowerFrame frame = { .block = block, .as = as };
+    da_append(&lowerer->frames, frame);
+}
+
+// Pops the frame on top, `value` is what it lowered to
+static
+void _done(Ssa_Lowerer *lowerer, Ssa_Id value) {
+    lowerer->frames.count--;
+    lowerer->value = value;
+}
+
+static
+Ssa_Id _lower_literal(Ssa_Lowerer *lowerer, Ast_Expr *expr, Type_Id as) {
+    Ast_LiteralExpr *literal = &expr->Literal;
+    union { uint64_t u; int64_t i; double f; } value = {0};
+    Type_Id type = Type_Error;
+    switch (literal->kind) {
+        case L_Integer:
+            type = _place(TYPE_NUMBER(literal->nclass), as);
+            value.u = literal->integer;
+            if (types_is_float(type)) {
+                value.f = (double)(int64_t)literal->integer;
+            }
+            break;
+        case L_Float:
+            type = _place(TYPE_NUMBER(literal->nclass), as);
+            value.f = literal->floating;
+            break;
+        case L_Boolean:
+            type = Type_Bool;
+            value.u = literal->boolean;
+            break;
+        case L_Char:
+            type = Type_Char;
+            value.u = literal->wchar;
+            break;
+        case L_Nil:
+            type = Type_Nil;
+            break;
+        case L_String:
+            return _unsupported(lowerer, "a string", expr->span, Type_Str);
+    }
+    if (type == TYPE_NUMBER(Nc_f32)) {
+        value.f = (float)value.f;
+    }
+    return ssa_const(&lowerer->builder, type, value.u);
+}
+
+// The value of `lhs` and of `rhs` only if `lhs` did not decide it already.
+// The right side is lowered by a frame, _end_logical joins the two after it
+static
+void _begin_logical(Ssa_Lowerer *lowerer, Ssa_LowerFrame *frame, BinaryOp op, Ssa_Id lhs, Ast_Expr *rhs) {
+    Ssa_Builder *builder = &lowerer->builder;
+    Ssa_BlockId right = ssa_new_block(builder);
+    Ssa_BlockId join = ssa_new_block(builder);
+    if (op == Bo_And) {
+        ssa_branch(builder, lhs, right, join);
+    } else {
+        ssa_branch(builder, lhs, join, right);
+    }
+    ssa_seal(builder, right);
+    ssa_switch_to(builder, right);
+    frame->values[0] = lhs;
+    frame->join = join;
+    _lower_expr(lowerer, rhs, Type_Bool);
+}
+
+static
+Ssa_Id _end_logical(Ssa_Lowerer *lowerer, Ssa_LowerFrame *frame) {
+    Ssa_Builder *builder = &lowerer->builder;
+    Ssa_Id values[2] = { frame->values[0], lowerer->value };
+    ssa_jump(builder, frame->join);
+    ssa_seal(builder, frame->join);
+    ssa_switch_to(builder, frame->join);
+    // the branch was the first to reach `join`
+    return ssa_phi(builder, Type_Bool, values, 2);
+}
+
+static
+Ssa_Op _binary_op(BinaryOp op) {
+    switch (op) {
+        case Bo_Plus: return Ssa_Add;
+        case Bo_Minus: return Ssa_Sub;
+        case Bo_Mul: return Ssa_Mul;
+        case Bo_Div: return Ssa_Div;
+        case Bo_Mod: return Ssa_Mod;
+        case Bo_Shl: return Ssa_Shl;
+        case Bo_Shr: return Ssa_Shr;
+        case Bo_BAnd: return Ssa_BAnd;
+        case Bo_BOr: return Ssa_BOr;
+        case Bo_BXor: return Ssa_BXor;
+        case Bo_Eq: return Ssa_Eq;
+        case Bo_Ne: return Ssa_Ne;
+        case Bo_Lt: return Ssa_Lt;
+        case Bo_Le: return Ssa_Le;
+        case Bo_Gt: return Ssa_Gt;
+        case Bo_Ge: return Ssa_Ge;
+        default: break;
+    }
+    assert(false && "unreachable");
+}
+
+// An integer division or remainder traps on zero, the interpreter reports
+// it at `span`
+static
+Ssa_Id _emit_binary(Ssa_Lowerer *lowerer, Ssa_Op op, Type_Id type, Ssa_Id a, Ssa_Id b, Lex_Span span) {
+    Ssa_Id value = ssa_emit(&lowerer->builder, op, type, a, b);
+    if ((op == Ssa_Div || op == Ssa_Mod) && types_is_integer(type)) {
+        Ssa_Trap trap = { .instr = value, .span = span };
+        da_append(&lowerer->builder.function->traps, trap);
+    }
+    return value;
+}
+
+// The steps return right after pushing a frame, which may move the one they
+// were given
+
+static
+void _binary_step(Ssa_Lowerer *lowerer, Ssa_LowerFrame *frame) {
+    Ast_Expr *expr = frame->expr;
+    BinaryOp op = expr->Binary.op;
+    Ssa_Id value;
+    switch (frame->step++) {
+        case 0: {
+            if (op == Bo_And || op == Bo_Or) {
+                frame->step = 3;
+                _lower_expr(lowerer, expr->Binary.lhs, Type_Bool);
+                return;
+            }
+            // the shift amount keeps its own type
+            Type_Id lhs_type = _type_of(lowerer, expr->Binary.lhs->id);
+            Type_Id rhs_type = _type_of(lowerer, expr->Binary.rhs->id);
+            bool shift = op == Bo_Shl || op == Bo_Shr;
+            frame->type = shift ? lhs_type : _unified(lhs_type, rhs_type);
+            frame->operand = shift ? rhs_type : frame->type;
+            _lower_expr(lowerer, expr->Binary.lhs, frame->type);
+        } return;
+        case 1:
+            frame->values[0] = lowerer->value;
+            _lower_expr(lowerer, expr->Binary.rhs, frame->operand);
+            return;
+        case 2: {
+            Ssa_Op instr = _binary_op(op);
+            bool comparison = instr >= Ssa_Eq && instr <= Ssa_Ge;
+            Type_Id type = comparison ? Type_Bool : _default(frame->type);
+            value = _emit_binary(lowerer, instr, type, frame->values[0], lowerer->value, expr->span);
+        } break;
+        case 3:
+            _begin_logical(lowerer, frame, op, lowerer->value, expr->Binary.rhs);
+            return;
+        default:
+            value = _end_logical(lowerer, frame);
+            break;
+    }
+    _done(lowerer, _convert(lowerer, value, _type_of(lowerer, expr->id), frame->as));
+}
+
+static
+void _unary_step(Ssa_Lowerer *lowerer, Ssa_LowerFrame *frame) {
+    Ast_Expr *expr = frame->expr;
+    if (frame->step++ == 0) {
+        Type_Id type = _type_of(lowerer, expr->id);
+        if (expr->Unary.op == Uo_Deref) {
+            _done(lowerer, _unsupported(lowerer, "a dereference", expr->span, type));
+            return;
+        }
+        // a plain operand is converted first, so `-1` is negated as a float
+        // when it goes into one
+        frame->type = _is_plain(type) && !_is_plain(frame->as) ? _place(type, frame->as) : type;
+        _lower_expr(lowerer, expr->Unary.expr, frame->type);
+        return;
+    }
+    Type_Id result = frame->type;
+    Ssa_Id operand = lowerer->value;
+    switch (expr->Unary.op) {
+        case Uo_Minus:
+            operand = ssa_emit(&lowerer->builder, Ssa_Neg, _default(result), operand, SSA_NONE);
+            break;
+        case Uo_BitwiseNot:
+            operand = ssa_emit(&lowerer->builder, Ssa_BNot, _default(result), operand, SSA_NONE);
+            break;
+        case Uo_Not:
+            operand = ssa_emit(&lowerer->builder, Ssa_Not, Type_Bool, operand, SSA_NONE);
+            break;
+        default:
+            break;
+    }
+    _done(lowerer, operand);
+}
+
+static
+void _assign_step(Ssa_Lowerer *lowerer, Ssa_LowerFrame *frame) {
+    Ssa_Builder *builder = &lowerer->builder;
+    Ast_Expr *expr = frame->expr;
+    BinaryOp op = check_compound_operator(expr->Assign.op);
+    Ssa_Id value;
+    switch (frame->step) {
+        case 0: {
+            Ast_Expr *lhs = expr->Assign.lhs;
+            while (lhs->kind == Paren_kind) {
+                lhs = lhs->Paren.expr;
+            }
+            Type_Id type = _type_of(lowerer, lhs->id);
+            if (lhs->kind != Path_kind || lhs->Path.path.decl == NULL) {
+                _done(lowerer, _unsupported(lowerer, "an assignment to anything but a local", expr->span, type));
+                return;
+            }
+            uint32_t var = lowerer->vars.items[lhs->Path.path.decl->id];
+            frame->var = var;
+            frame->type = type;
+            if (type == Type_Void) {
+                frame->step = 4;
+                _lower_expr(lowerer, expr->Assign.rhs, type);
+            } else if (op == Bo_Invalid) {
+                frame->step = 1;
+                _lower_expr(lowerer, expr->Assign.rhs, type);
+            } else if (op == Bo_And || op == Bo_Or) {
+                frame->step = 2;
+                _begin_logical(lowerer, frame, op, ssa_read(builder, var, type), expr->Assign.rhs);
+            } else {
+                bool shift = op == Bo_Shl || op == Bo_Shr;
+                Type_Id rhs_type = _type_of(lowerer, expr->Assign.rhs->id);
+                frame->step = 3;
+                _lower_expr(lowerer, expr->Assign.rhs, shift ? rhs_type : type);
+            }
+        } return;
+        case 1:
+            value = lowerer->value;
+            break;
+        case 2:
+            value = _end_logical(lowerer, frame);
+            break;
+        case 3: {
+            Ssa_Id operand = lowerer->value;
+            // read after the right side, which may assign to it as well
+            Ssa_Id current = ssa_read(builder, frame->var, frame->type);
+            value = _emit_binary(lowerer, _binary_op(op), frame->type, current, operand, expr->span);
+        } break;
+        default:
+            _done(lowerer, SSA_NONE);
+            return;
+    }
+    ssa_write(builder, frame->var, value);
+    _done(lowerer, value);
+}
+
+static
+void _if_step(Ssa_Lowerer *lowerer, Ssa_LowerFrame *frame) {
+    Ssa_Builder *builder = &lowerer->builder;
+    Ast_Expr *expr = frame->expr;
+    switch (frame->step++) {
+        case 0:
+            _lower_expr(lowerer, expr->If.condition, Type_Bool);
+            return;
+        case 1: {
+            Ssa_Id condition = lowerer->value;
+            Ssa_BlockId then = ssa_new_block(builder);
+            frame->otherwise = expr->If.else_block != NULL ? ssa_new_block(builder) : SSA_NONE;
+            frame->join = ssa_new_block(builder);
+            ssa_branch(builder, condition, then, frame->otherwise != SSA_NONE ? frame->otherwise : frame->join);
+
+            ssa_seal(builder, then);
+            ssa_switch_to(builder, then);
+            _lower_block(lowerer, expr->If.if_branch, frame->as);
+        } return;
+        case 2:
+            frame->values[0] = lowerer->value;
+            ssa_jump(builder, frame->join);
+            if (frame->otherwise == SSA_NONE) {
+                ssa_seal(builder, frame->join);
+                ssa_switch_to(builder, frame->join);
+                _done(lowerer, SSA_NONE);
+                return;
+            }
+            ssa_seal(builder, frame->otherwise);
+            ssa_switch_to(builder, frame->otherwise);
+            _lower_expr(lowerer, expr->If.else_block, frame->as);
+            return;
+    }
+    Ssa_Id values[2] = { frame->values[0], lowerer->value };
+    ssa_jump(builder, frame->join);
+    ssa_seal(builder, frame->join);
+    ssa_switch_to(builder, frame->join);
+    if (values[0] == SSA_NONE || values[1] == SSA_NONE) {
+        _done(lowerer, SSA_NONE);
+        return;
+    }
+    Type_Id type = builder->function->instrs.items[values[0]].type;
+    _done(lowerer, ssa_phi(builder, type, values, 2));
+}
+
+static
+void _expr_step(Ssa_Lowerer *lowerer, Ssa_LowerFrame *frame) {
+    Ast_Expr *expr = frame->expr;
+    Type_Id type = _type_of(lowerer, expr->id);
+    switch (expr->kind) {
+        case Literal_kind:
+            _done(lowerer, _lower_literal(lowerer, expr, frame->as));
+            break;
+        case Path_kind: {
+            Ast_Stmt *decl = expr->Path.path.decl;
+            // the checker reported unresolved names already
+            assert(decl != NULL && "unresolved path");
+            // a void local has no value
+            Ssa_Id value = SSA_NONE;
+            if (type != Type_Void) {
+                value = ssa_read(&lowerer->builder, lowerer->vars.items[decl->id], type);
+            }
+            _done(lowerer, value);
+        } break;
+        // the same frame goes on with what is inside
+        case Paren_kind:
+            frame->expr = expr->Paren.expr;
+            break;
+        case Block_kind:
+            frame->expr = NULL;
+            frame->block = expr->Block.block;
+            break;
+        case Unary_kind:
+            _unary_step(lowerer, frame);
+            break;
+        case Binary_kind:
+            _binary_step(lowerer, frame);
+            break;
+        case Assign_kind:
+            _assign_step(lowerer, frame);
+            break;
+        case If_kind:
+            _if_step(lowerer, frame);
+            break;
+        case Call_kind:
+            _done(lowerer, _unsupported(lowerer, "a call", expr->span, type));
+            break;
+        case Subscript_kind:
+            _done(lowerer, _unsupported(lowerer, "a subscript", expr->span, type));
+            break;
+        case Member_kind:
+            _done(lowerer, _unsupported(lowerer, "a member access", expr->span, type));
+            break;
+        case Refrence_kind:
+            _done(lowerer, _unsupported(lowerer, "a reference", expr->span, type));
+            break;
+        default:
+            assert(false && "unreachable");
+    }
+}
+
+static
+void _bind(Ssa_Lowerer *lowerer, Ast_Stmt *stmt, Type_Id type, Ssa_Id value) {
+    uint32_t var = ssa_new_var(&lowerer->builder);
+    lowerer->vars.items[stmt->id] = var;
+    if (type != Type_Void) {
+        ssa_write(&lowerer->builder, var, value);
+    }
+    if (lowerer->depth == 1) {
+        Ssa_Local local = { .name = stmt->Decl.ident, .type = type };
+        da_append(&lowerer->builder.function->locals, local);
+        da_append(&lowerer->returned, var);
+    }
+}
+
+// The value of a block is the expression it ends in without a semicolon,
+// kept in `values[0]` while the statements are lowered
+static
+void _block_step(Ssa_Lowerer *lowerer, Ssa_LowerFrame *frame) {
+    Ast_Block *block = frame->block;
+    switch (frame->step) {
+        case 0:
+            frame->values[0] = SSA_NONE;
+            lowerer->depth++;
+            frame->step = 1;
+            return;
+        case 2: {
+            Ast_Stmt *stmt = block->stmts.items[frame->index - 1];
+            _bind(lowerer, stmt, _type_of(lowerer, stmt->id), lowerer->value);
+            frame->step = 1;
+        } return;
+        case 3: {
+            Ast_Stmt *stmt = block->stmts.items[frame->index - 1];
+            bool last = frame->index == block->stmts.count && !stmt->Expr.semicolon;
+            frame->values[0] = last ? lowerer->value : SSA_NONE;
+            frame->step = 1;
+        } return;
+    }
+    if (frame->index == block->stmts.count) {
+        lowerer->depth--;
+        _done(lowerer, frame->values[0]);
+        return;
+    }
+    size_t i = frame->index++;
+    Ast_Stmt *stmt = block->stmts.items[i];
+    if (stmt->kind != Decl_kind) {
+        bool last = i + 1 == block->stmts.count && !stmt->Expr.semicolon;
+        frame->step = 3;
+        _lower_expr(lowerer, stmt->Expr.expr, last ? frame->as : Type_Void);
+        return;
+    }
+
+    Type_Id type = _type_of(lowerer, stmt->id);
+    // values are scalars, strings and pointers have no lowering yet
+    if (type == Type_Str || type >= Type_NumberOfPrimitives) {
+        _bind(lowerer, stmt, type, _unsupported(lowerer, "a local that is not a scalar", stmt->span, type));
+    } else if (stmt->Decl.init != NULL) {
+        frame->step = 2;
+        _lower_expr(lowerer, stmt->Decl.init, type);
+    } else {
+        _bind(lowerer, stmt, type, ssa_const(&lowerer->builder, type, 0));
+    }
+}
+
+// Runs the frames until all of them are done
+static
+void _lower_frames(Ssa_Lowerer *lowerer) {
+    while (lowerer->frames.count > 0) {
+        Ssa_LowerFrame *frame = &lowerer->frames.items[lowerer->frames.count - 1];
+        if (frame->block != NULL) {
+            _block_step(lowerer, frame);
+        } else {
+            _expr_step(lowerer, frame);
+        }
+    }
+}
+
+bool ssa_lower(Ssa_Lowerer *lowerer, Checker *checker, Ast_Block *block, Ssa_Function *function, Writer *err) {
+    lowerer->checker = checker;
+    lowerer->err = err;
+    lowerer->failed = false;
+    lowerer->depth = 0;
+    lowerer->returned.count = 0;
+    // only the Decl slots are used
+    if (lowerer->vars.capacity < checker->types.count) {
+        free(lowerer->vars.items);
+        lowerer->vars.capacity = checker->types.count;
+        lowerer->vars.items = malloc(lowerer->vars.capacity * sizeof(Ssa_Id));
+        assert(lowerer->vars.items != NULL && "Buy more RAM lol");
+    }
+    lowerer->vars.count = checker->types.count;
+
+    Ssa_Builder *builder = &lowerer->builder;
+    ssa_begin(builder, function);
+    lowerer->frames.count = 0;
+    _lower_block(lowerer, block, Type_Void);
+    _lower_frames(lowerer);
+
+    // the values the locals have at the end, in place of their variables
+    Ssa_Ids *values = &lowerer->returned;
+    for (size_t i = 0; i < values->count; i++) {
+        Ssa_Local *local = &function->locals.items[i];
+        if (local->type == Type_Void) {
+            values->items[i] = SSA_NONE;
+        } else {
+            values->items[i] = ssa_read(builder, values->items[i], local->type);
+        }
+    }
+    ssa_ret(builder, values->items, values->count);
+    ssa_finish(builder);
+    return !lowerer->failed;
+}
+
+void ssa_lowerer_free(Ssa_Lowerer *lowerer) {
+    ssa_builder_free(&lowerer->builder);
+    free(lowerer->frames.items);
+    free(lowerer->vars.items);
+    free(lowerer->returned.items);
+    *lowerer = (Ssa_Lowerer) {0};
+}
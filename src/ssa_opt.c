@@ -0,0 +1,818 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "dynarray.h"
+#include "ssa.h"
+
+const char *ssa_pass_names[Ssa_NumberOfPasses] = {
+#define _PASS(name) #name,
+    ENUMERATE_SSA_PASSES
+#undef _PASS
+};
+
+static
+uint64_t _now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static inline
+Ssa_Instr *_instr(Ssa_Optimizer *optimizer, Ssa_Id id) {
+    return &optimizer->function->instrs.items[id];
+}
+
+static inline
+Ssa_Block *_block(Ssa_Optimizer *optimizer, Ssa_BlockId id) {
+    return &optimizer->function->blocks.items[id];
+}
+
+// The instructions of `block` in order
+static inline
+Ssa_Id *_order(Ssa_Optimizer *optimizer, Ssa_BlockId block) {
+    return optimizer->function->order.items + _block(optimizer, block)->start;
+}
+
+// Sets the count of `ids`, the contents are left to the caller
+static
+void _resize(Ssa_Ids *ids, size_t count) {
+    if (ids->capacity < count) {
+        free(ids->items);
+        ids->capacity = count;
+        ids->items = malloc(ids->capacity * sizeof(Ssa_Id));
+        assert(ids->items != NULL && "Buy more RAM lol");
+    }
+    ids->count = count;
+}
+
+// Grows the arrays by instruction, block and edge to the function
+static
+void _reserve(Ssa_Optimizer *optimizer) {
+    Ssa_Function *function = optimizer->function;
+    if (optimizer->capacity < function->instrs.count) {
+        optimizer->capacity = function->instrs.count;
+        free(optimizer->lattice);
+        free(optimizer->constants);
+        free(optimizer->live);
+        optimizer->lattice = malloc(optimizer->capacity * sizeof(uint8_t));
+        optimizer->constants = malloc(optimizer->capacity * sizeof(Ssa_Value));
+        optimizer->live = malloc(optimizer->capacity * sizeof(bool));
+        assert(optimizer->lattice != NULL && optimizer->constants != NULL && optimizer->live != NULL
+            && "Buy more RAM lol");
+    }
+    if (optimizer->block_capacity < function->blocks.count) {
+        optimizer->block_capacity = function->blocks.count;
+        free(optimizer->reached);
+        free(optimizer->merged);
+        optimizer->reached = malloc(optimizer->block_capacity * sizeof(bool));
+        optimizer->merged = malloc(optimizer->block_capacity * sizeof(bool));
+        assert(optimizer->reached != NULL && optimizer->merged != NULL && "Buy more RAM lol");
+    }
+    // a function of a single block has no edges, memset wants the array all
+    // the same
+    if (optimizer->edge_capacity < function->edges.count || optimizer->taken == NULL) {
+        optimizer->edge_capacity = function->edges.count;
+        free(optimizer->taken);
+        optimizer->taken = malloc((optimizer->edge_capacity + 1) * sizeof(bool));
+        assert(optimizer->taken != NULL && "Buy more RAM lol");
+    }
+}
+
+// The users of every value in the blocks, a user of two operands that are
+// the same value is there twice
+static
+void _build_users(Ssa_Optimizer *optimizer) {
+    Ssa_Function *function = optimizer->function;
+    size_t count = function->instrs.count;
+    Ssa_Ids *start = &optimizer->user_start;
+    _resize(start, count + 1);
+    memset(start->items, 0, start->count * sizeof(Ssa_Id));
+    for (size_t i = 0; i < function->order.count; i++) {
+        Ssa_Instr *instr = _instr(optimizer, function->order.items[i]);
+        for (uint32_t j = 0; j < ssa_operand_count(instr); j++) {
+            Ssa_Id value = *ssa_operand(function, instr, j);
+            if (value != SSA_NONE) {
+                start->items[value + 1]++;
+            }
+        }
+    }
+    for (size_t i = 0; i < count; i++) {
+        start->items[i + 1] += start->items[i];
+    }
+    // filled through start[v], which ends up at start[v + 1]
+    _resize(&optimizer->users, start->items[count]);
+    for (size_t i = 0; i < function->order.count; i++) {
+        Ssa_Id user = function->order.items[i];
+        Ssa_Instr *instr = _instr(optimizer, user);
+        for (uint32_t j = 0; j < ssa_operand_count(instr); j++) {
+            Ssa_Id value = *ssa_operand(function, instr, j);
+            if (value != SSA_NONE) {
+                optimizer->users.items[start->items[value]++] = user;
+            }
+        }
+    }
+    memmove(start->items + 1, start->items, count * sizeof(Ssa_Id));
+    start->items[0] = 0;
+}
+
+// Drops the edge from `pred` to `block` and the operands the phis of `block`
+// had for it
+static
+void _remove_pred(Ssa_Optimizer *optimizer, Ssa_BlockId block, Ssa_BlockId pred) {
+    Ssa_Function *function = optimizer->function;
+    Ssa_Block *target = _block(optimizer, block);
+    uint32_t previous = SSA_NONE;
+    uint32_t edge = target->preds;
+    uint32_t index = 0;
+    while (edge != SSA_NONE && function->edges.items[edge].from != pred) {
+        previous = edge;
+        edge = function->edges.items[edge].next;
+        index++;
+    }
+    // an unreachable block lost its predecessors already
+    if (edge == SSA_NONE) {
+        return;
+    }
+    uint32_t next = function->edges.items[edge].next;
+    if (previous == SSA_NONE) {
+        target->preds = next;
+    } else {
+        function->edges.items[previous].next = next;
+    }
+    if (target->last_pred == edge) {
+        target->last_pred = previous;
+    }
+    target->pred_count--;
+
+    Ssa_Id *order = _order(optimizer, block);
+    for (uint32_t i = 0; i < target->count; i++) {
+        Ssa_Instr *instr = _instr(optimizer, order[i]);
+        if (instr->op != Ssa_Phi) {
+            continue;
+        }
+        Ssa_Id *operands = function->operands.items + instr->a;
+        memmove(operands + index, operands + index + 1, (instr->b - index - 1) * sizeof(Ssa_Id));
+        instr->b--;
+    }
+}
+
+// Sparse conditional constant propagation of Wegman and Zadeck. A value
+// starts out unknown and only goes down the lattice, a block is only looked
+// at once an edge to it was taken.
+enum {
+    Lattice_Unknown,
+    Lattice_Constant,
+    Lattice_Varying,
+};
+
+static
+void _sccp_set(Ssa_Optimizer *optimizer, Ssa_Id id, uint8_t state, Ssa_Value value) {
+    if (state <= optimizer->lattice[id]) {
+        return;
+    }
+    optimizer->lattice[id] = state;
+    optimizer->constants[id] = value;
+    da_append(&optimizer->worklist, id);
+}
+
+static void _sccp_visit(Ssa_Optimizer *optimizer, Ssa_Id id);
+
+static
+void _sccp_take(Ssa_Optimizer *optimizer, Ssa_BlockId from, Ssa_BlockId to) {
+    Ssa_Function *function = optimizer->function;
+    bool changed = false;
+    for (uint32_t edge = _block(optimizer, to)->preds; edge != SSA_NONE; edge = function->edges.items[edge].next) {
+        if (function->edges.items[edge].from == from && !optimizer->taken[edge]) {
+            optimizer->taken[edge] = true;
+            changed = true;
+        }
+    }
+    if (!changed) {
+        return;
+    }
+    if (!optimizer->reached[to]) {
+        optimizer->reached[to] = true;
+        da_append(&optimizer->stack, to);
+        return;
+    }
+    // the phis have another operand now
+    Ssa_Id *order = _order(optimizer, to);
+    for (uint32_t i = 0; i < _block(optimizer, to)->count; i++) {
+        if (_instr(optimizer, order[i])->op == Ssa_Phi) {
+            _sccp_visit(optimizer, order[i]);
+        }
+    }
+}
+
+static
+void _sccp_phi(Ssa_Optimizer *optimizer, Ssa_Id id) {
+    Ssa_Function *function = optimizer->function;
+    Ssa_Instr *instr = _instr(optimizer, id);
+    uint8_t state = Lattice_Unknown;
+    Ssa_Value value = {0};
+    uint32_t edge = _block(optimizer, instr->block)->preds;
+    for (uint32_t i = 0; i < instr->b && state != Lattice_Varying; i++, edge = function->edges.items[edge].next) {
+        Ssa_Id operand = function->operands.items[instr->a + i];
+        if (!optimizer->taken[edge] || optimizer->lattice[operand] == Lattice_Unknown) {
+            continue;
+        }
+        if (optimizer->lattice[operand] == Lattice_Varying) {
+            state = Lattice_Varying;
+        } else if (state == Lattice_Unknown) {
+            state = Lattice_Constant;
+            value = optimizer->constants[operand];
+        } else if (value.u != optimizer->constants[operand].u) {
+            state = Lattice_Varying;
+        }
+    }
+    _sccp_set(optimizer, id, state, value);
+}
+
+static
+void _sccp_visit(Ssa_Optimizer *optimizer, Ssa_Id id) {
+    Ssa_Instr *instr = _instr(optimizer, id);
+    switch (instr->op) {
+        case Ssa_Jump:
+            _sccp_take(optimizer, instr->block, instr->a);
+            return;
+        case Ssa_Branch:
+            switch (optimizer->lattice[instr->a]) {
+                case Lattice_Constant:
+                    _sccp_take(optimizer, instr->block, optimizer->constants[instr->a].i ? instr->b : instr->c);
+                    break;
+                case Lattice_Varying:
+                    _sccp_take(optimizer, instr->block, instr->b);
+                    _sccp_take(optimizer, instr->block, instr->c);
+                    break;
+            }
+            return;
+        case Ssa_Ret:
+            return;
+        case Ssa_Phi:
+            _sccp_phi(optimizer, id);
+            return;
+        case Ssa_Const: {
+            Ssa_Value value = { .u = instr->a | (uint64_t)instr->b << 32 };
+            _sccp_set(optimizer, id, Lattice_Constant, ssa_normalize(optimizer->types, instr->type, value));
+        } return;
+        case Ssa_Undef:
+            _sccp_set(optimizer, id, Lattice_Varying, (Ssa_Value) {0});
+            return;
+        default:
+            break;
+    }
+    uint32_t count = ssa_operand_count(instr);
+    uint8_t state = Lattice_Constant;
+    for (uint32_t i = 0; i < count; i++) {
+        uint8_t operand = optimizer->lattice[*ssa_operand(optimizer->function, instr, i)];
+        state = operand == Lattice_Varying || state == Lattice_Varying ? Lattice_Varying
+            : operand == Lattice_Unknown ? Lattice_Unknown : state;
+    }
+    if (state != Lattice_Constant) {
+        _sccp_set(optimizer, id, state, (Ssa_Value) {0});
+        return;
+    }
+    Ssa_Value a = optimizer->constants[instr->a];
+    Ssa_Value b = count == 2 ? optimizer->constants[instr->b] : (Ssa_Value) {0};
+    Ssa_Value value;
+    // a division by zero is left to trap when it runs
+    if (!ssa_fold(optimizer->types, instr->op, instr->type, _instr(optimizer, instr->a)->type, a, b, &value)) {
+        _sccp_set(optimizer, id, Lattice_Varying, value);
+        return;
+    }
+    _sccp_set(optimizer, id, Lattice_Constant, value);
+}
+
+static
+bool _sccp(Ssa_Optimizer *optimizer) {
+    Ssa_Function *function = optimizer->function;
+    _build_users(optimizer);
+    memset(optimizer->lattice, Lattice_Unknown, function->instrs.count * sizeof(uint8_t));
+    memset(optimizer->reached, 0, function->blocks.count * sizeof(bool));
+    memset(optimizer->taken, 0, function->edges.count * sizeof(bool));
+
+    // the blocks reached for the first time, and the values that went down
+    // the lattice and whose users have to be looked at again
+    Ssa_Ids *blocks = &optimizer->stack;
+    Ssa_Ids *values = &optimizer->worklist;
+    blocks->count = 0;
+    values->count = 0;
+    optimizer->reached[0] = true;
+    da_append(blocks, 0);
+    while (blocks->count > 0 || values->count > 0) {
+        if (blocks->count > 0) {
+            Ssa_BlockId block = blocks->items[--blocks->count];
+            Ssa_Id *order = _order(optimizer, block);
+            for (uint32_t i = 0; i < _block(optimizer, block)->count; i++) {
+                _sccp_visit(optimizer, order[i]);
+            }
+            continue;
+        }
+        Ssa_Id value = values->items[--values->count];
+        Ssa_Id *users = optimizer->users.items;
+        for (Ssa_Id i = optimizer->user_start.items[value]; i < optimizer->user_start.items[value + 1]; i++) {
+            if (optimizer->reached[_instr(optimizer, users[i])->block]) {
+                _sccp_visit(optimizer, users[i]);
+            }
+        }
+    }
+
+    bool changed = false;
+    for (Ssa_BlockId block = 0; block < function->blocks.count; block++) {
+        Ssa_Block *current = _block(optimizer, block);
+        Ssa_Id *order = _order(optimizer, block);
+        if (!optimizer->reached[block]) {
+            for (uint32_t i = 0; i < current->count; i++) {
+                Ssa_Instr *instr = _instr(optimizer, order[i]);
+                Ssa_BlockId successors[2];
+                uint32_t count = ssa_successors(instr, successors);
+                for (uint32_t j = 0; j < count; j++) {
+                    _remove_pred(optimizer, successors[j], block);
+                }
+                // nothing that runs uses it
+                instr->op = Ssa_Nop;
+                instr->c = SSA_NONE;
+                changed = true;
+            }
+            current->preds = SSA_NONE;
+            current->last_pred = SSA_NONE;
+            current->pred_count = 0;
+            continue;
+        }
+        for (uint32_t i = 0; i < current->count; i++) {
+            Ssa_Id id = order[i];
+            Ssa_Instr *instr = _instr(optimizer, id);
+            if (instr->op == Ssa_Branch) {
+                assert(optimizer->lattice[instr->a] != Lattice_Unknown && "a branch that runs has a condition");
+                if (optimizer->lattice[instr->a] == Lattice_Constant) {
+                    bool then = optimizer->constants[instr->a].i;
+                    _remove_pred(optimizer, then ? instr->c : instr->b, block);
+                    instr->op = Ssa_Jump;
+                    instr->a = then ? instr->b : instr->c;
+                    changed = true;
+                }
+            } else if (instr->op != Ssa_Const && optimizer->lattice[id] == Lattice_Constant) {
+                Ssa_Value value = optimizer->constants[id];
+                instr->op = Ssa_Const;
+                instr->a = (uint32_t)value.u;
+                instr->b = (uint32_t)(value.u >> 32);
+                changed = true;
+            }
+        }
+    }
+    return changed;
+}
+
+// Dominators with the algorithm of Cooper, Harvey and Kennedy over the
+// blocks that are reached from the entry
+static
+void _dominators(Ssa_Optimizer *optimizer) {
+    Ssa_Function *function = optimizer->function;
+    size_t count = function->blocks.count;
+    Ssa_Ids *rpo = &optimizer->rpo;
+    Ssa_Ids *index = &optimizer->rpo_index;
+    Ssa_Ids *idom = &optimizer->idom;
+    _resize(index, count);
+    _resize(idom, count);
+    memset(index->items, 0xff, count * sizeof(Ssa_Id));
+    memset(idom->items, 0xff, count * sizeof(Ssa_Id));
+
+    // postorder with the successor to visit next of every block on the
+    // stack, the next one is visited when a block is marked
+    Ssa_Ids *stack = &optimizer->stack;
+    Ssa_Ids *next = &optimizer->worklist;
+    stack->count = 0;
+    next->count = 0;
+    rpo->count = 0;
+    index->items[0] = 0;
+    da_append(stack, 0);
+    da_append(next, 0);
+    while (stack->count > 0) {
+        Ssa_BlockId block = stack->items[stack->count - 1];
+        Ssa_Block *current = _block(optimizer, block);
+        Ssa_Instr *terminator = _instr(optimizer, _order(optimizer, block)[current->count - 1]);
+        Ssa_BlockId successors[2];
+        uint32_t successor_count = ssa_successors(terminator, successors);
+        uint32_t i = next->items[next->count - 1]++;
+        if (i < successor_count) {
+            if (index->items[successors[i]] == SSA_NONE) {
+                index->items[successors[i]] = 0;
+                da_append(stack, successors[i]);
+                da_append(next, 0);
+            }
+            continue;
+        }
+        da_append(rpo, block);
+        stack->count--;
+        next->count--;
+    }
+    for (size_t i = 0; i < rpo->count / 2; i++) {
+        Ssa_BlockId block = rpo->items[i];
+        rpo->items[i] = rpo->items[rpo->count - 1 - i];
+        rpo->items[rpo->count - 1 - i] = block;
+    }
+    for (size_t i = 0; i < rpo->count; i++) {
+        index->items[rpo->items[i]] = i;
+    }
+
+    idom->items[0] = 0;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 1; i < rpo->count; i++) {
+            Ssa_BlockId block = rpo->items[i];
+            Ssa_Id dominator = SSA_NONE;
+            for (uint32_t edge = _block(optimizer, block)->preds; edge != SSA_NONE; edge = function->edges.items[edge].next) {
+                Ssa_BlockId pred = function->edges.items[edge].from;
+                if (idom->items[pred] == SSA_NONE) {
+                    continue;
+                }
+                if (dominator == SSA_NONE) {
+                    dominator = pred;
+                    continue;
+                }
+                // the common dominator of both
+                Ssa_BlockId a = pred;
+                while (a != dominator) {
+                    while (index->items[a] > index->items[dominator]) a = idom->items[a];
+                    while (index->items[dominator] > index->items[a]) dominator = idom->items[dominator];
+                }
+            }
+            if (idom->items[block] != dominator) {
+                idom->items[block] = dominator;
+                changed = true;
+            }
+        }
+    }
+
+    // the children of every block, in reverse postorder
+    Ssa_Ids *start = &optimizer->child_start;
+    _resize(start, count + 1);
+    memset(start->items, 0, start->count * sizeof(Ssa_Id));
+    for (size_t i = 1; i < rpo->count; i++) {
+        start->items[idom->items[rpo->items[i]] + 1]++;
+    }
+    for (size_t i = 0; i < count; i++) {
+        start->items[i + 1] += start->items[i];
+    }
+    _resize(&optimizer->children, rpo->count);
+    for (size_t i = 1; i < rpo->count; i++) {
+        Ssa_BlockId block = rpo->items[i];
+        optimizer->children.items[start->items[idom->items[block]]++] = block;
+    }
+    memmove(start->items + 1, start->items, count * sizeof(Ssa_Id));
+    start->items[0] = 0;
+}
+
+// Global value numbering over the dominator tree, the value of an
+// instruction is its operation on the values of its operands
+static inline
+bool _commutative(Ssa_Optimizer *optimizer, Ssa_Instr *instr) {
+    switch (instr->op) {
+        case Ssa_Eq: case Ssa_Ne:
+            return true;
+        // a NaN operand of a float sum or product ends up in the result,
+        // which one depends on the order
+        case Ssa_Add: case Ssa_Mul:
+            return !types_is_float(_instr(optimizer, instr->a)->type);
+        case Ssa_BAnd: case Ssa_BOr: case Ssa_BXor:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static inline
+bool _numbered(Ssa_Op op) {
+    switch (op) {
+        case Ssa_Undef: case Ssa_Phi: case Ssa_Jump: case Ssa_Branch: case Ssa_Ret: case Ssa_Nop:
+            return false;
+        default:
+            return true;
+    }
+}
+
+static
+uint64_t _hash(Ssa_Optimizer *optimizer, Ssa_Instr *instr) {
+    uint64_t a = instr->a, b = instr->b;
+    if (_commutative(optimizer, instr) && a > b) {
+        a = instr->b;
+        b = instr->a;
+    }
+    // the low bits of a product only depend on the low bits of the key, the
+    // slot is taken from the high ones
+    uint64_t hash = ((uint64_t)instr->type << 8 | instr->op) * 0x9e3779b97f4a7c15ull;
+    hash = (hash ^ a) * 0x9e3779b97f4a7c15ull;
+    hash = (hash ^ b) * 0x9e3779b97f4a7c15ull;
+    return hash >> 32;
+}
+
+static
+bool _same(Ssa_Optimizer *optimizer, Ssa_Instr *x, Ssa_Instr *y) {
+    if (x->op != y->op || x->type != y->type) {
+        return false;
+    }
+    return (x->a == y->a && x->b == y->b)
+        || (_commutative(optimizer, x) && x->a == y->b && x->b == y->a);
+}
+
+// The phi merges a single value, or only itself and one
+static
+Ssa_Id _trivial_phi(Ssa_Optimizer *optimizer, Ssa_Id id) {
+    Ssa_Function *function = optimizer->function;
+    Ssa_Instr *instr = _instr(optimizer, id);
+    Ssa_Id same = SSA_NONE;
+    for (uint32_t i = 0; i < instr->b; i++) {
+        Ssa_Id operand = ssa_resolve(function, function->operands.items[instr->a + i]);
+        if (operand == id || operand == same) {
+            continue;
+        }
+        if (same != SSA_NONE) {
+            return SSA_NONE;
+        }
+        same = operand;
+    }
+    return same;
+}
+
+static
+bool _gvn_block(Ssa_Optimizer *optimizer, Ssa_BlockId block) {
+    Ssa_Function *function = optimizer->function;
+    size_t mask = optimizer->table_capacity - 1;
+    bool changed = false;
+    Ssa_Id *order = _order(optimizer, block);
+    for (uint32_t i = 0; i < _block(optimizer, block)->count; i++) {
+        Ssa_Id id = order[i];
+        Ssa_Instr *instr = _instr(optimizer, id);
+        if (instr->op == Ssa_Phi) {
+            Ssa_Id same = _trivial_phi(optimizer, id);
+            if (same != SSA_NONE) {
+                instr->op = Ssa_Nop;
+                instr->c = same;
+                changed = true;
+            }
+            continue;
+        }
+        if (!_numbered(instr->op)) {
+            continue;
+        }
+        if (instr->op != Ssa_Const) {
+            for (uint32_t j = 0; j < ssa_operand_count(instr); j++) {
+                Ssa_Id *operand = ssa_operand(function, instr, j);
+                *operand = ssa_resolve(function, *operand);
+            }
+        }
+        size_t slot = _hash(optimizer, instr) & mask;
+        while (optimizer->table[slot] != SSA_NONE && !_same(optimizer, _instr(optimizer, optimizer->table[slot]), instr)) {
+            slot = (slot + 1) & mask;
+        }
+        if (optimizer->table[slot] != SSA_NONE) {
+            instr->op = Ssa_Nop;
+            instr->c = optimizer->table[slot];
+            changed = true;
+            continue;
+        }
+        optimizer->table[slot] = id;
+        da_append(&optimizer->inserted, slot);
+    }
+    return changed;
+}
+
+static
+bool _gvn(Ssa_Optimizer *optimizer) {
+    Ssa_Function *function = optimizer->function;
+    _dominators(optimizer);
+
+    // half full at most
+    size_t capacity = 16;
+    while (capacity < 2 * function->order.count) {
+        capacity *= 2;
+    }
+    if (optimizer->table_capacity < capacity) {
+        free(optimizer->table);
+        optimizer->table_capacity = capacity;
+        optimizer->table = malloc(capacity * sizeof(Ssa_Id));
+        assert(optimizer->table != NULL && "Buy more RAM lol");
+    }
+    memset(optimizer->table, 0xff, optimizer->table_capacity * sizeof(Ssa_Id));
+    optimizer->inserted.count = 0;
+
+    // a block is on the stack once to be numbered and once more with the
+    // top bit set to undo its values when its children are done, the undo
+    // log length at the start of every open block is kept in `worklist`.
+    // Removing the values in the reverse order they went in leaves the
+    // probe sequences of the others intact.
+    Ssa_Ids *stack = &optimizer->stack;
+    Ssa_Ids *marks = &optimizer->worklist;
+    stack->count = 0;
+    marks->count = 0;
+    da_append(stack, 0);
+    bool changed = false;
+    while (stack->count > 0) {
+        Ssa_Id entry = stack->items[--stack->count];
+        if (entry & 0x80000000u) {
+            size_t mark = marks->items[--marks->count];
+            while (optimizer->inserted.count > mark) {
+                optimizer->table[optimizer->inserted.items[--optimizer->inserted.count]] = SSA_NONE;
+            }
+            continue;
+        }
+        da_append(marks, optimizer->inserted.count);
+        changed |= _gvn_block(optimizer, entry);
+        da_append(stack, entry | 0x80000000u);
+        for (Ssa_Id i = optimizer->child_start.items[entry + 1]; i > optimizer->child_start.items[entry]; i--) {
+            da_append(stack, optimizer->children.items[i - 1]);
+        }
+    }
+    return changed;
+}
+
+// Dead code elimination, what the terminators and the divisions that may
+// trap do not depend on is dropped
+static
+bool _may_trap(Ssa_Optimizer *optimizer, Ssa_Instr *instr) {
+    if ((instr->op != Ssa_Div && instr->op != Ssa_Mod) || !types_is_integer(instr->type)) {
+        return false;
+    }
+    Ssa_Instr *divisor = _instr(optimizer, instr->b);
+    if (divisor->op != Ssa_Const) {
+        return true;
+    }
+    Ssa_Value value = { .u = divisor->a | (uint64_t)divisor->b << 32 };
+    return ssa_normalize(optimizer->types, divisor->type, value).u == 0;
+}
+
+static
+bool _dce(Ssa_Optimizer *optimizer) {
+    Ssa_Function *function = optimizer->function;
+    memset(optimizer->live, 0, function->instrs.count * sizeof(bool));
+    Ssa_Ids *worklist = &optimizer->worklist;
+    worklist->count = 0;
+    for (size_t i = 0; i < function->order.count; i++) {
+        Ssa_Id id = function->order.items[i];
+        Ssa_Instr *instr = _instr(optimizer, id);
+        bool root = instr->op == Ssa_Jump || instr->op == Ssa_Branch || instr->op == Ssa_Ret
+            || _may_trap(optimizer, instr);
+        if (root) {
+            optimizer->live[id] = true;
+            da_append(worklist, id);
+        }
+    }
+    while (worklist->count > 0) {
+        Ssa_Instr *instr = _instr(optimizer, worklist->items[--worklist->count]);
+        for (uint32_t i = 0; i < ssa_operand_count(instr); i++) {
+            Ssa_Id operand = *ssa_operand(function, instr, i);
+            if (operand != SSA_NONE && !optimizer->live[operand]) {
+                optimizer->live[operand] = true;
+                da_append(worklist, operand);
+            }
+        }
+    }
+    bool changed = false;
+    for (size_t i = 0; i < function->order.count; i++) {
+        Ssa_Id id = function->order.items[i];
+        if (!optimizer->live[id]) {
+            _instr(optimizer, id)->op = Ssa_Nop;
+            _instr(optimizer, id)->c = SSA_NONE;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+// The terminator of `block`, grouped last by ssa_compact
+static inline
+Ssa_Instr *_terminator(Ssa_Optimizer *optimizer, Ssa_BlockId block) {
+    Ssa_Block *current = _block(optimizer, block);
+    assert(current->count > 0 && "a block that runs ends in a terminator");
+    return _instr(optimizer, _order(optimizer, block)[current->count - 1]);
+}
+
+// The block a jump of `block` goes to if it is the only way there, or
+// SSA_NONE
+static
+Ssa_BlockId _merge_target(Ssa_Optimizer *optimizer, Ssa_BlockId block) {
+    if (_block(optimizer, block)->count == 0) {
+        return SSA_NONE;
+    }
+    Ssa_Instr *terminator = _terminator(optimizer, block);
+    if (terminator->op != Ssa_Jump || terminator->a == block || _block(optimizer, terminator->a)->pred_count != 1) {
+        return SSA_NONE;
+    }
+    return terminator->a;
+}
+
+// Block merging. The blocks are marked first, a chain of them is appended
+// to the first one that is not, its head, so the order of the chain in
+// `Ssa_Function.order` stays good until ssa_compact. The instructions keep
+// their order by id, which puts those of the head first.
+static
+bool _merge(Ssa_Optimizer *optimizer) {
+    Ssa_Function *function = optimizer->function;
+    memset(optimizer->merged, 0, function->blocks.count * sizeof(bool));
+    for (Ssa_BlockId block = 0; block < function->blocks.count; block++) {
+        Ssa_BlockId target = _merge_target(optimizer, block);
+        if (target != SSA_NONE) {
+            optimizer->merged[target] = true;
+        }
+    }
+    bool changed = false;
+    for (Ssa_BlockId head = 0; head < function->blocks.count; head++) {
+        if (optimizer->merged[head]) {
+            continue;
+        }
+        Ssa_BlockId last = head;
+        for (Ssa_BlockId next = _merge_target(optimizer, last); next != SSA_NONE; next = _merge_target(optimizer, last)) {
+            Ssa_Instr *jump = _terminator(optimizer, last);
+            jump->op = Ssa_Nop;
+            jump->c = SSA_NONE;
+            Ssa_Block *current = _block(optimizer, next);
+            Ssa_Id *order = _order(optimizer, next);
+            for (uint32_t i = 0; i < current->count; i++) {
+                Ssa_Instr *instr = _instr(optimizer, order[i]);
+                instr->block = head;
+                // of the single predecessor
+                if (instr->op == Ssa_Phi) {
+                    instr->op = Ssa_Nop;
+                    instr->c = function->operands.items[instr->a];
+                }
+            }
+            current->preds = SSA_NONE;
+            current->last_pred = SSA_NONE;
+            current->pred_count = 0;
+            last = next;
+            changed = true;
+        }
+        if (last == head) {
+            continue;
+        }
+        // the successors of the chain are now those of the head
+        Ssa_BlockId successors[2];
+        uint32_t count = ssa_successors(_terminator(optimizer, last), successors);
+        for (uint32_t i = 0; i < count; i++) {
+            for (uint32_t edge = _block(optimizer, successors[i])->preds; edge != SSA_NONE; edge = function->edges.items[edge].next) {
+                if (function->edges.items[edge].from == last) {
+                    function->edges.items[edge].from = head;
+                }
+            }
+        }
+    }
+    return changed;
+}
+
+static bool (*passes[Ssa_NumberOfPasses])(Ssa_Optimizer *optimizer) = {
+    [Ssa_Pass_Sccp] = _sccp,
+    [Ssa_Pass_Gvn] = _gvn,
+    [Ssa_Pass_Dce] = _dce,
+    [Ssa_Pass_Merge] = _merge,
+};
+
+void ssa_optimize(Ssa_Optimizer *optimizer, Ssa_Function *function, Type_Table *types) {
+    optimizer->function = function;
+    optimizer->types = types;
+    memset(optimizer->stats, 0, sizeof(optimizer->stats));
+    optimizer->rounds = 0;
+    // the passes only drop instructions and edges
+    _reserve(optimizer);
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        optimizer->rounds++;
+        for (int pass = 0; pass < Ssa_NumberOfPasses; pass++) {
+            uint64_t start = _now();
+            size_t count = function->order.count;
+            if (passes[pass](optimizer)) {
+                ssa_compact(function);
+                changed = true;
+            }
+            Ssa_PassStats *stats = &optimizer->stats[pass];
+            stats->runs++;
+            stats->removed += count - function->order.count;
+            stats->ns += _now() - start;
+        }
+    }
+}
+
+void ssa_optimizer_free(Ssa_Optimizer *optimizer) {
+    free(optimizer->user_start.items);
+    free(optimizer->users.items);
+    free(optimizer->worklist.items);
+    free(optimizer->stack.items);
+    free(optimizer->lattice);
+    free(optimizer->constants);
+    free(optimizer->live);
+    free(optimizer->reached);
+    free(optimizer->merged);
+    free(optimizer->taken);
+    free(optimizer->rpo.items);
+    free(optimizer->rpo_index.items);
+    free(optimizer->idom.items);
+    free(optimizer->child_start.items);
+    free(optimizer->children.items);
+    free(optimizer->table);
+    free(optimizer->inserted.items);
+    *optimizer = (Ssa_Optimizer) {0};
+}
@@ -0,0 +1,128 @@
+#ifdef BANG_INSTRUMENT
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "metrics.h"
+#include "trace.h"
+#include "writer.h"
+
+bool trace_enabled;
+
+static _Atomic(Trace_Buffer *) trace_buffers;
+static atomic_uint trace_next_tid;
+static _Thread_local Trace_Buffer *trace_buffer;
+
+static
+Trace_Chunk *_new_chunk(void) {
+    Trace_Chunk *chunk = malloc(sizeof(Trace_Chunk));
+    assert(chunk != NULL && "Buy more RAM lol");
+    chunk->next = NULL;
+    chunk->count = 0;
+    return chunk;
+}
+
+static
+Trace_Buffer *_register_thread(void) {
+    Trace_Buffer *buffer = malloc(sizeof(Trace_Buffer));
+    assert(buffer != NULL && "Buy more RAM lol");
+    buffer->tid = atomic_fetch_add(&trace_next_tid, 1) + 1;
+    buffer->first = buffer->last = _new_chunk();
+    buffer->names = (Arena) {0};
+
+    buffer->next = atomic_load(&trace_buffers);
+    while (!atomic_compare_exchange_weak(&trace_buffers, &buffer->next, buffer));
+    return buffer;
+}
+
+void trace_event(const char *category, const char *name, char phase) {
+    uint64_t ts = metrics_now();
+    Trace_Buffer *buffer = trace_buffer;
+    if (buffer == NULL) {
+        buffer = trace_buffer = _register_thread();
+    }
+    Trace_Chunk *chunk = buffer->last;
+    if (chunk->count == TRACE_CHUNK_EVENTS) {
+        chunk = chunk->next = buffer->last = _new_chunk();
+    }
+    size_t size = strlen(name) + 1;
+    char *copy = arena_alloc(&buffer->names, size);
+    memcpy(copy, name, size);
+    chunk->events[chunk->count++] = (Trace_Event) {
+        .name = copy,
+        .category = category,
+        .ts = ts,
+        .phase = phase
+    };
+}
+
+static
+void _write_string(Writer *w, const char *str) {
+    writer_char(w, '"');
+    for (; *str != '\0'; str++) {
+        unsigned char chr = *str;
+        if (chr == '"' || chr == '\\') {
+            writer_char(w, '\\');
+            writer_char(w, chr);
+        } else if (chr < 0x20) {
+            writer_cstr(w, "\\u00");
+            writer_char(w, "0123456789abcdef"[chr >> 4]);
+            writer_char(w, "0123456789abcdef"[chr & 0xf]);
+        } else {
+            writer_char(w, chr);
+        }
+    }
+    writer_char(w, '"');
+}
+
+bool trace_dump(const char *filename) {
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "ERROR: Could not open trace file: %s: %s\n", filename, strerror(errno));
+        return false;
+    }
+
+    static Writer out;
+    Writer *w = &out;
+    writer_init(w, fd);
+
+    writer_cstr(w, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    bool first = true;
+    for (Trace_Buffer *buffer = atomic_load(&trace_buffers); buffer != NULL; buffer = buffer->next) {
+        for (Trace_Chunk *chunk = buffer->first; chunk != NULL; chunk = chunk->next) {
+            for (size_t i = 0; i < chunk->count; i++) {
+                Trace_Event *event = &chunk->events[i];
+                writer_cstr(w, first ? "\n{\"name\":" : ",\n{\"name\":");
+                _write_string(w, event->name);
+                writer_cstr(w, ",\"cat\":");
+                _write_string(w, event->category);
+                writer_cstr(w, ",\"ph\":\"");
+                writer_char(w, event->phase);
+                // trace_event timestamps are in microseconds
+                writer_cstr(w, "\",\"ts\":");
+                writer_u64(w, event->ts / 1000);
+                writer_char(w, '.');
+                uint64_t fraction = event->ts % 1000;
+                writer_char(w, '0' + fraction / 100);
+                writer_char(w, '0' + fraction / 10 % 10);
+                writer_char(w, '0' + fraction % 10);
+                writer_cstr(w, ",\"pid\":1,\"tid\":");
+                writer_u64(w, buffer->tid);
+                writer_char(w, '}');
+                first = false;
+            }
+        }
+    }
+    writer_cstr(w, "\n]}\n");
+    writer_flush(w);
+    close(fd);
+    return !w->failed;
+}
+
+#endif // BANG_INSTRUMENT
@@ -0,0 +1,68 @@
+#ifndef TRACE_H_
+#define TRACE_H_
+
+// Begin/end events in Chrome's trace_event format, for `--trace=<file>`.
+// Like metrics.h this only exists with BANG_INSTRUMENT defined, otherwise
+// the macros expand to nothing.
+
+#ifdef BANG_INSTRUMENT
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "arena.h"
+
+#define TRACE_CHUNK_EVENTS 4096
+
+typedef struct {
+    // a copy in the arena of the recording thread, names like the paths of
+    // modules are freed before the trace is dumped
+    const char *name;
+    // has to outlive the trace, string literals
+    const char *category;
+    uint64_t ts;
+    char phase;
+} Trace_Event;
+
+typedef struct _Trace_Chunk Trace_Chunk;
+
+struct _Trace_Chunk {
+    Trace_Chunk *next;
+    size_t count;
+    Trace_Event events[TRACE_CHUNK_EVENTS];
+};
+
+// Every thread records into its own buffer, so recording never takes a
+// lock. The buffers are chained into a global list when a thread records
+// its first event.
+typedef struct _Trace_Buffer Trace_Buffer;
+
+struct _Trace_Buffer {
+    Trace_Buffer *next;
+    uint32_t tid;
+    Trace_Chunk *first;
+    Trace_Chunk *last;
+    // the names of the events
+    Arena names;
+};
+
+extern bool trace_enabled;
+
+void trace_event(const char *category, const char *name, char phase);
+// Writes all recorded events to `filename`, only call once all threads
+// stopped recording
+bool trace_dump(const char *filename);
+
+#define TRACE_BEGIN(category, name) \
+    do { if (trace_enabled) trace_event((category), (name), 'B'); } while (0)
+#define TRACE_END(category, name) \
+    do { if (trace_enabled) trace_event((category), (name), 'E'); } while (0)
+
+#else
+
+#define TRACE_BEGIN(category, name)
+#define TRACE_END(category, name)
+
+#endif // BANG_INSTRUMENT
+
+#endif // TRACE_H_
@@ -0,0 +1,163 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dynarray.h"
+#include "hash.h"
+#include "types.h"
+
+#define TYPES_HASH_SEED 0x62616e6774797065ull
+
+static
+uint64_t _hash(Type_Info *info, const Type_Id *elements, size_t count) {
+    uint64_t hash = hash_mix(info->kind ^ HASH_P0, ((uint64_t)info->inner << 32 | info->nclass) ^ HASH_P1);
+    hash = hash_mix(hash ^ info->size, (info->mut | info->nullable << 1) ^ TYPES_HASH_SEED);
+    if (info->kind == Ty_Tuple) {
+        hash ^= hash_bytes(elements, count * sizeof(Type_Id), TYPES_HASH_SEED);
+    }
+    return hash;
+}
+
+static
+bool _equal(Type_Table *table, Type_Info *info, Type_Info *other, const Type_Id *elements, size_t count) {
+    if (info->kind != other->kind || info->nclass != other->nclass || info->inner != other->inner
+            || info->size != other->size || info->mut != other->mut || info->nullable != other->nullable) {
+        return false;
+    }
+    if (info->kind != Ty_Tuple) {
+        return true;
+    }
+    return other->count == count
+        && memcmp(&table->elements.items[other->start], elements, count * sizeof(Type_Id)) == 0;
+}
+
+static
+void _table_insert(Type_Table *table, uint64_t hash, Type_Id id) {
+    size_t mask = table->slots_capacity - 1;
+    size_t slot = hash & mask;
+    while (table->slots[slot] != 0) {
+        slot = (slot + 1) & mask;
+    }
+    table->slots[slot] = id + 1;
+}
+
+static
+void _table_grow(Type_Table *table) {
+    free(table->slots);
+    table->slots_capacity = table->slots_capacity == 0 ? TYPES_TABLE_INIT_CAP : table->slots_capacity * 2;
+    table->slots = calloc(table->slots_capacity, sizeof(uint32_t));
+    assert(table->slots != NULL && "Buy more RAM lol");
+    for (Type_Id id = 0; id < table->infos.count; id++) {
+        Type_Info *info = &table->infos.items[id];
+        const Type_Id *elements = &table->elements.items[info->start];
+        _table_insert(table, _hash(info, elements, info->count), id);
+    }
+}
+
+Type_Id types_intern(Type_Table *table, Type_Info info, const Type_Id *elements, size_t count) {
+    if (info.kind != Ty_Tuple) {
+        count = 0;
+    }
+    info.start = 0;
+    info.count = 0;
+    uint64_t hash = _hash(&info, elements, count);
+    if (table->slots_capacity > 0) {
+        size_t mask = table->slots_capacity - 1;
+        for (size_t slot = hash & mask; table->slots[slot] != 0; slot = (slot + 1) & mask) {
+            Type_Id id = table->slots[slot] - 1;
+            if (_equal(table, &info, &table->infos.items[id], elements, count)) {
+                return id;
+            }
+        }
+    }
+
+    // kept at most half full
+    if (2 * (table->infos.count + 1) > table->slots_capacity) {
+        _table_grow(table);
+    }
+    if (info.kind == Ty_Tuple) {
+        info.start = table->elements.count;
+        info.count = count;
+        da_append_many(&table->elements, elements, count);
+    }
+    Type_Id id = table->infos.count;
+    da_append(&table->infos, info);
+    _table_insert(table, hash, id);
+    return id;
+}
+
+void types_init(Type_Table *table) {
+    *table = (Type_Table) {0};
+    static const Type_Kind simple[] = { Ty_Error, Ty_Void, Ty_Bool, Ty_Char, Ty_Str, Ty_Nil };
+    for (size_t i = 0; i < sizeof(simple) / sizeof(simple[0]); i++) {
+        types_intern(table, (Type_Info) { .kind = simple[i] }, NULL, 0);
+    }
+    for (int nclass = 0; nclass < Nc_NumberOfElements; nclass++) {
+        types_intern(table, (Type_Info) { .kind = Ty_Number, .nclass = nclass }, NULL, 0);
+    }
+    assert(table->infos.count == Type_NumberOfPrimitives && "primitives out of sync");
+}
+
+void types_print(Writer *w, Type_Table *table, Type_Id id) {
+    Type_Info *info = types_info(table, id);
+    switch (info->kind) {
+        case Ty_Error: writer_cstr(w, "<error>"); break;
+        case Ty_Void: writer_cstr(w, "void"); break;
+        case Ty_Bool: writer_cstr(w, "bool"); break;
+        case Ty_Char: writer_cstr(w, "char"); break;
+        case Ty_Str: writer_cstr(w, "str"); break;
+        case Ty_Nil: writer_cstr(w, "nil"); break;
+        case Ty_Number:
+            writer_cstr(w, number_class_to_string(info->nclass));
+            break;
+        case Ty_Ref:
+        case Ty_Ptr:
+            writer_char(w, info->kind == Ty_Ref ? '&' : '*');
+            if (info->mut) {
+                writer_cstr(w, "let ");
+            }
+            types_print(w, table, info->inner);
+            if (info->nullable) {
+                writer_char(w, '?');
+            }
+            break;
+        case Ty_Nullable:
+            types_print(w, table, info->inner);
+            writer_char(w, '?');
+            break;
+        case Ty_Owned:
+            writer_char(w, '|');
+            types_print(w, table, info->inner);
+            writer_char(w, '|');
+            break;
+        case Ty_Array:
+            writer_char(w, '[');
+            writer_u64(w, info->size);
+            writer_char(w, ']');
+            types_print(w, table, info->inner);
+            break;
+        case Ty_Slice:
+            writer_cstr(w, "[]");
+            types_print(w, table, info->inner);
+            break;
+        case Ty_Tuple:
+            writer_char(w, '(');
+            for (uint32_t i = 0; i < info->count; i++) {
+                if (i > 0) {
+                    writer_cstr(w, ", ");
+                }
+                types_print(w, table, table->elements.items[info->start + i]);
+            }
+            writer_char(w, ')');
+            break;
+        case Ty_NumberOfElements:
+            assert(false && "unreachable");
+    }
+}
+
+void types_free(Type_Table *table) {
+    free(table->infos.items);
+    free(table->elements.items);
+    free(table->slots);
+    *table = (Type_Table) {0};
+}
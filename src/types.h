@@ -0,0 +1,149 @@
+#ifndef TYPES_H_
+#define TYPES_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "lexer.h"
+#include "writer.h"
+
+#define TYPES_TABLE_INIT_CAP 256
+
+// Types are interned: every distinct type is stored once and named by its
+// index into the table, so two types are the same exactly if their ids are.
+typedef uint32_t Type_Id;
+
+#define ENUMERATE_TYPE_KINDS \
+    _KIND(Error)             \
+    _KIND(Void)              \
+    _KIND(Bool)              \
+    _KIND(Char)              \
+    _KIND(Str)               \
+    _KIND(Nil)               \
+    _KIND(Number)            \
+    _KIND(Ref)               \
+    _KIND(Ptr)               \
+    _KIND(Nullable)          \
+    _KIND(Owned)             \
+    _KIND(Array)             \
+    _KIND(Slice)             \
+    _KIND(Tuple)
+
+typedef enum {
+#define _KIND(name) Ty_##name,
+    ENUMERATE_TYPE_KINDS
+#undef _KIND
+    Ty_NumberOfElements
+} Type_Kind;
+
+// The primitives are interned first and have fixed ids, one per number
+// class for the numbers
+enum {
+    // the type of everything that could not be typed, it is compatible
+    // with every type so an error is reported only once
+    Type_Error,
+    Type_Void,
+    Type_Bool,
+    Type_Char,
+    Type_Str,
+    Type_Nil,
+    Type_Numbers,
+    Type_NumberOfPrimitives = Type_Numbers + Nc_NumberOfElements,
+};
+
+#define TYPE_NUMBER(nclass) ((Type_Id)(Type_Numbers + (nclass)))
+
+typedef struct {
+    Type_Kind kind;
+    // Number
+    Lex_NumberClass nclass;
+    // Ref and Ptr
+    bool mut;
+    bool nullable;
+    // the pointee or element of Ref, Ptr, Nullable, Owned, Array and Slice
+    Type_Id inner;
+    // Array
+    uint64_t size;
+    // Tuple, the elements are `Type_Table.elements[start..start+count]`
+    uint32_t start;
+    uint32_t count;
+} Type_Info;
+
+typedef struct {
+    Type_Info *items;
+    size_t count;
+    size_t capacity;
+} Type_Infos;
+
+typedef struct {
+    Type_Id *items;
+    size_t count;
+    size_t capacity;
+} Type_Ids;
+
+typedef struct {
+    Type_Infos infos;
+    Type_Ids elements;
+    // open addressing on the hash of the info, id + 1 and 0 for empty slots
+    uint32_t *slots;
+    size_t slots_capacity;
+} Type_Table;
+
+void types_init(Type_Table *table);
+// The id of `info`, which is added if it is new. The elements of a tuple
+// are passed in `elements`, `info.start` and `info.count` are ignored.
+Type_Id types_intern(Type_Table *table, Type_Info info, const Type_Id *elements, size_t count);
+void types_print(Writer *w, Type_Table *table, Type_Id id);
+void types_free(Type_Table *table);
+
+static inline
+Type_Info *types_info(Type_Table *table, Type_Id id) {
+    return &table->infos.items[id];
+}
+
+static inline
+Type_Id types_pointer(Type_Table *table, Type_Kind kind, Type_Id inner, bool mut, bool nullable) {
+    Type_Info info = { .kind = kind, .inner = inner, .mut = mut, .nullable = nullable };
+    return types_intern(table, info, NULL, 0);
+}
+
+static inline
+int types_class_bits(Lex_NumberClass nclass) {
+    switch (nclass) {
+        case Nc_i8: case Nc_u8: return 8;
+        case Nc_i16: case Nc_u16: return 16;
+        case Nc_i32: case Nc_u32: return 32;
+        default: return 64;
+    }
+}
+
+// The integer `value`, in two's complement like Literal.integer, is
+// representable in `nclass`
+static inline
+bool types_class_fits(Lex_NumberClass nclass, uint64_t value) {
+    int bits = types_class_bits(nclass);
+    if (bits == 64) {
+        return true;
+    }
+    if (IS_UNSIGNED_CLASS(nclass)) {
+        return value >> bits == 0;
+    }
+    int64_t limit = (int64_t)1 << (bits - 1);
+    return (int64_t)value >= -limit && (int64_t)value < limit;
+}
+
+static inline
+bool types_is_integer(Type_Id id) {
+    return id >= Type_Numbers && id < Type_NumberOfPrimitives
+        && id != TYPE_NUMBER(Nc_f32) && id != TYPE_NUMBER(Nc_f64)
+        && id != TYPE_NUMBER(Nc_FloatingPointNumber);
+}
+
+static inline
+bool types_is_float(Type_Id id) {
+    return id == TYPE_NUMBER(Nc_f32) || id == TYPE_NUMBER(Nc_f64)
+        || id == TYPE_NUMBER(Nc_FloatingPointNumber);
+}
+
+#endif // TYPES_H_
@@ -0,0 +1,71 @@
+#include <stdlib.h>
+
+#define AST_CHILDREN_H_IMPLEMENTATION
+#include "visitor.h"
+
+static inline
+Ast_Node _make_node(Ast_WalkEntry entry) {
+    return (Ast_Node) {
+        .klass = entry.klass,
+        .ptr = *entry.slot,
+        .slot = entry.slot
+    };
+}
+
+static
+bool _walk_stack(Ast_Visitor *visitor) {
+    Ast_WalkStack *stack = &visitor->stack;
+    while (stack->count > 0) {
+        Ast_WalkEntry entry = stack->items[--stack->count];
+        Ast_Node node = _make_node(entry);
+
+        if (entry.post) {
+            if (visitor->post(visitor, node) == Visit_Break) {
+                goto stop;
+            }
+            continue;
+        }
+
+        Ast_VisitResult result = Visit_Continue;
+        if (visitor->pre != NULL) {
+            result = visitor->pre(visitor, node);
+            if (result == Visit_Break) {
+                goto stop;
+            }
+            // the pre hook may have replaced or removed the node
+            node.ptr = *entry.slot;
+            if (node.ptr == NULL) {
+                continue;
+            }
+        }
+
+        if (visitor->post != NULL) {
+            entry.post = true;
+            da_append(stack, entry);
+        }
+        if (result == Visit_Continue) {
+            ast_walk_push_children(stack, node.klass, node.ptr);
+        }
+    }
+    return true;
+stop:
+    stack->count = 0;
+    return false;
+}
+
+bool ast_walk(Ast_Visitor *visitor, Ast_NodeClass klass, void **slot) {
+    visitor->stack.count = 0;
+    ast_walk_push(&visitor->stack, klass, slot);
+    return _walk_stack(visitor);
+}
+
+bool ast_walk_source(Ast_Visitor *visitor, Ast_Source *source) {
+    visitor->stack.count = 0;
+    ast_walk_push_list(&visitor->stack, Node_Item, *source);
+    return _walk_stack(visitor);
+}
+
+void ast_visitor_free(Ast_Visitor *visitor) {
+    free(visitor->stack.items);
+    visitor->stack = (Ast_WalkStack) {0};
+}
@@ -0,0 +1,88 @@
+#ifndef VISITOR_H_
+#define VISITOR_H_
+
+#include "AST.h"
+#include "dynarray.h"
+
+typedef enum {
+    Node_Expr,
+    Node_Type,
+    Node_Stmt,
+    Node_Block,
+    Node_Item,
+} Ast_NodeClass;
+
+// A node as seen by the visitor hooks. `slot` points to the parents
+// reference of the node, so a pass can replace the node in place.
+typedef struct {
+    Ast_NodeClass klass;
+    union {
+        Ast_Expr *expr;
+        Ast_Type *type;
+        Ast_Stmt *stmt;
+        Ast_Block *block;
+        Ast_Item *item;
+        void *ptr;
+    };
+    void **slot;
+} Ast_Node;
+
+typedef enum {
+    Visit_Continue,
+    // don't descend into the children; the post hook still runs
+    Visit_Skip,
+    // stop the whole walk
+    Visit_Break,
+} Ast_VisitResult;
+
+typedef struct {
+    Ast_NodeClass klass;
+    bool post;
+    void **slot;
+} Ast_WalkEntry;
+
+typedef struct {
+    Ast_WalkEntry *items;
+    size_t count;
+    size_t capacity;
+} Ast_WalkStack;
+
+typedef struct _Ast_Visitor Ast_Visitor;
+typedef Ast_VisitResult (*Ast_VisitFn)(Ast_Visitor *visitor, Ast_Node node);
+
+// Both hooks are optional. The walk keeps its work on `stack` instead of
+// the C stack, which is kept around between walks to avoid reallocating.
+struct _Ast_Visitor {
+    Ast_VisitFn pre;
+    Ast_VisitFn post;
+    void *data;
+    Ast_WalkStack stack;
+};
+
+#define ast_walk_push(stack, node_klass, node_slot)           \
+    do {                                                      \
+        if (*(node_slot) != NULL) {                           \
+            Ast_WalkEntry __entry = {                         \
+                .klass = (node_klass),                        \
+                .post = false,                                \
+                .slot = (void **)(node_slot)                  \
+            };                                                \
+            da_append((stack), __entry);                      \
+        }                                                     \
+    } while (0)
+
+#define ast_walk_push_list(stack, node_klass, list)           \
+    do {                                                      \
+        for (size_t __i = (list).count; __i > 0; __i--) {     \
+            ast_walk_push((stack), (node_klass), &(list).items[__i - 1]); \
+        }                                                     \
+    } while (0)
+
+#include "ast_children.generated.h"
+
+// Returns false if a hook stopped the walk with `Visit_Break`
+bool ast_walk(Ast_Visitor *visitor, Ast_NodeClass klass, void **slot);
+bool ast_walk_source(Ast_Visitor *visitor, Ast_Source *source);
+void ast_visitor_free(Ast_Visitor *visitor);
+
+#endif // VISITOR_H_
@@ -0,0 +1,178 @@
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include "vm.h"
+
+int64_t vm_execute(Vm *vm, Vm_Chunk *chunk) {
+    if (vm->capacity < chunk->registers) {
+        free(vm->registers);
+        vm->capacity = chunk->registers;
+        vm->registers = malloc(vm->capacity * sizeof(Vm_Value));
+        assert(vm->registers != NULL && "Buy more RAM lol");
+    }
+
+    // one indirect jump per instruction from its own place, which the branch
+    // predictor tells apart better than the single one of a switch
+    static void *labels[Vm_NumberOfOps] = {
+#define _OP(name) [Vm_##name] = &&op_##name,
+        ENUMERATE_VM_OPS
+#undef _OP
+    };
+
+    Vm_Value *r = vm->registers;
+    const Vm_Value *k = chunk->constants.items;
+    const Vm_Instr *code = chunk->code.items;
+    const Vm_Instr *ip = code;
+    Vm_Instr i;
+
+#define DISPATCH() do { i = *ip++; goto *labels[VM_OP(i)]; } while (0)
+#define A r[VM_A(i)]
+#define B r[VM_B(i)]
+#define C r[VM_C(i)]
+#define BINARY(name, field, expr) op_##name: A.field = (expr); DISPATCH();
+
+    DISPATCH();
+
+op_LoadK: A = k[VM_BX(i)]; DISPATCH();
+op_LoadI: A.i = VM_SBX(i); DISPATCH();
+op_Move: A = B; DISPATCH();
+
+    // integers wrap around like the unsigned ones, see _narrow
+    BINARY(AddI, u, B.u + C.u)
+    BINARY(SubI, u, B.u - C.u)
+    BINARY(MulI, u, B.u * C.u)
+op_DivS:
+    if (C.i == 0) goto fail;
+    // INT64_MIN / -1 wraps around
+    A.i = C.i == -1 ? (int64_t)-B.u : B.i / C.i;
+    DISPATCH();
+op_DivU:
+    if (C.u == 0) goto fail;
+    A.u = B.u / C.u;
+    DISPATCH();
+op_ModS:
+    if (C.i == 0) goto fail;
+    A.i = C.i == -1 ? 0 : B.i % C.i;
+    DISPATCH();
+op_ModU:
+    if (C.u == 0) goto fail;
+    A.u = B.u % C.u;
+    DISPATCH();
+    BINARY(Shl, u, B.u << (C.u & 63))
+    BINARY(ShrS, i, B.i >> (C.u & 63))
+    BINARY(ShrU, u, B.u >> (C.u & 63))
+    BINARY(BAnd, u, B.u & C.u)
+    BINARY(BOr, u, B.u | C.u)
+    BINARY(BXor, u, B.u ^ C.u)
+
+    BINARY(AddF, f, B.f + C.f)
+    BINARY(SubF, f, B.f - C.f)
+    BINARY(MulF, f, B.f * C.f)
+    BINARY(DivF, f, B.f / C.f)
+    BINARY(ModF, f, fmod(B.f, C.f))
+
+    BINARY(EqI, i, B.u == C.u)
+    BINARY(NeI, i, B.u != C.u)
+    BINARY(LtS, i, B.i < C.i)
+    BINARY(LeS, i, B.i <= C.i)
+    BINARY(LtU, i, B.u < C.u)
+    BINARY(LeU, i, B.u <= C.u)
+    BINARY(EqF, i, B.f == C.f)
+    BINARY(NeF, i, B.f != C.f)
+    BINARY(LtF, i, B.f < C.f)
+    BINARY(LeF, i, B.f <= C.f)
+
+op_NegI: A.u = -B.u; DISPATCH();
+op_NegF: A.f = -B.f; DISPATCH();
+op_BNot: A.u = ~B.u; DISPATCH();
+op_Not: A.i = !B.i; DISPATCH();
+op_IntToF: A.f = (double)B.i; DISPATCH();
+op_RoundF32: A.f = (float)B.f; DISPATCH();
+op_Sext: A.i = (int64_t)(B.u << (64 - VM_C(i))) >> (64 - VM_C(i)); DISPATCH();
+op_Zext: A.u = B.u & (((uint64_t)1 << VM_C(i)) - 1); DISPATCH();
+
+op_Jmp: ip += VM_SBX(i); DISPATCH();
+op_JmpIf: if (A.i) ip += VM_SBX(i); DISPATCH();
+op_JmpIfNot: if (!A.i) ip += VM_SBX(i); DISPATCH();
+op_Halt: return -1;
+
+fail:
+    return ip - code - 1;
+
+#undef BINARY
+#undef C
+#undef B
+#undef A
+#undef DISPATCH
+}
+
+void vm_print_value(Writer *out, Vm_Value value, Type_Table *types, Type_Id type) {
+    switch (type) {
+        case Type_Bool:
+            writer_cstr(out, value.i ? "true" : "false");
+            return;
+        case Type_Char:
+            writer_char(out, '\'');
+            writer_char(out, (char)value.u);
+            writer_char(out, '\'');
+            return;
+        case Type_Nil:
+            writer_cstr(out, "nil");
+            return;
+        case Type_Void:
+            writer_cstr(out, "()");
+            return;
+        default:
+            break;
+    }
+    if (types_is_float(type)) {
+        writer_f64(out, value.f);
+    } else if (IS_UNSIGNED_CLASS(types_info(types, type)->nclass)) {
+        writer_u64(out, value.u);
+    } else {
+        writer_i64(out, value.i);
+    }
+}
+
+bool vm_run(Vm *vm, Vm_Chunk *chunk, Type_Table *types, Writer *out, Writer *err) {
+    int64_t failed = vm_execute(vm, chunk);
+    if (failed >= 0) {
+        // the only instructions that fail
+        writer_cstr(err, "ERROR: Division by zero at ");
+        lexer_print_span(err, chunk->spans.items[failed]);
+        writer_char(err, '\n');
+        return false;
+    }
+    for (size_t i = 0; i < chunk->locals.count; i++) {
+        Vm_Local *local = &chunk->locals.items[i];
+        writer_write(out, local->name.items, local->name.count);
+        writer_cstr(out, ": ");
+        types_print(out, types, local->type);
+        writer_cstr(out, " = ");
+        vm_print_value(out, vm->registers[local->reg], types, local->type);
+        writer_char(out, '\n');
+    }
+    return true;
+}
+
+void vm_chunk_reset(Vm_Chunk *chunk) {
+    chunk->code.count = 0;
+    chunk->spans.count = 0;
+    chunk->constants.count = 0;
+    chunk->locals.count = 0;
+    chunk->registers = 0;
+}
+
+void vm_chunk_free(Vm_Chunk *chunk) {
+    free(chunk->code.items);
+    free(chunk->spans.items);
+    free(chunk->constants.items);
+    free(chunk->locals.items);
+    *chunk = (Vm_Chunk) {0};
+}
+
+void vm_free(Vm *vm) {
+    free(vm->registers);
+    *vm = (Vm) {0};
+}
@@ -0,0 +1,213 @@
+#ifndef VM_H_
+#define VM_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "AST.h"
+#include "checker.h"
+#include "writer.h"
+
+// Register based bytecode for #entrypoint blocks. Every local and
+// temporary of a block has a register, an instruction names its operands by
+// register so `x = a + b * c` is two instructions instead of the six of a
+// stack machine. The instructions are typed: the compiler picks them from
+// the types the checker gave the nodes, so the interpreter never looks at
+// what a value is. Values narrower than 64 bits are kept sign or zero
+// extended and wrap around like the machine types they are named after.
+//
+// An instruction is a 64 bit word: the opcode and up to three 16 bit
+// operands, `a` is the destination. `bx` is the 32 bit b and c together,
+// a constant index or a jump offset relative to the next instruction.
+typedef uint64_t Vm_Instr;
+
+#define VM_MAX_REGISTERS 0xffff
+
+#define VM_ENCODE(op, a, b, c) \
+    ((Vm_Instr)(op) | (Vm_Instr)(a) << 16 | (Vm_Instr)(b) << 32 | (Vm_Instr)(c) << 48)
+#define VM_ENCODE_BX(op, a, bx) \
+    ((Vm_Instr)(op) | (Vm_Instr)(a) << 16 | (Vm_Instr)(uint32_t)(bx) << 32)
+#define VM_OP(instr) ((uint16_t)(instr))
+#define VM_A(instr) ((uint16_t)((instr) >> 16))
+#define VM_B(instr) ((uint16_t)((instr) >> 32))
+#define VM_C(instr) ((uint16_t)((instr) >> 48))
+#define VM_BX(instr) ((uint32_t)((instr) >> 32))
+#define VM_SBX(instr) ((int32_t)((instr) >> 32))
+
+// The S and U variants are the signed and unsigned ones, shifts take their
+// amount modulo 64. Division by zero is the only runtime error.
+#define ENUMERATE_VM_OPS \
+    /* a = ... */        \
+    _OP(LoadK)           \
+    _OP(LoadI)           \
+    _OP(Move)            \
+    /* a = b op c */     \
+    _OP(AddI)            \
+    _OP(SubI)            \
+    _OP(MulI)            \
+    _OP(DivS)            \
+    _OP(DivU)            \
+    _OP(ModS)            \
+    _OP(ModU)            \
+    _OP(Shl)             \
+    _OP(ShrS)            \
+    _OP(ShrU)            \
+    _OP(BAnd)            \
+    _OP(BOr)             \
+    _OP(BXor)            \
+    _OP(AddF)            \
+    _OP(SubF)            \
+    _OP(MulF)            \
+    _OP(DivF)            \
+    _OP(ModF)            \
+    _OP(EqI)             \
+    _OP(NeI)             \
+    _OP(LtS)             \
+    _OP(LeS)             \
+    _OP(LtU)             \
+    _OP(LeU)             \
+    _OP(EqF)             \
+    _OP(NeF)             \
+    _OP(LtF)             \
+    _OP(LeF)             \
+    /* a = op b */       \
+    _OP(NegI)            \
+    _OP(NegF)            \
+    _OP(BNot)            \
+    _OP(Not)             \
+    _OP(IntToF)          \
+    _OP(RoundF32)        \
+    /* c is the width */ \
+    _OP(Sext)            \
+    _OP(Zext)            \
+    /* by bx */          \
+    _OP(Jmp)             \
+    _OP(JmpIf)           \
+    _OP(JmpIfNot)        \
+    _OP(Halt)
+
+typedef enum {
+#define _OP(name) Vm_##name,
+    ENUMERATE_VM_OPS
+#undef _OP
+    Vm_NumberOfOps
+} Vm_Op;
+
+typedef union {
+    int64_t i;
+    uint64_t u;
+    double f;
+} Vm_Value;
+
+typedef struct {
+    Vm_Instr *items;
+    size_t count;
+    size_t capacity;
+} Vm_Code;
+
+typedef struct {
+    Vm_Value *items;
+    size_t count;
+    size_t capacity;
+} Vm_Constants;
+
+typedef struct {
+    Lex_Span *items;
+    size_t count;
+    size_t capacity;
+} Vm_Spans;
+
+// A local of the outermost block, which is reported after a run
+typedef struct {
+    String_Builder name;
+    uint32_t reg;
+    Type_Id type;
+} Vm_Local;
+
+typedef struct {
+    Vm_Local *items;
+    size_t count;
+    size_t capacity;
+} Vm_Locals;
+
+typedef struct {
+    Vm_Code code;
+    // the span of every instruction, for runtime errors
+    Vm_Spans spans;
+    Vm_Constants constants;
+    uint32_t registers;
+    Vm_Locals locals;
+} Vm_Chunk;
+
+typedef struct {
+    uint32_t *items;
+    size_t count;
+    size_t capacity;
+} Vm_Registers;
+
+// An expression or a block being compiled. Its code is emitted in steps,
+// between which the frames of its operands run, so nesting takes room in
+// Vm_Frames instead of on the C stack
+typedef struct {
+    // `block` is set instead of `expr` for a block
+    Ast_Expr *expr;
+    Ast_Block *block;
+    uint32_t dest;
+    Type_Id as;
+    int step;
+    // the first free register when it started, restored once it is done
+    uint32_t top;
+    // kept from one step to the next, what for depends on the node
+    uint32_t a;
+    uint32_t b;
+    uint32_t target;
+    Type_Id type;
+    Type_Id operand;
+    size_t jump;
+    size_t skip;
+    size_t start;
+    size_t index;
+} Vm_Frame;
+
+typedef struct {
+    Vm_Frame *items;
+    size_t count;
+    size_t capacity;
+} Vm_Frames;
+
+typedef struct {
+    Checker *checker;
+    Vm_Chunk *chunk;
+    // the register of every Decl by node id
+    Vm_Registers locals;
+    Vm_Frames frames;
+    // first free register, the ones below are locals and temporaries in use
+    uint32_t top;
+    // nesting of the blocks, the locals at depth 1 go into Vm_Chunk.locals
+    int depth;
+    Writer *err;
+    bool failed;
+} Vm_Compiler;
+
+typedef struct {
+    Vm_Value *registers;
+    size_t capacity;
+} Vm;
+
+// Compiles `block`, which has to be checked by `checker`, into `chunk`.
+// Expressions the VM does not cover yet, like calls, are reported to `err`.
+bool vm_compile(Vm_Compiler *compiler, Checker *checker, Ast_Block *block, Vm_Chunk *chunk, Writer *err);
+// Runs `chunk` and prints the locals of its outermost block to `out`,
+// runtime errors go to `err`
+bool vm_run(Vm *vm, Vm_Chunk *chunk, Type_Table *types, Writer *out, Writer *err);
+// Runs `chunk`, returns the index of the failing instruction or -1
+int64_t vm_execute(Vm *vm, Vm_Chunk *chunk);
+// Prints `value` as a value of `type` the way vm_run prints the locals
+void vm_print_value(Writer *out, Vm_Value value, Type_Table *types, Type_Id type);
+void vm_chunk_reset(Vm_Chunk *chunk);
+void vm_chunk_free(Vm_Chunk *chunk);
+void vm_compiler_free(Vm_Compiler *compiler);
+void vm_free(Vm *vm);
+
+#endif // VM_H_
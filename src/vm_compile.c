@@ -0,0 +1,553 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dynarray.h"
+#include "vm.h"
+
+// the value of an expression that is only evaluated for its effects
+#define VM_DISCARD UINT32_MAX
+
+static
+size_t _emit(Vm_Compiler *compiler, Vm_Instr instr, Lex_Span span) {
+    da_append(&compiler->chunk->code, instr);
+    da_append(&compiler->chunk->spans, span);
+    return compiler->chunk->code.count - 1;
+}
+
+static
+void _error(Vm_Compiler *compiler, const char *message, const char *what, Lex_Span span) {
+    compiler->failed = true;
+    writer_cstr(compiler->err, "ERROR: ");
+    writer_cstr(compiler->err, message);
+    writer_cstr(compiler->err, what);
+    writer_cstr(compiler->err, " at ");
+    lexer_print_span(compiler->err, span);
+    writer_char(compiler->err, '\n');
+}
+
+static
+uint32_t _push(Vm_Compiler *compiler, Lex_Span span) {
+    if (compiler->top == VM_MAX_REGISTERS) {
+        if (!compiler->failed) {
+            _error(compiler, "Too many locals and temporaries", "", span);
+        }
+        // keeps compiling into some register, the chunk is not run
+        return 0;
+    }
+    uint32_t reg = compiler->top++;
+    if (compiler->top > compiler->chunk->registers) {
+        compiler->chunk->registers = compiler->top;
+    }
+    return reg;
+}
+
+static inline
+Type_Id _type_of(Vm_Compiler *compiler, Ast_Expr *expr) {
+    return check_type_of(compiler->checker, expr->id);
+}
+
+// Jumps to the next instruction to be emitted
+static
+void _patch(Vm_Compiler *compiler, size_t jump) {
+    Vm_Instr *instr = &compiler->chunk->code.items[jump];
+    int64_t offset = (int64_t)compiler->chunk->code.count - (int64_t)(jump + 1);
+    *instr = VM_ENCODE_BX(VM_OP(*instr), VM_A(*instr), (int32_t)offset);
+}
+
+// Wraps `reg` around to the width of `type`
+static
+void _narrow(Vm_Compiler *compiler, uint32_t reg, Type_Id type, Lex_Span span) {
+    if (type == TYPE_NUMBER(Nc_f32)) {
+        _emit(compiler, VM_ENCODE(Vm_RoundF32, reg, reg, 0), span);
+        return;
+    }
+    if (!types_is_integer(type)) {
+        return;
+    }
+    Lex_NumberClass nclass = types_info(&compiler->checker->table, type)->nclass;
+    int bits = types_class_bits(nclass);
+    if (bits < 64) {
+        Vm_Op op = IS_UNSIGNED_CLASS(nclass) ? Vm_Zext : Vm_Sext;
+        _emit(compiler, VM_ENCODE(op, reg, reg, bits), span);
+    }
+}
+
+static inline
+bool _is_plain(Type_Id type) {
+    return type == TYPE_NUMBER(Nc_Number) || type == TYPE_NUMBER(Nc_FloatingPointNumber);
+}
+
+// A value of a plain number type is computed in 64 bits and takes the type
+// of the place it goes to, a plain Number given a float type holds an integer
+static
+void _convert(Vm_Compiler *compiler, uint32_t reg, Type_Id from, Type_Id to, Lex_Span span) {
+    if (!_is_plain(from) || from == to) {
+        return;
+    }
+    if (from == TYPE_NUMBER(Nc_Number) && types_is_float(to)) {
+        _emit(compiler, VM_ENCODE(Vm_IntToF, reg, reg, 0), span);
+    }
+    if (!_is_plain(to)) {
+        _narrow(compiler, reg, to, span);
+    }
+}
+
+// The type the operands of a binary operator are evaluated in, the checker
+// unified them already
+static
+Type_Id _unified(Type_Id lhs, Type_Id rhs) {
+    if (lhs == TYPE_NUMBER(Nc_Number) || (lhs == TYPE_NUMBER(Nc_FloatingPointNumber) && rhs != TYPE_NUMBER(Nc_Number))) {
+        return rhs;
+    }
+    return lhs;
+}
+
+// Compiles the value of `expr` into `dest` as a value of `as`, which is
+// the type of the place it goes to. Only its frame is pushed, the code is
+// emitted by _compile_frames, the frame on top first
+static
+void _compile_expr(Vm_Compiler *compiler, Ast_Expr *expr, uint32_t dest, Type_Id as) {
+    Vm_Frame frame = { .expr = expr, .dest = dest, .as = as, .top = compiler->top };
+    da_append(&compiler->frames, frame);
+}
+
+static
+void _compile_block(Vm_Compiler *compiler, Ast_Block *block, uint32_t dest, Type_Id as) {
+    Vm_Frame frame = { .block = block, .dest = dest, .as = as, .top = compiler->top };
+    da_append(&compiler->frames, frame);
+}
+
+// Pops the frame on top, the registers it took are free again
+static
+void _done(Vm_Compiler *compiler) {
+    Vm_Frames *frames = &compiler->frames;
+    compiler->top = frames->items[--frames->count].top;
+}
+
+// Writes the register holding the value of `expr` as `as` to `reg`, locals
+// are used in place. Anything else is compiled into a new register by a
+// frame, after which the frame that asked may have moved
+static
+void _operand(Vm_Compiler *compiler, Ast_Expr *expr, Type_Id as, uint32_t *reg) {
+    while (expr->kind == Paren_kind) {
+        expr = expr->Paren.expr;
+    }
+    if (expr->kind == Path_kind && expr->Path.path.decl != NULL) {
+        // locals are never plain Numbers, there is nothing to convert
+        *reg = compiler->locals.items[expr->Path.path.decl->id];
+        return;
+    }
+    *reg = _push(compiler, expr->span);
+    _compile_expr(compiler, expr, *reg, as);
+}
+
+// `reg` was taken as the left operand before the code from `start` on, the
+// right operand, was compiled. If that code assigns to it, as in
+// `a + (a = 1)`, the left operand is copied before that happens.
+static
+uint32_t _protect(Vm_Compiler *compiler, size_t start, uint32_t reg, Lex_Span span) {
+    Vm_Code *code = &compiler->chunk->code;
+    bool written = false;
+    for (size_t i = start; i < code->count && !written; i++) {
+        Vm_Op op = VM_OP(code->items[i]);
+        written = op != Vm_Jmp && op != Vm_JmpIf && op != Vm_JmpIfNot && VM_A(code->items[i]) == reg;
+    }
+    if (!written) {
+        return reg;
+    }
+    // above every register the right operand uses, so the copy survives it
+    compiler->top = compiler->chunk->registers;
+    uint32_t copy = _push(compiler, span);
+    _emit(compiler, VM_ENCODE(Vm_Move, copy, reg, 0), span);
+    Vm_Spans *spans = &compiler->chunk->spans;
+    // the code in between only jumps within itself, relative jumps stay valid
+    memmove(&code->items[start + 1], &code->items[start], (code->count - start - 1) * sizeof(Vm_Instr));
+    memmove(&spans->items[start + 1], &spans->items[start], (spans->count - start - 1) * sizeof(Lex_Span));
+    code->items[start] = VM_ENCODE(Vm_Move, copy, reg, 0);
+    spans->items[start] = span;
+    return copy;
+}
+
+static
+void _compile_literal(Vm_Compiler *compiler, Ast_Expr *expr, uint32_t dest) {
+    Ast_LiteralExpr *literal = &expr->Literal;
+    Vm_Value value = {0};
+    switch (literal->kind) {
+        case L_Integer: value.u = literal->integer; break;
+        case L_Float:
+            value.f = literal->nclass == Nc_f32 ? (float)literal->floating : literal->floating;
+            break;
+        case L_Boolean: value.i = literal->boolean; break;
+        case L_Char: value.i = literal->wchar; break;
+        case L_Nil: value.i = 0; break;
+        case L_String:
+            _error(compiler, "Cannot run ", "a string", expr->span);
+            return;
+    }
+    if (literal->kind != L_Float && value.i >= INT32_MIN && value.i <= INT32_MAX) {
+        _emit(compiler, VM_ENCODE_BX(Vm_LoadI, dest, (int32_t)value.i), expr->span);
+        return;
+    }
+    _emit(compiler, VM_ENCODE_BX(Vm_LoadK, dest, compiler->chunk->constants.count), expr->span);
+    da_append(&compiler->chunk->constants, value);
+}
+
+// The instruction of `op` for operands of `type`, 0 with `swap` set for the
+// comparisons that are the reverse of another
+static
+Vm_Op _binary_op(Vm_Compiler *compiler, BinaryOp op, Type_Id type, bool *swap) {
+    bool is_float = types_is_float(type);
+    bool is_unsigned = types_is_integer(type)
+        && IS_UNSIGNED_CLASS(types_info(&compiler->checker->table, type)->nclass);
+    *swap = false;
+    switch (op) {
+        case Bo_Plus: return is_float ? Vm_AddF : Vm_AddI;
+        case Bo_Minus: return is_float ? Vm_SubF : Vm_SubI;
+        case Bo_Mul: return is_float ? Vm_MulF : Vm_MulI;
+        case Bo_Div: return is_float ? Vm_DivF : is_unsigned ? Vm_DivU : Vm_DivS;
+        case Bo_Mod: return is_float ? Vm_ModF : is_unsigned ? Vm_ModU : Vm_ModS;
+        case Bo_Shl: return Vm_Shl;
+        case Bo_Shr: return is_unsigned ? Vm_ShrU : Vm_ShrS;
+        case Bo_BAnd: return Vm_BAnd;
+        case Bo_BOr: return Vm_BOr;
+        case Bo_BXor: return Vm_BXor;
+        case Bo_Eq: return is_float ? Vm_EqF : Vm_EqI;
+        case Bo_Ne: return is_float ? Vm_NeF : Vm_NeI;
+        case Bo_Gt: *swap = true; // fallthrough
+        case Bo_Lt: return is_float ? Vm_LtF : is_unsigned ? Vm_LtU : Vm_LtS;
+        case Bo_Ge: *swap = true; // fallthrough
+        case Bo_Le: return is_float ? Vm_LeF : is_unsigned ? Vm_LeU : Vm_LeS;
+        default: break;
+    }
+    assert(false && "unreachable");
+}
+
+// The steps return right after pushing a frame, which may move the one they
+// were given
+
+static
+void _binary_step(Vm_Compiler *compiler, Vm_Frame *frame) {
+    Ast_Expr *expr = frame->expr;
+    BinaryOp op = expr->Binary.op;
+    Ast_Expr *lhs = expr->Binary.lhs;
+    Ast_Expr *rhs = expr->Binary.rhs;
+    switch (frame->step++) {
+        case 0: {
+            if (op == Bo_And || op == Bo_Or) {
+                // not into `dest` right away, it may be a local the rhs reads
+                uint32_t value = _push(compiler, expr->span);
+                frame->a = value;
+                frame->step = 3;
+                _compile_expr(compiler, lhs, value, Type_Bool);
+                return;
+            }
+            frame->target = frame->dest != VM_DISCARD ? frame->dest : _push(compiler, expr->span);
+
+            // the shift amount keeps its own type
+            Type_Id lhs_type = _type_of(compiler, lhs);
+            Type_Id rhs_type = _type_of(compiler, rhs);
+            bool shift = op == Bo_Shl || op == Bo_Shr;
+            frame->type = shift ? lhs_type : _unified(lhs_type, rhs_type);
+            frame->operand = shift ? rhs_type : frame->type;
+            _operand(compiler, lhs, frame->type, &frame->a);
+        } return;
+        case 1:
+            frame->start = compiler->chunk->code.count;
+            _operand(compiler, rhs, frame->operand, &frame->b);
+            return;
+        case 2: {
+            uint32_t a = _protect(compiler, frame->start, frame->a, expr->span);
+            uint32_t b = frame->b;
+            bool swap;
+            Vm_Op instr = _binary_op(compiler, op, frame->type, &swap);
+            _emit(compiler, swap ? VM_ENCODE(instr, frame->target, b, a) : VM_ENCODE(instr, frame->target, a, b), expr->span);
+            _narrow(compiler, frame->target, _type_of(compiler, expr), expr->span);
+        } break;
+        case 3: {
+            Vm_Op jump = op == Bo_And ? Vm_JmpIfNot : Vm_JmpIf;
+            frame->jump = _emit(compiler, VM_ENCODE_BX(jump, frame->a, 0), expr->span);
+            _compile_expr(compiler, rhs, frame->a, Type_Bool);
+        } return;
+        case 4:
+            _patch(compiler, frame->jump);
+            if (frame->dest != VM_DISCARD) {
+                _emit(compiler, VM_ENCODE(Vm_Move, frame->dest, frame->a, 0), expr->span);
+            }
+            break;
+    }
+    if (frame->dest != VM_DISCARD) {
+        _convert(compiler, frame->dest, _type_of(compiler, expr), frame->as, expr->span);
+    }
+    _done(compiler);
+}
+
+static
+void _unary_step(Vm_Compiler *compiler, Vm_Frame *frame) {
+    Ast_Expr *expr = frame->expr;
+    UnaryOp op = expr->Unary.op;
+    if (frame->step++ == 0) {
+        Type_Id type = _type_of(compiler, expr);
+        if (op == Uo_Deref) {
+            _error(compiler, "Cannot run ", "a dereference", expr->span);
+            _done(compiler);
+            return;
+        }
+        // a plain operand is converted first, so `-1` is negated as a float
+        // when it goes into one
+        frame->type = _is_plain(type) && !_is_plain(frame->as) ? frame->as : type;
+        _operand(compiler, expr->Unary.expr, frame->type, &frame->a);
+        return;
+    }
+    Type_Id result = frame->type;
+    uint32_t target = frame->dest != VM_DISCARD ? frame->dest : _push(compiler, expr->span);
+    bool is_float = types_is_float(result);
+    Vm_Op instr = Vm_Move;
+    switch (op) {
+        case Uo_Minus: instr = is_float ? Vm_NegF : Vm_NegI; break;
+        case Uo_BitwiseNot: instr = Vm_BNot; break;
+        case Uo_Not: instr = Vm_Not; break;
+        default: break;
+    }
+    _emit(compiler, VM_ENCODE(instr, target, frame->a, 0), expr->span);
+    _narrow(compiler, target, result, expr->span);
+    _done(compiler);
+}
+
+static
+void _assign_step(Vm_Compiler *compiler, Vm_Frame *frame) {
+    Ast_Expr *expr = frame->expr;
+    BinaryOp op = check_compound_operator(expr->Assign.op);
+    switch (frame->step) {
+        case 0: {
+            Ast_Expr *lhs = expr->Assign.lhs;
+            while (lhs->kind == Paren_kind) {
+                lhs = lhs->Paren.expr;
+            }
+            if (lhs->kind != Path_kind || lhs->Path.path.decl == NULL) {
+                _error(compiler, "Cannot run ", "an assignment to anything but a local", expr->span);
+                _done(compiler);
+                return;
+            }
+            uint32_t local = compiler->locals.items[lhs->Path.path.decl->id];
+            Type_Id type = _type_of(compiler, lhs);
+            frame->target = local;
+            frame->type = type;
+
+            if (op == Bo_Invalid) {
+                frame->step = 3;
+                _compile_expr(compiler, expr->Assign.rhs, local, type);
+            } else if (op == Bo_And || op == Bo_Or) {
+                Vm_Op jump = op == Bo_And ? Vm_JmpIfNot : Vm_JmpIf;
+                frame->jump = _emit(compiler, VM_ENCODE_BX(jump, local, 0), expr->span);
+                frame->step = 2;
+                _compile_expr(compiler, expr->Assign.rhs, local, type);
+            } else {
+                bool shift = op == Bo_Shl || op == Bo_Shr;
+                Type_Id rhs_type = _type_of(compiler, expr->Assign.rhs);
+                frame->step = 1;
+                _operand(compiler, expr->Assign.rhs, shift ? rhs_type : type, &frame->a);
+            }
+        } return;
+        case 1: {
+            bool swap;
+            Vm_Op instr = _binary_op(compiler, op, frame->type, &swap);
+            _emit(compiler, VM_ENCODE(instr, frame->target, frame->target, frame->a), expr->span);
+            _narrow(compiler, frame->target, frame->type, expr->span);
+        } break;
+        case 2:
+            _patch(compiler, frame->jump);
+            break;
+        case 3:
+            break;
+    }
+    if (frame->dest != VM_DISCARD && frame->dest != frame->target) {
+        _emit(compiler, VM_ENCODE(Vm_Move, frame->dest, frame->target, 0), expr->span);
+    }
+    _done(compiler);
+}
+
+static
+void _if_step(Vm_Compiler *compiler, Vm_Frame *frame) {
+    Ast_Expr *expr = frame->expr;
+    switch (frame->step++) {
+        case 0:
+            _operand(compiler, expr->If.condition, Type_Bool, &frame->a);
+            return;
+        case 1:
+            frame->jump = _emit(compiler, VM_ENCODE_BX(Vm_JmpIfNot, frame->a, 0), expr->span);
+            compiler->top = frame->top;
+            _compile_block(compiler, expr->If.if_branch, frame->dest, frame->as);
+            return;
+        case 2:
+            if (expr->If.else_block == NULL) {
+                _patch(compiler, frame->jump);
+                break;
+            }
+            frame->skip = _emit(compiler, VM_ENCODE_BX(Vm_Jmp, 0, 0), expr->span);
+            _patch(compiler, frame->jump);
+            _compile_expr(compiler, expr->If.else_block, frame->dest, frame->as);
+            return;
+        case 3:
+            _patch(compiler, frame->skip);
+            break;
+    }
+    _done(compiler);
+}
+
+static
+void _expr_step(Vm_Compiler *compiler, Vm_Frame *frame) {
+    Ast_Expr *expr = frame->expr;
+    uint32_t dest = frame->dest;
+    switch (expr->kind) {
+        case Literal_kind:
+            if (dest != VM_DISCARD) {
+                _compile_literal(compiler, expr, dest);
+                _convert(compiler, dest, _type_of(compiler, expr), frame->as, expr->span);
+            }
+            break;
+        case Path_kind: {
+            Ast_Stmt *decl = expr->Path.path.decl;
+            // the checker reported unresolved names already
+            assert(decl != NULL && "unresolved path");
+            uint32_t local = compiler->locals.items[decl->id];
+            if (dest != VM_DISCARD && dest != local) {
+                _emit(compiler, VM_ENCODE(Vm_Move, dest, local, 0), expr->span);
+            }
+        } break;
+        // the same frame goes on with what is inside
+        case Paren_kind:
+            frame->expr = expr->Paren.expr;
+            return;
+        case Block_kind:
+            frame->expr = NULL;
+            frame->block = expr->Block.block;
+            return;
+        case Unary_kind:
+            _unary_step(compiler, frame);
+            return;
+        case Binary_kind:
+            _binary_step(compiler, frame);
+            return;
+        case Assign_kind:
+            _assign_step(compiler, frame);
+            return;
+        case If_kind:
+            _if_step(compiler, frame);
+            return;
+        case Call_kind:
+            _error(compiler, "Cannot run ", "a call", expr->span);
+            break;
+        case Subscript_kind:
+            _error(compiler, "Cannot run ", "a subscript", expr->span);
+            break;
+        case Member_kind:
+            _error(compiler, "Cannot run ", "a member access", expr->span);
+            break;
+        case Refrence_kind:
+            _error(compiler, "Cannot run ", "a reference", expr->span);
+            break;
+        default:
+            assert(false && "unreachable");
+    }
+    _done(compiler);
+}
+
+// Bound after the init, like the resolver does
+static
+void _bind(Vm_Compiler *compiler, Ast_Stmt *stmt, uint32_t reg, Type_Id type) {
+    compiler->locals.items[stmt->id] = reg;
+    if (compiler->depth == 1) {
+        Vm_Local local = { .name = stmt->Decl.ident, .reg = reg, .type = type };
+        da_append(&compiler->chunk->locals, local);
+    }
+}
+
+// The value of a block is the expression it ends in without a semicolon
+static
+void _block_step(Vm_Compiler *compiler, Vm_Frame *frame) {
+    Ast_Block *block = frame->block;
+    switch (frame->step) {
+        case 0:
+            compiler->depth++;
+            frame->step = 1;
+            return;
+        case 2:
+            _bind(compiler, block->stmts.items[frame->index - 1], frame->a, frame->type);
+            frame->step = 1;
+            return;
+    }
+    if (frame->index == block->stmts.count) {
+        compiler->depth--;
+        _done(compiler);
+        return;
+    }
+    size_t i = frame->index++;
+    Ast_Stmt *stmt = block->stmts.items[i];
+    if (stmt->kind != Decl_kind) {
+        bool value = i + 1 == block->stmts.count && !stmt->Expr.semicolon;
+        _compile_expr(compiler, stmt->Expr.expr, value ? frame->dest : VM_DISCARD, frame->as);
+        return;
+    }
+
+    Type_Id type = check_type_of(compiler->checker, stmt->id);
+    // registers hold scalars, strings and pointers have no value to run on
+    bool scalar = type != Type_Str && type < Type_NumberOfPrimitives;
+    if (!scalar) {
+        _error(compiler, "Cannot run ", "a local that is not a scalar", stmt->span);
+    }
+    uint32_t reg = _push(compiler, stmt->span);
+    if (stmt->Decl.init != NULL && scalar) {
+        frame->a = reg;
+        frame->type = type;
+        frame->step = 2;
+        _compile_expr(compiler, stmt->Decl.init, reg, type);
+        return;
+    }
+    _emit(compiler, VM_ENCODE_BX(Vm_LoadI, reg, 0), stmt->span);
+    _bind(compiler, stmt, reg, type);
+}
+
+// Runs the frames until all of them are done
+static
+void _compile_frames(Vm_Compiler *compiler) {
+    while (compiler->frames.count > 0) {
+        Vm_Frame *frame = &compiler->frames.items[compiler->frames.count - 1];
+        if (frame->block != NULL) {
+            _block_step(compiler, frame);
+        } else {
+            _expr_step(compiler, frame);
+        }
+    }
+}
+
+bool vm_compile(Vm_Compiler *compiler, Checker *checker, Ast_Block *block, Vm_Chunk *chunk, Writer *err) {
+    compiler->checker = checker;
+    compiler->chunk = chunk;
+    compiler->err = err;
+    compiler->failed = false;
+    compiler->top = 0;
+    compiler->depth = 0;
+    // by node id like the types of the checker, only the Decl slots are used
+    compiler->locals.count = 0;
+    if (compiler->locals.capacity < checker->types.count) {
+        free(compiler->locals.items);
+        compiler->locals.capacity = checker->types.count;
+        compiler->locals.items = malloc(compiler->locals.capacity * sizeof(uint32_t));
+        assert(compiler->locals.items != NULL && "Buy more RAM lol");
+    }
+    compiler->locals.count = checker->types.count;
+
+    vm_chunk_reset(chunk);
+    compiler->frames.count = 0;
+    _compile_block(compiler, block, VM_DISCARD, Type_Void);
+    _compile_frames(compiler);
+    _emit(compiler, VM_ENCODE(Vm_Halt, 0, 0, 0), block->span);
+    return !compiler->failed;
+}
+
+void vm_compiler_free(Vm_Compiler *compiler) {
+    free(compiler->locals.items);
+    free(compiler->frames.items);
+    *compiler = (Vm_Compiler) {0};
+}
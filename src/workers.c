@@ -0,0 +1,185 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "workers.h"
+
+#define WORKERS_DEQUE_INIT_CAP 16
+
+typedef struct {
+    Workers *workers;
+    size_t id;
+} Workers_Thread;
+
+void workers_init(Workers *workers, size_t count, Workers_TaskFn task, void *data) {
+    assert(count > 0 && "need at least one worker");
+    *workers = (Workers) {
+        .deques = calloc(count, sizeof(Workers_Deque)),
+        .count = count,
+        .task = task,
+        .data = data,
+    };
+    assert(workers->deques != NULL && "Buy more RAM lol");
+    for (size_t i = 0; i < count; i++) {
+        pthread_mutex_init(&workers->deques[i].lock, NULL);
+    }
+    pthread_mutex_init(&workers->lock, NULL);
+    pthread_cond_init(&workers->changed, NULL);
+}
+
+// Room for `count` more tasks at the back, has to be called with the lock
+// of `deque` held
+static
+void _reserve(Workers_Deque *deque, size_t count) {
+    if (deque->tail + count <= deque->capacity) {
+        return;
+    }
+    size_t pending = deque->tail - deque->head;
+    // an empty deque may not have items yet
+    if (pending > 0) {
+        memmove(deque->items, deque->items + deque->head, pending * sizeof(void *));
+    }
+    deque->head = 0;
+    deque->tail = pending;
+    if (pending + count <= deque->capacity) {
+        return;
+    }
+    size_t capacity = deque->capacity == 0 ? WORKERS_DEQUE_INIT_CAP : deque->capacity;
+    while (capacity < pending + count) {
+        capacity *= 2;
+    }
+    deque->items = realloc(deque->items, capacity * sizeof(void *));
+    assert(deque->items != NULL && "Buy more RAM lol");
+    deque->capacity = capacity;
+}
+
+void workers_push(Workers *workers, size_t worker, void *task) {
+    // counted before it can be stolen, so it can not be done before
+    pthread_mutex_lock(&workers->lock);
+    workers->pending++;
+    pthread_mutex_unlock(&workers->lock);
+
+    Workers_Deque *deque = &workers->deques[worker];
+    pthread_mutex_lock(&deque->lock);
+    _reserve(deque, 1);
+    deque->items[deque->tail++] = task;
+    pthread_mutex_unlock(&deque->lock);
+
+    pthread_mutex_lock(&workers->lock);
+    workers->pushes++;
+    pthread_cond_signal(&workers->changed);
+    pthread_mutex_unlock(&workers->lock);
+}
+
+static
+bool _pop(Workers_Deque *deque, void **task) {
+    pthread_mutex_lock(&deque->lock);
+    bool found = deque->head < deque->tail;
+    if (found) {
+        *task = deque->items[--deque->tail];
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+
+// Moves the front half of a victims deque into the empty deque of `id`. The
+// two locks are taken in the order of the deques, two workers stealing from
+// each other can not deadlock
+static
+bool _steal(Workers *workers, size_t id) {
+    Workers_Deque *own = &workers->deques[id];
+    for (size_t i = 1; i < workers->count; i++) {
+        size_t other = (id + i) % workers->count;
+        Workers_Deque *victim = &workers->deques[other];
+        pthread_mutex_lock(other < id ? &victim->lock : &own->lock);
+        pthread_mutex_lock(other < id ? &own->lock : &victim->lock);
+        size_t pending = victim->tail - victim->head;
+        if (pending > 0) {
+            size_t take = (pending + 1) / 2;
+            _reserve(own, take);
+            memcpy(own->items + own->tail, victim->items + victim->head, take * sizeof(void *));
+            own->tail += take;
+            victim->head += take;
+        }
+        pthread_mutex_unlock(&victim->lock);
+        pthread_mutex_unlock(&own->lock);
+        if (pending > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static
+void *_worker_main(void *arg) {
+    Workers_Thread *thread = arg;
+    Workers *workers = thread->workers;
+    Workers_Deque *own = &workers->deques[thread->id];
+    void *task;
+    while (true) {
+        while (_pop(own, &task)) {
+            workers->task(workers->data, thread->id, task);
+            pthread_mutex_lock(&workers->lock);
+            if (--workers->pending == 0) {
+                pthread_cond_broadcast(&workers->changed);
+            }
+            pthread_mutex_unlock(&workers->lock);
+        }
+
+        pthread_mutex_lock(&workers->lock);
+        size_t pushes = workers->pushes;
+        bool done = workers->pending == 0;
+        pthread_mutex_unlock(&workers->lock);
+        if (done) {
+            break;
+        }
+        if (_steal(workers, thread->id)) {
+            continue;
+        }
+        // the pending tasks are running on other workers and may push more,
+        // a push after `pushes` was read is in a deque before it is counted
+        pthread_mutex_lock(&workers->lock);
+        while (workers->pushes == pushes && workers->pending > 0) {
+            pthread_cond_wait(&workers->changed, &workers->lock);
+        }
+        pthread_mutex_unlock(&workers->lock);
+    }
+    return NULL;
+}
+
+void workers_run(Workers *workers) {
+    size_t count = workers->count;
+    Workers_Thread *threads = malloc(count * sizeof(Workers_Thread));
+    pthread_t *handles = malloc(count * sizeof(pthread_t));
+    assert(threads != NULL && handles != NULL && "Buy more RAM lol");
+
+    for (size_t i = 0; i < count; i++) {
+        threads[i] = (Workers_Thread) { .workers = workers, .id = i };
+    }
+    for (size_t i = 1; i < count; i++) {
+        int error = pthread_create(&handles[i], NULL, _worker_main, &threads[i]);
+        assert(error == 0 && "could not start worker thread");
+    }
+    _worker_main(&threads[0]);
+    for (size_t i = 1; i < count; i++) {
+        pthread_join(handles[i], NULL);
+    }
+    free(handles);
+    free(threads);
+}
+
+void workers_free(Workers *workers) {
+    for (size_t i = 0; i < workers->count; i++) {
+        pthread_mutex_destroy(&workers->deques[i].lock);
+        free(workers->deques[i].items);
+    }
+    pthread_cond_destroy(&workers->changed);
+    pthread_mutex_destroy(&workers->lock);
+    free(workers->deques);
+}
+
+size_t workers_default_count(void) {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (size_t)count : 1;
+}
@@ -0,0 +1,51 @@
+#ifndef WORKERS_H_
+#define WORKERS_H_
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Runs tasks on `count` threads, the calling thread being worker 0, until
+// none is left, a task may push more of them. Every worker has a deque of
+// its own: the tasks it pushes go onto the back and it takes the latest one
+// from there, which keeps a chain of tasks pushing each other going on one
+// worker. Once its deque runs dry it steals the front half, the oldest
+// tasks, of the deque of another worker. `worker` identifies the running
+// thread, so tasks can use per-worker state without locking.
+typedef void (*Workers_TaskFn)(void *data, size_t worker, void *task);
+
+typedef struct {
+    pthread_mutex_t lock;
+    // pending tasks [head, tail)
+    void **items;
+    size_t head;
+    size_t tail;
+    size_t capacity;
+} Workers_Deque;
+
+typedef struct {
+    Workers_Deque *deques;
+    size_t count;
+    Workers_TaskFn task;
+    void *data;
+
+    // guards the counts below, idle workers wait on `changed`
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    // pushed and not done yet
+    size_t pending;
+    // bumped by every push, so an idle worker notices one it raced with
+    size_t pushes;
+} Workers;
+
+void workers_init(Workers *workers, size_t count, Workers_TaskFn task, void *data);
+// Queues `task` on the deque of `worker`, any of them before workers_run and
+// the calling one from within a task
+void workers_push(Workers *workers, size_t worker, void *task);
+// Returns once every task pushed, before or while running, is done
+void workers_run(Workers *workers);
+void workers_free(Workers *workers);
+// Online CPUs, at least 1
+size_t workers_default_count(void);
+
+#endif // WORKERS_H_
@@ -0,0 +1,138 @@
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "dynarray.h"
+#include "writer.h"
+
+void writer_init(Writer *w, int fd) {
+    w->fd = fd;
+    w->sink = NULL;
+    w->failed = false;
+    w->count = 0;
+}
+
+void writer_init_sink(Writer *w, String_Builder *sink) {
+    w->fd = -1;
+    w->sink = sink;
+    w->failed = false;
+    w->count = 0;
+}
+
+static
+void _write_all(Writer *w, const char *data, size_t count) {
+    // an empty String_Builder has no items to copy from or to
+    if (count == 0 || w->failed) {
+        return;
+    }
+    if (w->sink != NULL) {
+        da_append_many(w->sink, data, count);
+        return;
+    }
+    int fd = w->fd;
+    while (count > 0) {
+        ssize_t result = write(fd, data, count);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            fprintf(stderr, "ERROR: Could not write output: %s\n", strerror(errno));
+            w->failed = true;
+            return;
+        }
+        data += result;
+        count -= result;
+    }
+}
+
+void writer_flush(Writer *w) {
+    _write_all(w, w->buffer, w->count);
+    w->count = 0;
+}
+
+void writer_write(Writer *w, const char *data, size_t count) {
+    if (count == 0) {
+        return;
+    }
+    if (w->count + count > WRITER_BUFFER_SIZE) {
+        writer_flush(w);
+        if (count > WRITER_BUFFER_SIZE) {
+            // too big to be buffered, hand it to the fd directly
+            _write_all(w, data, count);
+            return;
+        }
+    }
+    memcpy(w->buffer + w->count, data, count);
+    w->count += count;
+}
+
+void writer_cstr(Writer *w, const char *cstr) {
+    writer_write(w, cstr, strlen(cstr));
+}
+
+void writer_sv(Writer *w, String_View sv) {
+    writer_write(w, sv.data, sv.count);
+}
+
+static const char _digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+void writer_u64(Writer *w, uint64_t value) {
+    // digits are produced back to front, two at a time
+    char buffer[20];
+    char *end = buffer + sizeof(buffer);
+    char *start = end;
+    while (value >= 100) {
+        const char *pair = &_digit_pairs[(value % 100) * 2];
+        value /= 100;
+        *--start = pair[1];
+        *--start = pair[0];
+    }
+    if (value >= 10) {
+        const char *pair = &_digit_pairs[value * 2];
+        *--start = pair[1];
+        *--start = pair[0];
+    } else {
+        *--start = (char)('0' + value);
+    }
+    writer_write(w, start, end - start);
+}
+
+void writer_i64(Writer *w, int64_t value) {
+    if (value < 0) {
+        writer_char(w, '-');
+        writer_u64(w, (uint64_t)0 - (uint64_t)value);
+        return;
+    }
+    writer_u64(w, (uint64_t)value);
+}
+
+void writer_hex(Writer *w, uint64_t value) {
+    static const char digits[] = "0123456789abcdef";
+    char buffer[16];
+    char *end = buffer + sizeof(buffer);
+    char *start = end;
+    do {
+        *--start = digits[value & 0xf];
+        value >>= 4;
+    } while (value != 0);
+    writer_write(w, start, end - start);
+}
+
+void writer_f64(Writer *w, double value) {
+    char buffer[350];
+    int count = snprintf(buffer, sizeof(buffer), "%f", value);
+    assert(count >= 0 && (size_t)count < sizeof(buffer));
+    writer_write(w, buffer, count);
+}
@@ -0,0 +1,45 @@
+#ifndef WRITER_H_
+#define WRITER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "strings.h"
+
+#define WRITER_BUFFER_SIZE (64*1024)
+
+// Buffered output to a file descriptor. Everything printed goes through the
+// fixed-size buffer, so memory stays constant no matter how much is written.
+// A writer with a `sink` collects its output in memory instead.
+typedef struct {
+    int fd;
+    String_Builder *sink;
+    // a write to `fd` failed and was reported, the rest of the output is
+    // dropped
+    bool failed;
+    size_t count;
+    char buffer[WRITER_BUFFER_SIZE];
+} Writer;
+
+void writer_init(Writer *w, int fd);
+void writer_init_sink(Writer *w, String_Builder *sink);
+void writer_flush(Writer *w);
+void writer_write(Writer *w, const char *data, size_t count);
+
+void writer_cstr(Writer *w, const char *cstr);
+void writer_sv(Writer *w, String_View sv);
+void writer_u64(Writer *w, uint64_t value);
+void writer_i64(Writer *w, int64_t value);
+void writer_hex(Writer *w, uint64_t value);
+void writer_f64(Writer *w, double value);
+
+static inline
+void writer_char(Writer *w, char chr) {
+    if (w->count == WRITER_BUFFER_SIZE) {
+        writer_flush(w);
+    }
+    w->buffer[w->count++] = chr;
+}
+
+#endif // WRITER_H_